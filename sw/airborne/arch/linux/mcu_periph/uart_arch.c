@@ -39,29 +39,172 @@
 
 #include <pthread.h>
 #include <sys/select.h>
+#include <fcntl.h>
+#include <time.h>
+
+#if PERIODIC_TELEMETRY
+#include "subsystems/datalink/telemetry.h"
+#endif
 
 #ifndef UART_THREAD_PRIO
 #define UART_THREAD_PRIO 11
 #endif
 
 static void uart_receive_handler(struct uart_periph *periph);
+static void uart_transmit_handler(struct uart_periph *periph);
 static void *uart_thread(void *data __attribute__((unused)));
-static pthread_mutex_t uart_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #define TRACE(fmt,args...)    fprintf(stderr, fmt, args)
 //#define TRACE(fmt,args...)
 
+/** List of the enabled uarts, scanned by the reader thread */
+static struct uart_periph *const uart_periphs[] = {
+#if USE_UART0
+  &uart0,
+#endif
+#if USE_UART1
+  &uart1,
+#endif
+#if USE_UART2
+  &uart2,
+#endif
+#if USE_UART3
+  &uart3,
+#endif
+#if USE_UART4
+  &uart4,
+#endif
+#if USE_UART5
+  &uart5,
+#endif
+#if USE_UART6
+  &uart6,
+#endif
+  NULL
+};
+
+/**
+ * Wake up of the uart thread when bytes are queued while it sleeps.
+ * The thread sets uart_tx_idle before checking the tx rings for the last time,
+ * the writers publish their bytes before clearing it, so either the thread
+ * sees the bytes or the writer sees the flag and writes to the pipe.
+ */
+static int uart_wake_pipe[2] = { -1, -1 };
+static bool_t uart_tx_idle = FALSE;
+
+#if PERIODIC_TELEMETRY
+/** Bus numbers of the uarts of uart_periphs */
+static const uint8_t uart_buses[] = {
+#if USE_UART0
+  0,
+#endif
+#if USE_UART1
+  1,
+#endif
+#if USE_UART2
+  2,
+#endif
+#if USE_UART3
+  3,
+#endif
+#if USE_UART4
+  4,
+#endif
+#if USE_UART5
+  5,
+#endif
+#if USE_UART6
+  6,
+#endif
+  0
+};
+
+/**
+ * Send the hold times of one uart per message, in turn.
+ * They are reset after each report, so it gives the worst case since the
+ * previous report of the same uart.
+ */
+static void send_uart_hold_times(struct transport_tx *trans, struct link_device *dev)
+{
+  static uint8_t idx = 0;
+  if (uart_periphs[idx] == NULL) {
+    idx = 0;
+    if (uart_periphs[idx] == NULL) { return; }
+  }
+  struct uart_periph *p = uart_periphs[idx];
+  struct uart_arch_periph *arch = (struct uart_arch_periph *)(p->reg_addr);
+  if (arch != NULL) {
+    uint32_t rx_hold_max = arch->rx_hold_max;
+    uint32_t tx_hold_max = arch->tx_hold_max;
+    uint32_t tx_dropped = __atomic_load_n(&arch->tx_dropped, __ATOMIC_RELAXED);
+    uint8_t bus = uart_buses[idx];
+    pprz_msg_send_UART_HOLD_TIMES(trans, dev, AC_ID, &rx_hold_max, &tx_hold_max, &tx_dropped, &bus);
+    uart_arch_reset_stats(p);
+  }
+  idx++;
+}
+#endif
+
+/** Monotonic time in microseconds, used for the hold time statistics */
+static uint32_t uart_time_usec(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static inline void uart_update_max(volatile uint32_t *max, uint32_t start)
+{
+  uint32_t dt = uart_time_usec() - start;
+  if (dt > *max) {
+    *max = dt;
+  }
+}
+
 void uart_arch_init(void)
 {
-  pthread_mutex_init(&uart_mutex, NULL);
+  if (pipe(uart_wake_pipe) != 0 ||
+      fcntl(uart_wake_pipe[0], F_SETFL, O_NONBLOCK) != 0 ||
+      fcntl(uart_wake_pipe[1], F_SETFL, O_NONBLOCK) != 0) {
+    fprintf(stderr, "uart_arch_init: Could not create UART wake up pipe.\n");
+    return;
+  }
 
   pthread_t tid;
   if (pthread_create(&tid, NULL, uart_thread, NULL) != 0) {
     fprintf(stderr, "uart_arch_init: Could not create UART reading thread.\n");
     return;
   }
+
+#if PERIODIC_TELEMETRY
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_UART_HOLD_TIMES_ID, send_uart_hold_times);
+#endif
+}
+
+void uart_arch_reset_stats(struct uart_periph *p)
+{
+  struct uart_arch_periph *arch = (struct uart_arch_periph *)(p->reg_addr);
+  if (arch != NULL) {
+    arch->rx_hold_max = 0;
+    arch->tx_hold_max = 0;
+  }
 }
 
+/** Number of bytes waiting in the tx ring of a uart */
+static inline uint16_t uart_tx_pending(struct uart_periph *p)
+{
+  int16_t pending = __atomic_load_n(&p->tx_insert_idx, __ATOMIC_SEQ_CST) - p->tx_extract_idx;
+  if (pending < 0) {
+    pending += UART_TX_BUFFER_SIZE;
+  }
+  return (uint16_t)pending;
+}
+
+/**
+ * Reader and writer thread of all the uarts.
+ * Reads the incoming bytes into the rx rings and sends the bytes of the tx
+ * rings when the ports can take them, so the main loop never waits on a port.
+ */
 static void *uart_thread(void *data __attribute__((unused)))
 {
   get_rt_prio(UART_THREAD_PRIO);
@@ -69,237 +212,236 @@ static void *uart_thread(void *data __attribute__((unused)))
   /* file descriptor list */
   fd_set fds_master;
   /* maximum file descriptor number */
-  int fdmax = 0;
+  int fdmax = uart_wake_pipe[0];
+  int i, fd;
 
   /* clear the fd list */
   FD_ZERO(&fds_master);
+  FD_SET(uart_wake_pipe[0], &fds_master);
   /* add used fds */
-  int fd;
-#if USE_UART0
-  if (uart0.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart0.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART1
-  if (uart1.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart1.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART2
-  if (uart2.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart2.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART3
-  if (uart3.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart3.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART4
-  if (uart4.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart4.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART5
-  if (uart5.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart5.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
-    }
-  }
-#endif
-#if USE_UART6
-  if (uart6.reg_addr != NULL) {
-    fd = ((struct SerialPort *)uart6.reg_addr)->fd;
-    FD_SET(fd, &fds_master);
-    if (fd > fdmax) {
-      fdmax =fd;
+  for (i = 0; uart_periphs[i] != NULL; i++) {
+    if (uart_periphs[i]->reg_addr != NULL) {
+      fd = ((struct uart_arch_periph *)uart_periphs[i]->reg_addr)->port->fd;
+      FD_SET(fd, &fds_master);
+      if (fd > fdmax) {
+        fdmax = fd;
+      }
     }
   }
-}
-#endif
-
-/* fds to be read, modified after each select */
-fd_set fds;
 
-while (1) {
-  /* reset list of fds to check */
-  fds = fds_master;
-
-  if (select(fdmax + 1, &fds, NULL, NULL, NULL) < 0) {
-    fprintf(stderr, "uart_thread: select failed!");
-  }
-  else {
-#if USE_UART0
-    if (uart0.reg_addr != NULL) {
-      fd = ((struct SerialPort *)uart0.reg_addr)->fd;
-      if (FD_ISSET(fd, &fds)) {
-        uart_receive_handler(&uart0);
+  /* fds to be read and written, modified after each select */
+  fd_set fds, wfds;
+
+  while (1) {
+    /* reset list of fds to check */
+    fds = fds_master;
+    FD_ZERO(&wfds);
+
+    /* wait for the ports with bytes to send, the writers wake us up for the others */
+    bool_t tx_pending = FALSE;
+    __atomic_store_n(&uart_tx_idle, TRUE, __ATOMIC_SEQ_CST);
+    for (i = 0; uart_periphs[i] != NULL; i++) {
+      if (uart_periphs[i]->reg_addr != NULL && uart_tx_pending(uart_periphs[i]) > 0) {
+        FD_SET(((struct uart_arch_periph *)uart_periphs[i]->reg_addr)->port->fd, &wfds);
+        tx_pending = TRUE;
       }
     }
-#endif
-#if USE_UART1
-    if (uart1.reg_addr != NULL) {
-      fd = ((struct SerialPort *)uart1.reg_addr)->fd;
-      if (FD_ISSET(fd, &fds)) {
-        uart_receive_handler(&uart1);
-      }
-    }
-#endif
-#if USE_UART2
-    if (uart2.reg_addr != NULL) {
-      fd = ((struct SerialPort *)uart2.reg_addr)->fd;
-      if (FD_ISSET(fd, &fds)) {
-        uart_receive_handler(&uart2);
-      }
+    if (tx_pending) {
+      __atomic_store_n(&uart_tx_idle, FALSE, __ATOMIC_SEQ_CST);
     }
-#endif
-#if USE_UART3
-    if (uart3.reg_addr != NULL) {
-      fd = ((struct SerialPort *)uart3.reg_addr)->fd;
-      if (FD_ISSET(fd, &fds)) {
-        uart_receive_handler(&uart3);
+
+    if (select(fdmax + 1, &fds, &wfds, NULL, NULL) < 0) {
+      if (errno != EINTR) {
+        fprintf(stderr, "uart_thread: select failed!");
       }
     }
-#endif
-#if USE_UART4
-    if (uart4.reg_addr != NULL) {
-      fd = ((struct SerialPort *)uart4.reg_addr)->fd;
-      if (FD_ISSET(fd, &fds)) {
-        uart_receive_handler(&uart4);
-      }
-#endif
-#if USE_UART5
-      if (uart5.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart5.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart5);
-        }
+    else {
+      if (FD_ISSET(uart_wake_pipe[0], &fds)) {
+        uint8_t buf[16];
+        while (read(uart_wake_pipe[0], buf, sizeof(buf)) > 0);
       }
-#endif
-#if USE_UART6
-      if (uart6.reg_addr != NULL) {
-        fd = ((struct SerialPort *)uart6.reg_addr)->fd;
-        if (FD_ISSET(fd, &fds)) {
-          uart_receive_handler(&uart6);
+      for (i = 0; uart_periphs[i] != NULL; i++) {
+        if (uart_periphs[i]->reg_addr != NULL) {
+          fd = ((struct uart_arch_periph *)uart_periphs[i]->reg_addr)->port->fd;
+          if (FD_ISSET(fd, &fds)) {
+            uart_receive_handler(uart_periphs[i]);
+          }
+          if (FD_ISSET(fd, &wfds)) {
+            uart_transmit_handler(uart_periphs[i]);
+          }
         }
       }
-#endif
     }
   }
   return 0;
- }
+}
 
 
 void uart_periph_set_baudrate(struct uart_periph *periph, uint32_t baud)
 {
   periph->baudrate = baud;
 
-  struct SerialPort *port;
+  struct uart_arch_periph *arch = (struct uart_arch_periph *)(periph->reg_addr);
   // close serial port if already open
-  if (periph->reg_addr != NULL) {
-    port = (struct SerialPort *)(periph->reg_addr);
-    serial_port_close(port);
-    serial_port_free(port);
+  if (arch != NULL) {
+    serial_port_close(arch->port);
+    serial_port_free(arch->port);
+  }
+  else {
+    arch = calloc(1, sizeof(struct uart_arch_periph));
   }
   // open serial port
-  port = serial_port_new();
-  // use register address to store SerialPort structure pointer...
-  periph->reg_addr = (void *)port;
+  arch->port = serial_port_new();
+  // use register address to store the linux specific structure pointer...
+  periph->reg_addr = (void *)arch;
 
   //TODO: set device name in application and pass as argument
   // FIXME: paparazzi baud is 9600 for B9600 while open_raw needs 12 for B9600
   // /printf("opening %s on uart0 at termios.h baud value=%d\n", periph->dev, baud);
-  int ret = serial_port_open_raw(port, periph->dev, baud);
+  int ret = serial_port_open_raw(arch->port, periph->dev, baud);
   if (ret != 0) {
     TRACE("Error opening %s code %d\n", periph->dev, ret);
-    serial_port_free(port);
+    serial_port_free(arch->port);
+    free(arch);
     periph->reg_addr = NULL;
   }
 }
 
-void uart_put_byte(struct uart_periph *periph, uint8_t data)
+/**
+ * Queue bytes in the tx ring, sent later by the uart thread.
+ * Main loop side (single producer): only tx_insert_idx is written, and never
+ * waits. The bytes that do not fit are dropped and counted in tx_dropped.
+ */
+static void uart_write(struct uart_periph *periph, uint8_t *data, uint16_t len)
 {
   if (periph->reg_addr == NULL) { return; } // device not initialized ?
 
-  /* write single byte to serial port */
-  struct SerialPort *port = (struct SerialPort *)(periph->reg_addr);
+  struct uart_arch_periph *arch = (struct uart_arch_periph *)(periph->reg_addr);
+  uint16_t insert = periph->tx_insert_idx;
+  uint16_t extract = __atomic_load_n(&periph->tx_extract_idx, __ATOMIC_ACQUIRE);
+  uint16_t i;
 
-  int ret = 0;
-  do{
-    ret = write((int)(port->fd), &data, 1);
-  } while(ret < 1 && errno == EAGAIN); //FIXME: max retry
+  for (i = 0; i < len; i++) {
+    uint16_t temp = (insert + 1) % UART_TX_BUFFER_SIZE;
+    if (temp == extract) {
+      __atomic_add_fetch(&arch->tx_dropped, len - i, __ATOMIC_RELAXED);
+      break;
+    }
+    periph->tx_buf[insert] = data[i];
+    insert = temp;
+  }
+  __atomic_store_n(&periph->tx_insert_idx, insert, __ATOMIC_SEQ_CST);
 
-  if (ret < 1) {
-    TRACE("uart_put_byte: write %d failed [%d: %s]\n", data, ret, strerror(errno));
+  if (__atomic_exchange_n(&uart_tx_idle, FALSE, __ATOMIC_SEQ_CST)) {
+    uint8_t wake = 0;
+    if (write(uart_wake_pipe[1], &wake, 1) < 0) {
+      // pipe full, the thread is already woken up
+    }
   }
 }
 
+void uart_put_byte(struct uart_periph *periph, uint8_t data)
+{
+  uart_write(periph, &data, 1);
+}
 
-static void uart_receive_handler(struct uart_periph *periph)
+/**
+ * Queue a complete buffer at once instead of byte per byte.
+ */
+void uart_put_buffer(struct uart_periph *periph, uint8_t *data, uint16_t len)
+{
+  uart_write(periph, data, len);
+}
+
+/**
+ * Write the pending bytes of the tx ring to the serial port.
+ * Runs in the uart thread (single consumer): only tx_extract_idx is written,
+ * and published after the write so the main loop never overwrites unsent bytes.
+ * On a write error the pending bytes are dropped and counted in tx_dropped.
+ */
+static void uart_transmit_handler(struct uart_periph *periph)
 {
-  unsigned char c = 'D';
+  struct uart_arch_periph *arch = (struct uart_arch_periph *)(periph->reg_addr);
+  uint16_t insert = __atomic_load_n(&periph->tx_insert_idx, __ATOMIC_ACQUIRE);
+  uint16_t extract = periph->tx_extract_idx;
+  if (insert == extract) { return; }
+
+  // contiguous part of the ring, the rest is sent on the next round
+  uint16_t len = (insert > extract ? insert : UART_TX_BUFFER_SIZE) - extract;
+  uint32_t start = uart_time_usec();
+
+  int ret = write(arch->port->fd, &periph->tx_buf[extract], len);
+  if (ret > 0) {
+    extract = (extract + ret) % UART_TX_BUFFER_SIZE;
+  }
+  else if (ret < 0 && errno != EAGAIN && errno != EINTR) {
+    int16_t pending = insert - extract;
+    if (pending < 0) {
+      pending += UART_TX_BUFFER_SIZE;
+    }
+    __atomic_add_fetch(&arch->tx_dropped, pending, __ATOMIC_RELAXED);
+    extract = insert;
+  }
+  __atomic_store_n(&periph->tx_extract_idx, extract, __ATOMIC_RELEASE);
+
+  uart_update_max(&arch->tx_hold_max, start);
+}
 
-  if (periph->reg_addr == NULL) { return; } // device not initialized ?
 
-  struct SerialPort *port = (struct SerialPort *)(periph->reg_addr);
-  int fd = port->fd;
+/**
+ * Read all the pending bytes of a serial port into the rx ring.
+ * Runs in the reader thread (single producer): only rx_insert_idx is written,
+ * and published after the data so the main loop never sees a partial byte.
+ */
+static void uart_receive_handler(struct uart_periph *periph)
+{
+  uint8_t buf[UART_RX_BUFFER_SIZE];
 
-  pthread_mutex_lock(&uart_mutex);
+  if (periph->reg_addr == NULL) { return; } // device not initialized ?
 
-  if (read(fd, &c, 1) > 0) {
-    //printf("r %x %c\n",c,c);
-    uint16_t temp = (periph->rx_insert_idx + 1) % UART_RX_BUFFER_SIZE;
-    // check for more room in queue
-    if (temp != periph->rx_extract_idx) {
-      periph->rx_buf[periph->rx_insert_idx] = c;
-      periph->rx_insert_idx = temp;  // update insert index
-    }
-    else {
-      TRACE("uart_receive_handler: rx_buf full! discarding received byte: %x %c\n", c, c);
+  struct uart_arch_periph *arch = (struct uart_arch_periph *)(periph->reg_addr);
+  uint32_t start = uart_time_usec();
+
+  int nb = read(arch->port->fd, buf, UART_RX_BUFFER_SIZE);
+  if (nb > 0) {
+    uint16_t insert = periph->rx_insert_idx;
+    uint16_t extract = __atomic_load_n(&periph->rx_extract_idx, __ATOMIC_ACQUIRE);
+    int i;
+    for (i = 0; i < nb; i++) {
+      uint16_t temp = (insert + 1) % UART_RX_BUFFER_SIZE;
+      // check for more room in queue
+      if (temp == extract) {
+        // rx_buf full, count the discarded bytes as overrun
+        periph->ore += nb - i;
+        break;
+      }
+      periph->rx_buf[insert] = buf[i];
+      insert = temp;
     }
+    __atomic_store_n(&periph->rx_insert_idx, insert, __ATOMIC_RELEASE);
   }
-  pthread_mutex_unlock(&uart_mutex);
+
+  uart_update_max(&arch->rx_hold_max, start);
 }
 
+/**
+ * Get the next byte from the rx ring.
+ * Main loop side (single consumer): only rx_extract_idx is written.
+ * Should only be called after uart_char_available returned a positive value.
+ */
 uint8_t uart_getch(struct uart_periph *p)
 {
-  pthread_mutex_lock(&uart_mutex);
   uint8_t ret = p->rx_buf[p->rx_extract_idx];
-  p->rx_extract_idx = (p->rx_extract_idx + 1) % UART_RX_BUFFER_SIZE;
-  pthread_mutex_unlock(&uart_mutex);
+  __atomic_store_n(&p->rx_extract_idx, (p->rx_extract_idx + 1) % UART_RX_BUFFER_SIZE, __ATOMIC_RELEASE);
   return ret;
 }
 
 uint16_t uart_char_available(struct uart_periph *p)
 {
-  pthread_mutex_lock(&uart_mutex);
-  int16_t available = p->rx_insert_idx - p->rx_extract_idx;
+  int16_t available = __atomic_load_n(&p->rx_insert_idx, __ATOMIC_ACQUIRE) - p->rx_extract_idx;
   if (available < 0) {
     available += UART_RX_BUFFER_SIZE;
   }
-  pthread_mutex_unlock(&uart_mutex);
   return (uint16_t)available;
 }
 
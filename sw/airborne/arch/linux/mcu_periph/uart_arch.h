@@ -36,9 +36,35 @@
 
 #include "mcu_periph/uart.h"
 
+#include <stdint.h>
+
 // for definition of baud rates
 #include <termios.h>
 
+/**
+ * Linux part of a uart_periph, pointed to by its reg_addr.
+ *
+ * The rx_buf of the uart_periph is used as a single producer/single consumer
+ * ring: the reader thread only writes rx_insert_idx, the main loop only writes
+ * rx_extract_idx, so neither side ever waits on the other. Bytes dropped
+ * because the ring is full are counted in the ore field of the uart_periph.
+ * The tx_buf is the same kind of ring the other way: the main loop only writes
+ * tx_insert_idx and the same thread sends the bytes, the dropped ones are
+ * counted in tx_dropped.
+ */
+struct SerialPort;
+struct uart_periph;
+
+struct uart_arch_periph {
+  struct SerialPort *port;
+  volatile uint32_t rx_hold_max;  ///< longest time (us) spent by the reader thread on one read
+  volatile uint32_t tx_hold_max;  ///< longest time (us) spent by the uart thread on one write
+  volatile uint32_t tx_dropped;   ///< bytes dropped because the tx ring was full or the write failed
+};
+
+/** Reset the worst case hold times of a uart, done after each UART_HOLD_TIMES message */
+extern void uart_arch_reset_stats(struct uart_periph *p);
+
 // for conversion between linux baud rate definition and actual speed
 static inline int uart_speed(int def)
 {
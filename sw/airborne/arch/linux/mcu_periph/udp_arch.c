@@ -31,20 +31,89 @@
 
 #include <pthread.h>
 #include <sys/select.h>
+#include <time.h>
 
 #include "rt_priority.h"
 
+#if PERIODIC_TELEMETRY
+#include "subsystems/datalink/telemetry.h"
+#endif
+
 #ifndef UDP_THREAD_PRIO
 #define UDP_THREAD_PRIO 10
 #endif
 
 static void *udp_thread(void *data __attribute__((unused)));
-static pthread_mutex_t udp_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-void udp_arch_init(void)
+#if PERIODIC_TELEMETRY
+/** List of the enabled udp peripherals and their numbers, reported in turn */
+static struct udp_periph *const udp_periphs[] = {
+#if USE_UDP0
+  &udp0,
+#endif
+#if USE_UDP1
+  &udp1,
+#endif
+#if USE_UDP2
+  &udp2,
+#endif
+  NULL
+};
+
+static const uint8_t udp_numbers[] = {
+#if USE_UDP0
+  0,
+#endif
+#if USE_UDP1
+  1,
+#endif
+#if USE_UDP2
+  2,
+#endif
+  0
+};
+
+/**
+ * Send the overrun counter and the hold times of one udp peripheral per
+ * message, in turn. The hold times are reset after each report.
+ */
+static void send_udp_hold_times(struct transport_tx *trans, struct link_device *dev)
 {
-  pthread_mutex_init(&udp_mutex, NULL);
+  static uint8_t idx = 0;
+  if (udp_periphs[idx] == NULL) {
+    idx = 0;
+    if (udp_periphs[idx] == NULL) { return; }
+  }
+  struct udp_periph *p = udp_periphs[idx];
+  uint16_t ore = p->ore;
+  uint32_t rx_hold_max = p->rx_hold_max;
+  uint32_t tx_hold_max = p->tx_hold_max;
+  uint8_t nb = udp_numbers[idx];
+  pprz_msg_send_UDP_HOLD_TIMES(trans, dev, AC_ID, &ore, &rx_hold_max, &tx_hold_max, &nb);
+  p->rx_hold_max = 0;
+  p->tx_hold_max = 0;
+  idx++;
+}
+#endif
+
+/** Monotonic time in microseconds, used for the hold time statistics */
+static uint32_t udp_time_usec(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static inline void udp_update_max(volatile uint32_t *max, uint32_t start)
+{
+  uint32_t dt = udp_time_usec() - start;
+  if (dt > *max) {
+    *max = dt;
+  }
+}
 
+void udp_arch_init(void)
+{
 #ifdef USE_UDP0
   UDP0Init();
 #endif
@@ -60,6 +129,10 @@ void udp_arch_init(void)
     fprintf(stderr, "udp_arch_init: Could not create UDP reading thread.\n");
     return;
   }
+
+#if PERIODIC_TELEMETRY
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_UDP_HOLD_TIMES_ID, send_udp_hold_times);
+#endif
 }
 
 /**
@@ -75,65 +148,69 @@ void udp_arch_periph_init(struct udp_periph *p, char *host, int port_out, int po
 
 /**
  * Get number of bytes available in receive buffer.
+ * The rx_buf is a single producer/single consumer ring: the reader thread
+ * only writes rx_insert_idx and the main loop only writes rx_extract_idx.
  * @param p pointer to UDP peripheral
  * @return number of bytes available in receive buffer
  */
 uint16_t udp_char_available(struct udp_periph *p)
 {
-  pthread_mutex_lock(&udp_mutex);
-  int16_t available = p->rx_insert_idx - p->rx_extract_idx;
+  int16_t available = __atomic_load_n(&p->rx_insert_idx, __ATOMIC_ACQUIRE) - p->rx_extract_idx;
   if (available < 0) {
     available += UDP_RX_BUFFER_SIZE;
   }
-  pthread_mutex_unlock(&udp_mutex);
   return (uint16_t)available;
 }
 
 /**
  * Get the last character from the receive buffer.
+ * Should only be called after udp_char_available returned a positive value.
  * @param p pointer to UDP peripheral
  * @return last byte
  */
 uint8_t udp_getch(struct udp_periph *p)
 {
-  pthread_mutex_lock(&udp_mutex);
   uint8_t ret = p->rx_buf[p->rx_extract_idx];
-  p->rx_extract_idx = (p->rx_extract_idx + 1) % UDP_RX_BUFFER_SIZE;
-  pthread_mutex_unlock(&udp_mutex);
+  __atomic_store_n(&p->rx_extract_idx, (p->rx_extract_idx + 1) % UDP_RX_BUFFER_SIZE, __ATOMIC_RELEASE);
   return ret;
 }
 
 /**
- * Read bytes from UDP
+ * Read bytes from UDP.
+ * Called from the reader thread only. The bytes of a datagram that do not
+ * fit in the receive buffer are dropped and counted in ore.
  */
 void udp_receive(struct udp_periph *p)
 {
   if (p == NULL) return;
   if (p->network == NULL) return;
 
-  int16_t i;
-  int16_t available = UDP_RX_BUFFER_SIZE - udp_char_available(p);
   uint8_t buf[UDP_RX_BUFFER_SIZE];
   struct UdpSocket *sock = (struct UdpSocket *) p->network;
-
-  if (available <= 0) {
-    return;  // No space
-  }
+  uint32_t start = udp_time_usec();
 
   socklen_t slen = sizeof(struct sockaddr_in);
   ssize_t byte_read = recvfrom(sock->sockfd, buf, UDP_RX_BUFFER_SIZE, MSG_DONTWAIT,
                                (struct sockaddr *)&sock->addr_in, &slen);
 
-  pthread_mutex_lock(&udp_mutex);
-
   if (byte_read > 0) {
+    uint16_t insert = p->rx_insert_idx;
+    uint16_t extract = __atomic_load_n(&p->rx_extract_idx, __ATOMIC_ACQUIRE);
+    ssize_t i;
     for (i = 0; i < byte_read; i++) {
-      p->rx_buf[p->rx_insert_idx] = buf[i];
-      p->rx_insert_idx = (p->rx_insert_idx + 1) % UDP_RX_BUFFER_SIZE;
+      uint16_t temp = (insert + 1) % UDP_RX_BUFFER_SIZE;
+      if (temp == extract) {
+        p->ore += byte_read - i;
+        break;
+      }
+      p->rx_buf[insert] = buf[i];
+      insert = temp;
     }
+    // publish the new bytes to the main loop
+    __atomic_store_n(&p->rx_insert_idx, insert, __ATOMIC_RELEASE);
   }
 
-  pthread_mutex_unlock(&udp_mutex);
+  udp_update_max(&p->rx_hold_max, start);
 }
 
 /**
@@ -147,6 +224,7 @@ void udp_send_message(struct udp_periph *p)
   struct UdpSocket *sock = (struct UdpSocket *) p->network;
 
   if (p->tx_insert_idx > 0) {
+    uint32_t start = udp_time_usec();
     ssize_t bytes_sent = sendto(sock->sockfd, p->tx_buf, p->tx_insert_idx, MSG_DONTWAIT,
                                 (struct sockaddr *)&sock->addr_out, sizeof(sock->addr_out));
     if (bytes_sent != p->tx_insert_idx) {
@@ -159,6 +237,7 @@ void udp_send_message(struct udp_periph *p)
       }
     }
     p->tx_insert_idx = 0;
+    udp_update_max(&p->tx_hold_max, start);
   }
 }
 
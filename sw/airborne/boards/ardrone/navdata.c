@@ -236,7 +236,7 @@ bool_t navdata_init()
   }
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "ARDRONE_NAVDATA", send_navdata);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ARDRONE_NAVDATA_ID, send_navdata);
 #endif
 
   // Set to initialized
@@ -106,10 +106,10 @@ static inline void main_init(void)
 
   downlink_init();
 
-  register_periodic_telemetry(DefaultPeriodic, "AUTOPILOT_VERSION", send_autopilot_version);
-  register_periodic_telemetry(DefaultPeriodic, "ALIVE", send_alive);
-  register_periodic_telemetry(DefaultPeriodic, "COMMANDS", send_commands);
-  register_periodic_telemetry(DefaultPeriodic, "ACTUATORS", send_actuators);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AUTOPILOT_VERSION_ID, send_autopilot_version);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ALIVE_ID, send_alive);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_COMMANDS_ID, send_commands);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ACTUATORS_ID, send_actuators);
 
   // send body_to_imu from here for now
   AbiSendMsgBODY_TO_IMU_QUAT(1, orientationGetQuat_f(&imu.body_to_imu));
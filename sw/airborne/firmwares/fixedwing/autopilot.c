@@ -191,16 +191,16 @@ void autopilot_init(void)
 
 #if PERIODIC_TELEMETRY
   /* register some periodic message */
-  register_periodic_telemetry(DefaultPeriodic, "AUTOPILOT_VERSION", send_autopilot_version);
-  register_periodic_telemetry(DefaultPeriodic, "ALIVE", send_alive);
-  register_periodic_telemetry(DefaultPeriodic, "PPRZ_MODE", send_mode);
-  register_periodic_telemetry(DefaultPeriodic, "ATTITUDE", send_attitude);
-  register_periodic_telemetry(DefaultPeriodic, "ESTIMATOR", send_estimator);
-  register_periodic_telemetry(DefaultPeriodic, "AIRSPEED", send_airspeed);
-  register_periodic_telemetry(DefaultPeriodic, "BAT", send_bat);
-  register_periodic_telemetry(DefaultPeriodic, "ENERGY", send_energy);
-  register_periodic_telemetry(DefaultPeriodic, "DL_VALUE", send_dl_value);
-  register_periodic_telemetry(DefaultPeriodic, "DESIRED", send_desired);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AUTOPILOT_VERSION_ID, send_autopilot_version);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ALIVE_ID, send_alive);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_PPRZ_MODE_ID, send_mode);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ATTITUDE_ID, send_attitude);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ESTIMATOR_ID, send_estimator);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AIRSPEED_ID, send_airspeed);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_BAT_ID, send_bat);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ENERGY_ID, send_energy);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_DL_VALUE_ID, send_dl_value);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_DESIRED_ID, send_desired);
 #if defined RADIO_CALIB && defined RADIO_CONTROL_SETTINGS
   register_periodic_telemetry(DefaultPeriodic, "RC_SETTINGS", send_rc_settings);
 #endif
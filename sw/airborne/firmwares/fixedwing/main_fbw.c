@@ -152,13 +152,13 @@ void init_fbw(void)
 #endif
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "FBW_STATUS", send_fbw_status);
-  register_periodic_telemetry(DefaultPeriodic, "COMMANDS", send_commands);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_FBW_STATUS_ID, send_fbw_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_COMMANDS_ID, send_commands);
 #ifdef ACTUATORS
-  register_periodic_telemetry(DefaultPeriodic, "ACTUATORS", send_actuators);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ACTUATORS_ID, send_actuators);
 #endif
 #ifdef RADIO_CONTROL
-  register_periodic_telemetry(DefaultPeriodic, "RC", send_rc);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_RC_ID, send_rc);
 #endif
 #endif
 
@@ -541,12 +541,12 @@ void nav_init(void)
 #endif
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "NAVIGATION_REF", send_nav_ref);
-  register_periodic_telemetry(DefaultPeriodic, "NAVIGATION", send_nav);
-  register_periodic_telemetry(DefaultPeriodic, "WP_MOVED", send_wp_moved);
-  register_periodic_telemetry(DefaultPeriodic, "CIRCLE", send_circle);
-  register_periodic_telemetry(DefaultPeriodic, "SEGMENT", send_segment);
-  register_periodic_telemetry(DefaultPeriodic, "SURVEY", send_survey);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_NAVIGATION_REF_ID, send_nav_ref);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_NAVIGATION_ID, send_nav);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_WP_MOVED_ID, send_wp_moved);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_CIRCLE_ID, send_circle);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_SEGMENT_ID, send_segment);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_SURVEY_ID, send_survey);
 #endif
 }
 
@@ -361,9 +361,9 @@ void h_ctl_init(void)
 #endif
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "CALIBRATION", send_calibration);
-  register_periodic_telemetry(DefaultPeriodic, "TUNE_ROLL", send_tune_roll);
-  register_periodic_telemetry(DefaultPeriodic, "H_CTL_A", send_ctl_a);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_CALIBRATION_ID, send_calibration);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_TUNE_ROLL_ID, send_tune_roll);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_H_CTL_A_ID, send_ctl_a);
 #endif
 }
 
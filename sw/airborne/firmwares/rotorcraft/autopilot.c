@@ -302,19 +302,19 @@ void autopilot_init(void)
   /* set startup mode, propagates through to guidance h/v */
   autopilot_set_mode(MODE_STARTUP);
 
-  register_periodic_telemetry(DefaultPeriodic, "AUTOPILOT_VERSION", send_autopilot_version);
-  register_periodic_telemetry(DefaultPeriodic, "ALIVE", send_alive);
-  register_periodic_telemetry(DefaultPeriodic, "ROTORCRAFT_STATUS", send_status);
-  register_periodic_telemetry(DefaultPeriodic, "ENERGY", send_energy);
-  register_periodic_telemetry(DefaultPeriodic, "ROTORCRAFT_FP", send_fp);
-  register_periodic_telemetry(DefaultPeriodic, "ROTORCRAFT_CMD", send_rotorcraft_cmd);
-  register_periodic_telemetry(DefaultPeriodic, "DL_VALUE", send_dl_value);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AUTOPILOT_VERSION_ID, send_autopilot_version);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ALIVE_ID, send_alive);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ROTORCRAFT_STATUS_ID, send_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ENERGY_ID, send_energy);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ROTORCRAFT_FP_ID, send_fp);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ROTORCRAFT_CMD_ID, send_rotorcraft_cmd);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_DL_VALUE_ID, send_dl_value);
 #ifdef ACTUATORS
-  register_periodic_telemetry(DefaultPeriodic, "ACTUATORS", send_actuators);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ACTUATORS_ID, send_actuators);
 #endif
 #ifdef RADIO_CONTROL
-  register_periodic_telemetry(DefaultPeriodic, "RC", send_rc);
-  register_periodic_telemetry(DefaultPeriodic, "ROTORCRAFT_RADIO_CONTROL", send_rotorcraft_rc);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_RC_ID, send_rc);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ROTORCRAFT_RADIO_CONTROL_ID, send_rotorcraft_rc);
 #endif
 }
 
@@ -185,10 +185,10 @@ void guidance_h_init(void)
 #endif
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "GUIDANCE_H_INT", send_gh);
-  register_periodic_telemetry(DefaultPeriodic, "HOVER_LOOP", send_hover_loop);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_GUIDANCE_H_INT_ID, send_gh);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_HOVER_LOOP_ID, send_hover_loop);
   register_periodic_telemetry(DefaultPeriodic, "GUIDANCE_H_REF", send_href);
-  register_periodic_telemetry(DefaultPeriodic, "ROTORCRAFT_TUNE_HOVER", send_tune_hover);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ROTORCRAFT_TUNE_HOVER_ID, send_tune_hover);
 #endif
 }
 
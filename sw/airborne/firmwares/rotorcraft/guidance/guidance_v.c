@@ -192,8 +192,8 @@ void guidance_v_init(void)
 #endif
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "VERT_LOOP", send_vert_loop);
-  register_periodic_telemetry(DefaultPeriodic, "TUNE_VERT", send_tune_vert);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_VERT_LOOP_ID, send_vert_loop);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_TUNE_VERT_ID, send_tune_vert);
 #endif
 }
 
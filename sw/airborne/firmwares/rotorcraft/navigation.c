@@ -181,8 +181,8 @@ void nav_init(void)
   dist2_to_wp = 0;
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "ROTORCRAFT_NAV_STATUS", send_nav_status);
-  register_periodic_telemetry(DefaultPeriodic, "WP_MOVED", send_wp_moved);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_ROTORCRAFT_NAV_STATUS_ID, send_nav_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_WP_MOVED_ID, send_wp_moved);
 #endif
 }
 
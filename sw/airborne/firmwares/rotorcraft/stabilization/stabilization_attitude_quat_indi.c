@@ -132,7 +132,7 @@ void stabilization_attitude_init(void)
   stabilization_attitude_ref_init();
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "STAB_ATTITUDE_INDI", send_att_indi);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_STAB_ATTITUDE_INDI_ID, send_att_indi);
 #endif
 }
 
@@ -135,7 +135,7 @@ void stabilization_attitude_init(void)
 #if PERIODIC_TELEMETRY
   register_periodic_telemetry(DefaultPeriodic, "STAB_ATTITUDE", send_att);
   register_periodic_telemetry(DefaultPeriodic, "STAB_ATTITUDE_REF", send_att_ref);
-  register_periodic_telemetry(DefaultPeriodic, "AHRS_REF_QUAT", send_ahrs_ref_quat);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AHRS_REF_QUAT_ID, send_ahrs_ref_quat);
 #endif
 }
 
@@ -288,8 +288,8 @@ void link_mcu_init(void)
 #ifdef AP
 #if PERIODIC_TELEMETRY
   // If FBW has not telemetry, then AP can send some of the info
-  register_periodic_telemetry(DefaultPeriodic, "COMMANDS", send_commands);
-  register_periodic_telemetry(DefaultPeriodic, "FBW_STATUS", send_fbw_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_COMMANDS_ID, send_commands);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_FBW_STATUS_ID, send_fbw_status);
 #endif
 #endif
 }
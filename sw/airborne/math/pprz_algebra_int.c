@@ -160,18 +160,12 @@ void int32_rmat_of_quat(struct Int32RMat *rm, struct Int32Quat *q)
  */
 void int32_rmat_of_eulers_321(struct Int32RMat *rm, struct Int32Eulers *e)
 {
-  int32_t sphi;
-  PPRZ_ITRIG_SIN(sphi, e->phi);
-  int32_t cphi;
-  PPRZ_ITRIG_COS(cphi, e->phi);
-  int32_t stheta;
-  PPRZ_ITRIG_SIN(stheta, e->theta);
-  int32_t ctheta;
-  PPRZ_ITRIG_COS(ctheta, e->theta);
-  int32_t spsi;
-  PPRZ_ITRIG_SIN(spsi, e->psi);
-  int32_t cpsi;
-  PPRZ_ITRIG_COS(cpsi, e->psi);
+  int32_t sphi, cphi;
+  PPRZ_ITRIG_SINCOS(sphi, cphi, e->phi);
+  int32_t stheta, ctheta;
+  PPRZ_ITRIG_SINCOS(stheta, ctheta, e->theta);
+  int32_t spsi, cpsi;
+  PPRZ_ITRIG_SINCOS(spsi, cpsi, e->psi);
 
   int32_t ctheta_cpsi = INT_MULT_RSHIFT(ctheta, cpsi,   INT32_TRIG_FRAC);
   int32_t ctheta_spsi = INT_MULT_RSHIFT(ctheta, spsi,   INT32_TRIG_FRAC);
@@ -203,18 +197,12 @@ void int32_rmat_of_eulers_321(struct Int32RMat *rm, struct Int32Eulers *e)
 
 void int32_rmat_of_eulers_312(struct Int32RMat *rm, struct Int32Eulers *e)
 {
-  int32_t sphi;
-  PPRZ_ITRIG_SIN(sphi, e->phi);
-  int32_t cphi;
-  PPRZ_ITRIG_COS(cphi, e->phi);
-  int32_t stheta;
-  PPRZ_ITRIG_SIN(stheta, e->theta);
-  int32_t ctheta;
-  PPRZ_ITRIG_COS(ctheta, e->theta);
-  int32_t spsi;
-  PPRZ_ITRIG_SIN(spsi, e->psi);
-  int32_t cpsi;
-  PPRZ_ITRIG_COS(cpsi, e->psi);
+  int32_t sphi, cphi;
+  PPRZ_ITRIG_SINCOS(sphi, cphi, e->phi);
+  int32_t stheta, ctheta;
+  PPRZ_ITRIG_SINCOS(stheta, ctheta, e->theta);
+  int32_t spsi, cpsi;
+  PPRZ_ITRIG_SINCOS(spsi, cpsi, e->psi);
 
   int32_t stheta_spsi = INT_MULT_RSHIFT(stheta, spsi,   INT32_TRIG_FRAC);
   int32_t stheta_cpsi = INT_MULT_RSHIFT(stheta, cpsi,   INT32_TRIG_FRAC);
@@ -362,18 +350,12 @@ void int32_quat_of_eulers(struct Int32Quat *q, struct Int32Eulers *e)
   const int32_t theta2 = e->theta / 2;
   const int32_t psi2   = e->psi   / 2;
 
-  int32_t s_phi2;
-  PPRZ_ITRIG_SIN(s_phi2, phi2);
-  int32_t c_phi2;
-  PPRZ_ITRIG_COS(c_phi2, phi2);
-  int32_t s_theta2;
-  PPRZ_ITRIG_SIN(s_theta2, theta2);
-  int32_t c_theta2;
-  PPRZ_ITRIG_COS(c_theta2, theta2);
-  int32_t s_psi2;
-  PPRZ_ITRIG_SIN(s_psi2, psi2);
-  int32_t c_psi2;
-  PPRZ_ITRIG_COS(c_psi2, psi2);
+  int32_t s_phi2, c_phi2;
+  PPRZ_ITRIG_SINCOS(s_phi2, c_phi2, phi2);
+  int32_t s_theta2, c_theta2;
+  PPRZ_ITRIG_SINCOS(s_theta2, c_theta2, theta2);
+  int32_t s_psi2, c_psi2;
+  PPRZ_ITRIG_SINCOS(s_psi2, c_psi2, psi2);
 
   int32_t c_th_c_ps = INT_MULT_RSHIFT(c_theta2, c_psi2, INT32_TRIG_FRAC);
   int32_t c_th_s_ps = INT_MULT_RSHIFT(c_theta2, s_psi2, INT32_TRIG_FRAC);
@@ -392,10 +374,8 @@ void int32_quat_of_eulers(struct Int32Quat *q, struct Int32Eulers *e)
 
 void int32_quat_of_axis_angle(struct Int32Quat *q, struct Int32Vect3 *uv, int32_t angle)
 {
-  int32_t san2;
-  PPRZ_ITRIG_SIN(san2, (angle / 2));
-  int32_t can2;
-  PPRZ_ITRIG_COS(can2, (angle / 2));
+  int32_t san2, can2;
+  PPRZ_ITRIG_SINCOS(san2, can2, (angle / 2));
   q->qi = can2;
   q->qx = san2 * uv->x;
   q->qy = san2 * uv->y;
@@ -544,14 +524,10 @@ void int32_eulers_of_quat(struct Int32Eulers *e, struct Int32Quat *q)
 
 void int32_rates_of_eulers_dot_321(struct Int32Rates *r, struct Int32Eulers *e, struct Int32Eulers *ed)
 {
-  int32_t sphi;
-  PPRZ_ITRIG_SIN(sphi, e->phi);
-  int32_t cphi;
-  PPRZ_ITRIG_COS(cphi, e->phi);
-  int32_t stheta;
-  PPRZ_ITRIG_SIN(stheta, e->theta);
-  int32_t ctheta;
-  PPRZ_ITRIG_COS(ctheta, e->theta);
+  int32_t sphi, cphi;
+  PPRZ_ITRIG_SINCOS(sphi, cphi, e->phi);
+  int32_t stheta, ctheta;
+  PPRZ_ITRIG_SINCOS(stheta, ctheta, e->theta);
 
   int32_t cphi_ctheta = INT_MULT_RSHIFT(cphi,   ctheta, INT32_TRIG_FRAC);
   int32_t sphi_ctheta = INT_MULT_RSHIFT(sphi,   ctheta, INT32_TRIG_FRAC);
@@ -563,10 +539,8 @@ void int32_rates_of_eulers_dot_321(struct Int32Rates *r, struct Int32Eulers *e,
 
 void int32_eulers_dot_321_of_rates(struct Int32Eulers *ed, struct Int32Eulers *e, struct Int32Rates *r)
 {
-  int32_t sphi;
-  PPRZ_ITRIG_SIN(sphi, e->phi);
-  int32_t cphi;
-  PPRZ_ITRIG_COS(cphi, e->phi);
+  int32_t sphi, cphi;
+  PPRZ_ITRIG_SINCOS(sphi, cphi, e->phi);
   int32_t stheta;
   PPRZ_ITRIG_SIN(stheta, e->theta);
   int64_t ctheta;
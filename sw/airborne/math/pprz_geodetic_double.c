@@ -182,6 +182,138 @@ void ned_of_lla_point_d(struct NedCoor_d *ned, struct LtpDef_d *def, struct LlaC
 }
 
 
+/*
+ * Batch conversions on struct of arrays.
+ * The constants and the local frame are only loaded once and the loops
+ * have no function calls besides libm, so they can be vectorized.
+ */
+
+/** LLA of n ECEF points, same algorithm as lla_of_ecef_d() */
+void lla_of_ecef_array_d(struct LlaCoorArray_d *lla, struct EcefCoorArray_d *ecef, uint32_t n)
+{
+  const double a = 6378137.0;           /* earth semimajor axis in meters */
+  const double f = 1. / 298.257223563;  /* reciprocal flattening          */
+  const double b = a * (1. - f);        /* semi-minor axis                */
+  const double b2 = b * b;
+  const double e2 = 2.*f - (f * f);     /* first eccentricity squared     */
+  const double ep2 = f * (2. - f) / ((1. - f) * (1. - f)); /* second eccentricity squared */
+  const double E2 = a * a - b2;
+
+  for (uint32_t i = 0; i < n; i++) {
+    const double x = ecef->x[i], y = ecef->y[i], z = ecef->z[i];
+    const double z2 = z * z;
+    const double r2 = x * x + y * y;
+    const double r = sqrt(r2);
+    const double F = 54.*b2 * z2;
+    const double G = r2 + (1 - e2) * z2 - e2 * E2;
+    const double c = (e2 * e2 * F * r2) / (G * G * G);
+    const double s = cbrt(1 + c + sqrt(c * c + 2 * c));
+    const double s1 = 1 + s + 1 / s;
+    const double P = F / (3 * s1 * s1 * G * G);
+    const double Q = sqrt(1 + 2 * e2 * e2 * P);
+    const double ro = -(e2 * P * r) / (1 + Q) + sqrt((a * a / 2) * (1 + 1 / Q) - ((1 - e2) * P * z2) / (Q *
+                      (1 + Q)) - P * r2 / 2);
+    const double tmp = (r - e2 * ro) * (r - e2 * ro);
+    const double U = sqrt(tmp + z2);
+    const double V = sqrt(tmp + (1 - e2) * z2);
+    const double zo = (b2 * z) / (a * V);
+
+    lla->alt[i] = U * (1 - b2 / (a * V));
+    lla->lat[i] = atan((z + ep2 * zo) / r);
+    lla->lon[i] = atan2(y, x);
+  }
+}
+
+/** ECEF of n LLA points */
+void ecef_of_lla_array_d(struct EcefCoorArray_d *ecef, struct LlaCoorArray_d *lla, uint32_t n)
+{
+  const double a = 6378137.0;           /* earth semimajor axis in meters */
+  const double f = 1. / 298.257223563;  /* reciprocal flattening          */
+  const double e2 = 2.*f - (f * f);     /* first eccentricity squared     */
+
+  for (uint32_t i = 0; i < n; i++) {
+    const double sin_lat = sin(lla->lat[i]);
+    const double cos_lat = cos(lla->lat[i]);
+    const double sin_lon = sin(lla->lon[i]);
+    const double cos_lon = cos(lla->lon[i]);
+    const double a_chi = a / sqrt(1. - e2 * sin_lat * sin_lat);
+    const double r = (a_chi + lla->alt[i]) * cos_lat;
+    ecef->x[i] = r * cos_lon;
+    ecef->y[i] = r * sin_lon;
+    ecef->z[i] = (a_chi * (1. - e2) + lla->alt[i]) * sin_lat;
+  }
+}
+
+/** ENU of n ECEF points */
+void enu_of_ecef_point_array_d(struct EnuCoorArray_d *enu, struct LtpDef_d *def, struct EcefCoorArray_d *ecef,
+                               uint32_t n)
+{
+  const double *m = def->ltp_of_ecef.m;
+  const double x0 = def->ecef.x, y0 = def->ecef.y, z0 = def->ecef.z;
+  for (uint32_t i = 0; i < n; i++) {
+    const double dx = ecef->x[i] - x0;
+    const double dy = ecef->y[i] - y0;
+    const double dz = ecef->z[i] - z0;
+    enu->x[i] = m[0] * dx + m[1] * dy + m[2] * dz;
+    enu->y[i] = m[3] * dx + m[4] * dy + m[5] * dz;
+    enu->z[i] = m[6] * dx + m[7] * dy + m[8] * dz;
+  }
+}
+
+/** NED of n ECEF points */
+void ned_of_ecef_point_array_d(struct NedCoorArray_d *ned, struct LtpDef_d *def, struct EcefCoorArray_d *ecef,
+                               uint32_t n)
+{
+  /* same arrays in ENU order, then swap and negate */
+  struct EnuCoorArray_d enu = { ned->y, ned->x, ned->z };
+  enu_of_ecef_point_array_d(&enu, def, ecef, n);
+  for (uint32_t i = 0; i < n; i++) {
+    ned->z[i] = -ned->z[i];
+  }
+}
+
+/**
+ * ENU of n LLA points.
+ * ECEF and ENU are computed in the same pass without intermediate arrays,
+ * using the precomputed origin and rotation of the local frame.
+ */
+void enu_of_lla_point_array_d(struct EnuCoorArray_d *enu, struct LtpDef_d *def, struct LlaCoorArray_d *lla,
+                              uint32_t n)
+{
+  const double a = 6378137.0;           /* earth semimajor axis in meters */
+  const double f = 1. / 298.257223563;  /* reciprocal flattening          */
+  const double e2 = 2.*f - (f * f);     /* first eccentricity squared     */
+  const double *m = def->ltp_of_ecef.m;
+  const double x0 = def->ecef.x, y0 = def->ecef.y, z0 = def->ecef.z;
+
+  for (uint32_t i = 0; i < n; i++) {
+    const double sin_lat = sin(lla->lat[i]);
+    const double cos_lat = cos(lla->lat[i]);
+    const double sin_lon = sin(lla->lon[i]);
+    const double cos_lon = cos(lla->lon[i]);
+    const double a_chi = a / sqrt(1. - e2 * sin_lat * sin_lat);
+    const double r = (a_chi + lla->alt[i]) * cos_lat;
+    const double dx = r * cos_lon - x0;
+    const double dy = r * sin_lon - y0;
+    const double dz = (a_chi * (1. - e2) + lla->alt[i]) * sin_lat - z0;
+    enu->x[i] = m[0] * dx + m[1] * dy + m[2] * dz;
+    enu->y[i] = m[3] * dx + m[4] * dy + m[5] * dz;
+    enu->z[i] = m[6] * dx + m[7] * dy + m[8] * dz;
+  }
+}
+
+/** NED of n LLA points, see enu_of_lla_point_array_d() */
+void ned_of_lla_point_array_d(struct NedCoorArray_d *ned, struct LtpDef_d *def, struct LlaCoorArray_d *lla,
+                              uint32_t n)
+{
+  struct EnuCoorArray_d enu = { ned->y, ned->x, ned->z };
+  enu_of_lla_point_array_d(&enu, def, lla, n);
+  for (uint32_t i = 0; i < n; i++) {
+    ned->z[i] = -ned->z[i];
+  }
+}
+
+
 /* geocentric latitude of geodetic latitude */
 double gc_of_gd_lat_d(double gd_lat, double hmsl)
 {
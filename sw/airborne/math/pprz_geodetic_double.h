@@ -101,6 +101,42 @@ struct LtpDef_d {
   double hmsl; ///< height in meters above mean sea level
 };
 
+/**
+ * @brief arrays of points in EarthCenteredEarthFixed coordinates
+ * @details Struct of arrays for the batch conversions, units: meters */
+struct EcefCoorArray_d {
+  double *x;
+  double *y;
+  double *z;
+};
+
+/**
+ * @brief arrays of points in Latitude, Longitude and Altitude
+ * @details Struct of arrays for the batch conversions, units: radians and meters */
+struct LlaCoorArray_d {
+  double *lat;
+  double *lon;
+  double *alt;
+};
+
+/**
+ * @brief arrays of points in local North East Down coordinates
+ * @details Struct of arrays for the batch conversions, units: meters */
+struct NedCoorArray_d {
+  double *x;
+  double *y;
+  double *z;
+};
+
+/**
+ * @brief arrays of points in local East North Up coordinates
+ * @details Struct of arrays for the batch conversions, units: meters */
+struct EnuCoorArray_d {
+  double *x;
+  double *y;
+  double *z;
+};
+
 extern void lla_of_utm_d(struct LlaCoor_d *out, struct UtmCoor_d *in);
 extern void ltp_def_from_ecef_d(struct LtpDef_d *def, struct EcefCoor_d *ecef);
 extern void lla_of_ecef_d(struct LlaCoor_d *out, struct EcefCoor_d *in);
@@ -123,6 +159,18 @@ extern void ned_of_lla_point_d(struct NedCoor_d *ned, struct LtpDef_d *def, stru
 
 extern double gc_of_gd_lat_d(double gd_lat, double hmsl);
 
+/* batch conversions of n points */
+extern void lla_of_ecef_array_d(struct LlaCoorArray_d *lla, struct EcefCoorArray_d *ecef, uint32_t n);
+extern void ecef_of_lla_array_d(struct EcefCoorArray_d *ecef, struct LlaCoorArray_d *lla, uint32_t n);
+extern void enu_of_ecef_point_array_d(struct EnuCoorArray_d *enu, struct LtpDef_d *def, struct EcefCoorArray_d *ecef,
+                                      uint32_t n);
+extern void ned_of_ecef_point_array_d(struct NedCoorArray_d *ned, struct LtpDef_d *def, struct EcefCoorArray_d *ecef,
+                                      uint32_t n);
+extern void enu_of_lla_point_array_d(struct EnuCoorArray_d *enu, struct LtpDef_d *def, struct LlaCoorArray_d *lla,
+                                     uint32_t n);
+extern void ned_of_lla_point_array_d(struct NedCoorArray_d *ned, struct LtpDef_d *def, struct LlaCoorArray_d *lla,
+                                     uint32_t n);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
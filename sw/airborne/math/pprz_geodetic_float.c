@@ -260,6 +260,59 @@ void ecef_of_lla_f(struct EcefCoor_f *out, struct LlaCoor_f *in)
 }
 
 
+/*
+ * Batch conversions on struct of arrays.
+ * The constants and the local frame are only loaded once and the loops
+ * have no function calls besides libm, so they can be vectorized.
+ */
+
+/** ECEF of n LLA points */
+void ecef_of_lla_array_f(struct EcefCoorArray_f *ecef, struct LlaCoorArray_f *lla, uint32_t n)
+{
+  const float a = 6378137.0;           /* earth semimajor axis in meters */
+  const float f = 1. / 298.257223563;  /* reciprocal flattening          */
+  const float e2 = 2.*f - (f * f);     /* first eccentricity squared     */
+
+  for (uint32_t i = 0; i < n; i++) {
+    const float sin_lat = sinf(lla->lat[i]);
+    const float cos_lat = cosf(lla->lat[i]);
+    const float sin_lon = sinf(lla->lon[i]);
+    const float cos_lon = cosf(lla->lon[i]);
+    const float a_chi = a / sqrtf(1.f - e2 * sin_lat * sin_lat);
+    const float r = (a_chi + lla->alt[i]) * cos_lat;
+    ecef->x[i] = r * cos_lon;
+    ecef->y[i] = r * sin_lon;
+    ecef->z[i] = (a_chi * (1.f - e2) + lla->alt[i]) * sin_lat;
+  }
+}
+
+/** ENU of n ECEF points */
+void enu_of_ecef_point_array_f(struct EnuCoorArray_f *enu, struct LtpDef_f *def, struct EcefCoorArray_f *ecef,
+                               uint32_t n)
+{
+  const float *m = def->ltp_of_ecef.m;
+  const float x0 = def->ecef.x, y0 = def->ecef.y, z0 = def->ecef.z;
+  for (uint32_t i = 0; i < n; i++) {
+    const float dx = ecef->x[i] - x0;
+    const float dy = ecef->y[i] - y0;
+    const float dz = ecef->z[i] - z0;
+    enu->x[i] = m[0] * dx + m[1] * dy + m[2] * dz;
+    enu->y[i] = m[3] * dx + m[4] * dy + m[5] * dz;
+    enu->z[i] = m[6] * dx + m[7] * dy + m[8] * dz;
+  }
+}
+
+/** NED of n ECEF points */
+void ned_of_ecef_point_array_f(struct NedCoorArray_f *ned, struct LtpDef_f *def, struct EcefCoorArray_f *ecef,
+                               uint32_t n)
+{
+  /* same arrays in ENU order, then swap and negate */
+  struct EnuCoorArray_f enu = { ned->y, ned->x, ned->z };
+  enu_of_ecef_point_array_f(&enu, def, ecef, n);
+  for (uint32_t i = 0; i < n; i++) {
+    ned->z[i] = -ned->z[i];
+  }
+}
 
 
 #include "math/pprz_geodetic_utm.h"
@@ -352,3 +405,36 @@ void lla_of_utm_f(struct LlaCoor_f *lla, struct UtmCoor_f *utm)
   // copy alt above reference ellipsoid
   lla->alt = utm->alt;
 }
+
+/**
+ * UTM of n LLA points in the zone of utm.
+ * Same projection as utm_of_lla_f(), with sinh/cosh from a single exp
+ * and the isometric latitude of asin(t) computed as atanh(t).
+ */
+void utm_of_lla_array_f(struct UtmCoorArray_f *utm, struct LlaCoorArray_f *lla, uint32_t n)
+{
+  const float lambda_c = LambdaOfUtmZone(utm->zone);
+  for (uint32_t i = 0; i < n; i++) {
+    float ll = isometric_latitude_f(lla->lat[i], E);
+    float dl = lla->lon[i] - lambda_c;
+    float exp_ll = exp(ll);
+    float cosh_ll = (exp_ll + 1 / exp_ll) / 2;
+    float sinh_ll = (exp_ll - 1 / exp_ll) / 2;
+    float ll_ = atanh(sin(dl) / cosh_ll);
+    float lambda_ = atan(sinh_ll / cos(dl));
+    struct complex z_ = { lambda_,  ll_ };
+    CScal(serie_coeff_proj_mercator[0], z_);
+    uint8_t k;
+    for (k = 1; k < 3; k++) {
+      struct complex z = { lambda_,  ll_ };
+      CScal(2 * k, z);
+      CSin(z);
+      CScal(serie_coeff_proj_mercator[k], z);
+      CAdd(z, z_);
+    }
+    CScal(N, z_);
+    utm->east[i] = DELTA_EAST + z_.im;
+    utm->north[i] = DELTA_NORTH + z_.re;
+    utm->alt[i] = lla->alt[i];
+  }
+}
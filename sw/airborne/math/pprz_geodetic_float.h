@@ -97,6 +97,53 @@ struct LtpDef_f {
   float hmsl; ///< Height above mean sea level in meters
 };
 
+/**
+ * @brief arrays of points in EarthCenteredEarthFixed coordinates
+ * @details Struct of arrays for the batch conversions, units: meters */
+struct EcefCoorArray_f {
+  float *x;
+  float *y;
+  float *z;
+};
+
+/**
+ * @brief arrays of points in Latitude, Longitude and Altitude
+ * @details Struct of arrays for the batch conversions, units: radians and meters */
+struct LlaCoorArray_f {
+  float *lat;
+  float *lon;
+  float *alt;
+};
+
+/**
+ * @brief arrays of points in local North East Down coordinates
+ * @details Struct of arrays for the batch conversions, units: meters */
+struct NedCoorArray_f {
+  float *x;
+  float *y;
+  float *z;
+};
+
+/**
+ * @brief arrays of points in local East North Up coordinates
+ * @details Struct of arrays for the batch conversions, units: meters */
+struct EnuCoorArray_f {
+  float *x;
+  float *y;
+  float *z;
+};
+
+/**
+ * @brief arrays of points in UTM coordinates
+ * @details Struct of arrays for the batch conversions, units: meters.
+ * All points are in the same zone. */
+struct UtmCoorArray_f {
+  float *north;
+  float *east;
+  float *alt;
+  uint8_t zone;
+};
+
 extern void lla_of_utm_f(struct LlaCoor_f *lla, struct UtmCoor_f *utm);
 extern void utm_of_lla_f(struct UtmCoor_f *utm, struct LlaCoor_f *lla);
 extern void ltp_def_from_ecef_f(struct LtpDef_f *def, struct EcefCoor_f *ecef);
@@ -117,6 +164,14 @@ extern void ecef_of_enu_vect_f(struct EcefCoor_f *ecef, struct LtpDef_f *def, st
 extern void ecef_of_ned_vect_f(struct EcefCoor_f *ecef, struct LtpDef_f *def, struct NedCoor_f *ned);
 /* end use double versions */
 
+/* batch conversions of n points */
+extern void ecef_of_lla_array_f(struct EcefCoorArray_f *ecef, struct LlaCoorArray_f *lla, uint32_t n);
+extern void enu_of_ecef_point_array_f(struct EnuCoorArray_f *enu, struct LtpDef_f *def, struct EcefCoorArray_f *ecef,
+                                      uint32_t n);
+extern void ned_of_ecef_point_array_f(struct NedCoorArray_f *ned, struct LtpDef_f *def, struct EcefCoorArray_f *ecef,
+                                      uint32_t n);
+extern void utm_of_lla_array_f(struct UtmCoorArray_f *utm, struct LlaCoorArray_f *lla, uint32_t n);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
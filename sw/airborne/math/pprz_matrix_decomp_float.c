@@ -465,3 +465,439 @@ void pprz_svd_solve_float(float **x, float **u, float *w, float **v, float **b,
   }
 }
 
+
+/*
+ * Fixed size decompositions
+ *
+ * The cores below work on contiguous row major matrices with n columns. They
+ * are always inlined in the functions generated for each size, so n is a
+ * compile time constant there: the temporaries are fixed size arrays and the
+ * compiler can unroll the inner loops.
+ */
+
+#define DECOMP_INLINE static inline __attribute__((always_inline))
+
+DECOMP_INLINE void cholesky_core(float *out, float *in, const int n)
+{
+  int i, j, k;
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < (i + 1); j++) {
+      float s = 0;
+      for (k = 0; k < j; k++) {
+        s += out[i * n + k] * out[j * n + k];
+      }
+      // in[i][j] is read before out[i][j] is written, so in and out may be the same
+      out[i * n + j] = (i == j) ?
+                       sqrtf(in[i * n + i] - s) :
+                       (1.0 / out[j * n + j] * (in[i * n + j] - s));
+    }
+    for (j = i + 1; j < n; j++) {
+      out[i * n + j] = 0;
+    }
+  }
+}
+
+DECOMP_INLINE void qr_core(float *Q, float *R, float *in, float *e, float *d, const int n)
+{
+  int i, j, k;
+
+  // R is transformed in place, Q accumulates the Householder reflections
+  for (i = 0; i < n; i++) {
+    d[i] = in[i * n + i];
+  }
+  if (R != in) {
+    memcpy(R, in, sizeof(float) * n * n);
+  }
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < n; j++) {
+      Q[i * n + j] = (i == j) ? 1 : 0;
+    }
+  }
+
+  for (k = 0; k < n - 1; k++) {
+    // reflection of column k below the diagonal, with the same sign choice
+    // as pprz_qr_float (sign of the input matrix diagonal d)
+    float a = 0, b = 0;
+    for (i = k; i < n; i++) {
+      a += R[i * n + k] * R[i * n + k];
+    }
+    a = sqrtf(a);
+    if (d[k] > 0) { a = -a; }
+    for (i = k; i < n; i++) {
+      e[i] = R[i * n + k];
+    }
+    e[k] += a;
+    for (i = k; i < n; i++) {
+      b += e[i] * e[i];
+    }
+    if (b == 0) {
+      continue;
+    }
+    b = sqrtf(b);
+    for (i = k; i < n; i++) {
+      e[i] /= b;
+    }
+
+    // R = (I - 2 e eT) R
+    for (j = k; j < n; j++) {
+      float s = 0;
+      for (i = k; i < n; i++) {
+        s += e[i] * R[i * n + j];
+      }
+      s *= 2;
+      for (i = k; i < n; i++) {
+        R[i * n + j] -= s * e[i];
+      }
+    }
+    // Q = Q (I - 2 e eT)
+    for (i = 0; i < n; i++) {
+      float s = 0;
+      for (j = k; j < n; j++) {
+        s += Q[i * n + j] * e[j];
+      }
+      s *= 2;
+      for (j = k; j < n; j++) {
+        Q[i * n + j] -= s * e[j];
+      }
+    }
+  }
+
+  for (i = 1; i < n; i++) {
+    for (j = 0; j < i; j++) {
+      R[i * n + j] = 0;
+    }
+  }
+}
+
+#define A(_i, _j) a[(_i) * n + (_j)]
+#define V(_i, _j) v[(_i) * n + (_j)]
+
+DECOMP_INLINE int svd_core(float *a, float *w, float *v, float *rv1, int m, const int n)
+{
+  /* Householder reduction to bidiagonal form. */
+  int flag, i, its, j, jj, k, l = 0, NM = 0;
+  float C, F, H, S, X, Y, Z, tmp;
+  float G = 0.0;
+  float Scale = 0.0;
+  float ANorm = 0.0;
+
+  for (i = 0; i < n; ++i) {
+    l = i + 1;
+    rv1[i] = Scale * G;
+    G = 0.0;
+    S = 0.0;
+    Scale = 0.0;
+    if (i < m) {
+      for (k = i; k < m; ++k) {
+        Scale = Scale + fabsf(A(k, i));
+      }
+      if (Scale != 0.0) {
+        for (k = i; k < m; ++k) {
+          A(k, i) = A(k, i) / Scale;
+          S = S + A(k, i) * A(k, i);
+        }
+        F = A(i, i);
+        G = sqrtf(S);
+        if (F > 0.0) {
+          G = -G;
+        }
+        H = F * G - S;
+        A(i, i) = F - G;
+        if (i != (n - 1)) {
+          for (j = l; j < n; ++j) {
+            S = 0.0;
+            for (k = i; k < m; ++k) {
+              S = S + A(k, i) * A(k, j);
+            }
+            F = S / H;
+            for (k = i; k < m; ++k) {
+              A(k, j) = A(k, j) + F * A(k, i);
+            }
+          }
+        }
+        for (k = i; k < m; ++k) {
+          A(k, i) = Scale * A(k, i);
+        }
+      }
+    }
+
+    w[i] = Scale * G;
+    G = 0.0;
+    S = 0.0;
+    Scale = 0.0;
+    if ((i < m) && (i != (n - 1))) {
+      for (k = l; k < n; ++k) {
+        Scale = Scale + fabsf(A(i, k));
+      }
+      if (Scale != 0.0) {
+        for (k = l; k < n; ++k) {
+          A(i, k) = A(i, k) / Scale;
+          S = S + A(i, k) * A(i, k);
+        }
+        F = A(i, l);
+        G = sqrtf(S);
+        if (F > 0.0) {
+          G = -G;
+        }
+        H = F * G - S;
+        A(i, l) = F - G;
+        for (k = l; k < n; ++k) {
+          rv1[k] = A(i, k) / H;
+        }
+        if (i != (m - 1)) {
+          for (j = l; j < m; ++j) {
+            S = 0.0;
+            for (k = l; k < n; ++k) {
+              S = S + A(j, k) * A(i, k);
+            }
+            for (k = l; k < n; ++k) {
+              A(j, k) = A(j, k) + S * rv1[k];
+            }
+          }
+        }
+        for (k = l; k < n; ++k) {
+          A(i, k) = Scale * A(i, k);
+        }
+      }
+    }
+    tmp = fabsf(w[i]) + fabsf(rv1[i]);
+    if (tmp > ANorm) {
+      ANorm = tmp;
+    }
+  }
+
+  /* Accumulation of right-hand transformations. */
+  for (i = n - 1; i >= 0; --i) {
+    if (i < (n - 1)) {
+      if (G != 0.0) {
+        for (j = l; j < n; ++j) {
+          V(j, i) = (A(i, j) / A(i, l)) / G;
+        }
+        for (j = l; j < n; ++j) {
+          S = 0.0;
+          for (k = l; k < n; ++k) {
+            S = S + A(i, k) * V(k, j);
+          }
+          for (k = l; k < n; ++k) {
+            V(k, j) = V(k, j) + S * V(k, i);
+          }
+        }
+      }
+      for (j = l; j < n; ++j) {
+        V(i, j) = 0.0;
+        V(j, i) = 0.0;
+      }
+    }
+    V(i, i) = 1.0;
+    G = rv1[i];
+    l = i;
+  }
+
+  /* Accumulation of left-hand transformations. */
+  for (i = n - 1; i >= 0; --i) {
+    l = i + 1;
+    G = w[i];
+    if (i < (n - 1)) {
+      for (j = l; j < n; ++j) {
+        A(i, j) = 0.0;
+      }
+    }
+    if (G != 0.0) {
+      G = 1.0 / G;
+      if (i != (n - 1)) {
+        for (j = l; j < n; ++j) {
+          S = 0.0;
+          for (k = l; k < m; ++k) {
+            S = S + A(k, i) * A(k, j);
+          }
+          F = (S / A(i, i)) * G;
+          for (k = i; k < m; ++k) {
+            A(k, j) = A(k, j) + F * A(k, i);
+          }
+        }
+      }
+      for (j = i; j < m; ++j) {
+        A(j, i) = A(j, i) * G;
+      }
+    } else {
+      for (j = i; j < m; ++j) {
+        A(j, i) = 0.0;
+      }
+    }
+    A(i, i) = A(i, i) + 1.0;
+  }
+
+  /* Diagonalization of the bidiagonal form.
+     Loop over singular values. */
+  for (k = (n - 1); k >= 0; --k) {
+    /* Loop over allowed iterations. */
+    for (its = 1; its <= 30; ++its) {
+      /* Test for splitting.
+         Note that rv1[0] is always zero. */
+      flag = true;
+      for (l = k; l >= 0; --l) {
+        NM = l - 1;
+        if ((fabsf(rv1[l]) + ANorm) == ANorm) {
+          flag = false;
+          break;
+        } else if ((fabsf(w[NM]) + ANorm) == ANorm) {
+          break;
+        }
+      }
+
+      /* Cancellation of rv1[l], if l > 0; */
+      if (flag) {
+        C = 0.0;
+        S = 1.0;
+        for (i = l; i <= k; ++i) {
+          F = S * rv1[i];
+          if ((fabsf(F) + ANorm) != ANorm) {
+            G = w[i];
+            H = pythag(F, G);
+            w[i] = H;
+            H = 1.0 / H;
+            C = (G * H);
+            S = -(F * H);
+            for (j = 0; j < m; ++j) {
+              Y = A(j, NM);
+              Z = A(j, i);
+              A(j, NM) = (Y * C) + (Z * S);
+              A(j, i) = -(Y * S) + (Z * C);
+            }
+          }
+        }
+      }
+      Z = w[k];
+      /* Convergence. */
+      if (l == k) {
+        /* Singular value is made nonnegative. */
+        if (Z < 0.0) {
+          w[k] = -Z;
+          for (j = 0; j < n; ++j) {
+            V(j, k) = -V(j, k);
+          }
+        }
+        break;
+      }
+
+      if (its >= 30) {
+        // No convergence in 30 iterations
+        return 0;
+      }
+
+      X = w[l];
+      NM = k - 1;
+      Y = w[NM];
+      G = rv1[NM];
+      H = rv1[k];
+      F = ((Y - Z) * (Y + Z) + (G - H) * (G + H)) / (2.0 * H * Y);
+      G = pythag(F, 1.0);
+      tmp = G;
+      if (F < 0.0) {
+        tmp = -tmp;
+      }
+      F = ((X - Z) * (X + Z) + H * ((Y / (F + tmp)) - H)) / X;
+
+      /* Next QR transformation. */
+      C = 1.0;
+      S = 1.0;
+      for (j = l; j <= NM; ++j) {
+        i = j + 1;
+        G = rv1[i];
+        Y = w[i];
+        H = S * G;
+        G = C * G;
+        Z = pythag(F, H);
+        rv1[j] = Z;
+        C = F / Z;
+        S = H / Z;
+        F = (X * C) + (G * S);
+        G = -(X * S) + (G * C);
+        H = Y * S;
+        Y = Y * C;
+        for (jj = 0; jj < n; ++jj) {
+          X = V(jj, j);
+          Z = V(jj, i);
+          V(jj, j) = (X * C) + (Z * S);
+          V(jj, i) = -(X * S) + (Z * C);
+        }
+        Z = pythag(F, H);
+        w[j] = Z;
+
+        /* Rotation can be arbitrary if Z = 0. */
+        if (Z != 0.0) {
+          Z = 1.0 / Z;
+          C = F * Z;
+          S = H * Z;
+        }
+        F = (C * G) + (S * Y);
+        X = -(S * G) + (C * Y);
+        for (jj = 0; jj < m; ++jj) {
+          Y = A(jj, j);
+          Z = A(jj, i);
+          A(jj, j) = (Y * C) + (Z * S);
+          A(jj, i) = -(Y * S) + (Z * C);
+        }
+      }
+      rv1[l] = 0.0;
+      rv1[k] = F;
+      w[k] = X;
+    }
+  }
+
+  return 1;
+}
+
+DECOMP_INLINE void svd_solve_core(float *x, float *u, float *w, float *v, float *b, float *tmp, int m, const int n)
+{
+  int i, j, jj;
+  float s;
+  for (j = 0; j < n; j++) { //Calculate UTB
+    s = 0.0;
+    if (w[j] != 0.0) {   //Nonzero result only if wj is nonzero
+      for (i = 0; i < m; i++) { s += u[i * n + j] * b[i]; }
+      s /= w[j];         //This is the divide by wj
+    }
+    tmp[j] = s;
+  }
+  for (j = 0; j < n; j++) { //Matrix multiply by V to get answer
+    s = 0.0;
+    for (jj = 0; jj < n; jj++) { s += V(j, jj) * tmp[jj]; }
+    x[j] = s;
+  }
+}
+
+#undef A
+#undef V
+
+#define PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(_n) \
+  void pprz_cholesky_float_##_n(float out[_n][_n], float in[_n][_n]) \
+  { \
+    cholesky_core(&out[0][0], &in[0][0], _n); \
+  } \
+  void pprz_qr_float_##_n(float Q[_n][_n], float R[_n][_n], float in[_n][_n]) \
+  { \
+    float e[_n], d[_n]; \
+    qr_core(&Q[0][0], &R[0][0], &in[0][0], e, d, _n); \
+  } \
+  int pprz_svd_float_##_n(float a[][_n], float w[_n], float v[_n][_n], int m) \
+  { \
+    float rv1[_n]; \
+    return svd_core(&a[0][0], w, &v[0][0], rv1, m, _n); \
+  } \
+  void pprz_svd_solve_float_##_n(float x[_n], float u[][_n], float w[_n], float v[_n][_n], float *b, int m) \
+  { \
+    float tmp[_n]; \
+    svd_solve_core(x, &u[0][0], w, &v[0][0], b, tmp, m, _n); \
+  }
+
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(3)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(4)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(5)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(6)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(7)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(8)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(9)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(10)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(11)
+PPRZ_MATRIX_DECOMP_FLOAT_DEFINE(12)
@@ -103,6 +103,39 @@ int pprz_svd_float(float **a, float *w, float **v, int m, int n);
  */
 void pprz_svd_solve_float(float **x, float **u, float *w, float **v, float **b, int m, int n, int l);
 
+/** Fixed size decompositions
+ *
+ * The same algorithms on contiguous matrices with a compile time size,
+ * for instance for 4 columns:
+ *
+ *   void pprz_cholesky_float_4(float out[4][4], float in[4][4]);
+ *   void pprz_qr_float_4(float Q[4][4], float R[4][4], float in[4][4]);
+ *   int pprz_svd_float_4(float a[][4], float w[4], float v[4][4], int m);
+ *   void pprz_svd_solve_float_4(float x[4], float u[][4], float w[4], float v[4][4], float *b, int m);
+ *
+ * They do not need row pointer tables nor variable length arrays and their
+ * loops are specialized for the size. Sizes from 3 to 12 are available.
+ * The SVD and its solver take a [m x n] matrix (m >= n) and a single right-hand
+ * side column b[m]. The output of the Cholesky and QR decompositions may be
+ * their input (in place decomposition).
+ */
+#define PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(_n) \
+  extern void pprz_cholesky_float_##_n(float out[_n][_n], float in[_n][_n]); \
+  extern void pprz_qr_float_##_n(float Q[_n][_n], float R[_n][_n], float in[_n][_n]); \
+  extern int pprz_svd_float_##_n(float a[][_n], float w[_n], float v[_n][_n], int m); \
+  extern void pprz_svd_solve_float_##_n(float x[_n], float u[][_n], float w[_n], float v[_n][_n], float *b, int m);
+
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(3)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(4)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(5)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(6)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(7)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(8)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(9)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(10)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(11)
+PPRZ_MATRIX_DECOMP_FLOAT_DECLARE(12)
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -101,6 +101,29 @@ void pprz_polyfit_float(float *x, float *y, int n, int p, float *c)
   }
   // Solve linear system XtX.c = T after performing a SVD decomposition of XtX
   // which is probably a bit overkill but looks really cool
+  // (with the fixed size decomposition when there is one for this degree)
+  switch (p + 1) {
+#define POLYFIT_SOLVE_FIXED(_n) \
+    case _n: { \
+      float w[_n], v[_n][_n]; \
+      pprz_svd_float_##_n((float (*)[_n])&_XtX[0][0], w, v, _n); \
+      pprz_svd_solve_float_##_n(c, (float (*)[_n])&_XtX[0][0], w, v, &_T[0][0], _n); \
+      return; \
+    }
+    POLYFIT_SOLVE_FIXED(3)
+    POLYFIT_SOLVE_FIXED(4)
+    POLYFIT_SOLVE_FIXED(5)
+    POLYFIT_SOLVE_FIXED(6)
+    POLYFIT_SOLVE_FIXED(7)
+    POLYFIT_SOLVE_FIXED(8)
+    POLYFIT_SOLVE_FIXED(9)
+    POLYFIT_SOLVE_FIXED(10)
+    POLYFIT_SOLVE_FIXED(11)
+    POLYFIT_SOLVE_FIXED(12)
+#undef POLYFIT_SOLVE_FIXED
+    default:
+      break;
+  }
   float w[p + 1], _v[p + 1][p + 1];
   MAKE_MATRIX_PTR(v, _v, p + 1);
   pprz_svd_float(XtX, w, v, p + 1, p + 1);
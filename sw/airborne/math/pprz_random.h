@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file pprz_random.h
+ * @brief Small reentrant pseudo random number generator (xorshift32).
+ *
+ * Unlike rand(), the state is owned by the caller, so every thread or
+ * algorithm can have its own generator and replaying the same input with
+ * the same seed gives the same random sequence.
+ * Not suitable for anything related to security.
+ */
+
+#ifndef PPRZ_RANDOM_H
+#define PPRZ_RANDOM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "std.h"
+
+/** State of a random number generator */
+struct pprz_rand_t {
+  uint32_t state;   ///< Current state, never 0
+};
+
+/** Seed a random number generator
+ *  @param rng pointer to the generator
+ *  @param seed the seed, 0 is replaced by a fixed non zero value
+ */
+static inline void pprz_rand_seed(struct pprz_rand_t *rng, uint32_t seed)
+{
+  rng->state = (seed != 0) ? seed : 0x9E3779B9;
+}
+
+/** Get the next 32 bits random value
+ *  @param rng pointer to the generator
+ *  @return random value
+ */
+static inline uint32_t pprz_rand_u32(struct pprz_rand_t *rng)
+{
+  uint32_t x = rng->state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rng->state = x;
+  return x;
+}
+
+/** Get a random value in a range
+ *  @param rng pointer to the generator
+ *  @param n size of the range, must be >0
+ *  @return random value between 0 and n-1
+ */
+static inline uint32_t pprz_rand_range(struct pprz_rand_t *rng, uint32_t n)
+{
+  return (uint32_t)(((uint64_t)pprz_rand_u32(rng) * n) >> 32);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PPRZ_RANDOM_H */
@@ -26,7 +26,9 @@
 
 #include "pprz_trig_int.h"
 #include "pprz_algebra_int.h"
+#include <math.h>
 
+#if PPRZ_TRIG_INT_FULL_TABLE
 PPRZ_TRIG_CONST int16_t pprz_trig_int[6434] = {    0,
                                                    3,     7,    11,    15,    19,    23,    27,    31,    35,    39,    43,    47,    51,    55,    59,    63,
                                                    67,    71,    75,    79,    83,    87,    91,    95,    99,   103,   107,   111,   115,   119,   123,   127,
@@ -434,26 +436,231 @@ PPRZ_TRIG_CONST int16_t pprz_trig_int[6434] = {    0,
                                               };
 
 
-int32_t pprz_itrig_sin(int32_t angle)
+#endif
+
+/** Quarter sine table, sin(i * pi / 2 / PPRZ_TRIG_INTERP_SIZE) in Q15 */
+#define PPRZ_TRIG_INTERP_SIZE (1 << PPRZ_TRIG_INTERP_BITS)
+#if PPRZ_TRIG_INTERP_BITS == 6
+static const uint16_t pprz_trig_interp[65] = {
+      0,   804,  1608,  2411,  3212,  4011,  4808,  5602,  6393,  7180,  7962,  8740,  9512, 10279, 11039, 11793,
+  12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531, 18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+  23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791, 27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+  30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972, 32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+  32768
+};
+#elif PPRZ_TRIG_INTERP_BITS == 8
+static const uint16_t pprz_trig_interp[257] = {
+      0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,  2009,  2210,  2411,  2611,  2811,  3012,
+   3212,  3412,  3612,  3812,  4011,  4211,  4410,  4609,  4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,
+   6393,  6590,  6787,  6983,  7180,  7376,  7571,  7767,  7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,
+   9512,  9704,  9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605, 11793, 11980, 12167, 12354,
+  12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828, 14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+  15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+  18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001, 20160, 20318, 20475, 20632,
+  20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856, 22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028,
+  23170, 23312, 23453, 23593, 23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+  25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+  27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002, 28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803,
+  28899, 28993, 29086, 29178, 29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+  30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298,
+  31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737, 31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099,
+  32138, 32177, 32214, 32251, 32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+  32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753, 32758, 32762, 32766, 32767,
+  32768
+};
+#elif PPRZ_TRIG_INTERP_BITS == 10
+static const uint16_t pprz_trig_interp[1025] = {
+      0,    50,   101,   151,   201,   251,   302,   352,   402,   452,   503,   553,   603,   653,   704,   754,
+    804,   854,   905,   955,  1005,  1055,  1106,  1156,  1206,  1256,  1307,  1357,  1407,  1457,  1507,  1558,
+   1608,  1658,  1708,  1758,  1809,  1859,  1909,  1959,  2009,  2060,  2110,  2160,  2210,  2260,  2310,  2360,
+   2411,  2461,  2511,  2561,  2611,  2661,  2711,  2761,  2811,  2861,  2912,  2962,  3012,  3062,  3112,  3162,
+   3212,  3262,  3312,  3362,  3412,  3462,  3512,  3562,  3612,  3662,  3712,  3762,  3812,  3861,  3911,  3961,
+   4011,  4061,  4111,  4161,  4211,  4260,  4310,  4360,  4410,  4460,  4510,  4559,  4609,  4659,  4709,  4758,
+   4808,  4858,  4907,  4957,  5007,  5057,  5106,  5156,  5205,  5255,  5305,  5354,  5404,  5453,  5503,  5553,
+   5602,  5652,  5701,  5751,  5800,  5850,  5899,  5948,  5998,  6047,  6097,  6146,  6195,  6245,  6294,  6343,
+   6393,  6442,  6491,  6541,  6590,  6639,  6688,  6737,  6787,  6836,  6885,  6934,  6983,  7032,  7081,  7130,
+   7180,  7229,  7278,  7327,  7376,  7425,  7473,  7522,  7571,  7620,  7669,  7718,  7767,  7816,  7864,  7913,
+   7962,  8011,  8059,  8108,  8157,  8206,  8254,  8303,  8351,  8400,  8449,  8497,  8546,  8594,  8643,  8691,
+   8740,  8788,  8836,  8885,  8933,  8982,  9030,  9078,  9127,  9175,  9223,  9271,  9319,  9368,  9416,  9464,
+   9512,  9560,  9608,  9656,  9704,  9752,  9800,  9848,  9896,  9944,  9992, 10040, 10088, 10135, 10183, 10231,
+  10279, 10326, 10374, 10422, 10469, 10517, 10565, 10612, 10660, 10707, 10755, 10802, 10850, 10897, 10945, 10992,
+  11039, 11087, 11134, 11181, 11228, 11276, 11323, 11370, 11417, 11464, 11511, 11558, 11605, 11652, 11699, 11746,
+  11793, 11840, 11887, 11934, 11980, 12027, 12074, 12121, 12167, 12214, 12261, 12307, 12354, 12400, 12447, 12493,
+  12540, 12586, 12633, 12679, 12725, 12772, 12818, 12864, 12910, 12957, 13003, 13049, 13095, 13141, 13187, 13233,
+  13279, 13325, 13371, 13417, 13463, 13508, 13554, 13600, 13646, 13691, 13737, 13783, 13828, 13874, 13919, 13965,
+  14010, 14056, 14101, 14146, 14192, 14237, 14282, 14327, 14373, 14418, 14463, 14508, 14553, 14598, 14643, 14688,
+  14733, 14778, 14823, 14867, 14912, 14957, 15002, 15046, 15091, 15136, 15180, 15225, 15269, 15314, 15358, 15402,
+  15447, 15491, 15535, 15580, 15624, 15668, 15712, 15756, 15800, 15844, 15888, 15932, 15976, 16020, 16064, 16108,
+  16151, 16195, 16239, 16282, 16326, 16369, 16413, 16456, 16500, 16543, 16587, 16630, 16673, 16717, 16760, 16803,
+  16846, 16889, 16932, 16975, 17018, 17061, 17104, 17147, 17190, 17233, 17275, 17318, 17361, 17403, 17446, 17488,
+  17531, 17573, 17616, 17658, 17700, 17743, 17785, 17827, 17869, 17911, 17953, 17995, 18037, 18079, 18121, 18163,
+  18205, 18247, 18288, 18330, 18372, 18413, 18455, 18496, 18538, 18579, 18621, 18662, 18703, 18745, 18786, 18827,
+  18868, 18909, 18950, 18991, 19032, 19073, 19114, 19155, 19195, 19236, 19277, 19317, 19358, 19399, 19439, 19479,
+  19520, 19560, 19601, 19641, 19681, 19721, 19761, 19801, 19841, 19881, 19921, 19961, 20001, 20041, 20081, 20120,
+  20160, 20200, 20239, 20279, 20318, 20357, 20397, 20436, 20475, 20515, 20554, 20593, 20632, 20671, 20710, 20749,
+  20788, 20827, 20865, 20904, 20943, 20981, 21020, 21059, 21097, 21136, 21174, 21212, 21251, 21289, 21327, 21365,
+  21403, 21441, 21479, 21517, 21555, 21593, 21631, 21668, 21706, 21744, 21781, 21819, 21856, 21894, 21931, 21968,
+  22006, 22043, 22080, 22117, 22154, 22191, 22228, 22265, 22302, 22339, 22375, 22412, 22449, 22485, 22522, 22558,
+  22595, 22631, 22668, 22704, 22740, 22776, 22812, 22848, 22884, 22920, 22956, 22992, 23028, 23064, 23099, 23135,
+  23170, 23206, 23241, 23277, 23312, 23348, 23383, 23418, 23453, 23488, 23523, 23558, 23593, 23628, 23663, 23697,
+  23732, 23767, 23801, 23836, 23870, 23905, 23939, 23973, 24008, 24042, 24076, 24110, 24144, 24178, 24212, 24246,
+  24279, 24313, 24347, 24380, 24414, 24448, 24481, 24514, 24548, 24581, 24614, 24647, 24680, 24713, 24746, 24779,
+  24812, 24845, 24878, 24910, 24943, 24976, 25008, 25041, 25073, 25105, 25138, 25170, 25202, 25234, 25266, 25298,
+  25330, 25362, 25394, 25425, 25457, 25489, 25520, 25552, 25583, 25615, 25646, 25677, 25708, 25739, 25771, 25802,
+  25833, 25863, 25894, 25925, 25956, 25986, 26017, 26048, 26078, 26108, 26139, 26169, 26199, 26229, 26259, 26290,
+  26320, 26349, 26379, 26409, 26439, 26468, 26498, 26528, 26557, 26586, 26616, 26645, 26674, 26704, 26733, 26762,
+  26791, 26820, 26848, 26877, 26906, 26935, 26963, 26992, 27020, 27049, 27077, 27105, 27133, 27162, 27190, 27218,
+  27246, 27273, 27301, 27329, 27357, 27384, 27412, 27440, 27467, 27494, 27522, 27549, 27576, 27603, 27630, 27657,
+  27684, 27711, 27738, 27765, 27791, 27818, 27844, 27871, 27897, 27924, 27950, 27976, 28002, 28028, 28054, 28080,
+  28106, 28132, 28158, 28183, 28209, 28234, 28260, 28285, 28311, 28336, 28361, 28386, 28411, 28436, 28461, 28486,
+  28511, 28536, 28560, 28585, 28610, 28634, 28658, 28683, 28707, 28731, 28755, 28779, 28803, 28827, 28851, 28875,
+  28899, 28922, 28946, 28970, 28993, 29016, 29040, 29063, 29086, 29109, 29132, 29155, 29178, 29201, 29224, 29247,
+  29269, 29292, 29314, 29337, 29359, 29381, 29404, 29426, 29448, 29470, 29492, 29514, 29535, 29557, 29579, 29600,
+  29622, 29643, 29665, 29686, 29707, 29729, 29750, 29771, 29792, 29813, 29833, 29854, 29875, 29895, 29916, 29936,
+  29957, 29977, 29997, 30018, 30038, 30058, 30078, 30098, 30118, 30137, 30157, 30177, 30196, 30216, 30235, 30254,
+  30274, 30293, 30312, 30331, 30350, 30369, 30388, 30407, 30425, 30444, 30462, 30481, 30499, 30518, 30536, 30554,
+  30572, 30590, 30608, 30626, 30644, 30662, 30680, 30697, 30715, 30732, 30750, 30767, 30784, 30801, 30819, 30836,
+  30853, 30869, 30886, 30903, 30920, 30936, 30953, 30969, 30986, 31002, 31018, 31034, 31050, 31067, 31082, 31098,
+  31114, 31130, 31146, 31161, 31177, 31192, 31207, 31223, 31238, 31253, 31268, 31283, 31298, 31313, 31328, 31342,
+  31357, 31372, 31386, 31400, 31415, 31429, 31443, 31457, 31471, 31485, 31499, 31513, 31527, 31540, 31554, 31568,
+  31581, 31594, 31608, 31621, 31634, 31647, 31660, 31673, 31686, 31699, 31711, 31724, 31737, 31749, 31761, 31774,
+  31786, 31798, 31810, 31822, 31834, 31846, 31858, 31870, 31881, 31893, 31904, 31916, 31927, 31938, 31950, 31961,
+  31972, 31983, 31994, 32005, 32015, 32026, 32037, 32047, 32058, 32068, 32078, 32088, 32099, 32109, 32119, 32129,
+  32138, 32148, 32158, 32167, 32177, 32186, 32196, 32205, 32214, 32224, 32233, 32242, 32251, 32259, 32268, 32277,
+  32286, 32294, 32303, 32311, 32319, 32328, 32336, 32344, 32352, 32360, 32368, 32376, 32383, 32391, 32398, 32406,
+  32413, 32421, 32428, 32435, 32442, 32449, 32456, 32463, 32470, 32477, 32483, 32490, 32496, 32503, 32509, 32515,
+  32522, 32528, 32534, 32540, 32546, 32551, 32557, 32563, 32568, 32574, 32579, 32585, 32590, 32595, 32600, 32605,
+  32610, 32615, 32620, 32625, 32629, 32634, 32638, 32643, 32647, 32651, 32656, 32660, 32664, 32668, 32672, 32675,
+  32679, 32683, 32686, 32690, 32693, 32697, 32700, 32703, 32706, 32709, 32712, 32715, 32718, 32721, 32723, 32726,
+  32729, 32731, 32733, 32736, 32738, 32740, 32742, 32744, 32746, 32748, 32749, 32751, 32753, 32754, 32756, 32757,
+  32758, 32759, 32760, 32761, 32762, 32763, 32764, 32765, 32766, 32766, 32767, 32767, 32767, 32768, 32768, 32768,
+  32768
+};
+#else
+#error "PPRZ_TRIG_INTERP_BITS has to be 6, 8 or 10"
+#endif
+
+/** Multiplier from an angle in [0, pi/2] with #INT32_ANGLE_FRAC
+ * to the position in the interpolation table in Q16, shifted by 4 */
+#define PPRZ_TRIG_INTERP_MUL ((uint32_t)(PPRZ_TRIG_INTERP_SIZE * 512 / M_PI + 0.5))
+
+/** sine of an angle in [0, pi/2] */
+static inline int32_t itrig_quarter(int32_t angle)
+{
+#if PPRZ_TRIG_INT_FULL_TABLE
+  return pprz_trig_int[angle];
+#else
+  const uint32_t p = ((uint32_t)angle * PPRZ_TRIG_INTERP_MUL) >> 4;
+  const uint32_t i = p >> 16;
+  if (i >= PPRZ_TRIG_INTERP_SIZE) {
+    return pprz_trig_interp[PPRZ_TRIG_INTERP_SIZE] >> 1;
+  }
+  const int32_t d = (int32_t)pprz_trig_interp[i + 1] - pprz_trig_interp[i];
+  const int32_t v = pprz_trig_interp[i] + ((d * (int32_t)(p & 0xFFFF)) >> 16);
+  return (v + 1) >> 1;
+#endif
+}
+
+/** sine of an angle in [-pi, pi] */
+static inline int32_t itrig_sin(int32_t angle)
 {
-  INT32_ANGLE_NORMALIZE(angle);
   if (angle > INT32_ANGLE_PI_2) {
     angle = INT32_ANGLE_PI - angle;
   } else if (angle < -INT32_ANGLE_PI_2) {
     angle = -INT32_ANGLE_PI - angle;
   }
   if (angle >= 0) {
-    return pprz_trig_int[angle];
+    return itrig_quarter(angle);
   } else {
-    return -pprz_trig_int[-angle];
+    return -itrig_quarter(-angle);
   }
 }
 
+int32_t pprz_itrig_sin(int32_t angle)
+{
+  INT32_ANGLE_NORMALIZE(angle);
+  return itrig_sin(angle);
+}
+
 int32_t pprz_itrig_cos(int32_t angle)
 {
   return pprz_itrig_sin(angle + INT32_ANGLE_PI_2);
 }
 
+/**
+ * Sine and cosine of the same angle.
+ * Same results as pprz_itrig_sin() and pprz_itrig_cos() with a single normalization.
+ */
+void pprz_itrig_sincos(int32_t *s, int32_t *c, int32_t angle)
+{
+  INT32_ANGLE_NORMALIZE(angle);
+  *s = itrig_sin(angle);
+  angle += INT32_ANGLE_PI_2;
+  if (angle > INT32_ANGLE_PI) {
+    angle -= INT32_ANGLE_2_PI;
+  }
+  *c = itrig_sin(angle);
+}
+
+/** Sine and cosine of n angles */
+void pprz_itrig_sincos_array(int32_t *s, int32_t *c, int32_t *angle, uint16_t n)
+{
+  for (uint16_t i = 0; i < n; i++) {
+    pprz_itrig_sincos(&s[i], &c[i], angle[i]);
+  }
+}
+
+/**
+ * Sine and cosine of a float angle (rad) from the interpolated table.
+ * Much faster than sinf/cosf without FPU double support, see #PPRZ_TRIG_INTERP_BITS for the accuracy.
+ */
+void pprz_trig_sincos_f(float *s, float *c, float angle)
+{
+  /* quadrant and position in the table */
+  const float x = angle * (float)(2. / M_PI);
+  int32_t q = (int32_t)x;
+  if (x < q) {
+    q--;
+  }
+  const float p = (x - q) * PPRZ_TRIG_INTERP_SIZE;
+  int32_t i = (int32_t)p;
+  if (i >= PPRZ_TRIG_INTERP_SIZE) {
+    i = PPRZ_TRIG_INTERP_SIZE - 1;
+  }
+  const float f = p - i;
+  const int32_t j = PPRZ_TRIG_INTERP_SIZE - i;
+  const float sa = (pprz_trig_interp[i] + f * ((int32_t)pprz_trig_interp[i + 1] - pprz_trig_interp[i])) *
+                   (1.f / 32768.f);
+  const float ca = (pprz_trig_interp[j] + f * ((int32_t)pprz_trig_interp[j - 1] - pprz_trig_interp[j])) *
+                   (1.f / 32768.f);
+  switch (q & 3) {
+    case 0:
+      *s = sa;
+      *c = ca;
+      break;
+    case 1:
+      *s = ca;
+      *c = -sa;
+      break;
+    case 2:
+      *s = -sa;
+      *c = -ca;
+      break;
+    default:
+      *s = -ca;
+      *c = sa;
+      break;
+  }
+}
+
+/** Sine and cosine of n float angles */
+void pprz_trig_sincos_f_array(float *s, float *c, float *angle, uint16_t n)
+{
+  for (uint16_t i = 0; i < n; i++) {
+    pprz_trig_sincos_f(&s[i], &c[i], angle[i]);
+  }
+}
+
 
 /* http://jet.ro/files/The_neglected_art_of_Fixed_Point_arithmetic_20060913.pdf */
 /* http://www.dspguru.com/dsp/tricks/fixed-point-atan2-with-self-normalization */
@@ -491,12 +698,16 @@ int32_t int32_atan2_2(int32_t y, int32_t x)
   int32_t a;
   if (x >= 0) {
     r = ((x - abs_y) << R_FRAC) / (x + abs_y);
-    int32_t r2 = (r * r) >> R_FRAC;
-    int32_t tmp1 = ((r2 * (int32_t)ANGLE_BFP_OF_REAL(0.1963)) >> INT32_ANGLE_FRAC) - ANGLE_BFP_OF_REAL(0.9817);
-    a = ((tmp1 * r) >> R_FRAC) + c1;
   } else {
     r = ((x + abs_y) << R_FRAC) / (abs_y - x);
-    a = c2 - ((c1 * r) >> R_FRAC);
+  }
+  /* third order: 0.1963 * r^3 - 0.9817 * r */
+  int32_t r2 = (r * r) >> R_FRAC;
+  int32_t tmp1 = ((r2 * (int32_t)ANGLE_BFP_OF_REAL(0.1963)) >> R_FRAC) - (int32_t)ANGLE_BFP_OF_REAL(0.9817);
+  if (x >= 0) {
+    a = ((tmp1 * r) >> R_FRAC) + c1;
+  } else {
+    a = ((tmp1 * r) >> R_FRAC) + c2;
   }
   if (y < 0) {
     return -a;  // negate if in quad III or IV
@@ -504,3 +715,55 @@ int32_t int32_atan2_2(int32_t y, int32_t x)
     return a;
   }
 }
+
+
+/** Table of atan(i / PPRZ_TRIG_ATAN_SIZE) in rad in Q16 */
+#define PPRZ_TRIG_ATAN_BITS 6
+#define PPRZ_TRIG_ATAN_SIZE (1 << PPRZ_TRIG_ATAN_BITS)
+static const uint16_t pprz_trig_atan[PPRZ_TRIG_ATAN_SIZE + 1] = {
+      0,  1024,  2047,  3070,  4091,  5110,  6126,  7140,  8150,  9156, 10158, 11155, 12147, 13133, 14114, 15088,
+  16055, 17015, 17968, 18913, 19850, 20779, 21699, 22610, 23512, 24406, 25289, 26163, 27028, 27882, 28727, 29561,
+  30386, 31200, 32003, 32797, 33580, 34353, 35115, 35867, 36608, 37340, 38060, 38771, 39472, 40162, 40842, 41512,
+  42172, 42823, 43464, 44095, 44716, 45328, 45931, 46525, 47109, 47685, 48251, 48809, 49359, 49899, 50432, 50956,
+  51472
+};
+
+/* pi/2 and pi in rad in Q16 */
+#define PPRZ_TRIG_ATAN_PI_2 102944
+#define PPRZ_TRIG_ATAN_PI   205887
+
+int32_t int32_atan2_table(int32_t y, int32_t x)
+{
+  uint32_t abs_x = (x < 0) ? -(uint32_t)x : (uint32_t)x;
+  uint32_t abs_y = (y < 0) ? -(uint32_t)y : (uint32_t)y;
+  uint32_t num = Min(abs_x, abs_y);
+  uint32_t den = Max(abs_x, abs_y);
+  if (den == 0) {
+    return 0;
+  }
+  /* scale down so that the ratio in Q16 fits */
+  while (den >= (1 << 15)) {
+    num >>= 1;
+    den >>= 1;
+  }
+  /* atan of the ratio in [0, 1] from the table */
+  const uint32_t r = (num << 16) / den;
+  const uint32_t i = r >> (16 - PPRZ_TRIG_ATAN_BITS);
+  int32_t a;
+  if (i >= PPRZ_TRIG_ATAN_SIZE) {
+    a = pprz_trig_atan[PPRZ_TRIG_ATAN_SIZE];
+  } else {
+    const int32_t d = (int32_t)pprz_trig_atan[i + 1] - pprz_trig_atan[i];
+    const int32_t f = r & ((1 << (16 - PPRZ_TRIG_ATAN_BITS)) - 1);
+    a = pprz_trig_atan[i] + ((d * f) >> (16 - PPRZ_TRIG_ATAN_BITS));
+  }
+  /* back to the right octant */
+  if (abs_y > abs_x) {
+    a = PPRZ_TRIG_ATAN_PI_2 - a;
+  }
+  if (x < 0) {
+    a = PPRZ_TRIG_ATAN_PI - a;
+  }
+  a = (a + (1 << (15 - INT32_ANGLE_FRAC))) >> (16 - INT32_ANGLE_FRAC);
+  return (y < 0) ? -a : a;
+}
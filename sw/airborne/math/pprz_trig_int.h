@@ -40,12 +40,51 @@ extern "C" {
 #define PPRZ_TRIG_CONST
 #endif
 
+/** Use the full sine table for the integer trig functions.
+ * One entry per angle step (12.8KB), direct lookup.
+ * If FALSE, the interpolated table of #PPRZ_TRIG_INTERP_BITS is used instead.
+ */
+#ifndef PPRZ_TRIG_INT_FULL_TABLE
+#define PPRZ_TRIG_INT_FULL_TABLE TRUE
+#endif
+
+/** Number of segments (log2) of the quarter sine table with linear interpolation.
+ * Used by the float functions and by the integer ones without #PPRZ_TRIG_INT_FULL_TABLE.
+ * Max error of the sine on [0, pi/2] (see tests/math/bench_pprz_trig):
+ *
+ * | bits | size   | int sin/cos (LSB) | float sin/cos |
+ * |------|--------|-------------------|---------------|
+ * | 6    | 130B   | 1.92              | 8.2e-5        |
+ * | 8    | 514B   | 0.79              | 1.6e-5        |
+ * | 10   | 2050B  | 0.73              | 1.5e-5        |
+ * | full | 12.8KB | 1.00              |               |
+ */
+#ifndef PPRZ_TRIG_INTERP_BITS
+#define PPRZ_TRIG_INTERP_BITS 8
+#endif
+
+#if PPRZ_TRIG_INT_FULL_TABLE
 extern PPRZ_TRIG_CONST int16_t pprz_trig_int[];
+#endif
 
 extern int32_t pprz_itrig_sin(int32_t angle);
 extern int32_t pprz_itrig_cos(int32_t angle);
+extern void pprz_itrig_sincos(int32_t *s, int32_t *c, int32_t angle);
+extern void pprz_itrig_sincos_array(int32_t *s, int32_t *c, int32_t *angle, uint16_t n);
+extern void pprz_trig_sincos_f(float *s, float *c, float angle);
+extern void pprz_trig_sincos_f_array(float *s, float *c, float *angle, uint16_t n);
+
+/** atan2 with different accuracies, angle in rad with #INT32_ANGLE_FRAC.
+ * Max error (host measurement, see tests/math/bench_pprz_trig):
+ * - int32_atan2: 0.077 rad (first order approximation)
+ * - int32_atan2_2: 0.012 rad (third order approximation)
+ * - int32_atan2_table: 0.00017 rad, less than 1 LSB (interpolated table)
+ */
 extern int32_t int32_atan2(int32_t y, int32_t x);
 extern int32_t int32_atan2_2(int32_t y, int32_t x);
+extern int32_t int32_atan2_table(int32_t y, int32_t x);
+
+#define PPRZ_ITRIG_SINCOS(_s, _c, _a) { pprz_itrig_sincos(&(_s), &(_c), _a); }
 
 /* for backwards compatibility */
 #define PPRZ_ITRIG_SIN(_s, _a) { _s = pprz_itrig_sin(_a); }
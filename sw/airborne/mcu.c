@@ -192,4 +192,8 @@ void mcu_event(void)
 #if USE_USB_SERIAL
   VCOM_event();
 #endif
+
+#if USE_UDP0 || USE_UDP1 || USE_UDP2
+  udp_event();
+#endif
 }
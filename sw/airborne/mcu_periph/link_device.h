@@ -35,6 +35,7 @@
  */
 typedef int (*check_free_space_t)(void *, uint8_t);
 typedef void (*put_byte_t)(void *, uint8_t);
+typedef void (*put_buffer_t)(void *, uint8_t *, uint16_t);
 typedef void (*send_message_t)(void *);
 typedef int (*char_available_t)(void *);
 typedef uint8_t (*get_byte_t)(void *);
@@ -44,6 +45,7 @@ typedef uint8_t (*get_byte_t)(void *);
 struct link_device {
   check_free_space_t check_free_space;  ///< check if transmit buffer is not full
   put_byte_t put_byte;                  ///< put one byte
+  put_buffer_t put_buffer;              ///< put several bytes at once (optional, NULL if not supported)
   send_message_t send_message;          ///< send completed buffer
   char_available_t char_available;      ///< check if a new character is available
   get_byte_t get_byte;                  ///< get a new char
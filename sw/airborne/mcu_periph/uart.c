@@ -202,13 +202,14 @@ void uart_periph_init(struct uart_periph *p)
   p->device.periph = (void *)p;
   p->device.check_free_space = (check_free_space_t)uart_check_free_space;
   p->device.put_byte = (put_byte_t)uart_put_byte;
+  p->device.put_buffer = (put_buffer_t)uart_put_buffer;
   p->device.send_message = (send_message_t)null_function;
   p->device.char_available = (char_available_t)uart_char_available;
   p->device.get_byte = (get_byte_t)uart_getch;
 
 #if PERIODIC_TELEMETRY
   // the first to register do it for the others
-  register_periodic_telemetry(DefaultPeriodic, "UART_ERRORS", send_uart_err);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_UART_ERRORS_ID, send_uart_err);
 #endif
 }
 
@@ -221,6 +222,21 @@ bool_t uart_check_free_space(struct uart_periph *p, uint8_t len)
   return (uint16_t)(space - 1) >= len;
 }
 
+/**
+ * Add several bytes to the tx buffer.
+ * Default implementation, architectures can provide a faster one.
+ * @param p    pointer to UART peripheral
+ * @param data bytes to add to tx buffer
+ * @param len  number of bytes
+ */
+void WEAK uart_put_buffer(struct uart_periph *p, uint8_t *data, uint16_t len)
+{
+  uint16_t i;
+  for (i = 0; i < len; i++) {
+    uart_put_byte(p, data[i]);
+  }
+}
+
 uint8_t WEAK uart_getch(struct uart_periph *p)
 {
   uint8_t ret = p->rx_buf[p->rx_extract_idx];
@@ -26,6 +26,8 @@
  */
 
 #include "mcu_periph/udp.h"
+#include "mcu_periph/sys_time.h"
+#include <string.h>
 
 /* Print the configurations */
 #if USE_UDP0
@@ -60,10 +62,15 @@ void udp_periph_init(struct udp_periph *p, char *host, int port_out, int port_in
   p->rx_insert_idx = 0;
   p->rx_extract_idx = 0;
   p->tx_insert_idx = 0;
+  p->tx_last_send = 0;
+  p->ore = 0;
+  p->rx_hold_max = 0;
+  p->tx_hold_max = 0;
   p->device.periph = (void *)p;
   p->device.check_free_space = (check_free_space_t) udp_check_free_space;
   p->device.put_byte = (put_byte_t) udp_put_byte;
-  p->device.send_message = (send_message_t) udp_send_message;
+  p->device.put_buffer = (put_buffer_t) udp_put_buffer;
+  p->device.send_message = (send_message_t) udp_end_message;
   p->device.char_available = (char_available_t) udp_char_available;
   p->device.get_byte = (get_byte_t) udp_getch;
 
@@ -79,6 +86,13 @@ void udp_periph_init(struct udp_periph *p, char *host, int port_out, int port_in
  */
 bool_t udp_check_free_space(struct udp_periph *p, uint8_t len)
 {
+#if UDP_TX_COALESCE
+  // send the pending messages to make room for the new one
+  if ((UDP_TX_BUFFER_SIZE - p->tx_insert_idx) < len && p->tx_insert_idx > 0) {
+    udp_send_message(p);
+    p->tx_last_send = get_sys_time_msec();
+  }
+#endif
   return (UDP_TX_BUFFER_SIZE - p->tx_insert_idx) >= len;
 }
 
@@ -97,3 +111,69 @@ void udp_put_byte(struct udp_periph *p, uint8_t data)
   p->tx_insert_idx++;
 }
 
+/**
+ * Add several bytes to the tx buffer.
+ * @param p    pointer to UDP peripheral
+ * @param data bytes to add to tx buffer
+ * @param len  number of bytes
+ */
+void udp_put_buffer(struct udp_periph *p, uint8_t *data, uint16_t len)
+{
+  if (len > UDP_TX_BUFFER_SIZE - p->tx_insert_idx) {
+    return;  // no room
+  }
+
+  memcpy(&p->tx_buf[p->tx_insert_idx], data, len);
+  p->tx_insert_idx += len;
+}
+
+#if UDP_TX_COALESCE
+/**
+ * Send the pending messages if the last datagram is older than
+ * UDP_TX_COALESCE_DELAY.
+ * @param p    pointer to UDP peripheral
+ */
+static void udp_flush(struct udp_periph *p)
+{
+  uint32_t now = get_sys_time_msec();
+  if (p->tx_insert_idx > 0 && now - p->tx_last_send >= UDP_TX_COALESCE_DELAY) {
+    p->tx_last_send = now;
+    udp_send_message(p);
+  }
+}
+#endif
+
+/**
+ * End of a message, send the datagram.
+ * When coalescing messages, it is only sent if the last datagram
+ * is older than UDP_TX_COALESCE_DELAY, otherwise udp_event sends it later.
+ * @param p    pointer to UDP peripheral
+ */
+void udp_end_message(struct udp_periph *p)
+{
+#if UDP_TX_COALESCE
+  udp_flush(p);
+#else
+  udp_send_message(p);
+#endif
+}
+
+/**
+ * Send the coalesced messages that are waiting for UDP_TX_COALESCE_DELAY,
+ * so the last messages of a burst are not held until the next one.
+ * Called from mcu_event.
+ */
+void udp_event(void)
+{
+#if UDP_TX_COALESCE
+#if USE_UDP0
+  udp_flush(&udp0);
+#endif
+#if USE_UDP1
+  udp_flush(&udp1);
+#endif
+#if USE_UDP2
+  udp_flush(&udp2);
+#endif
+#endif
+}
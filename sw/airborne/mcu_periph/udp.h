@@ -35,6 +35,19 @@
 #define UDP_RX_BUFFER_SIZE 256
 #define UDP_TX_BUFFER_SIZE 256
 
+/** Coalesce several messages in a single datagram.
+ * The buffer is sent when the next message doesn't fit or
+ * when the last datagram is older than UDP_TX_COALESCE_DELAY (ms),
+ * at the end of a message or from udp_event.
+ */
+#ifndef UDP_TX_COALESCE
+#define UDP_TX_COALESCE FALSE
+#endif
+
+#ifndef UDP_TX_COALESCE_DELAY
+#define UDP_TX_COALESCE_DELAY 20
+#endif
+
 struct udp_periph {
   /** Receive buffer */
   uint8_t rx_buf[UDP_RX_BUFFER_SIZE];
@@ -43,6 +56,10 @@ struct udp_periph {
   /** Transmit buffer */
   uint8_t tx_buf[UDP_TX_BUFFER_SIZE];
   uint16_t tx_insert_idx;
+  uint32_t tx_last_send;    ///< time of the last datagram (ms), used when coalescing messages
+  volatile uint16_t ore;            ///< overrun counter, bytes dropped because rx_buf was full
+  volatile uint32_t rx_hold_max;    ///< longest time (us) spent by the reader thread on one datagram
+  volatile uint32_t tx_hold_max;    ///< longest time (us) spent sending one datagram
   /** UDP network */
   void *network;
   /** Generic device interface */
@@ -52,12 +69,15 @@ struct udp_periph {
 extern void     udp_periph_init(struct udp_periph *p, char *host, int port_out, int port_in, bool_t broadcast);
 extern bool_t   udp_check_free_space(struct udp_periph *p, uint8_t len);
 extern void     udp_put_byte(struct udp_periph *p, uint8_t data);
+extern void     udp_put_buffer(struct udp_periph *p, uint8_t *data, uint16_t len);
+extern void     udp_end_message(struct udp_periph *p);
 extern uint16_t udp_char_available(struct udp_periph *p);
 extern uint8_t  udp_getch(struct udp_periph *p);
 extern void     udp_arch_periph_init(struct udp_periph *p, char *host, int port_out, int port_in, bool_t broadcast);
 extern void     udp_send_message(struct udp_periph *p);
 extern void     udp_send_raw(struct udp_periph *p, uint8_t *buffer, uint16_t size);
 extern void     udp_receive(struct udp_periph *p);
+extern void     udp_event(void);
 
 #if USE_UDP0
 extern struct udp_periph udp0;
@@ -101,8 +101,8 @@ void ahrs_infrared_init(void)
   AbiBindMsgGPS(AHRS_INFRARED_GPS_ID, &gps_ev, &gps_cb);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "IR_SENSORS", send_infrared);
-  register_periodic_telemetry(DefaultPeriodic, "STATE_FILTER_STATUS", send_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_IR_SENSORS_ID, send_infrared);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_STATE_FILTER_STATUS_ID, send_status);
 #endif
 }
 
@@ -207,9 +207,9 @@ void air_data_init(void)
   AbiBindMsgTEMPERATURE(AIR_DATA_TEMPERATURE_ID, &temperature_ev, temperature_cb);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "BARO_RAW", send_baro_raw);
-  register_periodic_telemetry(DefaultPeriodic, "AIR_DATA", send_air_data);
-  register_periodic_telemetry(DefaultPeriodic, "AMSL", send_amsl);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_BARO_RAW_ID, send_baro_raw);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AIR_DATA_ID, send_air_data);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AMSL_ID, send_amsl);
 #endif
 }
 
@@ -23,172 +23,249 @@
  * @file modules/computer_vision/blob/blob_finder.c
  *
  * Parse UYVY images and make a list of blobs of connected pixels
+ *
+ * The image is labelled line by line as runs of pixels passing the same
+ * filter. A run that touches runs of the previous line takes their label and
+ * the equivalences between labels are kept in a union-find forest (stored in
+ * the id field of the labels). The moments of a blob are accumulated per run
+ * while labelling, so a second pass over the labels merges the equivalent
+ * ones and only the output image needs another pass over the pixels.
  */
 
+#include "blob_finder.h"
+#include <string.h>
 
+/** Horizontal segment of labelled pixels on one line */
+struct image_run_t {
+  uint16_t start;   ///< First pixel of the run
+  uint16_t end;     ///< Last pixel of the run
+  uint16_t label;   ///< Provisional label of the run
+};
 
-#include "blob_finder.h"
-#include <stdio.h>
+/** Find the root of a label, halving the path on the way */
+static inline uint16_t label_find(struct image_label_t *labels, uint16_t l)
+{
+  while (labels[l].id != l) {
+    labels[l].id = labels[labels[l].id].id;
+    l = labels[l].id;
+  }
+  return l;
+}
+
+/** Merge two labels, the lowest root becomes the root of the other one */
+static inline void label_union(struct image_label_t *labels, uint16_t a, uint16_t b)
+{
+  a = label_find(labels, a);
+  b = label_find(labels, b);
+  if (a < b) {
+    labels[b].id = a;
+  } else if (b < a) {
+    labels[a].id = b;
+  }
+}
+
+/** Sum of the squares of 0..n-1 */
+static inline uint64_t sum_squares(uint64_t n)
+{
+  return n * (n - 1) * (2 * n - 1) / 6;
+}
+
+/** Add the run [x0, x1] on line y to the moments of a label */
+static void label_add_run(struct image_label_t *l, uint16_t x0, uint16_t x1, uint16_t y)
+{
+  uint32_t n = x1 - x0 + 1;
+  uint32_t sx = ((uint32_t)x0 + x1) * n / 2;
+  l->pixel_cnt += n;
+  l->x_sum += sx;
+  l->y_sum += n * y;
+  l->xx_sum += sum_squares(x1 + 1) - sum_squares(x0);
+  l->yy_sum += (uint64_t)n * y * y;
+  l->xy_sum += (uint64_t)sx * y;
+  if (x1 > l->x_max) { l->x_max = x1; }
+  if (y > l->y_max) { l->y_max = y; }
+}
+
+/** Add the moments of label src to label dst */
+static void label_merge(struct image_label_t *dst, struct image_label_t *src)
+{
+  dst->pixel_cnt += src->pixel_cnt;
+  dst->x_sum += src->x_sum;
+  dst->y_sum += src->y_sum;
+  dst->xx_sum += src->xx_sum;
+  dst->yy_sum += src->yy_sum;
+  dst->xy_sum += src->xy_sum;
+  if (src->x_min < dst->x_min) { dst->x_min = src->x_min; }
+  if (src->y_min < dst->y_min) { dst->y_min = src->y_min; }
+  if (src->x_max > dst->x_max) { dst->x_max = src->x_max; }
+  if (src->y_max > dst->y_max) { dst->y_max = src->y_max; }
+}
 
 void image_labeling(struct image_t *input, struct image_t *output, struct image_filter_t *filters, uint8_t filters_cnt,
                     struct image_label_t *labels, uint16_t *labels_count)
 {
   uint8_t *input_buf = (uint8_t *)input->buf;
   uint16_t *output_buf = (uint16_t *)output->buf;
-
-  // Initialize labels
   uint16_t labels_size = *labels_count;
   uint16_t labels_cnt = 0;
+  uint16_t width = input->w / 2;
   uint16_t i, x, y;
 
-  // Initialize first line with empty groups
-  uint16_t *p = output_buf;
-  for (i = 0; i < output->w; i++) {
-    *p++ = 0xffff;
+  // Bitmask of the filters accepting every value of each channel
+  uint32_t lut_y[256], lut_u[256], lut_v[256];
+  memset(lut_y, 0, sizeof(lut_y));
+  memset(lut_u, 0, sizeof(lut_u));
+  memset(lut_v, 0, sizeof(lut_v));
+  if (filters_cnt > 32) {
+    filters_cnt = 32;
+  }
+  for (uint8_t f = 0; f < filters_cnt; f++) {
+    uint32_t bit = 1u << f;
+    for (i = filters[f].y_min + 1; i < filters[f].y_max; i++) { lut_y[i] |= bit; }
+    for (i = filters[f].u_min + 1; i < filters[f].u_max; i++) { lut_u[i] |= bit; }
+    for (i = filters[f].v_min + 1; i < filters[f].v_max; i++) { lut_v[i] |= bit; }
   }
 
-  // Do steps of 2 for YUV image
-  // Skip first line as we need previous groups for connectivity
-  for (y = 1; y < input->h; y++) {
-    for (x = 0; x < input->w / 2; x++) {
-      uint16_t lid = 0;
-      uint8_t p_y = (input_buf[y * input->w * 2 + x * 4 + 1] + input_buf[y * input->w * 2 + x * 4 + 3]) / 2;
-      uint8_t p_u = input_buf[y * input->w * 2 + x * 4];
-      uint8_t p_v = input_buf[y * input->w * 2 + x * 4 + 2];
-
-      // Go trough the filters
-      uint8_t f = 0;
-      for (; f < filters_cnt; f++) {
-        if (p_y > filters[f].y_min && p_y < filters[f].y_max &&
-            p_u > filters[f].u_min && p_u < filters[f].u_max &&
-            p_v > filters[f].v_min && p_v < filters[f].v_max) {
-          break;
-        }
-      }
+  // Runs of the previous and the current line
+  struct image_run_t runs[2][IMAGE_LABELING_MAX_RUNS];
+  struct image_run_t *prev = runs[0], *cur = runs[1];
+  uint16_t prev_cnt = 0, cur_cnt;
 
-      // Check if this pixel belongs to a filter else goto next
-      if (f >= filters_cnt) {
-        output_buf[y * output->w + x] = 0xFFFF;
-        continue;
-      }
+  // First pass: find the runs and give them a provisional label
+  for (y = 0; y < input->h; y++) {
+    uint8_t *in = &input_buf[y * input->w * 2];
+    uint16_t *out = &output_buf[y * output->w];
+    uint16_t k = 0;   // First run of the previous line that may touch the current run
+    cur_cnt = 0;
 
-      // Check pixel above (if the same filter then take same group)
-      lid = output_buf[(y - 1) * output->w + x];
-      if (y > 0 && lid < labels_size && labels[lid].filter == f) {
-        output_buf[y * output->w + x] = lid;
-        labels[lid].pixel_cnt++;
-        labels[lid].x_sum += x;
-        labels[lid].y_sum += y;
+    x = 0;
+    while (x < width) {
+      // Classify the pixel, lowest filter index first
+      uint32_t mask = lut_y[(in[x * 4 + 1] + in[x * 4 + 3]) / 2] & lut_u[in[x * 4]] & lut_v[in[x * 4 + 2]];
+      if (mask == 0) {
+        out[x++] = IMAGE_LABELING_NONE;
         continue;
       }
+      uint8_t f = __builtin_ctz(mask);
 
-      // Check pixel top right (check for merging)
-      lid = output_buf[(y - 1) * output->w + x + 1];
-      if (y > 0 && x < output->w - 1 && lid < labels_size && labels[lid].filter == f) {
-
-        // Merging labels if needed
-        uint16_t lid_tl = output_buf[(y - 1) * output->w + x - 1]; // Top left
-        uint16_t lid_l = output_buf[y * output->w + x - 1]; // Left
-        uint16_t m = labels[lid].id, n = labels[lid].id;
-        if (x > 0 && lid_tl < labels_size && labels[lid_tl].filter == f) {
-          // Merge with top left
-          m = labels[lid].id;
-          n = labels[lid_tl].id;
-        } else if (x > 0 && lid_l < labels_size && labels[lid_l].filter == f) {
-          // Merge with left
-          m = labels[lid].id;
-          n = labels[lid_l].id;
+      // Extend the run as long as the pixels pass the same filter
+      uint16_t start = x;
+      for (x++; x < width; x++) {
+        mask = lut_y[(in[x * 4 + 1] + in[x * 4 + 3]) / 2] & lut_u[in[x * 4]] & lut_v[in[x * 4 + 2]];
+        if (mask == 0 || (uint8_t)__builtin_ctz(mask) != f) {
+          break;
         }
+      }
+      uint16_t end = x - 1;
 
-        // Change the id of the highest id label
-        if (m != n) {
-          if (m > n) {
-            m = n;
-            n = labels[lid].id;
-          }
-
-          for (i = 0; i < labels_cnt; i++) {
-            if (labels[i].id == n) {
-              labels[i].id = m;
-            }
-          }
+      // Connect with the 8-connected runs of the previous line with the same filter
+      uint16_t lid = IMAGE_LABELING_NONE;
+      while (k < prev_cnt && prev[k].end + 1 < start) {
+        k++;
+      }
+      for (uint16_t j = k; j < prev_cnt && prev[j].start <= end + 1; j++) {
+        if (labels[prev[j].label].filter != f) {
+          continue;
+        }
+        if (lid == IMAGE_LABELING_NONE) {
+          lid = prev[j].label;
+        } else {
+          label_union(labels, lid, prev[j].label);
         }
-
-        // Update the label
-        output_buf[y * output->w + x] = lid;
-        labels[lid].pixel_cnt++;
-        labels[lid].x_sum += x;
-        labels[lid].y_sum += y;
-        continue;
       }
 
-      // Take top left
-      lid = output_buf[(y - 1) * output->w + x - 1];
-      if (y > 0 && x > 0 && lid < labels_size && labels[lid].filter == f) {
-        output_buf[y * output->w + x] = lid;
-        labels[lid].pixel_cnt++;
-        labels[lid].x_sum += x;
-        labels[lid].y_sum += y;
-        continue;
+      // Create a new label, or leave the run unlabelled when there is no space left
+      if (lid == IMAGE_LABELING_NONE && labels_cnt < labels_size) {
+        lid = labels_cnt++;
+        labels[lid].id = lid;
+        labels[lid].filter = f;
+        labels[lid].pixel_cnt = 0;
+        labels[lid].x_min = start;
+        labels[lid].y_min = y;
+        labels[lid].x_max = end;
+        labels[lid].y_max = y;
+        labels[lid].x_sum = 0;
+        labels[lid].y_sum = 0;
+        labels[lid].xx_sum = 0;
+        labels[lid].yy_sum = 0;
+        labels[lid].xy_sum = 0;
       }
 
-      // Take left
-      lid = output_buf[y * output->w + x - 1];
-      if (x > 0 && lid < labels_size && labels[lid].filter == f) {
-        output_buf[y * output->w + x] = lid;
-        labels[lid].pixel_cnt++;
-        labels[lid].x_sum += x;
-        labels[lid].y_sum += y;
+      for (i = start; i <= end; i++) {
+        out[i] = lid;
+      }
+      if (lid == IMAGE_LABELING_NONE) {
         continue;
       }
 
-      // Check if there is enough space
-      if (labels_cnt >= labels_size - 1) {
-        break;
-      }
+      if (start < labels[lid].x_min) { labels[lid].x_min = start; }
+      label_add_run(&labels[lid], start, end, y);
 
-      // Create new group
-      lid = labels_cnt;
-      output_buf[y * output->w + x] = lid;
-      labels[lid].id = lid;
-      labels[lid].filter = f;
-      labels[lid].pixel_cnt = 1;
-      labels[lid].x_min = x;
-      labels[lid].y_min = y;
-      labels[lid].x_sum = x;
-      labels[lid].y_sum = y;
-      labels_cnt++;
+      // Keep the run for the next line (a too long list only loses connectivity)
+      if (cur_cnt >= IMAGE_LABELING_MAX_RUNS) {
+        continue;
+      }
+      cur[cur_cnt].start = start;
+      cur[cur_cnt].end = end;
+      cur[cur_cnt].label = lid;
+      cur_cnt++;
     }
-  }
 
-  if (labels_cnt >= labels_size - 1) {
-    printf("Break did not work: we have %d labels\n", labels_cnt);
+    struct image_run_t *tmp = prev;
+    prev = cur;
+    cur = tmp;
+    prev_cnt = cur_cnt;
   }
 
-  // Merge connected labels
+  // Second pass: flatten the forest (parents always have a lower index) and
+  // merge the moments in the roots
+  uint16_t blobs_cnt = 0;
   for (i = 0; i < labels_cnt; i++) {
-    if (labels[i].id != i) {
-      uint16_t new_id = labels[i].id;
-      labels[new_id].pixel_cnt += labels[i].pixel_cnt;
-      labels[new_id].x_sum += labels[i].x_sum;
-      labels[new_id].y_sum += labels[i].y_sum;
-
-      //printf("%d == %d,  ",new_id, i);
-
-      if (labels[i].x_min < labels[new_id].x_min) { labels[new_id].x_min = labels[i].x_min; }
-      if (labels[i].y_min < labels[new_id].y_min) { labels[new_id].y_min = labels[i].y_min; }
+    uint16_t root = labels[labels[i].id].id;
+    labels[i].id = root;
+    if (root != i) {
+      label_merge(&labels[root], &labels[i]);
+      labels[i].pixel_cnt = 0;
     }
   }
 
-  *labels_count = labels_cnt;
+  // Give the roots consecutive indices, non roots still point to their root
+  for (i = 0; i < labels_cnt; i++) {
+    if (labels[i].pixel_cnt > 0) {
+      labels[i].id = blobs_cnt++;
+    }
+  }
 
-  // Replace ID's
+  // Replace the provisional labels by the blob indices
   for (y = 0; y < input->h; y++) {
-    for (x = 0; x < input->w / 2; x++) {
-      uint16_t lid = output_buf[y * output->w + x];
-      if (lid < labels_cnt) {
-        output_buf[y * output->w + x] = labels[lid].id;
+    uint16_t *out = &output_buf[y * output->w];
+    for (x = 0; x < width; x++) {
+      uint16_t lid = out[x];
+      if (lid != IMAGE_LABELING_NONE) {
+        out[x] = (labels[lid].pixel_cnt > 0) ? labels[lid].id : labels[labels[lid].id].id;
       }
     }
   }
+
+  // Move the blobs to the front of the labels
+  for (i = 0; i < labels_cnt; i++) {
+    if (labels[i].pixel_cnt > 0) {
+      uint16_t b = labels[i].id;
+      if (b != i) {
+        labels[b].filter = labels[i].filter;
+        labels[b].pixel_cnt = labels[i].pixel_cnt;
+        labels[b].x_min = labels[i].x_min;
+        labels[b].y_min = labels[i].y_min;
+        labels[b].x_max = labels[i].x_max;
+        labels[b].y_max = labels[i].y_max;
+        labels[b].x_sum = labels[i].x_sum;
+        labels[b].y_sum = labels[i].y_sum;
+        labels[b].xx_sum = labels[i].xx_sum;
+        labels[b].yy_sum = labels[i].yy_sum;
+        labels[b].xy_sum = labels[i].xy_sum;
+        labels[b].id = b;
+      }
+    }
+  }
+
+  *labels_count = blobs_cnt;
 }
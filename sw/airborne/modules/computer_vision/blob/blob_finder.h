@@ -26,8 +26,18 @@
  */
 
 
+#ifndef BLOB_FINDER_H
+#define BLOB_FINDER_H
+
 #include "modules/computer_vision/lib/vision/image.h"
 
+/** Maximum number of runs (horizontal segments of pixels) per image line */
+#ifndef IMAGE_LABELING_MAX_RUNS
+#define IMAGE_LABELING_MAX_RUNS 1024
+#endif
+
+/** Value of the output pixels that do not belong to any blob */
+#define IMAGE_LABELING_NONE 0xFFFF
 
 /* YUV Color Filter Parameters */
 struct image_filter_t {
@@ -44,11 +54,16 @@ struct image_label_t {
   uint16_t id;              ///< Blob number
   uint8_t filter;           ///< Which filter triggered this blob
 
-  uint16_t pixel_cnt;       ///< Number of pixels in the blob
+  uint32_t pixel_cnt;       ///< Number of pixels in the blob
   uint16_t x_min;           ///< Top left corner
   uint16_t y_min;
+  uint16_t x_max;           ///< Bottom right corner
+  uint16_t y_max;
   uint32_t x_sum;           ///< Sum of all x coordinates (used to find center of gravity)
   uint32_t y_sum;
+  uint64_t xx_sum;          ///< Second order moments (used to find size and orientation)
+  uint64_t yy_sum;
+  uint64_t xy_sum;
 
   struct point_t contour[512];
   uint16_t contour_cnt;
@@ -56,5 +71,21 @@ struct image_label_t {
   uint16_t corners[4];
 };
 
+/**
+ * Find the blobs of connected pixels matching a set of color filters.
+ * Pixels are handled per UYVY pair (x coordinates are in half resolution) and
+ * 8-connected pixels passing the same filter end up in the same blob. When
+ * several filters match a pixel the first one is used (at most 32 filters).
+ * @param[in] input The UYVY image
+ * @param[out] output Image of input size with IMAGE_GRADIENT type, the first
+ *   half of every line receives the blob index of every pixel pair
+ *   (IMAGE_LABELING_NONE if it is not part of a blob)
+ * @param[in] filters The color filters
+ * @param[in] filters_cnt The number of filters
+ * @param[out] labels The blobs that are found
+ * @param[in,out] labels_count The size of labels in, the number of blobs out
+ */
 void image_labeling(struct image_t *input, struct image_t *output, struct image_filter_t *filters, uint8_t filters_cnt,
                     struct image_label_t *labels, uint16_t *labels_count);
+
+#endif /* BLOB_FINDER_H */
@@ -27,22 +27,263 @@
 
 #include "cv.h"
 
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifndef MAX_CV_FUNC
 #define MAX_CV_FUNC 10
+#endif
+
+static struct cv_listener cv_listeners[MAX_CV_FUNC];
+static uint8_t cv_listener_cnt = 0;
+
+static cvFrameFunction cv_frame_ref = NULL;
+static cvFrameFunction cv_frame_release = NULL;
 
-int cv_func_cnt = 0;
-cvFunction cv_func[MAX_CV_FUNC];
+static void *cv_listener_thread(void *data);
+
+/** Time difference in ms */
+static float cv_time_diff(struct timeval *start, struct timeval *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1000.f + (end->tv_usec - start->tv_usec) / 1000.f;
+}
 
-void cv_add(cvFunction func)
+/** Run the function of a consumer and update its statistics */
+static void cv_listener_process(struct cv_listener *l, struct image_t *img)
 {
-  if (cv_func_cnt < (MAX_CV_FUNC - 1)) {
-    cv_func[cv_func_cnt] = func;
-    cv_func_cnt++;
+  l->func(img);
+
+  struct timeval end;
+  gettimeofday(&end, NULL);
+  l->latency = cv_time_diff(&l->dispatch_time, &end);
+  if (l->latency > l->latency_max) {
+    l->latency_max = l->latency;
   }
+  l->processed++;
+}
+
+#if PERIODIC_TELEMETRY
+#include "subsystems/datalink/telemetry.h"
+/**
+ * Send the statistics of one consumer per call (round robin)
+ * @param[in] *trans The transport structure to send the information over
+ * @param[in] *dev The link to send the data over
+ */
+static void cv_telem_send(struct transport_tx *trans, struct link_device *dev)
+{
+  static uint8_t idx = 0;
+  if (cv_listener_cnt == 0) {
+    return;
+  }
+  if (idx >= cv_listener_cnt) {
+    idx = 0;
+  }
+  struct cv_listener *l = &cv_listeners[idx];
+  uint8_t threaded = l->threaded;
+  uint8_t access = l->access;
+  pprz_msg_send_CV_PIPELINE(trans, dev, AC_ID, &idx, &threaded, &access, &l->processed, &l->dropped,
+                            &l->latency, &l->latency_max);
+  idx++;
+}
+#endif
+
+/**
+ * Initialize the computer vision framework
+ */
+void cv_init(void)
+{
+#if PERIODIC_TELEMETRY
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_CV_PIPELINE_ID, cv_telem_send);
+#endif
 }
 
+/**
+ * Set the reference counting functions of the video source
+ * With these, consumers sharing the frame keep it alive on their own and
+ * cv_run does not have to wait for them before the frame is released.
+ * @param[in] ref Add a user to the frame
+ * @param[in] release Remove a user from the frame (the last one gives the buffer back)
+ */
+void cv_set_frame_ref(cvFrameFunction ref, cvFrameFunction release)
+{
+  cv_frame_ref = ref;
+  cv_frame_release = release;
+}
+
+/** Reserve a new consumer slot */
+static struct cv_listener *cv_new_listener(cvFunction func)
+{
+  if (cv_listener_cnt >= MAX_CV_FUNC) {
+    printf("[cv] Too many computer vision functions (MAX_CV_FUNC = %d).\n", MAX_CV_FUNC);
+    return NULL;
+  }
+  struct cv_listener *l = &cv_listeners[cv_listener_cnt];
+  memset(l, 0, sizeof(struct cv_listener));
+  l->func = func;
+  return l;
+}
+
+/**
+ * Add a function which is called on every frame in the video thread
+ * @param[in] func The processing function
+ * @return The consumer or NULL when there is no room left
+ */
+struct cv_listener *cv_add(cvFunction func)
+{
+  struct cv_listener *l = cv_new_listener(func);
+  if (l == NULL) {
+    return NULL;
+  }
+  l->threaded = FALSE;
+  cv_listener_cnt++;
+  return l;
+}
+
+/**
+ * Add a function which runs in its own thread
+ * A slow consumer will then not delay the other ones.
+ * @param[in] func The processing function
+ * @param[in] fps The maximum processing rate (0 for every frame)
+ * @param[in] access Use a shared read-only reference or a private copy of the frame
+ * @return The consumer or NULL when it could not be added
+ */
+struct cv_listener *cv_add_threaded(cvFunction func, float fps, enum cv_frame_access access)
+{
+  struct cv_listener *l = cv_new_listener(func);
+  if (l == NULL) {
+    return NULL;
+  }
+  l->threaded = TRUE;
+  l->fps = fps;
+  l->access = access;
+
+  pthread_mutex_init(&l->mutex, NULL);
+  pthread_cond_init(&l->cond, NULL);
+  if (pthread_create(&l->thread, NULL, cv_listener_thread, l) != 0) {
+    printf("[cv] Could not create computer vision thread.\n");
+    pthread_cond_destroy(&l->cond);
+    pthread_mutex_destroy(&l->mutex);
+    return NULL;
+  }
+  cv_listener_cnt++;
+  return l;
+}
+
+/**
+ * Thread of a threaded consumer, waits for frames given by cv_run
+ */
+static void *cv_listener_thread(void *data)
+{
+  struct cv_listener *l = (struct cv_listener *)data;
+
+  pthread_mutex_lock(&l->mutex);
+  while (TRUE) {
+    while (!l->busy) {
+      pthread_cond_wait(&l->cond, &l->mutex);
+    }
+    pthread_mutex_unlock(&l->mutex);
+
+    cv_listener_process(l, &l->img);
+    if (l->img_ref) {
+      cv_frame_release(&l->img);
+    }
+
+    pthread_mutex_lock(&l->mutex);
+    l->busy = FALSE;
+    pthread_cond_broadcast(&l->cond);
+  }
+
+  return NULL;
+}
+
+/** Check if a consumer is due for a new frame according to its maximum rate */
+static bool_t cv_rate_ok(struct cv_listener *l, struct timeval *now)
+{
+  if (l->fps <= 0 || (l->dispatch_time.tv_sec == 0 && l->dispatch_time.tv_usec == 0)) {
+    return TRUE;
+  }
+  return cv_time_diff(&l->dispatch_time, now) >= 1000.f / l->fps;
+}
+
+/**
+ * Give a frame to a threaded consumer
+ * @return TRUE when the consumer got the frame
+ */
+static bool_t cv_dispatch(struct cv_listener *l, struct image_t *img, struct timeval *now)
+{
+  pthread_mutex_lock(&l->mutex);
+  if (l->busy) {
+    l->dropped++;
+    pthread_mutex_unlock(&l->mutex);
+    return FALSE;
+  }
+
+  if (l->access == CV_FRAME_COPY) {
+    // (Re)allocate the private buffer when the frame format changes
+    if (l->img.buf == NULL || l->img.type != img->type || l->img.buf_size < img->buf_size) {
+      if (l->img.buf != NULL) {
+        image_free(&l->img);
+      }
+      image_create(&l->img, img->w, img->h, img->type);
+    }
+    image_copy(img, &l->img);
+  } else {
+    l->img_ref = (cv_frame_ref != NULL && cv_frame_release != NULL);
+    if (l->img_ref) {
+      cv_frame_ref(img);
+    }
+    l->img = *img;
+  }
+
+  l->dispatch_time = *now;
+  l->busy = TRUE;
+  pthread_cond_broadcast(&l->cond);
+  pthread_mutex_unlock(&l->mutex);
+  return TRUE;
+}
+
+/**
+ * Run all the consumers on a new frame
+ * The consumers in the video thread run first, as some of them modify the
+ * frame in place (e.g. colorfilter), then the threaded consumers get the
+ * final frame and run in parallel with the next frames of the video thread.
+ * Consumers sharing the frame hold a reference to it, without reference
+ * counting cv_run waits for them before returning.
+ * @param[in] *img The frame
+ */
 void cv_run(struct image_t *img)
 {
-  for (int i = 0; i < cv_func_cnt; i++) {
-    cv_func[i](img);
+  bool_t shared[MAX_CV_FUNC];
+  struct timeval now;
+  gettimeofday(&now, NULL);
+
+  for (uint8_t i = 0; i < cv_listener_cnt; i++) {
+    struct cv_listener *l = &cv_listeners[i];
+    if (!l->threaded && cv_rate_ok(l, &now)) {
+      l->dispatch_time = now;
+      cv_listener_process(l, img);
+    }
+  }
+
+  for (uint8_t i = 0; i < cv_listener_cnt; i++) {
+    struct cv_listener *l = &cv_listeners[i];
+    shared[i] = FALSE;
+
+    if (l->threaded && cv_rate_ok(l, &now) && cv_dispatch(l, img, &now)) {
+      shared[i] = (l->access == CV_FRAME_SHARED && !l->img_ref);
+    }
+  }
+
+  // Wait for the consumers reading the frame without reference before it is released
+  for (uint8_t i = 0; i < cv_listener_cnt; i++) {
+    if (shared[i]) {
+      struct cv_listener *l = &cv_listeners[i];
+      pthread_mutex_lock(&l->mutex);
+      while (l->busy) {
+        pthread_cond_wait(&l->cond, &l->mutex);
+      }
+      pthread_mutex_unlock(&l->mutex);
+    }
   }
 }
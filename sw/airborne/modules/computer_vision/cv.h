@@ -32,9 +32,44 @@
 #include "std.h"
 #include "lib/vision/image.h"
 
+#include <pthread.h>
+
 typedef bool_t (*cvFunction)(struct image_t *img);
+typedef void (*cvFrameFunction)(struct image_t *img);
+
+/* How a threaded consumer accesses the frame */
+enum cv_frame_access {
+  CV_FRAME_SHARED,  ///< Read-only reference to the video frame (reference counted, else cv_run waits for the consumer)
+  CV_FRAME_COPY     ///< Private copy of the frame, the video thread does not wait (frames are dropped when busy)
+};
+
+/* A consumer of the video frames */
+struct cv_listener {
+  cvFunction func;              ///< The processing function
+  bool_t threaded;              ///< Whether the function runs in its own thread
+  enum cv_frame_access access;  ///< Frame access of a threaded consumer
+  float fps;                    ///< Maximum processing rate (0 for every frame)
+
+  /* Threading */
+  pthread_t thread;             ///< The consumer thread
+  pthread_mutex_t mutex;        ///< Protects the frame hand-over
+  pthread_cond_t cond;          ///< Signals a new frame or the end of the processing
+  volatile bool_t busy;         ///< A frame is being processed
+  struct image_t img;           ///< The frame given to the thread (reference or private copy)
+  bool_t img_ref;               ///< The shared frame holds a reference which the thread releases
+  struct timeval dispatch_time; ///< When the last frame was given to the consumer
+
+  /* Statistics */
+  uint32_t processed;           ///< Amount of processed frames
+  uint32_t dropped;             ///< Amount of frames dropped because the consumer was busy
+  float latency;                ///< Last latency from dispatch to end of processing (ms)
+  float latency_max;            ///< Maximum latency (ms)
+};
 
-extern void cv_add(cvFunction func);
+extern void cv_init(void);
+extern void cv_set_frame_ref(cvFrameFunction ref, cvFrameFunction release);
+extern struct cv_listener *cv_add(cvFunction func);
+extern struct cv_listener *cv_add_threaded(cvFunction func, float fps, enum cv_frame_access access);
 extern void cv_run(struct image_t *img);
 
 #endif /* CV_H_ */
@@ -29,9 +29,32 @@
 
 #include "cv.h"
 #include "detect_window.h"
+#include "lib/vision/integral_image.h"
 #include <stdio.h>
+#include <stdlib.h>
+
+/** Window size and the pixel counts of its parts */
+struct window_size_t {
+  uint16_t window_size;   ///< Size of the window without border
+  uint16_t border_size;   ///< Size of the border around the window
+  uint16_t feature_size;  ///< Size of the window with border
+  uint16_t px_inner;      ///< Number of pixels inside the window
+  uint16_t px_border;     ///< Number of pixels of the border
+  uint16_t px_outer;      ///< Number of pixels of one side of the border
+  uint16_t min_response;  ///< Best response found
+  uint16_t coordinate[2]; ///< Top left corner of the best response
+};
+
+// buffers kept between frames
+static struct image_t gray;
+static uint32_t *integral_image = NULL;
+
+static void window_size_init(struct window_size_t *ws, uint16_t window_size);
+static void window_size_line(struct window_size_t *ws, uint16_t y, uint32_t *integral_image,
+                             uint32_t image_width, uint32_t image_height, uint8_t MODE);
 
 extern void detect_window_init(void){
+	gray.buf = NULL;
 	cv_add(detect_window);
 }
 
@@ -40,16 +63,27 @@ extern bool_t detect_window(struct image_t *img){
 	uint16_t coordinate[2];
 	coordinate[0] = 0; coordinate[1] = 0;
 	uint16_t response = 0;
-	uint32_t integral_image[img->w * img->h];
-	struct image_t gray;
-	image_create(&gray, img->w, img->h, IMAGE_GRAYSCALE);
+
+	// (re)allocate the buffers when the image size changes
+	if (gray.buf == NULL || gray.w != img->w || gray.h != img->h) {
+		// the old buffers are kept if it fails, and it is tried again on the next frame
+		uint32_t *new_integral_image = realloc(integral_image, img->w * img->h * sizeof(uint32_t));
+		if (new_integral_image == NULL) {
+			printf("[detect_window] Could not allocate the integral image, frame skipped.\n");
+			return FALSE;
+		}
+		integral_image = new_integral_image;
+		if (gray.buf != NULL) {
+			image_free(&gray);
+		}
+		image_create(&gray, img->w, img->h, IMAGE_GRAYSCALE);
+	}
 	image_to_grayscale(img, &gray);
 
 	response = detect_window_sizes( (uint8_t*)gray.buf, (uint32_t)img->w, (uint32_t)img->h, coordinate, integral_image, MODE_BRIGHT);
 	printf("Coordinate: %d, %d\n", coordinate[0], coordinate[1]);
 	printf("Response = %d\n", response);
 
-	image_free(&gray);
 	return 1;
 }
 
@@ -57,108 +91,171 @@ extern bool_t detect_window(struct image_t *img){
 uint16_t detect_window_sizes(uint8_t *in, uint32_t image_width, uint32_t image_height, uint16_t *coordinate,
                              uint32_t *integral_image, uint8_t MODE)
 {
-  // whether to calculate the integral image (only do once):
-  uint8_t calculate_integral_image = 1;
-  // whether the algorithm will determine the size of the window on the basis of the average distance to objects in view
-  uint8_t determine_size = 0;
-  uint16_t sizes[N_WINDOW_SIZES];
-  uint16_t best_response[N_WINDOW_SIZES];
+  struct window_size_t sizes[N_WINDOW_SIZES];
   uint16_t best_index = 0;
-  uint16_t best_xc = 0;
-  uint16_t best_yc = 0;
-  uint16_t s = 0;
-  sizes[0] = 100; //sizes[1] = 40; sizes[2] = 50; sizes[3] = 60;
+  uint16_t max_feature_size = 0;
+  uint16_t s, y;
 
+  window_size_init(&sizes[0], 100); //sizes[1] = 40; sizes[2] = 50; sizes[3] = 60;
   for (s = 0; s < N_WINDOW_SIZES; s++) {
+    if (sizes[s].feature_size > max_feature_size) {
+      max_feature_size = sizes[s].feature_size;
+    }
+  }
+
+  // calculate the integral image only once for all window sizes
+  get_integral_image(in, image_width, image_height, integral_image);
+
+  // evaluate all sizes line by line, so the lines of the integral image are reused while in cache
+  for (y = 0; y + max_feature_size < image_height; y++) {
+    for (s = 0; s < N_WINDOW_SIZES; s++) {
+      window_size_line(&sizes[s], y, integral_image, image_width, image_height, MODE);
+    }
+  }
+  for (s = 0; s < N_WINDOW_SIZES && max_feature_size < image_height; s++) {
+    for (y = image_height - max_feature_size; y + sizes[s].feature_size < image_height; y++) {
+      window_size_line(&sizes[s], y, integral_image, image_width, image_height, MODE);
+    }
+  }
 
-    // coordinate will contain the coordinate, best_response will be the best match * 100
-    calculate_integral_image = (s == 0); // only calculate the integal image for the first window size
-    best_response[s] = detect_window_one_size(in, image_width, image_height, coordinate, determine_size, &sizes[s],
-                                    calculate_integral_image, integral_image, MODE);
-   	if (s == 0 || best_response[s] < best_response[best_index]) {
-   		best_index = s;
-   		best_xc = coordinate[0];
-   		best_yc = coordinate[1];
-   	}
+  for (s = 0; s < N_WINDOW_SIZES; s++) {
+    if (s == 0 || sizes[s].min_response < sizes[best_index].min_response) {
+      best_index = s;
+    }
   }
 
-  coordinate[0] = best_xc;
-  coordinate[1] = best_yc;
-  return best_response[best_index];
+  // the coordinate is at the top left corner of the feature,
+  // the center of the window is then at:
+  coordinate[0] = sizes[best_index].coordinate[0] + sizes[best_index].feature_size / 2;
+  coordinate[1] = sizes[best_index].coordinate[1] + sizes[best_index].feature_size / 2;
+  return sizes[best_index].min_response;
 }
 
 uint16_t detect_window_one_size(uint8_t *in, uint32_t image_width, uint32_t image_height, uint16_t *coordinate,
-                       uint8_t determine_size, uint16_t *size, uint8_t calculate_integral_image, uint32_t *integral_image, uint8_t MODE)
+                       uint8_t determine_size, uint16_t *size, uint8_t calculate_integral_image,
+                       uint32_t *integral_image, uint8_t MODE)
 {
   /*
    * Steps:
-   * (0) filter out the bad pixels (i.e., those lower than 4) and replace them with a disparity of 6.
    * (1) get integral image (if calculate_integral_image == 1)
-   * (2) get average disparity to determine probable size (if determine_size == 1)
-   * (3) determine responses per location while determining the best-matching location (put it in coordinate)
+   * (2) determine responses per location while determining the best-matching location (put it in coordinate)
    */
-
-  // output of the function:
-  uint16_t min_response = RES;
-
-  // parameters:
-  uint16_t image_border = 10;
-  uint16_t window_size, border_size, feature_size, px_whole, px_inner, px_border, px_outer;
-  uint16_t relative_border = 15; // border in percentage of window size
-
-  // declaration other vars:
-  uint16_t x, y;
-  uint32_t response;
+  struct window_size_t ws;
+  uint16_t y;
 
   // (1) get integral image (if calculate_integral_image == 1)
-
   if (calculate_integral_image) {
     get_integral_image(in, image_width, image_height, integral_image);
   }
 
+  // (2) determine a response map for that size
+  window_size_init(&ws, *size);
+  for (y = 0; y + ws.feature_size < image_height; y++) {
+    window_size_line(&ws, y, integral_image, image_width, image_height, MODE);
+  }
+
+  // the coordinate is at the top left corner of the feature,
+  // the center of the window is then at:
+  coordinate[0] = ws.coordinate[0] + ws.feature_size / 2;
+  coordinate[1] = ws.coordinate[1] + ws.feature_size / 2;
+
+  return ws.min_response;
+}
+
+/**
+ * Compute the parameters of a window size
+ * @param[out] ws The window size
+ * @param[in] window_size The window size without border
+ */
+static void window_size_init(struct window_size_t *ws, uint16_t window_size)
+{
+  uint16_t relative_border = 15; // border in percentage of window size
+  uint16_t px_whole;
+
   // window size is without border, feature size is with border:
-  window_size = (*size);
-  border_size = (relative_border * window_size) / 100; // percentage
-  feature_size = window_size + 2 * border_size;
-  px_inner = feature_size - 2 * border_size;
-  px_inner = px_inner * px_inner;
-  px_whole = feature_size * feature_size;
-  px_border = px_whole - px_inner;
-  px_outer = border_size * window_size;
-
-  //print_number(px_inner, 0); print_space();
-
-  // (3) determine a response map for that size
-  for (x = 0; x < image_width - feature_size; x++) {
-    for (y = 0; y < image_height - feature_size; y++) {
-      response = get_window_response(x, y, feature_size, border_size, integral_image, image_width, image_height, px_inner, px_border, MODE);
-
-      if (response < RES) {
-		  if(MODE == MODE_DARK){
-			// the inside is further away than the outside, perform the border test:
-			response = get_border_response(x, y, feature_size, window_size, border_size, integral_image, image_width, image_height, px_inner, px_outer);
-		  }
-
-        if (response < min_response) {
-      		coordinate[0] = x;
-       		coordinate[1] = y;
-			min_response = response;
-        }
-      } else {
-        //in[x+y*image_width] = 255;
+  ws->window_size = window_size;
+  ws->border_size = (relative_border * window_size) / 100; // percentage
+  ws->feature_size = window_size + 2 * ws->border_size;
+  ws->px_inner = ws->feature_size - 2 * ws->border_size;
+  ws->px_inner = ws->px_inner * ws->px_inner;
+  px_whole = ws->feature_size * ws->feature_size;
+  ws->px_border = px_whole - ws->px_inner;
+  ws->px_outer = ws->border_size * window_size;
+  ws->min_response = RES;
+  ws->coordinate[0] = 0;
+  ws->coordinate[1] = 0;
+}
 
-      }
+/**
+ * Response of a window from the sums of the whole feature and of the inner part
+ */
+static inline uint16_t window_response(uint32_t whole_area, uint32_t inner_area, uint16_t px_inner, uint16_t px_border,
+                                       uint8_t MODE)
+{
+  uint32_t resp = RES;
+
+  if (MODE == MODE_DARK) {
+    if (whole_area - inner_area > 0) {
+      resp = (inner_area * RES * px_border) / ((whole_area - inner_area) * px_inner);
+    }
+  } else if (MODE == MODE_BRIGHT) {
+    if (inner_area / px_inner > 0) {
+      resp = (RES * (whole_area - inner_area) / px_border) / (inner_area / px_inner);
     }
   }
 
-  //in[coordinate[0]+coordinate[1]*image_width] = 255;
+  return resp;
+}
 
-  // the coordinate is at the top left corner of the feature,
-  // the center of the window is then at:
-  coordinate[0] += feature_size / 2;
-  coordinate[1] += feature_size / 2;
+/**
+ * Evaluate all the windows with their top left corner on one line.
+ * The best response is the first one in column order (x first), like
+ * a scan of the columns would give.
+ */
+static void window_size_line(struct window_size_t *ws, uint16_t y, uint32_t *integral_image,
+                             uint32_t image_width, uint32_t image_height, uint8_t MODE)
+{
+  if (image_width <= ws->feature_size) {
+    return;
+  }
+
+  uint16_t n = image_width - ws->feature_size;
+  uint16_t border = ws->border_size;
+  uint32_t whole[n], inner[n];
+  uint16_t x;
+
+  integral_image_box_row(integral_image, image_width, 0, y, ws->feature_size, ws->feature_size, n, whole);
+  integral_image_box_row(integral_image, image_width, border, y + border, ws->feature_size - 2 * border,
+                         ws->feature_size - 2 * border, n, inner);
+
+  for (x = 0; x < n; x++) {
+    if (MODE == MODE_BRIGHT) {
+      // reject without divisions the windows that cannot beat the best one:
+      // floor(a / px_border) >= (a - px_border + 1) / px_border and
+      // floor(inner / px_inner) <= inner / px_inner
+      uint32_t a = RES * (whole[x] - inner[x]);
+      if (a + 1 >= ws->px_border &&
+          (uint64_t)(a + 1 - ws->px_border) * ws->px_inner >=
+          (uint64_t)(ws->min_response + 1) * inner[x] * ws->px_border) {
+        continue;
+      }
+    }
+
+    uint16_t response = window_response(whole[x], inner[x], ws->px_inner, ws->px_border, MODE);
+    if (response < RES) {
+      if (MODE == MODE_DARK) {
+        // the inside is further away than the outside, perform the border test:
+        response = get_border_response(x, y, ws->feature_size, ws->window_size, border, integral_image, image_width,
+                                       image_height, ws->px_inner, ws->px_outer);
+      }
 
-  return min_response;
+      if (response < ws->min_response || (response == ws->min_response && x < ws->coordinate[0])) {
+        ws->coordinate[0] = x;
+        ws->coordinate[1] = y;
+        ws->min_response = response;
+      }
+    }
+  }
 }
 
 // this function can help if the window is not visible anymore:
@@ -198,21 +295,7 @@ uint16_t detect_escape(uint8_t *in, uint32_t image_width, uint32_t image_height,
 
 void get_integral_image(uint8_t *in, uint32_t image_width, uint32_t image_height, uint32_t *integral_image)
 {
-  uint16_t x, y;
-  for (x = 0; x < image_width; x++) {
-    for (y = 0; y < image_height; y++) {
-      if (x >= 1 && y >= 1) {
-        integral_image[x + y * image_width] = (uint32_t) in[x + y * image_width] + integral_image[x - 1 + y * image_width] +
-                                              integral_image[x + (y - 1) * image_width] - integral_image[x - 1 + (y - 1) * image_width];
-      } else if (x >= 1) {
-        integral_image[x + y * image_width] = (uint32_t) in[x + y * image_width] + integral_image[x - 1 + y * image_width];
-      } else if (y >= 1) {
-        integral_image[x + y * image_width] = (uint32_t) in[x + y * image_width] + integral_image[x + (y - 1) * image_width];
-      } else {
-        integral_image[x + y * image_width] = (uint32_t) in[x + y * image_width];
-      }
-    }
-  }
+  integral_image_compute(in, image_width, image_height, integral_image);
 }
 
 uint32_t get_sum_disparities(uint16_t min_x, uint16_t min_y, uint16_t max_x, uint16_t max_y, uint32_t *integral_image,
@@ -248,39 +331,14 @@ uint32_t get_avg_disparity(uint16_t min_x, uint16_t min_y, uint16_t max_x, uint1
 uint16_t get_window_response(uint16_t x, uint16_t y, uint16_t feature_size, uint16_t border, uint32_t *integral_image,
                              uint16_t image_width, uint16_t image_height, uint16_t px_inner, uint16_t px_border, uint8_t MODE)
 {
-  uint32_t whole_area, inner_area, resp;
+  uint32_t whole_area, inner_area;
 
   whole_area = get_sum_disparities(x, y, x + feature_size, y + feature_size, integral_image, image_width, image_height);
 
   inner_area = get_sum_disparities(x + border, y + border, x + feature_size - border, y + feature_size - border,
                                    integral_image, image_width, image_height);
 
-  if(MODE == MODE_DARK)
-  {
-	  if(whole_area-inner_area > 0)
-	  {
-		  resp = (inner_area * RES * px_border) / ((whole_area - inner_area) * px_inner);
-	  }
-	  else
-	  {
-		  resp = RES;
-	  }
-  }
-  else if(MODE == MODE_BRIGHT)
-  {
-	  if(inner_area > 0)
-	  {
-		  resp = (RES*(whole_area - inner_area)/px_border) / (inner_area/px_inner);
-		  //printf("%u: %u %u %u %u\n",resp,(RES*RES*(whole_area - inner_area)/px_border), (inner_area/px_inner), px_inner, px_border);
-	  }
-	  else
-	  {
-		  resp = RES;
-	  }
-  }
-
-
-   return resp;
+  return window_response(whole_area, inner_area, px_inner, px_border, MODE);
 }
 
 uint16_t get_border_response(uint16_t x, uint16_t y, uint16_t feature_size, uint16_t window_size, uint16_t border,
@@ -20,6 +20,15 @@
  * Encode images with the use of the JPEG encoding
  */
 
+/**
+ * Use the fast integer AAN DCT, with the level shift folded in the DC
+ * coefficient and the AAN output scaling merged into the quantization tables.
+ * Set to FALSE to use the original DCT.
+ */
+#ifndef JPEG_FAST_DCT
+#define JPEG_FAST_DCT TRUE
+#endif
+
 static inline unsigned char svs_size_code(int w)
 {
   // 1=(40,30) 2=(128,96) 3=(160,120) 5=(320,240) 7=(640,480) 9=(1280,1024);
@@ -60,6 +69,12 @@ int jpeg_create_svs_header(unsigned char *jpegbuf, int32_t size, int w)
 }
 
 
+#define JPEG_BLOCK_SIZE 64
+
+/**
+ * State of one encoding, nothing is shared between calls so several
+ * threads can encode at the same time
+ */
 typedef struct JPEG_ENCODER_STRUCTURE {
   uint16_t    mcu_width;
   uint16_t    mcu_height;
@@ -81,26 +96,56 @@ typedef struct JPEG_ENCODER_STRUCTURE {
   int16_t ldc2;
   int16_t ldc3;
 
+  /* Quantization tables of the quality factor */
+  uint8_t     Lqt [JPEG_BLOCK_SIZE];
+  uint8_t     Cqt [JPEG_BLOCK_SIZE];
+#if JPEG_FAST_DCT
+  int32_t     ILqt_aan [JPEG_BLOCK_SIZE];   ///< AAN quantization reciprocals, in ZigZag order
+  int32_t     ICqt_aan [JPEG_BLOCK_SIZE];   ///< AAN quantization reciprocals, in ZigZag order
+#else
+  uint16_t    ILqt [JPEG_BLOCK_SIZE];
+  uint16_t    ICqt [JPEG_BLOCK_SIZE];
+#endif
+
+  /* Blocks of the current MCU */
+  int16_t     Y1 [JPEG_BLOCK_SIZE];
+  int16_t     Y2 [JPEG_BLOCK_SIZE];
+  int16_t     CB [JPEG_BLOCK_SIZE];
+  int16_t     CR [JPEG_BLOCK_SIZE];
+  int16_t     Temp [JPEG_BLOCK_SIZE];
+  uint8_t     last_nonzero;   ///< Zigzag index of the last non zero coefficient in Temp
+
+  /* Bit buffer of the Huffman coder */
+  uint32_t    lcode;
+  uint16_t    bitindex;
+
+  void (*read_format)(struct JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *input_ptr);
 } JPEG_ENCODER_STRUCTURE;
 
 
 static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *, uint32_t, uint32_t, uint32_t);
 //static void jpeg_initialize_quantization_tables(uint32_t);
 
-static uint8_t *jpeg_write_markers(uint8_t *, uint32_t, uint32_t, uint32_t);
+static void jpeg_make_tables(JPEG_ENCODER_STRUCTURE *, int);
+static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *, uint8_t *, uint32_t, uint32_t, uint32_t);
 
 static void jpeg_read_400_format(JPEG_ENCODER_STRUCTURE *, uint8_t *);
 static void jpeg_read_422_format(JPEG_ENCODER_STRUCTURE *, uint8_t *);
 
 static uint8_t *jpeg_encodeMCU(JPEG_ENCODER_STRUCTURE *, uint32_t, uint8_t *);
 
+#if JPEG_FAST_DCT
+static void jpeg_DCT_AAN(int16_t *);
+static void jpeg_quantization_AAN(JPEG_ENCODER_STRUCTURE *, int16_t *, int32_t *);
+#else
 static void jpeg_levelshift(int16_t *);
 static void jpeg_DCT(int16_t *);
 
-static void jpeg_quantization(int16_t *, uint16_t *);
+static void jpeg_quantization(JPEG_ENCODER_STRUCTURE *, int16_t *, uint16_t *);
+#endif
 static uint8_t *jpeg_huffman(JPEG_ENCODER_STRUCTURE *, uint16_t, uint8_t *);
 
-static uint8_t *jpeg_close_bitstream(uint8_t *);
+static uint8_t *jpeg_close_bitstream(JPEG_ENCODER_STRUCTURE *, uint8_t *);
 
 //static int16_t fdct_coeff[8] = {0x5a82, 0x5a82, 0x30fb, 0x7641, 0x18f8, 0x7d8a, 0x471c, 0x6a6d};
 //static int16_t fdct_temp[64];
@@ -265,6 +310,20 @@ static uint8_t zigzag_table [] = {
   21, 34, 37, 47, 50, 56, 59, 61,
   35, 36, 48, 49, 57, 58, 62, 63
 };
+
+#if JPEG_FAST_DCT
+/* Natural index of the coefficients in ZigZag order (inverse of zigzag_table) */
+static uint8_t natural_order_table [] = {
+  0,  1,  8, 16,  9,  2,  3, 10,
+  17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34,
+  27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36,
+  29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46,
+  53, 60, 61, 54, 47, 55, 62, 63
+};
+#endif
 /*static uint8_t luminance_quant_table [] = {
   16, 11, 10, 16,  24,  40,  51,  61,
   12, 12, 14, 19,  26,  58,  60,  55,
@@ -287,25 +346,6 @@ static uint8_t chrominance_quant_table [] = {
   99, 99, 99, 99, 99, 99, 99, 99
 };*/
 
-#define JPEG_BLOCK_SIZE 64
-static uint8_t    Lqt [JPEG_BLOCK_SIZE];
-static uint8_t    Cqt [JPEG_BLOCK_SIZE];
-static uint16_t   ILqt [JPEG_BLOCK_SIZE];
-static uint16_t   ICqt [JPEG_BLOCK_SIZE];
-
-static int16_t    Y1 [JPEG_BLOCK_SIZE];
-static int16_t    Y2 [JPEG_BLOCK_SIZE];
-//static int16_t    Y3 [JPEG_BLOCK_SIZE];
-//static int16_t    Y4 [JPEG_BLOCK_SIZE];
-static int16_t    CB [JPEG_BLOCK_SIZE];
-static int16_t    CR [JPEG_BLOCK_SIZE];
-static int16_t    Temp [JPEG_BLOCK_SIZE];
-static uint32_t   lcode = 0;
-static uint16_t   bitindex = 0;
-
-
-void (*read_format)(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *input_ptr);
-
 static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *jpeg, uint32_t image_format, uint32_t image_width, uint32_t image_height)
 {
   uint16_t mcu_width, mcu_height, bytes_per_pixel;
@@ -318,7 +358,7 @@ static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *jpeg, uint32_t image_for
     jpeg->vertical_mcus = (uint16_t)((image_height + mcu_height - 1) >> 3);
 
     bytes_per_pixel = 1;
-    read_format = jpeg_read_400_format;
+    jpeg->read_format = jpeg_read_400_format;
   } else {
     jpeg->mcu_width = mcu_width = 16;
     jpeg->horizontal_mcus = (uint16_t)((image_width + mcu_width - 1) >> 4);
@@ -326,7 +366,7 @@ static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *jpeg, uint32_t image_for
     jpeg->mcu_height = mcu_height = 8;
     jpeg->vertical_mcus = (uint16_t)((image_height + mcu_height - 1) >> 3);
     bytes_per_pixel = 2;
-    read_format = jpeg_read_422_format;
+    jpeg->read_format = jpeg_read_422_format;
   }
 
   jpeg->rows_in_bottom_mcus = (uint16_t)(image_height - (jpeg->vertical_mcus - 1) * mcu_height);
@@ -342,8 +382,8 @@ static void jpeg_initialization(JPEG_ENCODER_STRUCTURE *jpeg, uint32_t image_for
   jpeg->ldc1 = 0;
   jpeg->ldc2 = 0;
   jpeg->ldc3 = 0;
-  lcode = 0;
-  bitindex = 0;
+  jpeg->lcode = 0;
+  jpeg->bitindex = 0;
 }
 
 /////////////////////////////////////////////////////////////
@@ -380,10 +420,9 @@ static const int jpeg_chroma_quantizer[64] = {
 };
 
 /*
- * Call MakeTables with the Q factor and two u_char[64] return arrays
+ * Compute the quantization tables of the encoder for the Q factor
  */
-void MakeTables(int q);
-void MakeTables(int q)
+static void jpeg_make_tables(JPEG_ENCODER_STRUCTURE *jpeg, int q)
 {
   int i;
   int factor = q;
@@ -404,14 +443,27 @@ void MakeTables(int q)
     /* Limit the quantizers to 1 <= q <= 255 */
     if (lq < 1) { lq = 1; }
     else if (lq > 255) { lq = 255; }
-    Lqt [i] = (uint8_t) lq;
-    ILqt [i] = 0x8000 / lq;
+    jpeg->Lqt [i] = (uint8_t) lq;
 
     if (cq < 1) { cq = 1; }
     else if (cq > 255) { cq = 255; }
-    Cqt [i] = (uint8_t) cq;
+    jpeg->Cqt [i] = (uint8_t) cq;
+
+#if JPEG_FAST_DCT
+    /* The AAN DCT output is scaled by 8 * aan_scale[row] * aan_scale[col],
+     * merge this into the quantization reciprocals (18 bit fixed point) */
+    static const float aan_scale[8] = {
+      1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+      1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+    };
+    float scale = 8.0f * aan_scale[i >> 3] * aan_scale[i & 7];
+    jpeg->ILqt_aan [zigzag_table [i]] = (int32_t)((1 << 18) / (lq * scale) + 0.5f);
+    jpeg->ICqt_aan [zigzag_table [i]] = (int32_t)((1 << 18) / (cq * scale) + 0.5f);
+#else
+    jpeg->ILqt [i] = 0x8000 / lq;
     //ICqt [i] = DSP_Division (0x8000, value);
-    ICqt [i] = 0x8000 / cq;
+    jpeg->ICqt [i] = 0x8000 / cq;
+#endif
   }
 }
 
@@ -445,11 +497,11 @@ void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality
   /* Quantization Table Initialization */
   //jpeg_initialize_quantization_tables (quality_factor);
 
-  MakeTables(quality_factor);
+  jpeg_make_tables(jpeg_encoder_structure, quality_factor);
 
   /* Writing Marker Data */
   if (add_dri_header) {
-    output_ptr = jpeg_write_markers(output_ptr, image_format, in->w, in->h);
+    output_ptr = jpeg_write_markers(jpeg_encoder_structure, output_ptr, image_format, in->w, in->h);
   }
 
   for (i = 1; i <= jpeg_encoder_structure->vertical_mcus; i++) {
@@ -468,7 +520,7 @@ void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality
         jpeg_encoder_structure->incr = jpeg_encoder_structure->length_minus_width;
       }
 
-      read_format(jpeg_encoder_structure, input_ptr);
+      jpeg_encoder_structure->read_format(jpeg_encoder_structure, input_ptr);
 
       /* Encode the data in MCU */
       output_ptr = jpeg_encodeMCU(jpeg_encoder_structure, image_format, output_ptr);
@@ -480,7 +532,7 @@ void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality
   }
 
   /* Close Routine */
-  output_ptr = jpeg_close_bitstream(output_ptr);
+  output_ptr = jpeg_close_bitstream(jpeg_encoder_structure, output_ptr);
   out->w = in->w;
   out->h = in->h;
   out->buf_size = output_ptr - (uint8_t *)out->buf;
@@ -488,30 +540,54 @@ void jpeg_encode_image(struct image_t *in, struct image_t *out, uint32_t quality
 
 static uint8_t *jpeg_encodeMCU(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint32_t image_format, uint8_t *output_ptr)
 {
-  jpeg_levelshift(Y1);
-  jpeg_DCT(Y1);
-  jpeg_quantization(Y1, ILqt);
+  JPEG_ENCODER_STRUCTURE *jpeg = jpeg_encoder_structure;
+
+#if JPEG_FAST_DCT
+  jpeg_DCT_AAN(jpeg->Y1);
+  jpeg_quantization_AAN(jpeg, jpeg->Y1, jpeg->ILqt_aan);
   output_ptr = jpeg_huffman(jpeg_encoder_structure, 1, output_ptr);
 
   if (image_format == FOUR_TWO_TWO) {
-    jpeg_levelshift(Y2);
-    jpeg_DCT(Y2);
-    jpeg_quantization(Y2, ILqt);
+    jpeg_DCT_AAN(jpeg->Y2);
+    jpeg_quantization_AAN(jpeg, jpeg->Y2, jpeg->ILqt_aan);
     output_ptr = jpeg_huffman(jpeg_encoder_structure, 1, output_ptr);
 
-    jpeg_levelshift(CB);
-    jpeg_DCT(CB);
-    jpeg_quantization(CB, ICqt);
+    jpeg_DCT_AAN(jpeg->CB);
+    jpeg_quantization_AAN(jpeg, jpeg->CB, jpeg->ICqt_aan);
     output_ptr = jpeg_huffman(jpeg_encoder_structure, 2, output_ptr);
 
-    jpeg_levelshift(CR);
-    jpeg_DCT(CR);
-    jpeg_quantization(CR, ICqt);
+    jpeg_DCT_AAN(jpeg->CR);
+    jpeg_quantization_AAN(jpeg, jpeg->CR, jpeg->ICqt_aan);
     output_ptr = jpeg_huffman(jpeg_encoder_structure, 3, output_ptr);
   }
   return output_ptr;
+#else
+  jpeg_levelshift(jpeg->Y1);
+  jpeg_DCT(jpeg->Y1);
+  jpeg_quantization(jpeg, jpeg->Y1, jpeg->ILqt);
+  output_ptr = jpeg_huffman(jpeg_encoder_structure, 1, output_ptr);
+
+  if (image_format == FOUR_TWO_TWO) {
+    jpeg_levelshift(jpeg->Y2);
+    jpeg_DCT(jpeg->Y2);
+    jpeg_quantization(jpeg, jpeg->Y2, jpeg->ILqt);
+    output_ptr = jpeg_huffman(jpeg_encoder_structure, 1, output_ptr);
+
+    jpeg_levelshift(jpeg->CB);
+    jpeg_DCT(jpeg->CB);
+    jpeg_quantization(jpeg, jpeg->CB, jpeg->ICqt);
+    output_ptr = jpeg_huffman(jpeg_encoder_structure, 2, output_ptr);
+
+    jpeg_levelshift(jpeg->CR);
+    jpeg_DCT(jpeg->CR);
+    jpeg_quantization(jpeg, jpeg->CR, jpeg->ICqt);
+    output_ptr = jpeg_huffman(jpeg_encoder_structure, 3, output_ptr);
+  }
+  return output_ptr;
+#endif
 }
 
+#if !JPEG_FAST_DCT
 /* Level shifting to get 8 bit SIGNED values for the data  */
 static void jpeg_levelshift(int16_t *const data)
 {
@@ -610,6 +686,120 @@ static void jpeg_DCT(int16_t *data)
     data++;
   }
 }
+#endif
+
+#if JPEG_FAST_DCT
+/* AAN constants in 8 bit fixed point */
+#define AAN_0_382683433 98
+#define AAN_0_541196100 139
+#define AAN_0_707106781 181
+#define AAN_1_306562965 334
+#define AAN_MUL(_v, _c) (((_v) * (_c)) >> 8)
+
+/**
+ * Fast integer forward DCT for one 8x8 block (Arai, Agui and Nakajima).
+ * Only 5 multiplications per row/column, the output is scaled by
+ * 8 * aan_scale[row] * aan_scale[col] which is compensated in the quantization.
+ * The level shift is applied on the DC coefficient only.
+ */
+static void jpeg_DCT_AAN(int16_t *data)
+{
+  int32_t tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+  int32_t tmp10, tmp11, tmp12, tmp13;
+  int32_t z1, z2, z3, z4, z5, z11, z13;
+  int16_t *d;
+  uint8_t i;
+
+  /* Rows */
+  for (i = 0, d = data; i < 8; i++, d += 8) {
+    tmp0 = d[0] + d[7];
+    tmp7 = d[0] - d[7];
+    tmp1 = d[1] + d[6];
+    tmp6 = d[1] - d[6];
+    tmp2 = d[2] + d[5];
+    tmp5 = d[2] - d[5];
+    tmp3 = d[3] + d[4];
+    tmp4 = d[3] - d[4];
+
+    /* Even part */
+    tmp10 = tmp0 + tmp3;
+    tmp13 = tmp0 - tmp3;
+    tmp11 = tmp1 + tmp2;
+    tmp12 = tmp1 - tmp2;
+
+    d[0] = (int16_t)(tmp10 + tmp11);
+    d[4] = (int16_t)(tmp10 - tmp11);
+
+    z1 = AAN_MUL(tmp12 + tmp13, AAN_0_707106781);
+    d[2] = (int16_t)(tmp13 + z1);
+    d[6] = (int16_t)(tmp13 - z1);
+
+    /* Odd part */
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    z5 = AAN_MUL(tmp10 - tmp12, AAN_0_382683433);
+    z2 = AAN_MUL(tmp10, AAN_0_541196100) + z5;
+    z4 = AAN_MUL(tmp12, AAN_1_306562965) + z5;
+    z3 = AAN_MUL(tmp11, AAN_0_707106781);
+
+    z11 = tmp7 + z3;
+    z13 = tmp7 - z3;
+
+    d[5] = (int16_t)(z13 + z2);
+    d[3] = (int16_t)(z13 - z2);
+    d[1] = (int16_t)(z11 + z4);
+    d[7] = (int16_t)(z11 - z4);
+  }
+
+  /* Columns */
+  for (i = 0, d = data; i < 8; i++, d++) {
+    tmp0 = d[0] + d[56];
+    tmp7 = d[0] - d[56];
+    tmp1 = d[8] + d[48];
+    tmp6 = d[8] - d[48];
+    tmp2 = d[16] + d[40];
+    tmp5 = d[16] - d[40];
+    tmp3 = d[24] + d[32];
+    tmp4 = d[24] - d[32];
+
+    /* Even part */
+    tmp10 = tmp0 + tmp3;
+    tmp13 = tmp0 - tmp3;
+    tmp11 = tmp1 + tmp2;
+    tmp12 = tmp1 - tmp2;
+
+    d[0] = (int16_t)(tmp10 + tmp11);
+    d[32] = (int16_t)(tmp10 - tmp11);
+
+    z1 = AAN_MUL(tmp12 + tmp13, AAN_0_707106781);
+    d[16] = (int16_t)(tmp13 + z1);
+    d[48] = (int16_t)(tmp13 - z1);
+
+    /* Odd part */
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    z5 = AAN_MUL(tmp10 - tmp12, AAN_0_382683433);
+    z2 = AAN_MUL(tmp10, AAN_0_541196100) + z5;
+    z4 = AAN_MUL(tmp12, AAN_1_306562965) + z5;
+    z3 = AAN_MUL(tmp11, AAN_0_707106781);
+
+    z11 = tmp7 + z3;
+    z13 = tmp7 - z3;
+
+    d[40] = (int16_t)(z13 + z2);
+    d[24] = (int16_t)(z13 - z2);
+    d[8] = (int16_t)(z11 + z4);
+    d[56] = (int16_t)(z11 - z4);
+  }
+
+  /* Level shift: subtracting 128 from all 64 inputs only changes DC (scaled by 8 * 8) */
+  data[0] -= 128 * 64;
+}
+#endif
 
 #define PUTBITS    \
   {    \
@@ -646,8 +836,11 @@ static uint8_t *jpeg_huffman(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uin
   int16_t bits_in_next_word;
   uint16_t numbits;
   uint32_t data;
+  uint32_t lcode = jpeg_encoder_structure->lcode;
+  uint16_t bitindex = jpeg_encoder_structure->bitindex;
+  uint8_t last_nonzero = jpeg_encoder_structure->last_nonzero;
 
-  Temp_Ptr = Temp;
+  Temp_Ptr = jpeg_encoder_structure->Temp;
   Coeff = *Temp_Ptr++;
 
   if (component == 1) {
@@ -677,9 +870,10 @@ static uint8_t *jpeg_huffman(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uin
 
   AbsCoeff = (Coeff < 0) ? -Coeff-- : Coeff;
 
-  while (AbsCoeff != 0) {
-    AbsCoeff >>= 1;
-    DataSize++;
+  if (AbsCoeff >> 8 == 0) {
+    DataSize = bitsize [AbsCoeff];
+  } else {
+    DataSize = bitsize [AbsCoeff >> 8] + 8;
   }
 
   HuffCode = DcCodeTable [DataSize];
@@ -691,7 +885,7 @@ static uint8_t *jpeg_huffman(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uin
 
   PUTBITS
 
-  for (i = 63; i > 0; i--) {
+  for (i = last_nonzero; i > 0; i--) {
     if ((Coeff = *Temp_Ptr++) != 0) {
       while (RunLength > 15) {
         RunLength -= 16;
@@ -723,19 +917,25 @@ static uint8_t *jpeg_huffman(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uin
     }
   }
 
-  if (RunLength != 0) {
+  // End of block when the last coefficients are zero
+  if (last_nonzero < 63) {
     data = AcCodeTable [0];
     numbits = AcSizeTable [0];
     PUTBITS
   }
+
+  jpeg_encoder_structure->lcode = lcode;
+  jpeg_encoder_structure->bitindex = bitindex;
   return output_ptr;
 }
 
 /* For bit Stuffing and EOI marker */
-static uint8_t *jpeg_close_bitstream(uint8_t *output_ptr)
+static uint8_t *jpeg_close_bitstream(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *output_ptr)
 {
   uint16_t i, count;
   uint8_t *ptr;
+  uint32_t lcode = jpeg_encoder_structure->lcode;
+  uint16_t bitindex = jpeg_encoder_structure->bitindex;
 
   if (bitindex > 0) {
     lcode <<= (32 - bitindex);
@@ -758,7 +958,7 @@ static uint8_t *jpeg_close_bitstream(uint8_t *output_ptr)
   return output_ptr;
 }
 
-static uint8_t *jpeg_write_markers(uint8_t *output_ptr, uint32_t image_format, uint32_t image_width, uint32_t image_height)
+static uint8_t *jpeg_write_markers(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *output_ptr, uint32_t image_format, uint32_t image_width, uint32_t image_height)
 {
   uint16_t i, header_length;
   uint8_t number_of_components;
@@ -780,7 +980,7 @@ static uint8_t *jpeg_write_markers(uint8_t *output_ptr, uint32_t image_format, u
 
   // Lqt table
   for (i = 0; i < 64; i++) {
-    *output_ptr++ = Lqt [i];
+    *output_ptr++ = jpeg_encoder_structure->Lqt [i];
   }
 
   // Quantization table marker
@@ -796,7 +996,7 @@ static uint8_t *jpeg_write_markers(uint8_t *output_ptr, uint32_t image_format, u
 
   // Cqt table
   for (i = 0; i < 64; i++) {
-    *output_ptr++ = Cqt [i];
+    *output_ptr++ = jpeg_encoder_structure->Cqt [i];
   }
 
   if (image_format == FOUR_ZERO_ZERO) {
@@ -945,24 +1145,53 @@ static uint8_t *jpeg_write_markers(uint8_t *output_ptr, uint32_t image_format, u
   }
 }*/
 
+#if !JPEG_FAST_DCT
 /* multiply DCT Coefficients with Quantization table and store in ZigZag location */
-static void jpeg_quantization(int16_t *const data, uint16_t *const quant_table_ptr)
+static void jpeg_quantization(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, int16_t *const data,
+                              uint16_t *const quant_table_ptr)
 {
   int16_t i;
   int32_t value;
+  int16_t *Temp = jpeg_encoder_structure->Temp;
+  uint8_t last_nonzero = 0;
 
   for (i = 63; i >= 0; i--) {
     value = data [i] * quant_table_ptr [i];
     value = (value + 0x4000) >> 15;
 
     Temp [zigzag_table [i]] = (int16_t) value;
+    if (value != 0 && zigzag_table [i] > last_nonzero) {
+      last_nonzero = zigzag_table [i];
+    }
+  }
+  jpeg_encoder_structure->last_nonzero = last_nonzero;
+}
+#endif
+
+#if JPEG_FAST_DCT
+/* Quantize the AAN DCT coefficients (descaling merged in the table) and store in ZigZag location */
+static void jpeg_quantization_AAN(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, int16_t *const data,
+                                  int32_t *const quant_table_ptr)
+{
+  uint8_t i;
+  int32_t value;
+  uint8_t last = 0;
+  int16_t *Temp = jpeg_encoder_structure->Temp;
+
+  /* Walk in ZigZag order so the last non zero coefficient comes for free */
+  for (i = 0; i < 64; i++) {
+    value = (data [natural_order_table [i]] * quant_table_ptr [i] + (1 << 17)) >> 18;
+    Temp [i] = (int16_t) value;
+    last = value ? i : last;
   }
+  jpeg_encoder_structure->last_nonzero = last;
 }
+#endif
 
 static void jpeg_read_400_format(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure, uint8_t *input_ptr)
 {
   int32_t i, j;
-  int16_t *Y1_Ptr = Y1;
+  int16_t *Y1_Ptr = jpeg_encoder_structure->Y1;
 
   uint16_t rows = jpeg_encoder_structure->rows;
   uint16_t cols = jpeg_encoder_structure->cols;
@@ -994,10 +1223,10 @@ static void jpeg_read_422_format(JPEG_ENCODER_STRUCTURE *jpeg_encoder_structure,
   int32_t i, j;
   uint16_t Y1_cols, Y2_cols;
 
-  int16_t *Y1_Ptr = Y1;
-  int16_t *Y2_Ptr = Y2;
-  int16_t *CB_Ptr = CB;
-  int16_t *CR_Ptr = CR;
+  int16_t *Y1_Ptr = jpeg_encoder_structure->Y1;
+  int16_t *Y2_Ptr = jpeg_encoder_structure->Y2;
+  int16_t *CB_Ptr = jpeg_encoder_structure->CB;
+  int16_t *CR_Ptr = jpeg_encoder_structure->CR;
 
   uint16_t rows = jpeg_encoder_structure->rows;
   uint16_t cols = jpeg_encoder_structure->cols;
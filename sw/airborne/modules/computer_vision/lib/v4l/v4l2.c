@@ -305,6 +305,7 @@ void v4l2_image_get(struct v4l2_device *dev, struct image_t *img)
       if (dev->buffers_deq_idx != V4L2_IMG_NONE) {
         img_idx = dev->buffers_deq_idx;
         dev->buffers_deq_idx = V4L2_IMG_NONE;
+        dev->buffers[img_idx].refcnt = 1;
       }
 
       pthread_mutex_unlock(&dev->mutex);
@@ -338,6 +339,7 @@ bool_t v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img)
   if (dev->buffers_deq_idx != V4L2_IMG_NONE) {
     img_idx = dev->buffers_deq_idx;
     dev->buffers_deq_idx = V4L2_IMG_NONE;
+    dev->buffers[img_idx].refcnt = 1;
   }
   pthread_mutex_unlock(&dev->mutex);
 
@@ -357,9 +359,26 @@ bool_t v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img)
   }
 }
 
+/**
+ * Add a user to an image we got from v4l2_image_get (Thread safe)
+ * This allows several consumers to read the memory mapped buffer without copying it.
+ * Every user must call v4l2_image_free() when done, the buffer is given back to the
+ * driver by the last one.
+ * @param[in] *dev The video for linux device which the image is from
+ * @param[in] *img The image to reference
+ */
+void v4l2_image_ref(struct v4l2_device *dev, struct image_t *img)
+{
+  pthread_mutex_lock(&dev->mutex);
+  dev->buffers[img->buf_idx].refcnt++;
+  pthread_mutex_unlock(&dev->mutex);
+}
+
 /**
  * Free the image and enqueue the buffer (Thread safe)
- * This must be done after processing the image, because else all buffers are locked
+ * This must be done after processing the image, because else all buffers are locked.
+ * When the image is referenced by several users, the buffer is only enqueued
+ * when the last one frees it.
  * @param[in] *dev The video for linux device which the image is from
  * @param[in] *img The image to free
  */
@@ -367,6 +386,16 @@ void v4l2_image_free(struct v4l2_device *dev, struct image_t *img)
 {
   struct v4l2_buffer buf;
 
+  // Drop our reference, the last user gives the buffer back
+  pthread_mutex_lock(&dev->mutex);
+  if (dev->buffers[img->buf_idx].refcnt > 1) {
+    dev->buffers[img->buf_idx].refcnt--;
+    pthread_mutex_unlock(&dev->mutex);
+    return;
+  }
+  dev->buffers[img->buf_idx].refcnt = 0;
+  pthread_mutex_unlock(&dev->mutex);
+
   // Enqueue the buffer
   CLEAR(buf);
   buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -42,6 +42,7 @@ struct v4l2_img_buf {
   size_t length;              ///< The size of the buffer
   struct timeval timestamp;   ///< The time value of the image
   void *buf;                  ///< Pointer to the memory mapped buffer
+  uint8_t refcnt;             ///< Amount of users of the dequeued buffer (enqueued again when it drops to 0)
 };
 
 /* V4L2 device */
@@ -53,7 +54,7 @@ struct v4l2_device {
   uint16_t h;                       ///< The height of the image
   uint8_t buffers_cnt;              ///< The number of image buffers
   volatile uint8_t buffers_deq_idx; ///< The current dequeued index
-  pthread_mutex_t mutex;            ///< Mutex lock for enqueue/dequeue of buffers (change the deq_idx)
+  pthread_mutex_t mutex;            ///< Mutex lock for enqueue/dequeue of buffers (change the deq_idx) and the refcnt
   struct v4l2_img_buf *buffers;     ///< The memory mapped image buffers
 };
 
@@ -63,6 +64,7 @@ struct v4l2_device *v4l2_init(char *device_name, uint16_t width, uint16_t height
                               uint32_t _pixelformat);
 void v4l2_image_get(struct v4l2_device *dev, struct image_t *img);
 bool_t v4l2_image_get_nonblock(struct v4l2_device *dev, struct image_t *img);
+void v4l2_image_ref(struct v4l2_device *dev, struct image_t *img);
 void v4l2_image_free(struct v4l2_device *dev, struct image_t *img);
 bool_t v4l2_start_capture(struct v4l2_device *dev);
 bool_t v4l2_stop_capture(struct v4l2_device *dev);
@@ -31,27 +31,115 @@ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+/**
+ * @file modules/computer_vision/lib/vision/fast_rosten.c
+ * FAST9 corner detection with non-maximum suppression and a corner budget.
+ *
+ * The segment test of Rosten (a corner has 9 contiguous pixels on the circle of
+ * 16 that are all brighter or all darker than the center) is evaluated with bit
+ * masks instead of the generated decision tree. On grayscale images a row is
+ * processed 16 pixels at a time: vector compares first reject on the 4 compass
+ * pixels (any arc of 9 pixels contains one of 0/8 and one of 4/12), then the
+ * arcs are found with vector ANDs and only the corners are scored.
+ *
+ * Detections are scored (sum of absolute differences over the arc side), only
+ * local maxima in their 3x3 neighbourhood are kept and spacing is enforced by a
+ * grid of min_dist sized cells keeping the FAST9_CELL_CORNERS strongest corners
+ * each. When more corners remain than requested, the strongest ones are returned.
+ */
+
 #include <stdlib.h>
+#include <string.h>
 #include "fast_rosten.h"
 
+#ifndef FAST9_USE_SIMD
+#define FAST9_USE_SIMD TRUE
+#endif
+
+#if FAST9_USE_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define FAST9_NEON 1
+#include <arm_neon.h>
+#elif FAST9_USE_SIMD && defined(__SSE2__)
+#define FAST9_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/** A scored corner in a grid cell */
+struct fast9_corner_t {
+  struct point_t pos;
+  uint16_t score;
+};
+
 static void fast_make_offsets(int32_t *pixel, uint16_t row_stride, uint8_t pixel_size);
+static uint16_t fast9_score(const uint8_t *p, const int32_t *pixel, uint8_t threshold);
+static void fast9_row(const uint8_t *row, const int32_t *pixel, uint8_t pixel_size, uint8_t threshold,
+                      uint16_t x_start, uint16_t x_end, uint16_t *scores);
+static uint16_t fast9_select_score(uint16_t *scores, uint32_t count, uint32_t k);
+
+/**
+ * Check if a mask of the 16 circle pixels contains 9 contiguous ones
+ * @param[in] mask The bit mask of the circle pixels
+ * @return Non zero when there is an arc of at least 9 pixels
+ */
+static inline uint32_t fast9_arc(uint32_t mask)
+{
+  mask |= mask << 16;     // wrap around the circle
+  mask &= mask >> 1;      // runs of 2
+  mask &= mask >> 2;      // runs of 4
+  mask &= mask >> 4;      // runs of 8
+  return mask & (mask >> 1); // runs of 9
+}
+
+/**
+ * Get the size of the scratch memory used by fast9_detect()
+ * @param[in] w The image width
+ * @param[in] h The image height
+ * @param[in] min_dist The minimum distance in pixels between detections
+ * @return The size in bytes
+ */
+uint32_t fast9_scratch_size(uint16_t w, uint16_t h, uint16_t min_dist)
+{
+  uint16_t cell_size = Max(min_dist, FAST9_MIN_CELL_SIZE);
+  uint32_t cells = ((w + cell_size - 1) / cell_size) * ((h + cell_size - 1) / cell_size);
+  return 3 * w * sizeof(uint16_t)
+         + cells * FAST9_CELL_CORNERS * (sizeof(struct fast9_corner_t) + sizeof(uint16_t))
+         + cells * sizeof(uint8_t)
+         + 4 * IMAGE_ARENA_ALIGN;
+}
 
 /**
  * Do a FAST9 corner detection
- * @param[in] *img The image to do the corner detection on
+ * The corners are written in a buffer provided by the caller. Temporary memory is
+ * taken from the arena and released again before returning.
+ * @param[in] *img The image to do the corner detection on (grayscale or YUV422)
  * @param[in] threshold The threshold which we use for FAST9
- * @param[in] min_dist The minimum distance in pixels between detections
+ * @param[in] min_dist The size in pixels of the grid cells used for spacing the corners
  * @param[in] x_padding The padding in the x direction to not scan for corners
  * @param[in] y_padding The padding in the y direction to not scan for corners
- * @param[out] *num_corner The amount of corners found
- * @return The corners found
+ * @param[out] *ret_corners The corners found
+ * @param[in] max_corners The corner budget, the strongest corners are kept (size of ret_corners)
+ * @param[out] *num_corners The amount of corners found
+ * @param[in] *arena Scratch memory of at least fast9_scratch_size() bytes, or NULL to allocate it
  */
-struct point_t *fast9_detect(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_padding, uint16_t y_padding, uint16_t *num_corners) {
-  uint32_t corner_cnt = 0;
-  uint16_t rsize = 512;
-  int pixel[16];
-  uint16_t x, y, i;
-  struct point_t *ret_corners = malloc(sizeof(struct point_t) * rsize);
+void fast9_detect(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_padding, uint16_t y_padding,
+                  struct point_t *ret_corners, uint16_t max_corners, uint16_t *num_corners, struct image_arena_t *arena)
+{
+  int32_t pixel[16];
+  uint16_t x, y;
+  uint32_t i, c;
+
+  *num_corners = 0;
+  if (img->w < 2 * (3 + x_padding) + 1 || img->h < 2 * (3 + y_padding) + 1 || max_corners == 0) {
+    return;
+  }
+
+  // Use a temporary arena when none is given
+  struct image_arena_t tmp_arena;
+  if (arena == NULL) {
+    image_arena_create(&tmp_arena, fast9_scratch_size(img->w, img->h, min_dist));
+    arena = &tmp_arena;
+  }
+  uint32_t arena_used = arena->used;
 
   // Set the pixel size
   uint8_t pixel_size = 1;
@@ -62,3579 +150,336 @@ struct point_t *fast9_detect(struct image_t *img, uint8_t threshold, uint16_t mi
   // Calculate the pixel offsets
   fast_make_offsets(pixel, img->w, pixel_size);
 
-  // Go trough all the pixels (minus the borders)
-  for (y = 3 + y_padding; y < img->h - 3 - y_padding; y++)
-    for (x = 3 + x_padding; x < img->w - 3 - x_padding; x++) {
-      // First check if we aren't in range vertical (TODO: fix less intensive way)
-      if (min_dist > 0) {
-        bool_t need_skip = FALSE;
+  // The scanned area and the grid over it
+  uint16_t x_start = 3 + x_padding, x_end = img->w - 3 - x_padding;
+  uint16_t y_start = 3 + y_padding, y_end = img->h - 3 - y_padding;
+  uint16_t cell_size = Max(min_dist, FAST9_MIN_CELL_SIZE);
+  uint16_t cells_w = (x_end - x_start + cell_size - 1) / cell_size;
+  uint32_t cells = cells_w * ((y_end - y_start + cell_size - 1) / cell_size);
 
-        // Go trough all the previous corners
-        for (i = 0; i < corner_cnt; i++) {
-          if (x - min_dist < ret_corners[i].x && ret_corners[i].x < x + min_dist
-              && y - min_dist < ret_corners[i].y && ret_corners[i].y < y + min_dist) {
-            need_skip = TRUE;
-            break;
-          }
-        }
+  uint16_t *rows = image_arena_alloc(arena, 3 * img->w * sizeof(uint16_t));
+  struct fast9_corner_t *grid = image_arena_alloc(arena, cells * FAST9_CELL_CORNERS * sizeof(struct fast9_corner_t));
+  uint8_t *cell_cnt = image_arena_alloc(arena, cells * sizeof(uint8_t));
+  uint16_t *scores = image_arena_alloc(arena, cells * FAST9_CELL_CORNERS * sizeof(uint16_t));
+  if (rows == NULL || grid == NULL || cell_cnt == NULL || scores == NULL) {
+    arena->used = arena_used;
+    if (arena == &tmp_arena) {
+      image_arena_free(&tmp_arena);
+    }
+    return;
+  }
+  memset(rows, 0, 3 * img->w * sizeof(uint16_t));
+  memset(cell_cnt, 0, cells * sizeof(uint8_t));
 
-        // Skip the box if we found a pixel nearby
-        if (need_skip) {
-          x += min_dist;
-          continue;
-        }
-      }
+  // Rolling score rows around the row being suppressed (scores outside the scanned area stay 0)
+  uint16_t *prev = rows, *mid = rows + img->w, *next = rows + 2 * img->w;
 
-      // Calculate the threshold values
-      const uint8_t *p = ((uint8_t *)img->buf) + y * img->w * pixel_size + x * pixel_size + pixel_size / 2;
-      int16_t cb = *p + threshold;
-      int16_t c_b = *p - threshold;
+  for (y = y_start; y <= y_end; y++) {
+    // Score the next row, or an empty row after the last one
+    if (y < y_end) {
+      const uint8_t *row = ((uint8_t *)img->buf) + y * img->w * pixel_size + pixel_size / 2;
+      fast9_row(row, pixel, pixel_size, threshold, x_start, x_end, next);
+    } else {
+      memset(next, 0, img->w * sizeof(uint16_t));
+    }
 
-      // Do the checks if it is a corner
-      if (p[pixel[0]] > cb)
-        if (p[pixel[1]] > cb)
-          if (p[pixel[2]] > cb)
-            if (p[pixel[3]] > cb)
-              if (p[pixel[4]] > cb)
-                if (p[pixel[5]] > cb)
-                  if (p[pixel[6]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        {}
-                      else if (p[pixel[15]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] < c_b)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[14]] < c_b)
-                        if (p[pixel[8]] < c_b)
-                          if (p[pixel[9]] < c_b)
-                            if (p[pixel[10]] < c_b)
-                              if (p[pixel[11]] < c_b)
-                                if (p[pixel[12]] < c_b)
-                                  if (p[pixel[13]] < c_b)
-                                    if (p[pixel[15]] < c_b)
-                                      {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] < c_b)
-                    if (p[pixel[15]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[13]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[11]] < c_b)
-                                  if (p[pixel[12]] < c_b)
-                                    if (p[pixel[14]] < c_b)
-                                      {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[13]] < c_b)
-                                  if (p[pixel[14]] < c_b)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[14]] < c_b)
-                                  if (p[pixel[15]] < c_b)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] < c_b)
-                  if (p[pixel[14]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[15]] > cb)
-                          {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                if (p[pixel[10]] > cb)
-                                  if (p[pixel[11]] > cb)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[11]] < c_b)
-                                  if (p[pixel[13]] < c_b)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[14]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[13]] < c_b)
-                                  if (p[pixel[6]] < c_b)
-                                    {}
-                                  else if (p[pixel[15]] < c_b)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                if (p[pixel[13]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[11]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] < c_b)
-                  if (p[pixel[7]] < c_b)
-                    if (p[pixel[8]] < c_b)
-                      if (p[pixel[9]] < c_b)
-                        if (p[pixel[10]] < c_b)
-                          if (p[pixel[11]] < c_b)
-                            if (p[pixel[13]] < c_b)
-                              if (p[pixel[14]] < c_b)
-                                if (p[pixel[6]] < c_b)
-                                  {}
-                                else if (p[pixel[15]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[4]] < c_b)
-                if (p[pixel[13]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                          {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                if (p[pixel[10]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                if (p[pixel[10]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[12]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[13]] < c_b)
-                  if (p[pixel[7]] < c_b)
-                    if (p[pixel[8]] < c_b)
-                      if (p[pixel[9]] < c_b)
-                        if (p[pixel[10]] < c_b)
-                          if (p[pixel[11]] < c_b)
-                            if (p[pixel[12]] < c_b)
-                              if (p[pixel[6]] < c_b)
-                                if (p[pixel[5]] < c_b)
-                                  {}
-                                else if (p[pixel[14]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else if (p[pixel[14]] < c_b)
-                                if (p[pixel[15]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] < c_b)
-                  if (p[pixel[6]] < c_b)
-                    if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        if (p[pixel[9]] < c_b)
-                          if (p[pixel[10]] < c_b)
-                            if (p[pixel[11]] < c_b)
-                              if (p[pixel[12]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] < c_b)
-                if (p[pixel[7]] < c_b)
-                  if (p[pixel[8]] < c_b)
-                    if (p[pixel[9]] < c_b)
-                      if (p[pixel[10]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            if (p[pixel[6]] < c_b)
-                              if (p[pixel[5]] < c_b)
-                                {}
-                              else if (p[pixel[14]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else if (p[pixel[14]] < c_b)
-                              if (p[pixel[15]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[3]] < c_b)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                          {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              if (p[pixel[9]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] < c_b)
-                if (p[pixel[7]] < c_b)
-                  if (p[pixel[8]] < c_b)
-                    if (p[pixel[9]] < c_b)
-                      if (p[pixel[11]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[5]] < c_b)
-                            if (p[pixel[4]] < c_b)
-                              {}
-                            else if (p[pixel[12]] < c_b)
-                              if (p[pixel[13]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[12]] < c_b)
-                            if (p[pixel[13]] < c_b)
-                              if (p[pixel[14]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            if (p[pixel[14]] < c_b)
-                              if (p[pixel[15]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] < c_b)
-              if (p[pixel[7]] < c_b)
-                if (p[pixel[8]] < c_b)
-                  if (p[pixel[9]] < c_b)
-                    if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[5]] < c_b)
-                            if (p[pixel[4]] < c_b)
-                              {}
-                            else if (p[pixel[13]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[13]] < c_b)
-                            if (p[pixel[14]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                            if (p[pixel[15]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[2]] < c_b)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                          {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            if (p[pixel[8]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[9]] < c_b)
-              if (p[pixel[7]] < c_b)
-                if (p[pixel[8]] < c_b)
-                  if (p[pixel[10]] < c_b)
-                    if (p[pixel[6]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[4]] < c_b)
-                          if (p[pixel[3]] < c_b)
-                            {}
-                          else if (p[pixel[11]] < c_b)
-                            if (p[pixel[12]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[11]] < c_b)
-                          if (p[pixel[12]] < c_b)
-                            if (p[pixel[13]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            if (p[pixel[14]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                            if (p[pixel[15]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] > cb)
-            if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] > cb)
-                  if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] < c_b)
-            if (p[pixel[7]] < c_b)
-              if (p[pixel[8]] < c_b)
-                if (p[pixel[10]] < c_b)
-                  if (p[pixel[11]] < c_b)
-                    if (p[pixel[6]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[4]] < c_b)
-                          if (p[pixel[3]] < c_b)
-                            {}
-                          else if (p[pixel[12]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                          if (p[pixel[15]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[1]] < c_b)
-          if (p[pixel[8]] > cb)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                          {}
-                        else if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[2]] > cb)
-                  if (p[pixel[3]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[7]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[8]] < c_b)
-            if (p[pixel[7]] < c_b)
-              if (p[pixel[9]] < c_b)
-                if (p[pixel[6]] < c_b)
-                  if (p[pixel[5]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[3]] < c_b)
-                        if (p[pixel[2]] < c_b)
-                          {}
-                        else if (p[pixel[10]] < c_b)
-                          if (p[pixel[11]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[10]] < c_b)
-                        if (p[pixel[11]] < c_b)
-                          if (p[pixel[12]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] < c_b)
-                      if (p[pixel[11]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                          if (p[pixel[13]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] < c_b)
-                    if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                          if (p[pixel[14]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] < c_b)
-                  if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                          if (p[pixel[15]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[8]] > cb)
-          if (p[pixel[9]] > cb)
-            if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] > cb)
-                  if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[2]] > cb)
-                if (p[pixel[3]] > cb)
-                  if (p[pixel[4]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[8]] < c_b)
-          if (p[pixel[7]] < c_b)
-            if (p[pixel[9]] < c_b)
-              if (p[pixel[10]] < c_b)
-                if (p[pixel[6]] < c_b)
-                  if (p[pixel[5]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[3]] < c_b)
-                        if (p[pixel[2]] < c_b)
-                          {}
-                        else if (p[pixel[11]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] < c_b)
-                        if (p[pixel[12]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        if (p[pixel[13]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else {
+    // Non-maximum suppression on the middle row and insertion in the grid
+    if (y > y_start) {
+      uint16_t my = y - 1;
+      for (x = x_start; x < x_end; x++) {
+        uint16_t s = mid[x];
+        if (s == 0 || s <= prev[x - 1] || s <= prev[x] || s <= prev[x + 1] || s <= mid[x - 1]
+            || s < mid[x + 1] || s < next[x - 1] || s < next[x] || s < next[x + 1]) {
           continue;
         }
-      else if (p[pixel[0]] < c_b)
-        if (p[pixel[1]] > cb)
-          if (p[pixel[8]] > cb)
-            if (p[pixel[7]] > cb)
-              if (p[pixel[9]] > cb)
-                if (p[pixel[6]] > cb)
-                  if (p[pixel[5]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[3]] > cb)
-                        if (p[pixel[2]] > cb)
-                          {}
-                        else if (p[pixel[10]] > cb)
-                          if (p[pixel[11]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[10]] > cb)
-                        if (p[pixel[11]] > cb)
-                          if (p[pixel[12]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] > cb)
-                      if (p[pixel[11]] > cb)
-                        if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] > cb)
-                    if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                          if (p[pixel[15]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[8]] < c_b)
-            if (p[pixel[9]] < c_b)
-              if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                          {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[2]] < c_b)
-                  if (p[pixel[3]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[1]] < c_b)
-          if (p[pixel[2]] > cb)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[7]] > cb)
-                if (p[pixel[8]] > cb)
-                  if (p[pixel[10]] > cb)
-                    if (p[pixel[6]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[4]] > cb)
-                          if (p[pixel[3]] > cb)
-                            {}
-                          else if (p[pixel[11]] > cb)
-                            if (p[pixel[12]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[11]] > cb)
-                          if (p[pixel[12]] > cb)
-                            if (p[pixel[13]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] > cb)
-                        if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            if (p[pixel[14]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                            if (p[pixel[15]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[9]] < c_b)
-              if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                          {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[3]] < c_b)
-                    if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[2]] < c_b)
-            if (p[pixel[3]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[7]] > cb)
-                  if (p[pixel[8]] > cb)
-                    if (p[pixel[9]] > cb)
-                      if (p[pixel[11]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[5]] > cb)
-                            if (p[pixel[4]] > cb)
-                              {}
-                            else if (p[pixel[12]] > cb)
-                              if (p[pixel[13]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[12]] > cb)
-                            if (p[pixel[13]] > cb)
-                              if (p[pixel[14]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            if (p[pixel[14]] > cb)
-                              if (p[pixel[15]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                          {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[4]] < c_b)
-                      if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[3]] < c_b)
-              if (p[pixel[4]] > cb)
-                if (p[pixel[13]] > cb)
-                  if (p[pixel[7]] > cb)
-                    if (p[pixel[8]] > cb)
-                      if (p[pixel[9]] > cb)
-                        if (p[pixel[10]] > cb)
-                          if (p[pixel[11]] > cb)
-                            if (p[pixel[12]] > cb)
-                              if (p[pixel[6]] > cb)
-                                if (p[pixel[5]] > cb)
-                                  {}
-                                else if (p[pixel[14]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else if (p[pixel[14]] > cb)
-                                if (p[pixel[15]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[13]] < c_b)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[5]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[12]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                          {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                if (p[pixel[10]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[5]] < c_b)
-                        if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                if (p[pixel[10]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] > cb)
-                  if (p[pixel[6]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[4]] < c_b)
-                if (p[pixel[5]] > cb)
-                  if (p[pixel[14]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[13]] > cb)
-                                  if (p[pixel[6]] > cb)
-                                    {}
-                                  else if (p[pixel[15]] > cb)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[14]] < c_b)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[6]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[11]] > cb)
-                                  if (p[pixel[13]] > cb)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                          {}
-                        else if (p[pixel[6]] < c_b)
-                          if (p[pixel[7]] < c_b)
-                            if (p[pixel[8]] < c_b)
-                              if (p[pixel[9]] < c_b)
-                                if (p[pixel[10]] < c_b)
-                                  if (p[pixel[11]] < c_b)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[13]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[5]] < c_b)
-                  if (p[pixel[6]] > cb)
-                    if (p[pixel[15]] < c_b)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[7]] > cb)
-                          if (p[pixel[8]] > cb)
-                            if (p[pixel[9]] > cb)
-                              if (p[pixel[10]] > cb)
-                                if (p[pixel[11]] > cb)
-                                  if (p[pixel[12]] > cb)
-                                    if (p[pixel[14]] > cb)
-                                      {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[13]] < c_b)
-                        if (p[pixel[14]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[13]] > cb)
-                                  if (p[pixel[14]] > cb)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[6]] < c_b)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[8]] > cb)
-                          if (p[pixel[9]] > cb)
-                            if (p[pixel[10]] > cb)
-                              if (p[pixel[11]] > cb)
-                                if (p[pixel[12]] > cb)
-                                  if (p[pixel[13]] > cb)
-                                    if (p[pixel[15]] > cb)
-                                      {}
-                                    else {
-                                      continue;
-                                    }
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[14]] < c_b)
-                        if (p[pixel[15]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[7]] < c_b)
-                      if (p[pixel[8]] < c_b)
-                        {}
-                      else if (p[pixel[15]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] > cb)
-                    if (p[pixel[7]] > cb)
-                      if (p[pixel[8]] > cb)
-                        if (p[pixel[9]] > cb)
-                          if (p[pixel[10]] > cb)
-                            if (p[pixel[11]] > cb)
-                              if (p[pixel[12]] > cb)
-                                if (p[pixel[14]] > cb)
-                                  if (p[pixel[15]] > cb)
-                                    {}
-                                  else {
-                                    continue;
-                                  }
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] > cb)
-                  if (p[pixel[7]] > cb)
-                    if (p[pixel[8]] > cb)
-                      if (p[pixel[9]] > cb)
-                        if (p[pixel[10]] > cb)
-                          if (p[pixel[11]] > cb)
-                            if (p[pixel[13]] > cb)
-                              if (p[pixel[14]] > cb)
-                                if (p[pixel[6]] > cb)
-                                  {}
-                                else if (p[pixel[15]] > cb)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                if (p[pixel[11]] < c_b)
-                                  {}
-                                else {
-                                  continue;
-                                }
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] > cb)
-                if (p[pixel[7]] > cb)
-                  if (p[pixel[8]] > cb)
-                    if (p[pixel[9]] > cb)
-                      if (p[pixel[10]] > cb)
-                        if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            if (p[pixel[6]] > cb)
-                              if (p[pixel[5]] > cb)
-                                {}
-                              else if (p[pixel[14]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else if (p[pixel[14]] > cb)
-                              if (p[pixel[15]] > cb)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              if (p[pixel[10]] < c_b)
-                                {}
-                              else {
-                                continue;
-                              }
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] > cb)
-              if (p[pixel[7]] > cb)
-                if (p[pixel[8]] > cb)
-                  if (p[pixel[9]] > cb)
-                    if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[6]] > cb)
-                          if (p[pixel[5]] > cb)
-                            if (p[pixel[4]] > cb)
-                              {}
-                            else if (p[pixel[13]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else if (p[pixel[13]] > cb)
-                            if (p[pixel[14]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                            if (p[pixel[15]] > cb)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            if (p[pixel[9]] < c_b)
-                              {}
-                            else {
-                              continue;
-                            }
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] > cb)
-            if (p[pixel[7]] > cb)
-              if (p[pixel[8]] > cb)
-                if (p[pixel[10]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[6]] > cb)
-                      if (p[pixel[5]] > cb)
-                        if (p[pixel[4]] > cb)
-                          if (p[pixel[3]] > cb)
-                            {}
-                          else if (p[pixel[12]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else if (p[pixel[12]] > cb)
-                          if (p[pixel[13]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                          if (p[pixel[14]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                          if (p[pixel[15]] > cb)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else if (p[pixel[9]] < c_b)
-            if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] < c_b)
-                  if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          if (p[pixel[8]] < c_b)
-                            {}
-                          else {
-                            continue;
-                          }
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else if (p[pixel[8]] > cb)
-          if (p[pixel[7]] > cb)
-            if (p[pixel[9]] > cb)
-              if (p[pixel[10]] > cb)
-                if (p[pixel[6]] > cb)
-                  if (p[pixel[5]] > cb)
-                    if (p[pixel[4]] > cb)
-                      if (p[pixel[3]] > cb)
-                        if (p[pixel[2]] > cb)
-                          {}
-                        else if (p[pixel[11]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else if (p[pixel[11]] > cb)
-                        if (p[pixel[12]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        if (p[pixel[13]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        if (p[pixel[14]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        if (p[pixel[15]] > cb)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
+
+        // Keep the strongest corners of the cell
+        uint32_t cell = ((my - y_start) / cell_size) * cells_w + (x - x_start) / cell_size;
+        struct fast9_corner_t *cell_corners = &grid[cell * FAST9_CELL_CORNERS];
+        uint8_t slot = cell_cnt[cell];
+        if (slot < FAST9_CELL_CORNERS) {
+          cell_cnt[cell]++;
+        } else {
+          slot = 0;
+          for (c = 1; c < FAST9_CELL_CORNERS; c++) {
+            if (cell_corners[c].score < cell_corners[slot].score) {
+              slot = c;
             }
-          else {
-            continue;
           }
-        else if (p[pixel[8]] < c_b)
-          if (p[pixel[9]] < c_b)
-            if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[3]] < c_b)
-                  if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[2]] < c_b)
-                if (p[pixel[3]] < c_b)
-                  if (p[pixel[4]] < c_b)
-                    if (p[pixel[5]] < c_b)
-                      if (p[pixel[6]] < c_b)
-                        if (p[pixel[7]] < c_b)
-                          {}
-                        else {
-                          continue;
-                        }
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
+          if (cell_corners[slot].score >= s) {
             continue;
           }
-        else {
-          continue;
         }
-      else if (p[pixel[7]] > cb)
-        if (p[pixel[8]] > cb)
-          if (p[pixel[9]] > cb)
-            if (p[pixel[6]] > cb)
-              if (p[pixel[5]] > cb)
-                if (p[pixel[4]] > cb)
-                  if (p[pixel[3]] > cb)
-                    if (p[pixel[2]] > cb)
-                      if (p[pixel[1]] > cb)
-                        {}
-                      else if (p[pixel[10]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] > cb)
-                      if (p[pixel[11]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] > cb)
-                    if (p[pixel[11]] > cb)
-                      if (p[pixel[12]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] > cb)
-                  if (p[pixel[11]] > cb)
-                    if (p[pixel[12]] > cb)
-                      if (p[pixel[13]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] > cb)
-                if (p[pixel[11]] > cb)
-                  if (p[pixel[12]] > cb)
-                    if (p[pixel[13]] > cb)
-                      if (p[pixel[14]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] > cb)
-              if (p[pixel[11]] > cb)
-                if (p[pixel[12]] > cb)
-                  if (p[pixel[13]] > cb)
-                    if (p[pixel[14]] > cb)
-                      if (p[pixel[15]] > cb)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else {
+        cell_corners[slot].pos.x = x;
+        cell_corners[slot].pos.y = my;
+        cell_corners[slot].score = s;
+      }
+    }
+
+    // Rotate the rows
+    uint16_t *tmp = prev;
+    prev = mid;
+    mid = next;
+    next = tmp;
+  }
+
+  // When over budget only keep the corners stronger than the max_corners'th score
+  uint32_t total = 0;
+  for (i = 0; i < cells; i++) {
+    for (c = 0; c < cell_cnt[i]; c++) {
+      scores[total++] = grid[i * FAST9_CELL_CORNERS + c].score;
+    }
+  }
+  uint16_t min_score = 0;
+  uint32_t min_score_cnt = max_corners;
+  if (total > max_corners) {
+    min_score = fast9_select_score(scores, total, max_corners - 1);
+    // Amount of corners with exactly the minimum score that still fit
+    for (i = 0; i < total; i++) {
+      if (scores[i] > min_score) {
+        min_score_cnt--;
+      }
+    }
+  }
+
+  // Output the corners in grid order
+  uint16_t corner_cnt = 0;
+  for (i = 0; i < cells; i++) {
+    for (c = 0; c < cell_cnt[i]; c++) {
+      struct fast9_corner_t *corner = &grid[i * FAST9_CELL_CORNERS + c];
+      if (corner->score < min_score || (corner->score == min_score && min_score_cnt == 0)) {
+        continue;
+      }
+      if (corner->score == min_score) {
+        min_score_cnt--;
+      }
+      ret_corners[corner_cnt++] = corner->pos;
+    }
+  }
+  *num_corners = corner_cnt;
+
+  // Release the scratch memory
+  arena->used = arena_used;
+  if (arena == &tmp_arena) {
+    image_arena_free(&tmp_arena);
+  }
+}
+
+/**
+ * Score the pixels of a row between x_start and x_end
+ * @param[in] *row Pointer to the first pixel (luminance) of the row
+ * @param[in] *pixel The offsets of the circle pixels
+ * @param[in] pixel_size The size of a pixel in bytes
+ * @param[in] threshold The FAST9 threshold
+ * @param[in] x_start The first pixel to score
+ * @param[in] x_end The end of the pixels to score (exclusive)
+ * @param[out] *scores The scores of the row (0 when not a corner)
+ */
+static void fast9_row(const uint8_t *row, const int32_t *pixel, uint8_t pixel_size, uint8_t threshold,
+                      uint16_t x_start, uint16_t x_end, uint16_t *scores)
+{
+  uint16_t x = x_start;
+
+#if defined(FAST9_SSE2) || defined(FAST9_NEON)
+  // Segment test on 16 pixels at a time, only the corners are scored
+  if (pixel_size == 1) {
+#if defined(FAST9_SSE2)
+    const __m128i t = _mm_set1_epi8((char)threshold);
+    const __m128i zero = _mm_setzero_si128();
+#else
+    const uint8x16_t t = vdupq_n_u8(threshold);
+#endif
+    for (; x + 16 <= x_end; x += 16) {
+      const uint8_t *p = row + x;
+      uint8_t k;
+#if defined(FAST9_SSE2)
+      __m128i c = _mm_loadu_si128((__m128i *)p);
+      __m128i hi = _mm_adds_epu8(c, t);
+      __m128i lo = _mm_subs_epu8(c, t);
+      __m128i b[16], d[16];
+
+      // Quick rejection on the compass pixels, an arc of 9 contains one of 0/8 and one of 4/12
+      for (k = 0; k < 16; k += 4) {
+        __m128i v = _mm_loadu_si128((__m128i *)(p + pixel[k]));
+        b[k] = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(v, hi), zero), zero);
+        d[k] = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(lo, v), zero), zero);
+      }
+      __m128i any = _mm_or_si128(
+                      _mm_and_si128(_mm_or_si128(b[0], b[8]), _mm_or_si128(b[4], b[12])),
+                      _mm_and_si128(_mm_or_si128(d[0], d[8]), _mm_or_si128(d[4], d[12])));
+      if (_mm_movemask_epi8(any) == 0) {
+        memset(&scores[x], 0, 16 * sizeof(uint16_t));
+        continue;
+      }
+
+      // The other circle pixels
+      for (k = 1; k < 16; k++) {
+        if ((k & 3) == 0) {
           continue;
         }
-      else if (p[pixel[7]] < c_b)
-        if (p[pixel[8]] < c_b)
-          if (p[pixel[9]] < c_b)
-            if (p[pixel[6]] < c_b)
-              if (p[pixel[5]] < c_b)
-                if (p[pixel[4]] < c_b)
-                  if (p[pixel[3]] < c_b)
-                    if (p[pixel[2]] < c_b)
-                      if (p[pixel[1]] < c_b)
-                        {}
-                      else if (p[pixel[10]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else if (p[pixel[10]] < c_b)
-                      if (p[pixel[11]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else if (p[pixel[10]] < c_b)
-                    if (p[pixel[11]] < c_b)
-                      if (p[pixel[12]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else if (p[pixel[10]] < c_b)
-                  if (p[pixel[11]] < c_b)
-                    if (p[pixel[12]] < c_b)
-                      if (p[pixel[13]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else if (p[pixel[10]] < c_b)
-                if (p[pixel[11]] < c_b)
-                  if (p[pixel[12]] < c_b)
-                    if (p[pixel[13]] < c_b)
-                      if (p[pixel[14]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else if (p[pixel[10]] < c_b)
-              if (p[pixel[11]] < c_b)
-                if (p[pixel[12]] < c_b)
-                  if (p[pixel[13]] < c_b)
-                    if (p[pixel[14]] < c_b)
-                      if (p[pixel[15]] < c_b)
-                        {}
-                      else {
-                        continue;
-                      }
-                    else {
-                      continue;
-                    }
-                  else {
-                    continue;
-                  }
-                else {
-                  continue;
-                }
-              else {
-                continue;
-              }
-            else {
-              continue;
-            }
-          else {
-            continue;
-          }
-        else {
+        __m128i v = _mm_loadu_si128((__m128i *)(p + pixel[k]));
+        b[k] = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(v, hi), zero), zero);
+        d[k] = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(lo, v), zero), zero);
+      }
+
+      // Arcs of 2, 4, 8 and 9 pixels starting at every circle pixel
+      __m128i b2[16], d2[16], arc = zero;
+      for (k = 0; k < 16; k++) {
+        b2[k] = _mm_and_si128(b[k], b[(k + 1) & 15]);
+        d2[k] = _mm_and_si128(d[k], d[(k + 1) & 15]);
+      }
+      __m128i b4[16], d4[16];
+      for (k = 0; k < 16; k++) {
+        b4[k] = _mm_and_si128(b2[k], b2[(k + 2) & 15]);
+        d4[k] = _mm_and_si128(d2[k], d2[(k + 2) & 15]);
+      }
+      for (k = 0; k < 16; k++) {
+        __m128i b9 = _mm_and_si128(_mm_and_si128(b4[k], b4[(k + 4) & 15]), b[(k + 8) & 15]);
+        __m128i d9 = _mm_and_si128(_mm_and_si128(d4[k], d4[(k + 4) & 15]), d[(k + 8) & 15]);
+        arc = _mm_or_si128(arc, _mm_or_si128(b9, d9));
+      }
+      uint32_t corners = _mm_movemask_epi8(arc);
+#else
+      uint8x16_t c = vld1q_u8(p);
+      uint8x16_t hi = vqaddq_u8(c, t);
+      uint8x16_t lo = vqsubq_u8(c, t);
+      uint8x16_t b[16], d[16];
+
+      // Quick rejection on the compass pixels, an arc of 9 contains one of 0/8 and one of 4/12
+      for (k = 0; k < 16; k += 4) {
+        uint8x16_t v = vld1q_u8(p + pixel[k]);
+        b[k] = vcgtq_u8(v, hi);
+        d[k] = vcltq_u8(v, lo);
+      }
+      uint8x16_t any = vorrq_u8(vandq_u8(vorrq_u8(b[0], b[8]), vorrq_u8(b[4], b[12])),
+                                vandq_u8(vorrq_u8(d[0], d[8]), vorrq_u8(d[4], d[12])));
+      uint64x2_t any64 = vreinterpretq_u64_u8(any);
+      if ((vgetq_lane_u64(any64, 0) | vgetq_lane_u64(any64, 1)) == 0) {
+        memset(&scores[x], 0, 16 * sizeof(uint16_t));
+        continue;
+      }
+
+      // The other circle pixels
+      for (k = 1; k < 16; k++) {
+        if ((k & 3) == 0) {
           continue;
         }
-      else {
-        continue;
+        uint8x16_t v = vld1q_u8(p + pixel[k]);
+        b[k] = vcgtq_u8(v, hi);
+        d[k] = vcltq_u8(v, lo);
       }
 
-      // When we have more corner than allocted space reallocate
-      if (corner_cnt == rsize) {
-        rsize *= 2;
-        ret_corners = realloc(ret_corners, sizeof(struct point_t) * rsize);
+      // Arcs of 2, 4, 8 and 9 pixels starting at every circle pixel
+      uint8x16_t b2[16], d2[16], b4[16], d4[16], arc = vdupq_n_u8(0);
+      for (k = 0; k < 16; k++) {
+        b2[k] = vandq_u8(b[k], b[(k + 1) & 15]);
+        d2[k] = vandq_u8(d[k], d[(k + 1) & 15]);
+      }
+      for (k = 0; k < 16; k++) {
+        b4[k] = vandq_u8(b2[k], b2[(k + 2) & 15]);
+        d4[k] = vandq_u8(d2[k], d2[(k + 2) & 15]);
+      }
+      for (k = 0; k < 16; k++) {
+        uint8x16_t b9 = vandq_u8(vandq_u8(b4[k], b4[(k + 4) & 15]), b[(k + 8) & 15]);
+        uint8x16_t d9 = vandq_u8(vandq_u8(d4[k], d4[(k + 4) & 15]), d[(k + 8) & 15]);
+        arc = vorrq_u8(arc, vorrq_u8(b9, d9));
+      }
+      uint8_t arc_lanes[16];
+      vst1q_u8(arc_lanes, arc);
+      uint32_t corners = 0;
+      for (k = 0; k < 16; k++) {
+        corners |= (arc_lanes[k] & 1) << k;
       }
+#endif
 
-      ret_corners[corner_cnt].x = x;
-      ret_corners[corner_cnt].y = y;
-      corner_cnt++;
+      for (k = 0; k < 16; k++) {
+        scores[x + k] = (corners & (1 << k)) ? fast9_score(p + k, pixel, threshold) : 0;
+      }
+    }
+  }
+#endif
+
+  // Remaining pixels
+  for (; x < x_end; x++) {
+    scores[x] = fast9_score(row + x * pixel_size, pixel, threshold);
+  }
+}
 
-      // Skip some in the width direction
-      x += min_dist;
+/**
+ * Do the FAST9 segment test on a pixel and score it
+ * @param[in] *p Pointer to the (luminance of the) pixel
+ * @param[in] *pixel The offsets of the circle pixels
+ * @param[in] threshold The FAST9 threshold
+ * @return The sum of the absolute differences above the threshold on the arc side, 0 if it is not a corner
+ */
+static uint16_t fast9_score(const uint8_t *p, const int32_t *pixel, uint8_t threshold)
+{
+  int16_t cb = *p + threshold;
+  int16_t c_b = *p - threshold;
+
+  // Quick rejection on the compass pixels, an arc of 9 contains one of 0/8 and one of 4/12
+  int16_t p0 = p[pixel[0]], p4 = p[pixel[4]], p8 = p[pixel[8]], p12 = p[pixel[12]];
+  bool_t bright = (p0 > cb || p8 > cb) && (p4 > cb || p12 > cb);
+  bool_t dark = (p0 < c_b || p8 < c_b) && (p4 < c_b || p12 < c_b);
+  if (!bright && !dark) {
+    return 0;
+  }
+
+  // Full circle masks and differences
+  uint32_t bright_mask = 0, dark_mask = 0;
+  uint16_t bright_sum = 0, dark_sum = 0;
+  for (uint8_t i = 0; i < 16; i++) {
+    int16_t v = p[pixel[i]];
+    if (v > cb) {
+      bright_mask |= 1 << i;
+      bright_sum += v - cb;
+    } else if (v < c_b) {
+      dark_mask |= 1 << i;
+      dark_sum += c_b - v;
     }
+  }
 
-  *num_corners = corner_cnt;
-  return ret_corners;
+  if (fast9_arc(bright_mask)) {
+    return bright_sum;
+  } else if (fast9_arc(dark_mask)) {
+    return dark_sum;
+  }
+  return 0;
+}
+
+/**
+ * Find the k'th highest score (quickselect), the scores are reordered
+ * @param[in,out] *scores The scores
+ * @param[in] count The amount of scores
+ * @param[in] k The index in descending order
+ * @return The k'th highest score
+ */
+static uint16_t fast9_select_score(uint16_t *scores, uint32_t count, uint32_t k)
+{
+  int32_t left = 0, right = count - 1;
+  while (left < right) {
+    uint16_t pivot = scores[left + (right - left) / 2];
+    int32_t i = left, j = right;
+    while (i <= j) {
+      while (scores[i] > pivot) { i++; }
+      while (scores[j] < pivot) { j--; }
+      if (i <= j) {
+        uint16_t tmp = scores[i];
+        scores[i] = scores[j];
+        scores[j] = tmp;
+        i++;
+        j--;
+      }
+    }
+    if ((int32_t)k <= j) {
+      right = j;
+    } else if ((int32_t)k >= i) {
+      left = i;
+    } else {
+      break;
+    }
+  }
+  return scores[k];
 }
 
 /**
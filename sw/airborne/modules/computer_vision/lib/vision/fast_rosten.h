@@ -37,6 +37,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "std.h"
 #include "lib/vision/image.h"
 
-struct point_t *fast9_detect(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_padding, uint16_t y_padding, uint16_t *num_corners);
+/* Minimum size of the grid cells used for spacing the corners (when min_dist is smaller) */
+#ifndef FAST9_MIN_CELL_SIZE
+#define FAST9_MIN_CELL_SIZE 4
+#endif
+
+/* Amount of corners kept per grid cell */
+#ifndef FAST9_CELL_CORNERS
+#define FAST9_CELL_CORNERS 1
+#endif
+
+void fast9_detect(struct image_t *img, uint8_t threshold, uint16_t min_dist, uint16_t x_padding, uint16_t y_padding,
+                  struct point_t *ret_corners, uint16_t max_corners, uint16_t *num_corners, struct image_arena_t *arena);
+uint32_t fast9_scratch_size(uint16_t w, uint16_t h, uint16_t min_dist);
 
 #endif
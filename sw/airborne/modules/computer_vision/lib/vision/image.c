@@ -28,6 +28,37 @@
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * Use the vectorised (NEON or SSE2) kernels when the compiler targets them.
+ * Set to FALSE to force the scalar versions.
+ */
+#ifndef IMAGE_USE_SIMD
+#define IMAGE_USE_SIMD TRUE
+#endif
+
+#if IMAGE_USE_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define IMAGE_NEON 1
+#include <arm_neon.h>
+#elif IMAGE_USE_SIMD && defined(__SSE2__)
+#define IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/**
+ * Get the name of the kernel implementation selected at build time
+ * @return "neon", "sse2" or "scalar"
+ */
+const char *image_simd_name(void)
+{
+#if defined(IMAGE_NEON)
+  return "neon";
+#elif defined(IMAGE_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
 /**
  * Create a new image
  * @param[out] *img The output image
@@ -41,19 +72,106 @@ void image_create(struct image_t *img, uint16_t width, uint16_t height, enum ima
   img->type = type;
   img->w = width;
   img->h = height;
+  img->buf_size = image_buf_size(width, height, type);
 
+  img->buf = malloc(img->buf_size);
+}
+
+/**
+ * Get the buffer size needed for an image
+ * @param[in] width The width of the image
+ * @param[in] height The height of the image
+ * @param[in] type The type of image
+ * @return The size of the buffer in bytes
+ */
+uint32_t image_buf_size(uint16_t width, uint16_t height, enum image_type type)
+{
   // Depending on the type the size differs
   if (type == IMAGE_YUV422) {
-    img->buf_size = sizeof(uint8_t) * 2 * width * height;
+    return sizeof(uint8_t) * 2 * width * height;
   } else if (type == IMAGE_JPEG) {
-    img->buf_size = sizeof(uint8_t) * 2 * width * height;  // At maximum quality this is enough
+    return sizeof(uint8_t) * 2 * width * height;  // At maximum quality this is enough
   } else if (type == IMAGE_GRADIENT) {
-    img->buf_size = sizeof(int16_t) * width * height;
+    return sizeof(int16_t) * width * height;
   } else {
-    img->buf_size = sizeof(uint8_t) * width * height;
+    return sizeof(uint8_t) * width * height;
   }
+}
 
-  img->buf = malloc(img->buf_size);
+/**
+ * Create a scratch arena
+ * @param[out] *arena The arena
+ * @param[in] size The size in bytes (each allocation can use up to IMAGE_ARENA_ALIGN - 1 bytes more)
+ */
+void image_arena_create(struct image_arena_t *arena, uint32_t size)
+{
+  arena->buf = malloc(size);
+  arena->size = (arena->buf != NULL) ? size : 0;
+  arena->used = 0;
+  arena->max_used = 0;
+}
+
+/**
+ * Free the memory of a scratch arena
+ * @param[in] *arena The arena to free
+ */
+void image_arena_free(struct image_arena_t *arena)
+{
+  free(arena->buf);
+  arena->buf = NULL;
+  arena->size = 0;
+  arena->used = 0;
+}
+
+/**
+ * Release all the allocations of an arena at once
+ * Everything taken from the arena before is invalid afterwards.
+ * @param[in] *arena The arena
+ */
+void image_arena_reset(struct image_arena_t *arena)
+{
+  arena->used = 0;
+}
+
+/**
+ * Take a block of memory from an arena
+ * @param[in] *arena The arena
+ * @param[in] size The size in bytes
+ * @return The memory block (aligned on IMAGE_ARENA_ALIGN) or NULL if the arena is full
+ */
+void *image_arena_alloc(struct image_arena_t *arena, uint32_t size)
+{
+  uint32_t start = (arena->used + IMAGE_ARENA_ALIGN - 1) & ~(IMAGE_ARENA_ALIGN - 1);
+  if (start > arena->size || size > arena->size - start) {
+    return NULL;
+  }
+
+  arena->used = start + size;
+  if (arena->used > arena->max_used) {
+    arena->max_used = arena->used;
+  }
+  return &arena->buf[start];
+}
+
+/**
+ * Create a new image with its buffer taken from an arena
+ * The image must not be freed with image_free(), it is released with the arena.
+ * @param[out] *img The output image
+ * @param[in] width The width of the image
+ * @param[in] height The height of the image
+ * @param[in] type The type of image
+ * @param[in] *arena The arena to take the buffer from
+ * @return FALSE if there is not enough room left in the arena
+ */
+bool_t image_create_arena(struct image_t *img, uint16_t width, uint16_t height, enum image_type type,
+                          struct image_arena_t *arena)
+{
+  img->type = type;
+  img->w = width;
+  img->h = height;
+  img->buf_size = image_buf_size(width, height, type);
+  img->buf = image_arena_alloc(arena, img->buf_size);
+  return (img->buf != NULL);
 }
 
 /**
@@ -114,19 +232,50 @@ void image_to_grayscale(struct image_t *input, struct image_t *output)
 {
   uint8_t *source = input->buf;
   uint8_t *dest = output->buf;
-  source++;
+  uint32_t i = 0;
+  uint32_t pixels = output->w * output->h;
 
   // Copy the creation timestamp (stays the same)
   memcpy(&output->ts, &input->ts, sizeof(struct timeval));
 
-  // Copy the pixels
-  for (int y = 0; y < output->h; y++) {
-    for (int x = 0; x < output->w; x++) {
-      if (output->type == IMAGE_YUV422) {
-        *dest++ = 127;  // U / V
-      }
-      *dest++ = *source;    // Y
-      source += 2;
+  // Copy the pixels, 16 at a time when vectorised
+#if defined(IMAGE_NEON)
+  if (output->type == IMAGE_YUV422) {
+    uint8x16x2_t px;
+    px.val[0] = vdupq_n_u8(127);
+    for (; i + 16 <= pixels; i += 16) {
+      px.val[1] = vld2q_u8(source + 2 * i).val[1];
+      vst2q_u8(dest + 2 * i, px);
+    }
+  } else {
+    for (; i + 16 <= pixels; i += 16) {
+      vst1q_u8(dest + i, vld2q_u8(source + 2 * i).val[1]);
+    }
+  }
+#elif defined(IMAGE_SSE2)
+  if (output->type == IMAGE_YUV422) {
+    const __m128i y_mask = _mm_set1_epi16((int16_t)0xFF00);
+    const __m128i uv = _mm_set1_epi16(127);
+    for (; i + 8 <= pixels; i += 8) {
+      __m128i px = _mm_loadu_si128((__m128i *)(source + 2 * i));
+      _mm_storeu_si128((__m128i *)(dest + 2 * i), _mm_or_si128(_mm_and_si128(px, y_mask), uv));
+    }
+  } else {
+    for (; i + 16 <= pixels; i += 16) {
+      __m128i lo = _mm_srli_epi16(_mm_loadu_si128((__m128i *)(source + 2 * i)), 8);
+      __m128i hi = _mm_srli_epi16(_mm_loadu_si128((__m128i *)(source + 2 * i + 16)), 8);
+      _mm_storeu_si128((__m128i *)(dest + i), _mm_packus_epi16(lo, hi));
+    }
+  }
+#endif
+
+  // Remaining pixels
+  for (; i < pixels; i++) {
+    if (output->type == IMAGE_YUV422) {
+      dest[2 * i] = 127;  // U / V
+      dest[2 * i + 1] = source[2 * i + 1]; // Y
+    } else {
+      dest[i] = source[2 * i + 1]; // Y
     }
   }
 }
@@ -149,43 +298,73 @@ uint16_t image_yuv422_colorfilt(struct image_t *input, struct image_t *output, u
   uint16_t cnt = 0;
   uint8_t *source = input->buf;
   uint8_t *dest = output->buf;
+  uint32_t i = 0;
+  uint32_t macro_pixels = output->w * output->h / 2;
 
   // Copy the creation timestamp (stays the same)
   memcpy(&output->ts, &input->ts, sizeof(struct timeval));
 
-  // Go trough all the pixels
-  for (uint16_t y = 0; y < output->h; y++) {
-    for (uint16_t x = 0; x < output->w; x += 2) {
-      // Check if the color is inside the specified values
-      if (
-        (dest[1] >= y_m)
-        && (dest[1] <= y_M)
-        && (dest[0] >= u_m)
-        && (dest[0] <= u_M)
-        && (dest[2] >= v_m)
-        && (dest[2] <= v_M)
-      ) {
-        cnt ++;
-        // UYVY
-        dest[0] = 64;        // U
-        dest[1] = source[1];  // Y
-        dest[2] = 255;        // V
-        dest[3] = source[3];  // Y
-      } else {
-        // UYVY
-        char u = source[0] - 127;
-        u /= 4;
-        dest[0] = 127;        // U
-        dest[1] = source[1];  // Y
-        u = source[2] - 127;
-        u /= 4;
-        dest[2] = 127;        // V
-        dest[3] = source[3];  // Y
-      }
-
-      // Go to the next 2 pixels
-      dest += 4;
-      source += 4;
+  // Filter 4 macro pixels (UYVY) at a time when vectorised, the second Y is never filtered
+#if defined(IMAGE_NEON)
+  const uint8x16_t lo = vreinterpretq_u8_u32(vdupq_n_u32(u_m | (y_m << 8) | (v_m << 16)));
+  const uint8x16_t hi = vreinterpretq_u8_u32(vdupq_n_u32(u_M | (y_M << 8) | (v_M << 16) | (0xFFu << 24)));
+  const uint8x16_t y_mask = vreinterpretq_u8_u16(vdupq_n_u16(0xFF00));
+  const uint8x16_t uv_in = vreinterpretq_u8_u32(vdupq_n_u32(64 | (255 << 16)));
+  const uint8x16_t uv_out = vreinterpretq_u8_u32(vdupq_n_u32(127 | (127 << 16)));
+  uint32x4_t cnt_v = vdupq_n_u32(0);
+  for (; i + 4 <= macro_pixels; i += 4) {
+    uint8x16_t px = vld1q_u8(source + 4 * i);
+    uint8x16_t in_range = vandq_u8(vcgeq_u8(px, lo), vcleq_u8(px, hi));
+    uint32x4_t mask = vceqq_u32(vreinterpretq_u32_u8(in_range), vdupq_n_u32(0xFFFFFFFF));
+    uint8x16_t uv = vbslq_u8(vreinterpretq_u8_u32(mask), uv_in, uv_out);
+    vst1q_u8(dest + 4 * i, vbslq_u8(y_mask, px, uv));
+    cnt_v = vaddq_u32(cnt_v, vshrq_n_u32(mask, 31));
+  }
+  cnt += vgetq_lane_u32(cnt_v, 0) + vgetq_lane_u32(cnt_v, 1) + vgetq_lane_u32(cnt_v, 2) + vgetq_lane_u32(cnt_v, 3);
+#elif defined(IMAGE_SSE2)
+  const __m128i lo = _mm_set1_epi32(u_m | (y_m << 8) | (v_m << 16));
+  const __m128i hi = _mm_set1_epi32(u_M | (y_M << 8) | (v_M << 16) | (0xFFu << 24));
+  const __m128i y_mask = _mm_set1_epi16((int16_t)0xFF00);
+  const __m128i uv_in = _mm_set1_epi32(64 | (255 << 16));
+  const __m128i uv_out = _mm_set1_epi32(127 | (127 << 16));
+  for (; i + 4 <= macro_pixels; i += 4) {
+    __m128i px = _mm_loadu_si128((__m128i *)(source + 4 * i));
+    // unsigned byte compares through min/max
+    __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(px, lo), px);
+    __m128i le = _mm_cmpeq_epi8(_mm_min_epu8(px, hi), px);
+    __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(ge, le), _mm_set1_epi32(-1));
+    __m128i uv = _mm_or_si128(_mm_and_si128(mask, uv_in), _mm_andnot_si128(mask, uv_out));
+    _mm_storeu_si128((__m128i *)(dest + 4 * i), _mm_or_si128(_mm_and_si128(px, y_mask), uv));
+    int bits = _mm_movemask_ps(_mm_castsi128_ps(mask));
+    cnt += (bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1) + ((bits >> 3) & 1);
+  }
+#endif
+
+  // Go trough the remaining pixels
+  for (; i < macro_pixels; i++) {
+    uint8_t *src = source + 4 * i;
+    uint8_t *dst = dest + 4 * i;
+    // Check if the color is inside the specified values
+    if (
+      (src[1] >= y_m)
+      && (src[1] <= y_M)
+      && (src[0] >= u_m)
+      && (src[0] <= u_M)
+      && (src[2] >= v_m)
+      && (src[2] <= v_M)
+    ) {
+      cnt ++;
+      // UYVY
+      dst[0] = 64;        // U
+      dst[1] = src[1];  // Y
+      dst[2] = 255;        // V
+      dst[3] = src[3];  // Y
+    } else {
+      // UYVY
+      dst[0] = 127;        // U
+      dst[1] = src[1];  // Y
+      dst[2] = 127;        // V
+      dst[3] = src[3];  // Y
     }
   }
   return cnt;
@@ -216,9 +395,54 @@ void image_yuv422_downsample(struct image_t *input, struct image_t *output, uint
   // Copy the creation timestamp (stays the same)
   memcpy(&output->ts, &input->ts, sizeof(struct timeval));
 
+  // Without downsampling this is a plain copy
+  if (downsample == 1) {
+    memcpy(dest, source, output->w * output->h * 2);
+    return;
+  }
+
   // Go trough all the pixels
   for (uint16_t y = 0; y < output->h; y++) {
-    for (uint16_t x = 0; x < output->w; x += 2) {
+    uint16_t x = 0;
+#if defined(IMAGE_NEON)
+    // Downsample by 2: de-interleave 32 pixels and keep the even macro pixels
+    // with the first Y of the odd macro pixels
+    if (downsample == 2) {
+      for (; x + 16 <= output->w; x += 16) {
+        uint8x16x4_t in = vld4q_u8(source);
+        uint8x16x2_t y1 = vuzpq_u8(in.val[1], in.val[1]);
+        uint8x8x4_t out;
+        out.val[0] = vget_low_u8(vuzpq_u8(in.val[0], in.val[0]).val[0]);
+        out.val[1] = vget_low_u8(y1.val[0]);
+        out.val[2] = vget_low_u8(vuzpq_u8(in.val[2], in.val[2]).val[0]);
+        out.val[3] = vget_low_u8(y1.val[1]);
+        vst4_u8(dest, out);
+        source += 64;
+        dest += 32;
+      }
+    }
+#elif defined(IMAGE_SSE2)
+    // Downsample by 2: take the UYV bytes of the even macro pixels
+    // and the first Y of the odd macro pixels
+    if (downsample == 2) {
+      const __m128i uyv_mask = _mm_set1_epi32(0x00FFFFFF);
+      const __m128i y_mask = _mm_set1_epi32(0x0000FF00);
+      for (; x + 8 <= output->w; x += 8) {
+        __m128i a = _mm_loadu_si128((__m128i *)source);
+        __m128i b = _mm_loadu_si128((__m128i *)(source + 16));
+        // even words of a and b in the low halves, odd words in the high halves
+        a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i even = _mm_unpacklo_epi64(a, b);
+        __m128i odd = _mm_unpackhi_epi64(a, b);
+        __m128i out = _mm_or_si128(_mm_and_si128(even, uyv_mask), _mm_slli_epi32(_mm_and_si128(odd, y_mask), 16));
+        _mm_storeu_si128((__m128i *)dest, out);
+        source += 32;
+        dest += 16;
+      }
+    }
+#endif
+    for (; x < output->w; x += 2) {
       // YUYV
       *dest++ = *source++; // U
       *dest++ = *source++; // Y
@@ -303,11 +527,33 @@ void image_gradients(struct image_t *input, struct image_t *dx, struct image_t *
   int16_t *dx_buf = (int16_t *)dx->buf;
   int16_t *dy_buf = (int16_t *)dy->buf;
 
-  // Go trough all pixels except the borders
-  for (uint16_t x = 1; x < input->w - 1; x++) {
-    for (uint16_t y = 1; y < input->h - 1; y++) {
-      dx_buf[(y - 1)*dx->w + (x - 1)] = (int16_t)input_buf[y * input->w + x + 1] - (int16_t)input_buf[y * input->w + x - 1];
-      dy_buf[(y - 1)*dy->w + (x - 1)] = (int16_t)input_buf[(y + 1) * input->w + x] - (int16_t)input_buf[(y - 1) * input->w + x];
+  // Go trough all pixels except the borders (row by row for memory locality)
+  for (uint16_t y = 1; y < input->h - 1; y++) {
+    uint8_t *row = &input_buf[y * input->w];
+    uint8_t *row_up = row - input->w;
+    uint8_t *row_down = row + input->w;
+    int16_t *dx_row = &dx_buf[(y - 1) * dx->w];
+    int16_t *dy_row = &dy_buf[(y - 1) * dy->w];
+    uint16_t x = 1;
+#if defined(IMAGE_NEON)
+    for (; x + 8 < input->w; x += 8) {
+      vst1q_s16(&dx_row[x - 1], vreinterpretq_s16_u16(vsubl_u8(vld1_u8(&row[x + 1]), vld1_u8(&row[x - 1]))));
+      vst1q_s16(&dy_row[x - 1], vreinterpretq_s16_u16(vsubl_u8(vld1_u8(&row_down[x]), vld1_u8(&row_up[x]))));
+    }
+#elif defined(IMAGE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 8 < input->w; x += 8) {
+      __m128i right = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)&row[x + 1]), zero);
+      __m128i left = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)&row[x - 1]), zero);
+      __m128i down = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)&row_down[x]), zero);
+      __m128i up = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)&row_up[x]), zero);
+      _mm_storeu_si128((__m128i *)&dx_row[x - 1], _mm_sub_epi16(right, left));
+      _mm_storeu_si128((__m128i *)&dy_row[x - 1], _mm_sub_epi16(down, up));
+    }
+#endif
+    for (; x < input->w - 1; x++) {
+      dx_row[x - 1] = (int16_t)row[x + 1] - (int16_t)row[x - 1];
+      dy_row[x - 1] = (int16_t)row_down[x] - (int16_t)row_up[x];
     }
   }
 }
@@ -365,15 +611,46 @@ uint32_t image_difference(struct image_t *img_a, struct image_t *img_b, struct i
     diff_buf = (int16_t *)diff->buf;
   }
 
-  // Go trough the imagge pixels and calculate the difference
-  for (uint16_t x = 0; x < img_b->w; x++) {
-    for (uint16_t y = 0; y < img_b->h; y++) {
-      int16_t diff_c = img_a_buf[(y + 1) * img_a->w + (x + 1)] - img_b_buf[y * img_b->w + x];
+  // Go trough the image pixels row by row and calculate the difference
+  for (uint16_t y = 0; y < img_b->h; y++) {
+    uint8_t *a_row = &img_a_buf[(y + 1) * img_a->w + 1];
+    uint8_t *b_row = &img_b_buf[y * img_b->w];
+    int16_t *diff_row = (diff_buf != NULL) ? &diff_buf[y * diff->w] : NULL;
+    uint16_t x = 0;
+#if defined(IMAGE_NEON)
+    uint32x4_t sum_v = vdupq_n_u32(0);
+    for (; x + 8 <= img_b->w; x += 8) {
+      int16x8_t d = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(&a_row[x]), vld1_u8(&b_row[x])));
+      sum_v = vreinterpretq_u32_s32(vmlal_s16(vreinterpretq_s32_u32(sum_v), vget_low_s16(d), vget_low_s16(d)));
+      sum_v = vreinterpretq_u32_s32(vmlal_s16(vreinterpretq_s32_u32(sum_v), vget_high_s16(d), vget_high_s16(d)));
+      if (diff_row != NULL) {
+        vst1q_s16(&diff_row[x], d);
+      }
+    }
+    sum_diff2 += vgetq_lane_u32(sum_v, 0) + vgetq_lane_u32(sum_v, 1) + vgetq_lane_u32(sum_v, 2) + vgetq_lane_u32(sum_v, 3);
+#elif defined(IMAGE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum_v = _mm_setzero_si128();
+    for (; x + 8 <= img_b->w; x += 8) {
+      __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)&a_row[x]), zero);
+      __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)&b_row[x]), zero);
+      __m128i d = _mm_sub_epi16(a, b);
+      sum_v = _mm_add_epi32(sum_v, _mm_madd_epi16(d, d));
+      if (diff_row != NULL) {
+        _mm_storeu_si128((__m128i *)&diff_row[x], d);
+      }
+    }
+    uint32_t sums[4];
+    _mm_storeu_si128((__m128i *)sums, sum_v);
+    sum_diff2 += sums[0] + sums[1] + sums[2] + sums[3];
+#endif
+    for (; x < img_b->w; x++) {
+      int16_t diff_c = a_row[x] - b_row[x];
       sum_diff2 += diff_c * diff_c;
 
       // Set the difference image
-      if (diff_buf != NULL) {
-        diff_buf[y * diff->w + x] = diff_c;
+      if (diff_row != NULL) {
+        diff_row[x] = diff_c;
       }
     }
   }
@@ -417,6 +694,118 @@ int32_t image_multiply(struct image_t *img_a, struct image_t *img_b, struct imag
   return sum;
 }
 
+/**
+ * Create the buffers of a grayscale image pyramid
+ * Level 0 is not allocated as it references the source image when building.
+ * @param[out] *pyr The image pyramid
+ * @param[in] width The width of the full resolution image
+ * @param[in] height The height of the full resolution image
+ * @param[in] levels The maximum amount of levels (including full resolution) to allocate
+ */
+void image_pyramid_create(struct image_pyramid_t *pyr, uint16_t width, uint16_t height, uint8_t levels)
+{
+  Bound(levels, 1, IMAGE_PYRAMID_MAX_LEVELS);
+  pyr->levels = 0;
+
+  // Level 0 is a reference to the full resolution image
+  pyr->level[0].type = IMAGE_GRAYSCALE;
+  pyr->level[0].w = width;
+  pyr->level[0].h = height;
+  pyr->level[0].buf_size = 0;
+  pyr->level[0].buf = NULL;
+
+  for (uint8_t l = 1; l < IMAGE_PYRAMID_MAX_LEVELS; l++) {
+    if (l < levels) {
+      image_create(&pyr->level[l], pyr->level[l - 1].w / 2, pyr->level[l - 1].h / 2, IMAGE_GRAYSCALE);
+    } else {
+      pyr->level[l].buf_size = 0;
+      pyr->level[l].buf = NULL;
+    }
+  }
+}
+
+/**
+ * Free the buffers of an image pyramid
+ * @param[in] *pyr The image pyramid to free
+ */
+void image_pyramid_free(struct image_pyramid_t *pyr)
+{
+  for (uint8_t l = 1; l < IMAGE_PYRAMID_MAX_LEVELS; l++) {
+    if (pyr->level[l].buf != NULL) {
+      image_free(&pyr->level[l]);
+      pyr->level[l].buf = NULL;
+    }
+  }
+  pyr->levels = 0;
+}
+
+/**
+ * Build the pyramid of a grayscale image by averaging 2x2 pixel blocks
+ * The buffers must be created with image_pyramid_create(), the amount of levels
+ * is limited to the amount created.
+ * @param[in,out] *pyr The image pyramid (level 0 will reference *img)
+ * @param[in] *img The full resolution grayscale image
+ * @param[in] levels The amount of levels to build (including full resolution)
+ */
+void image_pyramid_build(struct image_pyramid_t *pyr, struct image_t *img, uint8_t levels)
+{
+  // Level 0 is a shallow copy of the input
+  memcpy(&pyr->level[0], img, sizeof(struct image_t));
+  pyr->levels = 1;
+
+  for (uint8_t l = 1; l < levels && l < IMAGE_PYRAMID_MAX_LEVELS && pyr->level[l].buf != NULL; l++) {
+    struct image_t *in = &pyr->level[l - 1];
+    struct image_t *out = &pyr->level[l];
+    uint8_t *in_buf = (uint8_t *)in->buf;
+    uint8_t *out_buf = (uint8_t *)out->buf;
+    memcpy(&out->ts, &in->ts, sizeof(struct timeval));
+
+    for (uint16_t y = 0; y < out->h; y++) {
+      uint8_t *row0 = &in_buf[2 * y * in->w];
+      uint8_t *row1 = row0 + in->w;
+      uint8_t *dest = &out_buf[y * out->w];
+      uint16_t x = 0;
+#if defined(IMAGE_NEON)
+      for (; x + 8 <= out->w; x += 8) {
+        // pairwise add the rows and round the average of 4 pixels
+        uint16x8_t sum = vpaddlq_u8(vld1q_u8(&row0[2 * x]));
+        sum = vpadalq_u8(sum, vld1q_u8(&row1[2 * x]));
+        vst1_u8(&dest[x], vrshrn_n_u16(sum, 2));
+      }
+#elif defined(IMAGE_SSE2)
+      const __m128i low_mask = _mm_set1_epi16(0x00FF);
+      const __m128i two = _mm_set1_epi16(2);
+      for (; x + 8 <= out->w; x += 8) {
+        __m128i a = _mm_loadu_si128((__m128i *)&row0[2 * x]);
+        __m128i b = _mm_loadu_si128((__m128i *)&row1[2 * x]);
+        __m128i sum = _mm_add_epi16(_mm_and_si128(a, low_mask), _mm_srli_epi16(a, 8));
+        sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_and_si128(b, low_mask), _mm_srli_epi16(b, 8)));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64((__m128i *)&dest[x], _mm_packus_epi16(sum, sum));
+      }
+#endif
+      for (; x < out->w; x++) {
+        dest[x] = (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) / 4;
+      }
+    }
+    pyr->levels++;
+  }
+}
+
+/**
+ * This will switch image pyramid *a and *b
+ * To be used together with image_switch() on the full resolution images.
+ * @param[in,out] *a The image pyramid to switch
+ * @param[in,out] *b The image pyramid to switch with
+ */
+void image_pyramid_switch(struct image_pyramid_t *a, struct image_pyramid_t *b)
+{
+  struct image_pyramid_t old_a;
+  memcpy(&old_a, a, sizeof(struct image_pyramid_t));
+  memcpy(a, b, sizeof(struct image_pyramid_t));
+  memcpy(b, &old_a, sizeof(struct image_pyramid_t));
+}
+
 /**
  * Show points in an image by coloring them through giving
  * the pixels the maximum value.
@@ -530,3 +919,81 @@ void image_draw_line(struct image_t *img, struct point_t *from, struct point_t *
     }
   }
 }
+
+/**
+ * Squared length of a flow vector
+ */
+static inline int32_t flow_size2(struct flow_t *v)
+{
+  return (int32_t)v->flow_x * v->flow_x + (int32_t)v->flow_y * v->flow_y;
+}
+
+/**
+ * Partially order flow vectors on their length (quickselect)
+ * Afterwards vectors[k] is the vector that would be at index k after a full sort,
+ * all the vectors before it are not longer and all the vectors after it are not shorter.
+ * This takes linear time on average instead of sorting the whole array.
+ * @param[in,out] *vectors The flow vectors
+ * @param[in] count The amount of flow vectors
+ * @param[in] k The index to select
+ */
+void image_flow_select(struct flow_t *vectors, uint16_t count, uint16_t k)
+{
+  if (k >= count) {
+    return;
+  }
+
+  int32_t left = 0, right = count - 1;
+  while (left < right) {
+    // Median of three as pivot, keeps sorted input linear
+    int32_t mid = left + (right - left) / 2;
+    struct flow_t tmp;
+    if (flow_size2(&vectors[mid]) < flow_size2(&vectors[left])) {
+      tmp = vectors[mid]; vectors[mid] = vectors[left]; vectors[left] = tmp;
+    }
+    if (flow_size2(&vectors[right]) < flow_size2(&vectors[left])) {
+      tmp = vectors[right]; vectors[right] = vectors[left]; vectors[left] = tmp;
+    }
+    if (flow_size2(&vectors[right]) < flow_size2(&vectors[mid])) {
+      tmp = vectors[right]; vectors[right] = vectors[mid]; vectors[mid] = tmp;
+    }
+    int32_t pivot = flow_size2(&vectors[mid]);
+
+    // Hoare partition
+    int32_t i = left, j = right;
+    while (i <= j) {
+      while (flow_size2(&vectors[i]) < pivot) { i++; }
+      while (flow_size2(&vectors[j]) > pivot) { j--; }
+      if (i <= j) {
+        tmp = vectors[i]; vectors[i] = vectors[j]; vectors[j] = tmp;
+        i++;
+        j--;
+      }
+    }
+
+    // Continue in the part containing k
+    if (k <= j) {
+      right = j;
+    } else if (k >= i) {
+      left = i;
+    } else {
+      return;
+    }
+  }
+}
+
+/**
+ * Get the flow vector at a percentile of the flow lengths
+ * The vectors are partially reordered (see image_flow_select()).
+ * @param[in,out] *vectors The flow vectors
+ * @param[in] count The amount of flow vectors (must be bigger than 0)
+ * @param[in] percentile The percentile (0 to 100, 50 is the median)
+ * @return The selected flow vector
+ */
+struct flow_t *image_flow_percentile(struct flow_t *vectors, uint16_t count, uint8_t percentile)
+{
+  Bound(percentile, 0, 100);
+  uint16_t k = ((uint32_t)(count - 1) * percentile + 50) / 100;
+  image_flow_select(vectors, count, k);
+  return &vectors[k];
+}
@@ -63,8 +63,41 @@ struct flow_t {
   int16_t flow_y;             ///< The y direction flow in subpixels
 };
 
+/* Maximum amount of levels in an image pyramid (including the full resolution) */
+#ifndef IMAGE_PYRAMID_MAX_LEVELS
+#define IMAGE_PYRAMID_MAX_LEVELS 4
+#endif
+
+/* Grayscale image pyramid, every level is half the size of the previous one */
+struct image_pyramid_t {
+  uint8_t levels;                                   ///< Amount of levels built (level 0 is the full resolution)
+  struct image_t level[IMAGE_PYRAMID_MAX_LEVELS];   ///< Level 0 references the source image, the others are owned
+};
+
+/* Alignment of the allocations in an image arena */
+#define IMAGE_ARENA_ALIGN 16
+
+/* Scratch memory allocated once, from which the per frame buffers are taken.
+ * Everything is released at once by image_arena_reset(), so a frame loop
+ * does not need any malloc/free. */
+struct image_arena_t {
+  uint8_t *buf;       ///< The memory block
+  uint32_t size;      ///< Size of the memory block in bytes
+  uint32_t used;      ///< Bytes currently in use
+  uint32_t max_used;  ///< Highest amount of bytes used since the creation
+};
+
 /* Usefull image functions */
+const char *image_simd_name(void);
 void image_create(struct image_t *img, uint16_t width, uint16_t height, enum image_type type);
+uint32_t image_buf_size(uint16_t width, uint16_t height, enum image_type type);
+void image_arena_create(struct image_arena_t *arena, uint32_t size);
+void image_arena_free(struct image_arena_t *arena);
+void image_arena_reset(struct image_arena_t *arena);
+void *image_arena_alloc(struct image_arena_t *arena, uint32_t size);
+bool_t image_create_arena(struct image_t *img, uint16_t width, uint16_t height, enum image_type type, struct image_arena_t *arena);
+void image_flow_select(struct flow_t *vectors, uint16_t count, uint16_t k);
+struct flow_t *image_flow_percentile(struct flow_t *vectors, uint16_t count, uint8_t percentile);
 void image_free(struct image_t *img);
 void image_copy(struct image_t *input, struct image_t *output);
 void image_switch(struct image_t *a, struct image_t *b);
@@ -76,6 +109,10 @@ void image_gradients(struct image_t *input, struct image_t *dx, struct image_t *
 void image_calculate_g(struct image_t *dx, struct image_t *dy, int32_t *g);
 uint32_t image_difference(struct image_t *img_a, struct image_t *img_b, struct image_t *diff);
 int32_t image_multiply(struct image_t *img_a, struct image_t *img_b, struct image_t *mult);
+void image_pyramid_create(struct image_pyramid_t *pyr, uint16_t width, uint16_t height, uint8_t levels);
+void image_pyramid_free(struct image_pyramid_t *pyr);
+void image_pyramid_build(struct image_pyramid_t *pyr, struct image_t *img, uint8_t levels);
+void image_pyramid_switch(struct image_pyramid_t *a, struct image_pyramid_t *b);
 void image_show_points(struct image_t *img, struct point_t *points, uint16_t points_cnt);
 void image_show_flow(struct image_t *img, struct flow_t *vectors, uint16_t points_cnt, uint8_t subpixel_factor);
 void image_draw_line(struct image_t *img, struct point_t *from, struct point_t *to);
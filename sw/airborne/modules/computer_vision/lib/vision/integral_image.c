@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file modules/computer_vision/lib/vision/integral_image.c
+ * Integral images and box filters on grayscale images.
+ *
+ * The integral image is built line by line: the prefix sum of the line is
+ * added to the previous line of the integral image. With SIMD the prefix sum
+ * of 8 pixels is done in 16 bit lanes with 3 shifted additions, so the memory
+ * is only walked once in its storage order.
+ */
+
+#include "integral_image.h"
+
+#ifndef INTEGRAL_IMAGE_USE_SIMD
+#define INTEGRAL_IMAGE_USE_SIMD TRUE
+#endif
+
+#if INTEGRAL_IMAGE_USE_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define INTEGRAL_IMAGE_NEON 1
+#include <arm_neon.h>
+#elif INTEGRAL_IMAGE_USE_SIMD && defined(__SSE2__)
+#define INTEGRAL_IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/**
+ * Get the name of the kernel implementation selected at build time
+ * @return "neon", "sse2" or "scalar"
+ */
+const char *integral_image_simd_name(void)
+{
+#if defined(INTEGRAL_IMAGE_NEON)
+  return "neon";
+#elif defined(INTEGRAL_IMAGE_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+/**
+ * Compute the integral image of a grayscale image
+ * @param[in] in The grayscale pixels
+ * @param[in] w The image width
+ * @param[in] h The image height
+ * @param[out] ii The integral image (w * h values)
+ */
+void integral_image_compute(uint8_t *in, uint16_t w, uint16_t h, uint32_t *ii)
+{
+  integral_image_rows(in, w, 0, h, ii);
+}
+
+/**
+ * Compute some lines of an integral image.
+ * The lines above y_start must already be computed, so the integral image can
+ * be updated incrementally (e.g. while the lines of a frame come in, or when
+ * only the top of the image is needed).
+ * @param[in] in The grayscale pixels of the whole image
+ * @param[in] w The image width
+ * @param[in] y_start First line to compute
+ * @param[in] y_end Line after the last one to compute
+ * @param[in,out] ii The integral image (w * h values)
+ */
+void integral_image_rows(uint8_t *in, uint16_t w, uint16_t y_start, uint16_t y_end, uint32_t *ii)
+{
+  for (uint16_t y = y_start; y < y_end; y++) {
+    uint8_t *p = &in[y * w];
+    uint32_t *row = &ii[y * w];
+    uint32_t *prev = (y > 0) ? &ii[(y - 1) * w] : NULL;
+    uint32_t sum = 0;
+    uint16_t x = 0;
+
+#if defined(INTEGRAL_IMAGE_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    for (; x + 8 <= w; x += 8) {
+      __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i *)&p[x]), zero);
+      v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+      v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+      v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+      __m128i lo = _mm_add_epi32(_mm_unpacklo_epi16(v, zero), carry);
+      __m128i hi = _mm_add_epi32(_mm_unpackhi_epi16(v, zero), carry);
+      carry = _mm_shuffle_epi32(hi, 0xFF);
+      if (prev != NULL) {
+        _mm_storeu_si128((__m128i *)&row[x], _mm_add_epi32(lo, _mm_loadu_si128((__m128i *)&prev[x])));
+        _mm_storeu_si128((__m128i *)&row[x + 4], _mm_add_epi32(hi, _mm_loadu_si128((__m128i *)&prev[x + 4])));
+      } else {
+        _mm_storeu_si128((__m128i *)&row[x], lo);
+        _mm_storeu_si128((__m128i *)&row[x + 4], hi);
+      }
+    }
+    sum = (uint32_t)_mm_cvtsi128_si32(carry);
+#elif defined(INTEGRAL_IMAGE_NEON)
+    uint16x8_t zero = vdupq_n_u16(0);
+    uint32x4_t carry = vdupq_n_u32(0);
+    for (; x + 8 <= w; x += 8) {
+      uint16x8_t v = vmovl_u8(vld1_u8(&p[x]));
+      v = vaddq_u16(v, vextq_u16(zero, v, 7));
+      v = vaddq_u16(v, vextq_u16(zero, v, 6));
+      v = vaddq_u16(v, vextq_u16(zero, v, 4));
+      uint32x4_t lo = vaddq_u32(vmovl_u16(vget_low_u16(v)), carry);
+      uint32x4_t hi = vaddq_u32(vmovl_u16(vget_high_u16(v)), carry);
+      carry = vdupq_lane_u32(vget_high_u32(hi), 1);
+      if (prev != NULL) {
+        vst1q_u32(&row[x], vaddq_u32(lo, vld1q_u32(&prev[x])));
+        vst1q_u32(&row[x + 4], vaddq_u32(hi, vld1q_u32(&prev[x + 4])));
+      } else {
+        vst1q_u32(&row[x], lo);
+        vst1q_u32(&row[x + 4], hi);
+      }
+    }
+    sum = vgetq_lane_u32(carry, 0);
+#endif
+
+    for (; x < w; x++) {
+      sum += p[x];
+      row[x] = (prev != NULL) ? sum + prev[x] : sum;
+    }
+  }
+}
+
+/**
+ * Box filter on a line: sums of n boxes of the same size, shifted by one pixel.
+ * Evaluating a whole line at once keeps the 2 lines of the integral image
+ * in cache and vectorizes, instead of 4 scattered lookups per box.
+ * @param[in] ii The integral image
+ * @param[in] w The image width
+ * @param[in] x Top left corner of the first box (excluded)
+ * @param[in] y Top left corner of the boxes (excluded)
+ * @param[in] box_w Width of the boxes
+ * @param[in] box_h Height of the boxes
+ * @param[in] n Number of boxes (x + n - 1 + box_w must be in the image)
+ * @param[out] out The n box sums
+ */
+void integral_image_box_row(uint32_t *ii, uint16_t w, uint16_t x, uint16_t y, uint16_t box_w, uint16_t box_h,
+                            uint16_t n, uint32_t *out)
+{
+  uint32_t *top = &ii[x + y * w];
+  uint32_t *bottom = &ii[x + (y + box_h) * w];
+  uint16_t i = 0;
+
+#if defined(INTEGRAL_IMAGE_SSE2)
+  for (; i + 4 <= n; i += 4) {
+    __m128i a = _mm_sub_epi32(_mm_loadu_si128((__m128i *)&bottom[i + box_w]), _mm_loadu_si128((__m128i *)&bottom[i]));
+    __m128i b = _mm_sub_epi32(_mm_loadu_si128((__m128i *)&top[i + box_w]), _mm_loadu_si128((__m128i *)&top[i]));
+    _mm_storeu_si128((__m128i *)&out[i], _mm_sub_epi32(a, b));
+  }
+#elif defined(INTEGRAL_IMAGE_NEON)
+  for (; i + 4 <= n; i += 4) {
+    uint32x4_t a = vsubq_u32(vld1q_u32(&bottom[i + box_w]), vld1q_u32(&bottom[i]));
+    uint32x4_t b = vsubq_u32(vld1q_u32(&top[i + box_w]), vld1q_u32(&top[i]));
+    vst1q_u32(&out[i], vsubq_u32(a, b));
+  }
+#endif
+
+  for (; i < n; i++) {
+    out[i] = (bottom[i + box_w] - bottom[i]) - (top[i + box_w] - top[i]);
+  }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file modules/computer_vision/lib/vision/integral_image.h
+ * Integral images and box filters on grayscale images.
+ *
+ * The integral image has the size of the input and ii[x + y * w] is the sum of
+ * all pixels in [0, x] x [0, y]. The sum of a box is then found with 4 lookups,
+ * whatever its size. Boxes are given by two corners (x0, y0) and (x1, y1) and
+ * contain the pixels in ]x0, x1] x ]y0, y1].
+ */
+
+#ifndef INTEGRAL_IMAGE_H
+#define INTEGRAL_IMAGE_H
+
+#include "std.h"
+
+void integral_image_compute(uint8_t *in, uint16_t w, uint16_t h, uint32_t *ii);
+void integral_image_rows(uint8_t *in, uint16_t w, uint16_t y_start, uint16_t y_end, uint32_t *ii);
+void integral_image_box_row(uint32_t *ii, uint16_t w, uint16_t x, uint16_t y, uint16_t box_w, uint16_t box_h,
+                            uint16_t n, uint32_t *out);
+const char *integral_image_simd_name(void);
+
+/**
+ * Sum of the pixels in a box
+ * @param[in] ii The integral image
+ * @param[in] w The image width
+ * @param[in] x0 Top left corner (excluded)
+ * @param[in] y0 Top left corner (excluded)
+ * @param[in] x1 Bottom right corner (included)
+ * @param[in] y1 Bottom right corner (included)
+ * @return The sum of the pixels in ]x0, x1] x ]y0, y1]
+ */
+static inline uint32_t integral_image_box(uint32_t *ii, uint16_t w, uint16_t x0, uint16_t y0, uint16_t x1,
+    uint16_t y1)
+{
+  return ii[x0 + y0 * w] + ii[x1 + y1 * w] - ii[x1 + y0 * w] - ii[x0 + y1 * w];
+}
+
+#endif /* INTEGRAL_IMAGE_H */
@@ -34,6 +34,57 @@
 #include <string.h>
 #include "lucas_kanade.h"
 
+/**
+ * Create the window images used by the Lucas Kanade iterations
+ * @param[out] *windows The 5 window images (I, J, DX, DY, diff)
+ * @param[in] patch_size The size of the patch in pixels
+ * @param[in] *arena The arena to take the buffers from, or NULL to allocate them
+ * @return FALSE if the arena is too small
+ */
+static bool_t lk_windows_create(struct image_t *windows, uint16_t patch_size, struct image_arena_t *arena)
+{
+  uint16_t padded_patch_size = patch_size + 2;
+  if (arena == NULL) {
+    image_create(&windows[0], padded_patch_size, padded_patch_size, IMAGE_GRAYSCALE);
+    image_create(&windows[1], patch_size, patch_size, IMAGE_GRAYSCALE);
+    image_create(&windows[2], patch_size, patch_size, IMAGE_GRADIENT);
+    image_create(&windows[3], patch_size, patch_size, IMAGE_GRADIENT);
+    image_create(&windows[4], patch_size, patch_size, IMAGE_GRADIENT);
+    return TRUE;
+  }
+  return image_create_arena(&windows[0], padded_patch_size, padded_patch_size, IMAGE_GRAYSCALE, arena)
+         && image_create_arena(&windows[1], patch_size, patch_size, IMAGE_GRAYSCALE, arena)
+         && image_create_arena(&windows[2], patch_size, patch_size, IMAGE_GRADIENT, arena)
+         && image_create_arena(&windows[3], patch_size, patch_size, IMAGE_GRADIENT, arena)
+         && image_create_arena(&windows[4], patch_size, patch_size, IMAGE_GRADIENT, arena);
+}
+
+/**
+ * Free the window images if they were not taken from an arena
+ */
+static void lk_windows_free(struct image_t *windows, struct image_arena_t *arena)
+{
+  if (arena == NULL) {
+    for (uint8_t i = 0; i < 5; i++) {
+      image_free(&windows[i]);
+    }
+  }
+}
+
+/**
+ * Get the amount of arena memory needed by the Lucas Kanade functions
+ * @param[in] half_window_size Half the window size
+ * @return The size in bytes (including the alignment of the allocations)
+ */
+uint32_t opticFlowLKScratchSize(uint16_t half_window_size)
+{
+  uint16_t patch_size = 2 * half_window_size;
+  return image_buf_size(patch_size + 2, patch_size + 2, IMAGE_GRAYSCALE)
+         + image_buf_size(patch_size, patch_size, IMAGE_GRAYSCALE)
+         + 3 * image_buf_size(patch_size, patch_size, IMAGE_GRADIENT)
+         + 5 * IMAGE_ARENA_ALIGN;
+}
+
 
 /**
  * Compute the optical flow of several points using the Lucas-Kanade algorithm by Yves Bouguet
@@ -43,15 +94,18 @@
  * @param[in] *old_img The old grayscale image (TODO: fix YUV422 support)
  * @param[in] *points Points to start tracking from
  * @param[in/out] points_cnt The amount of points and it returns the amount of points tracked
+ * @param[out] *vectors The vectors from the original *points in subpixels (must hold max_points)
  * @param[in] half_window_size Half the window size (in both x and y direction) to search inside
  * @param[in] subpixel_factor The subpixel factor which calculations should be based on
  * @param[in] max_iteration Maximum amount of iterations to find the new point
  * @param[in] step_threshold The threshold at which the iterations should stop
- * @param[in] max_point The maximum amount of points to track, we skip x points and then take a point.
- * @return The vectors from the original *points in subpixels
+ * @param[in] max_points The maximum amount of points to track, we skip x points and then take a point.
+ * @param[in] *arena Scratch memory for the windows, or NULL to allocate them
  */
-struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, struct point_t *points, uint16_t *points_cnt,
-                           uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points) {
+void opticFlowLK(struct image_t *new_img, struct image_t *old_img, struct point_t *points, uint16_t *points_cnt,
+                 struct flow_t *vectors, uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations,
+                 uint8_t step_threshold, uint16_t max_points, struct image_arena_t *arena)
+{
   // A straightforward one-level implementation of Lucas-Kanade.
   // For all points:
   // (1) determine the subpixel neighborhood in the old image
@@ -63,8 +117,6 @@ struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, str
   //     [c] calculate the 'b'-vector
   //     [d] calculate the additional flow step and possibly terminate the iteration
 
-  // Allocate some memory for returning the vectors
-  struct flow_t *vectors = malloc(sizeof(struct flow_t) * max_points);
   uint16_t new_p = 0;
   uint16_t points_orig = *points_cnt;
   *points_cnt = 0;
@@ -72,15 +124,14 @@ struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, str
   // determine patch sizes and initialize neighborhoods
   uint16_t patch_size = 2 * half_window_size;
   uint32_t error_threshold = (25 * 25) *(patch_size *patch_size);
-  uint16_t padded_patch_size = patch_size + 2;
 
   // Create the window images
-  struct image_t window_I, window_J, window_DX, window_DY, window_diff;
-  image_create(&window_I, padded_patch_size, padded_patch_size, IMAGE_GRAYSCALE);
-  image_create(&window_J, patch_size, patch_size, IMAGE_GRAYSCALE);
-  image_create(&window_DX, patch_size, patch_size, IMAGE_GRADIENT);
-  image_create(&window_DY, patch_size, patch_size, IMAGE_GRADIENT);
-  image_create(&window_diff, patch_size, patch_size, IMAGE_GRADIENT);
+  struct image_t windows[5];
+  struct image_t *window_I = &windows[0], *window_J = &windows[1];
+  struct image_t *window_DX = &windows[2], *window_DY = &windows[3], *window_diff = &windows[4];
+  if (!lk_windows_create(windows, patch_size, arena)) {
+    return;
+  }
 
   // Calculate the amount of points to skip
   float skip_points = (points_orig > max_points) ? points_orig / max_points : 1;
@@ -102,14 +153,14 @@ struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, str
     vectors[new_p].flow_y = 0;
 
     // (1) determine the subpixel neighborhood in the old image
-    image_subpixel_window(old_img, &window_I, &vectors[new_p].pos, subpixel_factor);
+    image_subpixel_window(old_img, window_I, &vectors[new_p].pos, subpixel_factor);
 
     // (2) get the x- and y- gradients
-    image_gradients(&window_I, &window_DX, &window_DY);
+    image_gradients(window_I, window_DX, window_DY);
 
     // (3) determine the 'G'-matrix [sum(Axx) sum(Axy); sum(Axy) sum(Ayy)], where sum is over the window
     int32_t G[4];
-    image_calculate_g(&window_DX, &window_DY, G);
+    image_calculate_g(window_DX, window_DY, G);
 
     // calculate G's determinant in subpixel units:
     int32_t Det = (G[0] * G[3] - G[1] * G[2]) / subpixel_factor;
@@ -138,17 +189,17 @@ struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, str
       }
 
       //     [a] get the subpixel neighborhood in the new image
-      image_subpixel_window(new_img, &window_J, &new_point, subpixel_factor);
+      image_subpixel_window(new_img, window_J, &new_point, subpixel_factor);
 
       //     [b] determine the image difference between the two neighborhoods
-      uint32_t error = image_difference(&window_I, &window_J, &window_diff);
+      uint32_t error = image_difference(window_I, window_J, window_diff);
       if (error > error_threshold && it > max_iterations / 2) {
         tracked = FALSE;
         break;
       }
 
-      int32_t b_x = image_multiply(&window_diff, &window_DX, NULL) / 255;
-      int32_t b_y = image_multiply(&window_diff, &window_DY, NULL) / 255;
+      int32_t b_x = image_multiply(window_diff, window_DX, NULL) / 255;
+      int32_t b_y = image_multiply(window_diff, window_DY, NULL) / 255;
 
       //     [d] calculate the additional flow step and possibly terminate the iteration
       int16_t step_x = (G[3] * b_x - G[1] * b_y) / Det;
@@ -170,12 +221,172 @@ struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, str
   }
 
   // Free the images
-  image_free(&window_I);
-  image_free(&window_J);
-  image_free(&window_DX);
-  image_free(&window_DY);
-  image_free(&window_diff);
-
-  // Return the vectors
-  return vectors;
+  lk_windows_free(windows, arena);
+
+}
+
+/**
+ * Check if a subpixel point has a full window inside the image
+ * @param[in] *img The image
+ * @param[in] x The x coordinate in subpixels
+ * @param[in] y The y coordinate in subpixels
+ * @param[in] half_window_size Half the window size
+ * @param[in] subpixel_factor The subpixel factor
+ * @return TRUE if the window is inside the image
+ */
+static bool_t lk_inside_roi(struct image_t *img, int32_t x, int32_t y, uint16_t half_window_size, uint16_t subpixel_factor)
+{
+  if (x < 0 || y < 0) {
+    return FALSE;
+  }
+  x /= subpixel_factor;
+  y /= subpixel_factor;
+  return !(x < half_window_size || (img->w - x) < half_window_size
+           || y < half_window_size || (img->h - y) < half_window_size);
+}
+
+/**
+ * Compute the optical flow of several points using the pyramidal Lucas-Kanade algorithm by Yves Bouguet
+ * The points are tracked from the coarsest level of the pyramids to the full resolution,
+ * every level starting from the (doubled) flow of the previous one. This way larger motions
+ * are tracked with less iterations. The pyramids need to be built by image_pyramid_build() and the
+ * vectors buffer is provided by the caller. With a scratch arena nothing is allocated at all.
+ * @param[in] *new_pyr The pyramid of the newest grayscale image
+ * @param[in] *old_pyr The pyramid of the old grayscale image
+ * @param[in] *points Points to start tracking from
+ * @param[in/out] points_cnt The amount of points and it returns the amount of points tracked
+ * @param[out] *vectors The vectors from the original *points in subpixels (must hold max_points)
+ * @param[in] half_window_size Half the window size (in both x and y direction) to search inside
+ * @param[in] subpixel_factor The subpixel factor which calculations should be based on
+ * @param[in] max_iterations Maximum amount of iterations per level to find the new point
+ * @param[in] step_threshold The threshold at which the iterations should stop
+ * @param[in] max_points The maximum amount of points to track, we skip x points and then take a point.
+ * @param[in] *arena Scratch memory for the windows, or NULL to allocate them
+ */
+void opticFlowLKPyramid(struct image_pyramid_t *new_pyr, struct image_pyramid_t *old_pyr, struct point_t *points,
+                        uint16_t *points_cnt, struct flow_t *vectors, uint16_t half_window_size, uint16_t subpixel_factor,
+                        uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points, struct image_arena_t *arena)
+{
+  uint16_t new_p = 0;
+  uint16_t points_orig = *points_cnt;
+  *points_cnt = 0;
+
+  // Only use the levels both pyramids have
+  uint8_t levels = Min(new_pyr->levels, old_pyr->levels);
+
+  // determine patch sizes and initialize neighborhoods
+  uint16_t patch_size = 2 * half_window_size;
+  uint32_t error_threshold = (25 * 25) * (patch_size * patch_size);
+
+  // Create the window images
+  struct image_t windows[5];
+  struct image_t *window_I = &windows[0], *window_J = &windows[1];
+  struct image_t *window_DX = &windows[2], *window_DY = &windows[3], *window_diff = &windows[4];
+  if (!lk_windows_create(windows, patch_size, arena)) {
+    return;
+  }
+
+  // Calculate the amount of points to skip
+  float skip_points = (points_orig > max_points) ? points_orig / max_points : 1;
+
+  // Go trough all points
+  for (uint16_t i = 0; i < max_points && i < points_orig; i++) {
+    uint16_t p = i * skip_points;
+
+    // If the pixel is outside ROI, do not track it
+    if (!lk_inside_roi(&old_pyr->level[0], points[p].x * subpixel_factor, points[p].y * subpixel_factor,
+                       half_window_size, subpixel_factor)) {
+      continue;
+    }
+
+    // Guessed flow from the coarser levels (in subpixels of the current level)
+    int32_t guess_x = 0, guess_y = 0;
+    bool_t tracked = TRUE;
+
+    for (int8_t l = levels - 1; l >= 0 && tracked; l--) {
+      struct image_t *old_img = &old_pyr->level[l];
+      struct image_t *new_img = &new_pyr->level[l];
+
+      // The point on this level in subpixel coordinates
+      struct point_t pos = {
+        (points[p].x * subpixel_factor) >> l,
+        (points[p].y * subpixel_factor) >> l
+      };
+      int32_t flow_x = guess_x, flow_y = guess_y;
+
+      // (1) determine the subpixel neighborhood in the old image
+      // (2) get the x- and y- gradients
+      // (3) determine the 'G'-matrix
+      int32_t G[4], Det = 0;
+      if (lk_inside_roi(old_img, pos.x, pos.y, half_window_size, subpixel_factor)) {
+        image_subpixel_window(old_img, window_I, &pos, subpixel_factor);
+        image_gradients(window_I, window_DX, window_DY);
+        image_calculate_g(window_DX, window_DY, G);
+        Det = (G[0] * G[3] - G[1] * G[2]) / subpixel_factor;
+      }
+
+      // Without texture on a coarse level we keep the guess, on the full resolution we give up
+      if (Det < 1) {
+        if (l == 0) {
+          tracked = FALSE;
+        }
+      } else {
+        // (4) iterate over taking steps in the image to minimize the error
+        for (uint8_t it = 0; it < max_iterations; it++) {
+          int32_t new_x = pos.x + flow_x;
+          int32_t new_y = pos.y + flow_y;
+          if (!lk_inside_roi(new_img, new_x, new_y, half_window_size, subpixel_factor)) {
+            tracked = FALSE;
+            break;
+          }
+          struct point_t new_point = { new_x, new_y };
+
+          //     [a] get the subpixel neighborhood in the new image
+          image_subpixel_window(new_img, window_J, &new_point, subpixel_factor);
+
+          //     [b] determine the image difference between the two neighborhoods
+          uint32_t error = image_difference(window_I, window_J, window_diff);
+          if (l == 0 && error > error_threshold && it > max_iterations / 2) {
+            tracked = FALSE;
+            break;
+          }
+
+          //     [c] calculate the 'b'-vector
+          int32_t b_x = image_multiply(window_diff, window_DX, NULL) / 255;
+          int32_t b_y = image_multiply(window_diff, window_DY, NULL) / 255;
+
+          //     [d] calculate the additional flow step and possibly terminate the iteration
+          int16_t step_x = (G[3] * b_x - G[1] * b_y) / Det;
+          int16_t step_y = (G[0] * b_y - G[2] * b_x) / Det;
+          flow_x += step_x;
+          flow_y += step_y;
+
+          // Check if we exceeded the treshold
+          if ((abs(step_x) + abs(step_y)) < step_threshold) {
+            break;
+          }
+        }
+      }
+
+      // Propagate to the next finer level or store the result
+      if (l > 0) {
+        guess_x = 2 * flow_x;
+        guess_y = 2 * flow_y;
+      } else if (tracked) {
+        vectors[new_p].pos.x = points[p].x * subpixel_factor;
+        vectors[new_p].pos.y = points[p].y * subpixel_factor;
+        vectors[new_p].flow_x = flow_x;
+        vectors[new_p].flow_y = flow_y;
+      }
+    }
+
+    // If we tracked the point we update the index and the count
+    if (tracked) {
+      new_p++;
+      (*points_cnt)++;
+    }
+  }
+
+  // Free the images
+  lk_windows_free(windows, arena);
 }
@@ -34,7 +34,12 @@
 #include "std.h"
 #include "image.h"
 
-struct flow_t *opticFlowLK(struct image_t *new_img, struct image_t *old_img, struct point_t *points, uint16_t *points_cnt,
-                           uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points);
+void opticFlowLK(struct image_t *new_img, struct image_t *old_img, struct point_t *points, uint16_t *points_cnt,
+                 struct flow_t *vectors, uint16_t half_window_size, uint16_t subpixel_factor, uint8_t max_iterations,
+                 uint8_t step_threshold, uint16_t max_points, struct image_arena_t *arena);
+void opticFlowLKPyramid(struct image_pyramid_t *new_pyr, struct image_pyramid_t *old_pyr, struct point_t *points,
+                        uint16_t *points_cnt, struct flow_t *vectors, uint16_t half_window_size, uint16_t subpixel_factor,
+                        uint8_t max_iterations, uint8_t step_threshold, uint16_t max_points, struct image_arena_t *arena);
+uint32_t opticFlowLKScratchSize(uint16_t half_window_size);
 
 #endif /* OPTIC_FLOW_INT_H */
@@ -46,6 +46,11 @@
 // Is this still necessary?
 #define MAX_COUNT_PT 50
 
+// Probability that RANSAC drew at least one outlier free sample, used to stop early
+#ifndef LINEAR_FLOW_FIT_CONFIDENCE
+#define LINEAR_FLOW_FIT_CONFIDENCE 0.99f
+#endif
+
 #define MIN_SAMPLES_FIT 3
 #define NO_FIT 0
 #define FIT 1
@@ -56,13 +61,14 @@
  * @param[in] flow_t* vectors The optical flow vectors
  * @param[in] count The number of optical flow vectors
  * @param[in] error_threshold Error used to determine inliers / outliers.
- * @param[in] n_iterations Number of RANSAC iterations.
+ * @param[in] n_iterations Maximum number of RANSAC iterations.
  * @param[in] n_samples Number of samples used for a single fit (min. 3).
  * @param[in] im_width Image width in pixels
  * @param[in] im_height Image height in pixels
+ * @param[in] rng Random number generator used for the RANSAC samples
  * @param[out] info Contains all info extracted from the linear flow fit.
  */
-int analyze_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, int im_width, int im_height, struct linear_flow_fit_info *info)
+int analyze_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, int im_width, int im_height, struct pprz_rand_t *rng, struct linear_flow_fit_info *info)
 {
   // Are there enough flow vectors to perform a fit?
   if (count < MIN_SAMPLES_FIT) {
@@ -72,7 +78,7 @@ int analyze_linear_flow_field(struct flow_t *vectors, int count, float error_thr
 
   // fit linear flow field:
   float parameters_u[3], parameters_v[3], min_error_u, min_error_v;
-  fit_linear_flow_field(vectors, count, n_iterations, error_threshold, n_samples, parameters_u, parameters_v, &info->fit_error, &min_error_u, &min_error_v, &info->n_inliers_u, &info->n_inliers_v);
+  fit_linear_flow_field(vectors, count, error_threshold, n_iterations, n_samples, rng, parameters_u, parameters_v, &info->fit_error, &min_error_u, &min_error_v, &info->n_inliers_u, &info->n_inliers_v);
 
   // extract information from the parameters:
   extract_information_from_parameters(parameters_u, parameters_v, im_width, im_height, info);
@@ -80,20 +86,60 @@ int analyze_linear_flow_field(struct flow_t *vectors, int count, float error_thr
   // surface roughness is equal to fit error:
   info->surface_roughness = info->fit_error;
   info->divergence = info->relative_velocity_z;
-  float diverg = (abs(info->divergence) < 1E-5) ? 1E-5 : info->divergence;
+  float diverg = (fabsf(info->divergence) < 1E-5) ? 1E-5 : info->divergence;
   info->time_to_contact = 1.0f / diverg;
 
   // return successful fit:
   return FIT;
 }
 
+/**
+ * Evaluate a fit on all the vectors
+ * The residuals are accumulated in 4 independent lanes, so the loop pipelines (and vectorises) well.
+ * @param[in] x The x positions of the vectors
+ * @param[in] y The y positions of the vectors
+ * @param[in] f The flow of the vectors in the fitted direction
+ * @param[in] count The number of vectors
+ * @param[in] param The parameters of the fit (f = param[0] * x + param[1] * y + param[2])
+ * @param[in] error_threshold Error used to determine inliers / outliers, outliers count with this error
+ * @param[out] n_inliers The number of inliers
+ * @return The total error
+ */
+static float linear_flow_residuals(const float *x, const float *y, const float *f, int count, const float *param,
+                                   float error_threshold, int *n_inliers)
+{
+  float err[4] = {0, 0, 0, 0};
+  int inl[4] = {0, 0, 0, 0};
+  int p = 0;
+
+  for (; p + 4 <= count; p += 4) {
+    for (int l = 0; l < 4; l++) {
+      float r = fabsf(param[0] * x[p + l] + param[1] * y[p + l] + param[2] - f[p + l]);
+      int in = r < error_threshold;
+      err[l] += in ? r : error_threshold;
+      inl[l] += in;
+    }
+  }
+  for (; p < count; p++) {
+    float r = fabsf(param[0] * x[p] + param[1] * y[p] + param[2] - f[p]);
+    int in = r < error_threshold;
+    err[0] += in ? r : error_threshold;
+    inl[0] += in;
+  }
+
+  *n_inliers = inl[0] + inl[1] + inl[2] + inl[3];
+  return (err[0] + err[1]) + (err[2] + err[3]);
+}
+
 /**
  * Analyze a linear flow field, retrieving information such as divergence, surface roughness, focus of expansion, etc.
+ * RANSAC stops early when the best fits have enough inliers to reach LINEAR_FLOW_FIT_CONFIDENCE.
  * @param[in] flow_t* vectors The optical flow vectors
  * @param[in] count The number of optical flow vectors
  * @param[in] error_threshold Error used to determine inliers / outliers.
- * @param[in] n_iterations Number of RANSAC iterations.
+ * @param[in] n_iterations Maximum number of RANSAC iterations.
  * @param[in] n_samples Number of samples used for a single fit (min. 3).
+ * @param[in] rng Random number generator used for the samples (same seed and input gives the same fit)
  * @param[out] parameters_u* Parameters of the horizontal flow field
  * @param[out] parameters_v* Parameters of the vertical flow field
  * @param[out] fit_error* Total error of the finally selected fit
@@ -102,7 +148,7 @@ int analyze_linear_flow_field(struct flow_t *vectors, int count, float error_thr
  * @param[out] n_inliers_u* Number of inliers in the horizontal flow fit.
  * @param[out] n_inliers_v* Number of inliers in the vertical flow fit.
  */
-void fit_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, float *parameters_u, float *parameters_v, float *fit_error, float *min_error_u, float *min_error_v, int *n_inliers_u, int *n_inliers_v)
+void fit_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, struct pprz_rand_t *rng, float *parameters_u, float *parameters_v, float *fit_error, float *min_error_u, float *min_error_v, int *n_inliers_u, int *n_inliers_v)
 {
 
   // We will solve systems of the form A x = b,
@@ -118,64 +164,39 @@ void fit_linear_flow_field(struct flow_t *vectors, int count, float error_thresh
   // n_samples should not be higher than count:
   n_samples = (n_samples < count) ? n_samples : count;
 
-  // initialize matrices and vectors for the full point set problem:
-  // this is used for determining inliers
-  float _AA[count][3];
-  MAKE_MATRIX_PTR(AA, _AA, count);
-  float _bu_all[count][1];
-  MAKE_MATRIX_PTR(bu_all, _bu_all, count);
-  float _bv_all[count][1];
-  MAKE_MATRIX_PTR(bv_all, _bv_all, count);
+  // the full point set in separate arrays, used for determining inliers:
+  float xs[count], ys[count], us[count], vs[count];
   for (sam = 0; sam < count; sam++) {
-    AA[sam][0] = (float) vectors[sam].pos.x;
-    AA[sam][1] = (float) vectors[sam].pos.y;
-    AA[sam][2] = 1.0f;
-    bu_all[sam][0] = (float) vectors[sam].flow_x;
-    bv_all[sam][0] = (float) vectors[sam].flow_y;
+    xs[sam] = (float) vectors[sam].pos.x;
+    ys[sam] = (float) vectors[sam].pos.y;
+    us[sam] = (float) vectors[sam].flow_x;
+    vs[sam] = (float) vectors[sam].flow_y;
   }
 
-  // later used to determine the error of a set of parameters on the whole set:
-  float _bb[count][1];
-  MAKE_MATRIX_PTR(bb, _bb, count);
-  float _C[count][1];
-  MAKE_MATRIX_PTR(C, _C, count);
-
   // ***************
   // perform RANSAC:
   // ***************
 
   // set up variables for small linear system solved repeatedly inside RANSAC:
-  float _A[n_samples][3];
-  MAKE_MATRIX_PTR(A, _A, n_samples);
-  float _bu[n_samples][1];
-  MAKE_MATRIX_PTR(bu, _bu, n_samples);
-  float _bv[n_samples][1];
-  MAKE_MATRIX_PTR(bv, _bv, n_samples);
-  float w[n_samples], _v[3][3];
-  MAKE_MATRIX_PTR(v, _v, 3);
-  float _pu[3][1];
-  MAKE_MATRIX_PTR(pu, _pu, 3);
-  float _pv[3][1];
-  MAKE_MATRIX_PTR(pv, _pv, 3);
-
-  // iterate and store parameters, errors, inliers per fit:
-  float PU[n_iterations * 3];
-  float PV[n_iterations * 3];
-  float errors_pu[n_iterations];
-  errors_pu[0] = 0.0;
-  float errors_pv[n_iterations];
-  errors_pv[0] = 0.0;
-  int n_inliers_pu[n_iterations];
-  int n_inliers_pv[n_iterations];
+  float A[n_samples][3];
+  float bu[n_samples], bv[n_samples];
+  float w[3], v[3][3];
+
+  // only the best fit for each direction is kept:
+  float best_pu[3] = {0, 0, 0}, best_pv[3] = {0, 0, 0};
+  float best_error_u = 0, best_error_v = 0;
+  int best_inliers_u = 0, best_inliers_v = 0;
+  float log_no_success = logf(1.0f - LINEAR_FLOW_FIT_CONFIDENCE);
+  int max_iterations = n_iterations;
   int it, ii;
-  for (it = 0; it < n_iterations; it++) {
+  for (it = 0; it < max_iterations; it++) {
     // select a random sample of n_sample points:
     int sample_indices[n_samples];
     i_rand = 0;
 
     // sampling without replacement:
     while (i_rand < n_samples) {
-      si = rand() % count;
+      si = pprz_rand_range(rng, count);
       add_si = 1;
       for (ii = 0; ii < i_rand; ii++) {
         if (sample_indices[ii] == si) { add_si = 0; }
@@ -188,12 +209,11 @@ void fit_linear_flow_field(struct flow_t *vectors, int count, float error_thresh
 
     // Setup the system:
     for (sam = 0; sam < n_samples; sam++) {
-      A[sam][0] = (float) vectors[sample_indices[sam]].pos.x;
-      A[sam][1] = (float) vectors[sample_indices[sam]].pos.y;
+      A[sam][0] = xs[sample_indices[sam]];
+      A[sam][1] = ys[sample_indices[sam]];
       A[sam][2] = 1.0f;
-      bu[sam][0] = (float) vectors[sample_indices[sam]].flow_x;
-      bv[sam][0] = (float) vectors[sample_indices[sam]].flow_y;
-      //printf("%d,%d,%d,%d,%d\n",A[sam][0],A[sam][1],A[sam][2],bu[sam][0],bv[sam][0]);
+      bu[sam] = us[sample_indices[sam]];
+      bv[sam] = vs[sample_indices[sam]];
     }
 
     // Solve the small system:
@@ -201,104 +221,56 @@ void fit_linear_flow_field(struct flow_t *vectors, int count, float error_thresh
     // for horizontal flow:
     // decompose A in u, w, v with singular value decomposition A = u * w * vT.
     // u replaces A as output:
-    pprz_svd_float(A, w, v, n_samples, 3);
-    pprz_svd_solve_float(pu, A, w, v, bu, n_samples, 3, 1);
-    PU[it * 3] = pu[0][0];
-    PU[it * 3 + 1] = pu[1][0];
-    PU[it * 3 + 2] = pu[2][0];
-
+    pprz_svd_float_3(A, w, v, n_samples);
+    float param_u[3], param_v[3];
+    pprz_svd_solve_float_3(param_u, A, w, v, bu, n_samples);
     // for vertical flow:
-    pprz_svd_solve_float(pv, A, w, v, bv, n_samples, 3, 1);
-    PV[it * 3] = pv[0][0];
-    PV[it * 3 + 1] = pv[1][0];
-    PV[it * 3 + 2] = pv[2][0];
+    pprz_svd_solve_float_3(param_v, A, w, v, bv, n_samples);
 
     // count inliers and determine their error on all points:
-    errors_pu[it] = 0;
-    errors_pv[it] = 0;
-    n_inliers_pu[it] = 0;
-    n_inliers_pv[it] = 0;
-
-    // for horizontal flow:
-    // bb = AA * pu:
-    MAT_MUL(count, 3, 1, bb, AA, pu);
-    // subtract bu_all: C = 0 in case of perfect fit:
-    MAT_SUB(count, 1, C, bb, bu_all);
-
-    for (p = 0; p < count; p++) {
-      C[p][0] = abs(C[p][0]);
-      if (C[p][0] < error_threshold) {
-        errors_pu[it] += C[p][0];
-        n_inliers_pu[it]++;
-      } else {
-        errors_pu[it] += error_threshold;
-      }
+    int inliers_u, inliers_v;
+    float error_u = linear_flow_residuals(xs, ys, us, count, param_u, error_threshold, &inliers_u);
+    float error_v = linear_flow_residuals(xs, ys, vs, count, param_v, error_threshold, &inliers_v);
+
+    // keep the parameters with lowest error:
+    if (it == 0 || error_u < best_error_u) {
+      best_error_u = error_u;
+      best_inliers_u = inliers_u;
+      memcpy(best_pu, param_u, sizeof(best_pu));
+    }
+    if (it == 0 || error_v < best_error_v) {
+      best_error_v = error_v;
+      best_inliers_v = inliers_v;
+      memcpy(best_pv, param_v, sizeof(best_pv));
     }
 
-    // for vertical flow:
-    // bb = AA * pv:
-    MAT_MUL(count, 3, 1, bb, AA, pv);
-    // subtract bv_all: C = 0 in case of perfect fit:
-    MAT_SUB(count, 1, C, bb, bv_all);
-
-    for (p = 0; p < count; p++) {
-      C[p][0] = abs(C[p][0]);
-      if (C[p][0] < error_threshold) {
-        errors_pv[it] += C[p][0];
-        n_inliers_pv[it]++;
-      } else {
-        errors_pv[it] += error_threshold;
+    // early termination: iterations needed to draw an outlier free sample with the
+    // requested confidence, given the inlier ratio of the best fits so far
+    float inlier_ratio = (float) Min(best_inliers_u, best_inliers_v) / count;
+    if (inlier_ratio >= 1.0f) {
+      break;
+    }
+    float p_good = powf(inlier_ratio, n_samples);
+    if (p_good > 1E-6) {
+      float needed = log_no_success / logf(1.0f - p_good);
+      if (needed < max_iterations) {
+        max_iterations = (int) ceilf(needed);
       }
     }
   }
 
   // After all iterations:
-  // select the parameters with lowest error:
-  // for horizontal flow:
-  int param;
-  int min_ind = 0;
-  *min_error_u = (float)errors_pu[0];
-  for (it = 1; it < n_iterations; it++) {
-    if (errors_pu[it] < *min_error_u) {
-      *min_error_u = (float)errors_pu[it];
-      min_ind = it;
-    }
-  }
-  for (param = 0; param < 3; param++) {
-    parameters_u[param] = PU[min_ind * 3 + param];
-  }
-  *n_inliers_u = n_inliers_pu[min_ind];
-
-  // for vertical flow:
-  min_ind = 0;
-  *min_error_v = (float)errors_pv[0];
-  for (it = 0; it < n_iterations; it++) {
-    if (errors_pv[it] < *min_error_v) {
-      *min_error_v = (float)errors_pv[it];
-      min_ind = it;
-    }
-  }
-  for (param = 0; param < 3; param++) {
-    parameters_v[param] = PV[min_ind * 3 + param];
-  }
-  *n_inliers_v = n_inliers_pv[min_ind];
+  memcpy(parameters_u, best_pu, sizeof(best_pu));
+  memcpy(parameters_v, best_pv, sizeof(best_pv));
+  *n_inliers_u = best_inliers_u;
+  *n_inliers_v = best_inliers_v;
 
   // error has to be determined on the entire set without threshold:
-  // bb = AA * pu:
-  MAT_MUL(count, 3, 1, bb, AA, pu);
-  // subtract bu_all: C = 0 in case of perfect fit:
-  MAT_SUB(count, 1, C, bb, bu_all);
   *min_error_u = 0;
-  for (p = 0; p < count; p++) {
-    *min_error_u += abs(C[p][0]);
-  }
-  // bb = AA * pv:
-  MAT_MUL(count, 3, 1, bb, AA, pv);
-  // subtract bv_all: C = 0 in case of perfect fit:
-  MAT_SUB(count, 1, C, bb, bv_all);
   *min_error_v = 0;
   for (p = 0; p < count; p++) {
-    *min_error_v += abs(C[p][0]);
+    *min_error_u += fabsf(best_pu[0] * xs[p] + best_pu[1] * ys[p] + best_pu[2] - us[p]);
+    *min_error_v += fabsf(best_pv[0] * xs[p] + best_pv[1] * ys[p] + best_pv[2] - vs[p]);
   }
   *fit_error = (*min_error_u + *min_error_v) / (2 * count);
 
@@ -328,14 +300,14 @@ void extract_information_from_parameters(float *parameters_u, float *parameters_
   info->relative_velocity_x = -(parameters_u[2] + (im_width / 2.0f) * parameters_u[0] + (im_height / 2.0f) * parameters_u[1]);
   info->relative_velocity_y = -(parameters_v[2] + (im_width / 2.0f) * parameters_v[0] + (im_height / 2.0f) * parameters_v[1]);
 
-  float arv_x = abs(info->relative_velocity_x);
-  float arv_y = abs(info->relative_velocity_y);
+  float arv_x = fabsf(info->relative_velocity_x);
+  float arv_y = fabsf(info->relative_velocity_y);
 
   // extract inclination from flow field:
   float threshold_slope = 1.0;
   float eta = 0.002;
 
-  if (abs(parameters_v[1]) < eta && arv_y < threshold_slope && arv_x >= 2 * threshold_slope) {
+  if (fabsf(parameters_v[1]) < eta && arv_y < threshold_slope && arv_x >= 2 * threshold_slope) {
     // there is no forward motion and not enough vertical motion, but enough horizontal motion:
     info->slope_x = parameters_u[0] / info->relative_velocity_x;
   } else if (arv_y >= 2 * threshold_slope) {
@@ -347,7 +319,7 @@ void extract_information_from_parameters(float *parameters_u, float *parameters_
     info->slope_x = 0.0f;
   }
 
-  if (abs(parameters_u[0]) < eta && arv_x < threshold_slope && arv_y >= 2 * threshold_slope) {
+  if (fabsf(parameters_u[0]) < eta && arv_x < threshold_slope && arv_y >= 2 * threshold_slope) {
     // there is no forward motion, little horizontal movement, but sufficient vertical motion:
     info->slope_y = parameters_v[1] / info->relative_velocity_y;
   } else if (arv_x >= 2 * threshold_slope) {
@@ -364,12 +336,12 @@ void extract_information_from_parameters(float *parameters_u, float *parameters_
   // the FoE is the point where these 2 lines intersect (flow = (0,0))
   // x:
   float denominator = parameters_v[0] * parameters_u[1] - parameters_u[0] * parameters_v[1];
-  if (abs(denominator) > 1E-5) {
+  if (fabsf(denominator) > 1E-5) {
     info->focus_of_expansion_x = ((parameters_u[2] * parameters_v[1] - parameters_v[2] * parameters_u[1]) / denominator);
   } else { info->focus_of_expansion_x = 0.0f; }
   // y:
   denominator = parameters_u[1];
-  if (abs(denominator) > 1E-5) {
+  if (fabsf(denominator) > 1E-5) {
     info->focus_of_expansion_y = (-(parameters_u[0] * (info->focus_of_expansion_x) + parameters_u[2]) / denominator);
   } else { info->focus_of_expansion_y = 0.0f; }
 }
@@ -32,6 +32,7 @@
  */
 
 #include "lib/vision/image.h"
+#include "math/pprz_random.h"
 
 #ifndef LINEAR_FLOW_FIT
 #define LINEAR_FLOW_FIT
@@ -54,10 +55,10 @@ struct linear_flow_fit_info {
 };
 
 // This is the function called externally, passing the vector of optical flow vectors and information on the number of vectors and image size:
-int analyze_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, int im_width, int im_height, struct linear_flow_fit_info *info);
+int analyze_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, int im_width, int im_height, struct pprz_rand_t *rng, struct linear_flow_fit_info *info);
 
 // Fits the linear flow field with RANSAC:
-void fit_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, float *parameters_u, float *parameters_v, float *fit_error, float *min_error_u, float *min_error_v, int *n_inliers_u, int *n_inliers_v);
+void fit_linear_flow_field(struct flow_t *vectors, int count, float error_threshold, int n_iterations, int n_samples, struct pprz_rand_t *rng, float *parameters_u, float *parameters_v, float *fit_error, float *min_error_u, float *min_error_v, int *n_inliers_u, int *n_inliers_v);
 
 // Extracts relevant information from the fit parameters:
 void extract_information_from_parameters(float *parameters_u, float *parameters_v, int im_width, int im_height, struct linear_flow_fit_info *info);
@@ -97,6 +97,11 @@ PRINT_CONFIG_VAR(OPTICFLOW_MAX_ITERATIONS)
 #endif
 PRINT_CONFIG_VAR(OPTICFLOW_THRESHOLD_VEC)
 
+#ifndef OPTICFLOW_PYRAMID_LEVEL
+#define OPTICFLOW_PYRAMID_LEVEL 0
+#endif
+PRINT_CONFIG_VAR(OPTICFLOW_PYRAMID_LEVEL)
+
 #ifndef OPTICFLOW_FAST9_ADAPTIVE
 #define OPTICFLOW_FAST9_ADAPTIVE TRUE
 #endif
@@ -112,9 +117,20 @@ PRINT_CONFIG_VAR(OPTICFLOW_FAST9_THRESHOLD)
 #endif
 PRINT_CONFIG_VAR(OPTICFLOW_FAST9_MIN_DISTANCE)
 
+#ifndef OPTICFLOW_RANDOM_SEED
+#define OPTICFLOW_RANDOM_SEED 1
+#endif
+PRINT_CONFIG_VAR(OPTICFLOW_RANDOM_SEED)
+
+#ifndef OPTICFLOW_FAST9_MAX_CORNERS
+#define OPTICFLOW_FAST9_MAX_CORNERS 100
+#endif
+PRINT_CONFIG_VAR(OPTICFLOW_FAST9_MAX_CORNERS)
+
 /* Functions only used here */
 static uint32_t timeval_diff(struct timeval *starttime, struct timeval *finishtime);
-static int cmp_flow(const void *a, const void *b);
+static uint32_t opticflow_scratch_size(struct opticflow_t *opticflow);
+static void flow_median(struct flow_t *vectors, uint16_t count, int16_t *flow_x, int16_t *flow_y);
 
 /**
  * Initialize the opticflow calculator
@@ -127,6 +143,11 @@ void opticflow_calc_init(struct opticflow_t *opticflow, uint16_t w, uint16_t h)
   /* Create the image buffers */
   image_create(&opticflow->img_gray, w, h, IMAGE_GRAYSCALE);
   image_create(&opticflow->prev_img_gray, w, h, IMAGE_GRAYSCALE);
+  image_pyramid_create(&opticflow->pyr, w, h, IMAGE_PYRAMID_MAX_LEVELS);
+  image_pyramid_create(&opticflow->prev_pyr, w, h, IMAGE_PYRAMID_MAX_LEVELS);
+
+  /* Random samples of the divergence estimations, reproducible from the seed */
+  pprz_rand_seed(&opticflow->rng, OPTICFLOW_RANDOM_SEED);
 
   /* Set the previous values */
   opticflow->got_first_img = FALSE;
@@ -139,10 +160,15 @@ void opticflow_calc_init(struct opticflow_t *opticflow, uint16_t w, uint16_t h)
   opticflow->subpixel_factor = OPTICFLOW_SUBPIXEL_FACTOR;
   opticflow->max_iterations = OPTICFLOW_MAX_ITERATIONS;
   opticflow->threshold_vec = OPTICFLOW_THRESHOLD_VEC;
+  opticflow->pyramid_level = OPTICFLOW_PYRAMID_LEVEL;
 
   opticflow->fast9_adaptive = OPTICFLOW_FAST9_ADAPTIVE;
   opticflow->fast9_threshold = OPTICFLOW_FAST9_THRESHOLD;
   opticflow->fast9_min_distance = OPTICFLOW_FAST9_MIN_DISTANCE;
+  opticflow->fast9_max_corners = OPTICFLOW_FAST9_MAX_CORNERS;
+
+  /* The scratch memory for the frame calculations, sized for the default settings */
+  image_arena_create(&opticflow->scratch, opticflow_scratch_size(opticflow));
 }
 
 /**
@@ -160,16 +186,27 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
   // variables for linear flow fit:
   float error_threshold; int n_iterations_RANSAC, n_samples_RANSAC, success_fit; struct linear_flow_fit_info fit_info;
 
+  // Make sure the scratch memory fits the current settings (only allocates when they are increased)
+  uint32_t scratch_size = opticflow_scratch_size(opticflow);
+  if (scratch_size > opticflow->scratch.size) {
+    image_arena_free(&opticflow->scratch);
+    image_arena_create(&opticflow->scratch, scratch_size);
+  }
+  image_arena_reset(&opticflow->scratch);
+
   // Update FPS for information
   result->fps = 1 / (timeval_diff(&opticflow->prev_timestamp, &img->ts) / 1000.);
   memcpy(&opticflow->prev_timestamp, &img->ts, sizeof(struct timeval));
 
-  // Convert image to grayscale
+  // Convert image to grayscale and build its pyramid
+  uint8_t levels = opticflow->pyramid_level + 1;
   image_to_grayscale(img, &opticflow->img_gray);
+  image_pyramid_build(&opticflow->pyr, &opticflow->img_gray, levels);
 
   // Copy to previous image if not set
   if (!opticflow->got_first_img) {
     image_copy(&opticflow->img_gray, &opticflow->prev_img_gray);
+    image_pyramid_build(&opticflow->prev_pyr, &opticflow->prev_img_gray, levels);
     opticflow->got_first_img = TRUE;
   }
 
@@ -177,17 +214,25 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
   // Corner detection
   // *************************************************************************************
 
-  // FAST corner detection (TODO: non fixed threshold)
-  struct point_t *corners = fast9_detect(img, opticflow->fast9_threshold, opticflow->fast9_min_distance,
-                                         20, 20, &result->corner_cnt);
+  // FAST corner detection, at most one corner per fast9_min_distance grid cell
+  struct point_t *corners = image_arena_alloc(&opticflow->scratch, sizeof(struct point_t) * opticflow->fast9_max_corners);
+  struct flow_t *vectors = image_arena_alloc(&opticflow->scratch, sizeof(struct flow_t) * opticflow->max_track_corners);
+  if (corners == NULL || vectors == NULL) {
+    image_switch(&opticflow->img_gray, &opticflow->prev_img_gray);
+    image_pyramid_switch(&opticflow->pyr, &opticflow->prev_pyr);
+    return;
+  }
+  fast9_detect(&opticflow->img_gray, opticflow->fast9_threshold, opticflow->fast9_min_distance,
+               20, 20, corners, opticflow->fast9_max_corners, &result->corner_cnt, &opticflow->scratch);
 
   // Adaptive threshold
   if (opticflow->fast9_adaptive) {
 
-    // Decrease and increase the threshold based on previous values
-    if (result->corner_cnt < 40 && opticflow->fast9_threshold > 5) {
+    // Keep the corner count between 80% and 100% of the budget: decrease the threshold
+    // when short of corners, increase it when the budget is full (corners were dropped)
+    if (result->corner_cnt < opticflow->fast9_max_corners * 4 / 5 && opticflow->fast9_threshold > 5) {
       opticflow->fast9_threshold--;
-    } else if (result->corner_cnt > 50 && opticflow->fast9_threshold < 60) {
+    } else if (result->corner_cnt >= opticflow->fast9_max_corners && opticflow->fast9_threshold < 60) {
       opticflow->fast9_threshold++;
     }
   }
@@ -198,8 +243,8 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
 
   // Check if we found some corners to track
   if (result->corner_cnt < 1) {
-    free(corners);
-    image_copy(&opticflow->img_gray, &opticflow->prev_img_gray);
+    image_switch(&opticflow->img_gray, &opticflow->prev_img_gray);
+    image_pyramid_switch(&opticflow->pyr, &opticflow->prev_pyr);
     return;
   }
 
@@ -207,11 +252,11 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
   // Corner Tracking
   // *************************************************************************************
 
-  // Execute a Lucas Kanade optical flow
+  // Execute a (pyramidal) Lucas Kanade optical flow
   result->tracked_cnt = result->corner_cnt;
-  struct flow_t *vectors = opticFlowLK(&opticflow->img_gray, &opticflow->prev_img_gray, corners, &result->tracked_cnt,
-                                       opticflow->window_size / 2, opticflow->subpixel_factor, opticflow->max_iterations,
-                                       opticflow->threshold_vec, opticflow->max_track_corners);
+  opticFlowLKPyramid(&opticflow->pyr, &opticflow->prev_pyr, corners, &result->tracked_cnt, vectors,
+                     opticflow->window_size / 2, opticflow->subpixel_factor, opticflow->max_iterations,
+                     opticflow->threshold_vec, opticflow->max_track_corners, &opticflow->scratch);
 
 #if OPTICFLOW_DEBUG && OPTICFLOW_SHOW_FLOW
   image_show_flow(img, vectors, result->tracked_cnt, opticflow->subpixel_factor);
@@ -220,7 +265,7 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
   // Estimate size divergence:
   if (SIZE_DIV) {
     n_samples = 100;
-    size_divergence = get_size_divergence(vectors, result->tracked_cnt, n_samples);
+    size_divergence = get_size_divergence(vectors, result->tracked_cnt, n_samples, &opticflow->rng);
     result->div_size = size_divergence;
   } else {
     result->div_size = 0.0f;
@@ -230,7 +275,7 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
     error_threshold = 10.0f;
     n_iterations_RANSAC = 20;
     n_samples_RANSAC = 5;
-    success_fit = analyze_linear_flow_field(vectors, result->tracked_cnt, error_threshold, n_iterations_RANSAC, n_samples_RANSAC, img->w, img->h, &fit_info);
+    success_fit = analyze_linear_flow_field(vectors, result->tracked_cnt, error_threshold, n_iterations_RANSAC, n_samples_RANSAC, img->w, img->h, &opticflow->rng, &fit_info);
 
     if (!success_fit) {
       fit_info.divergence = 0.0f;
@@ -246,26 +291,7 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
 
 
   // Get the median flow
-  qsort(vectors, result->tracked_cnt, sizeof(struct flow_t), cmp_flow);
-  if (result->tracked_cnt == 0) {
-    // We got no flow
-    result->flow_x = 0;
-    result->flow_y = 0;
-  } else if (result->tracked_cnt > 3) {
-    // Take the average of the 3 median points
-    result->flow_x = vectors[result->tracked_cnt / 2 - 1].flow_x;
-    result->flow_y = vectors[result->tracked_cnt / 2 - 1].flow_y;
-    result->flow_x += vectors[result->tracked_cnt / 2].flow_x;
-    result->flow_y += vectors[result->tracked_cnt / 2].flow_y;
-    result->flow_x += vectors[result->tracked_cnt / 2 + 1].flow_x;
-    result->flow_y += vectors[result->tracked_cnt / 2 + 1].flow_y;
-    result->flow_x /= 3;
-    result->flow_y /= 3;
-  } else {
-    // Take the median point
-    result->flow_x = vectors[result->tracked_cnt / 2].flow_x;
-    result->flow_y = vectors[result->tracked_cnt / 2].flow_y;
-  }
+  flow_median(vectors, result->tracked_cnt, &result->flow_x, &result->flow_y);
 
   // Flow Derotation
   float diff_flow_x = (state->phi - opticflow->prev_phi) * img->w / OPTICFLOW_FOV_W;
@@ -282,9 +308,8 @@ void opticflow_calc_frame(struct opticflow_t *opticflow, struct opticflow_state_
   // *************************************************************************************
   // Next Loop Preparation
   // *************************************************************************************
-  free(corners);
-  free(vectors);
   image_switch(&opticflow->img_gray, &opticflow->prev_img_gray);
+  image_pyramid_switch(&opticflow->pyr, &opticflow->prev_pyr);
 }
 
 /**
@@ -302,17 +327,51 @@ static uint32_t timeval_diff(struct timeval *starttime, struct timeval *finishti
 }
 
 /**
- * Compare two flow vectors based on flow distance
- * Used for sorting.
- * @param[in] *a The first flow vector (should be vect flow_t)
- * @param[in] *b The second flow vector (should be vect flow_t)
- * @return Negative if b has more flow than a, 0 if the same and positive if a has more flow than b
+ * Get the scratch memory needed by a frame calculation with the current settings
+ * @param[in] *opticflow The optical flow structure
+ * @return The size in bytes
  */
-static int cmp_flow(const void *a, const void *b)
+static uint32_t opticflow_scratch_size(struct opticflow_t *opticflow)
 {
-  const struct flow_t *a_p = (const struct flow_t *)a;
-  const struct flow_t *b_p = (const struct flow_t *)b;
-  return (a_p->flow_x * a_p->flow_x + a_p->flow_y * a_p->flow_y) - (b_p->flow_x * b_p->flow_x + b_p->flow_y * b_p->flow_y);
+  // The corner detection and tracking scratch memory is not used at the same time
+  uint32_t fast9_size = fast9_scratch_size(opticflow->img_gray.w, opticflow->img_gray.h, opticflow->fast9_min_distance);
+  uint32_t lk_size = opticFlowLKScratchSize(opticflow->window_size / 2);
+  return sizeof(struct point_t) * opticflow->fast9_max_corners
+         + sizeof(struct flow_t) * opticflow->max_track_corners
+         + 2 * IMAGE_ARENA_ALIGN
+         + Max(fast9_size, lk_size);
 }
 
+/**
+ * Get the median flow of the vectors, based on the flow distance
+ * With more than 3 vectors the average of the 3 median ones is taken.
+ * Uses a selection instead of sorting, the vectors are reordered.
+ * @param[in,out] *vectors The flow vectors
+ * @param[in] count The amount of flow vectors
+ * @param[out] *flow_x The median flow in x direction
+ * @param[out] *flow_y The median flow in y direction
+ */
+static void flow_median(struct flow_t *vectors, uint16_t count, int16_t *flow_x, int16_t *flow_y)
+{
+  if (count == 0) {
+    // We got no flow
+    *flow_x = 0;
+    *flow_y = 0;
+    return;
+  }
+
+  // The median point, all shorter vectors are before it and all longer ones after it
+  struct flow_t *median = image_flow_percentile(vectors, count, 50);
+  if (count <= 3) {
+    *flow_x = median->flow_x;
+    *flow_y = median->flow_y;
+    return;
+  }
 
+  // Take the average of the 3 median points (the longest one before and the shortest one after)
+  uint16_t m = median - vectors;
+  image_flow_select(vectors, m, m - 1);
+  image_flow_select(&vectors[m + 1], count - m - 1, 0);
+  *flow_x = (vectors[m - 1].flow_x + vectors[m].flow_x + vectors[m + 1].flow_x) / 3;
+  *flow_y = (vectors[m - 1].flow_y + vectors[m].flow_y + vectors[m + 1].flow_y) / 3;
+}
@@ -33,6 +33,7 @@
 #include "inter_thread_data.h"
 #include "lib/vision/image.h"
 #include "lib/v4l/v4l2.h"
+#include "math/pprz_random.h"
 
 struct opticflow_t {
   bool_t got_first_img;             ///< If we got a image to work with
@@ -40,17 +41,23 @@ struct opticflow_t {
   float prev_theta;                 ///< Theta from the previous image frame
   struct image_t img_gray;          ///< Current gray image frame
   struct image_t prev_img_gray;     ///< Previous gray image frame
+  struct image_pyramid_t pyr;       ///< Pyramid of the current gray image frame
+  struct image_pyramid_t prev_pyr;  ///< Pyramid of the previous gray image frame
+  struct image_arena_t scratch;     ///< Scratch memory for the corners, flow vectors and tracking windows of a frame
   struct timeval prev_timestamp;    ///< Timestamp of the previous frame, used for FPS calculation
+  struct pprz_rand_t rng;           ///< Random number generator of the divergence estimations
 
   uint8_t max_track_corners;        ///< Maximum amount of corners Lucas Kanade should track
   uint16_t window_size;             ///< Window size of the Lucas Kanade calculation (needs to be even)
   uint8_t subpixel_factor;          ///< The amount of subpixels per pixel
   uint8_t max_iterations;           ///< The maximum amount of iterations the Lucas Kanade algorithm should do
   uint8_t threshold_vec;            ///< The threshold in x, y subpixels which the algorithm should stop
+  uint8_t pyramid_level;            ///< Amount of pyramid levels above full resolution (0 for single level tracking)
 
   bool_t fast9_adaptive;            ///< Whether the FAST9 threshold should be adaptive
   uint8_t fast9_threshold;          ///< FAST9 corner detection threshold
-  uint16_t fast9_min_distance;      ///< Minimum distance in pixels between corners
+  uint16_t fast9_min_distance;      ///< Size in pixels of the grid cells used to space the corners
+  uint16_t fast9_max_corners;       ///< Corner budget, only the strongest corners are kept
 };
 
 
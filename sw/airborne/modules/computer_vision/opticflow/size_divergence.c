@@ -40,12 +40,13 @@
  * @param[in] flow_t* vectors The optical flow vectors
  * @param[in] count The number of optical flow vectors
  * @param[in] n_samples The number of line segments that will be taken into account. 0 means all line segments will be considered.
+ * @param[in] rng Random number generator used to pick the line segments
  */
-float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
+float get_size_divergence(struct flow_t *vectors, int count, int n_samples, struct pprz_rand_t *rng)
 {
   float distance_1;
   float distance_2;
-  float *divs;
+  float sum_divs = 0;
   unsigned int sample;
   float dx;
   float dy;
@@ -58,12 +59,10 @@ float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
   }
 
   if (n_samples == 0) {
-    // divs will contain the individual divergence estimates:
+    // the individual divergence estimates are summed directly, no need to store them:
     n_elements = (count * count - count) / 2;
-    divs = (float *) malloc(sizeof(float) * n_elements);
 
     // go through all possible lines:
-    sample = 0;
     for (i = 0; i < count; i++) {
       for (j = i + 1; j < count; j++) {
         // distance in previous image:
@@ -77,28 +76,21 @@ float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
         distance_2 = sqrt(dx * dx + dy * dy);
 
         // calculate divergence for this sample:
-        divs[sample] = (distance_2 - distance_1) / distance_1;
-        sample++;
+        sum_divs += (distance_2 - distance_1) / distance_1;
       }
     }
 
     // calculate the mean divergence:
-    mean_divergence = get_mean(divs, n_elements);
-
-    // free the memory of divs:
-    free(divs);
+    mean_divergence = sum_divs / n_elements;
   } else {
-    // vector that will contain individual divergence estimates:
-    divs = (float *) malloc(sizeof(float) * n_samples);
-
     // take random samples:
     for (sample = 0; sample < n_samples; sample++) {
       // take two random indices:
-      i = rand() % count;
-      j = rand() % count;
+      i = pprz_rand_range(rng, count);
+      j = pprz_rand_range(rng, count);
       // ensure it is not the same index:
       while (i == j) {
-        j = rand() % count;
+        j = pprz_rand_range(rng, count);
       }
 
       // distance in previous image:
@@ -112,14 +104,11 @@ float get_size_divergence(struct flow_t *vectors, int count, int n_samples)
       distance_2 = sqrt(dx * dx + dy * dy);
 
       // calculate divergence for this sample:
-      divs[sample] = (distance_2 - distance_1) / distance_1;
+      sum_divs += (distance_2 - distance_1) / distance_1;
     }
 
     // calculate the mean divergence:
-    mean_divergence = get_mean(divs, n_samples);
-
-    // free the memory of divs:
-    free(divs);
+    mean_divergence = sum_divs / n_samples;
   }
 
   // return the calculated divergence:
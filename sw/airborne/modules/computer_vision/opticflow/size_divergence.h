@@ -30,11 +30,12 @@
  */
 
 #include "lib/vision/image.h"
+#include "math/pprz_random.h"
 
 #ifndef SIZE_DIVERGENCE
 #define SIZE_DIVERGENCE
 
-float get_size_divergence(struct flow_t *vectors, int count, int n_samples);
+float get_size_divergence(struct flow_t *vectors, int count, int n_samples, struct pprz_rand_t *rng);
 float get_mean(float *numbers, int n_elements);
 
 #endif
@@ -137,7 +137,7 @@ void opticflow_module_init(void)
   }
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "OPTIC_FLOW_EST", opticflow_telem_send);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_OPTIC_FLOW_EST_ID, opticflow_telem_send);
 #endif
 }
 
@@ -81,6 +81,18 @@ PRINT_CONFIG_VAR(VIDEO_THREAD_SHOT_PATH)
 
 // Main thread
 static void *video_thread_function(void *data);
+
+// Reference counting of the V4L2 buffers for the vision consumers sharing the frame
+static void video_thread_image_ref(struct image_t *img)
+{
+  v4l2_image_ref(video_thread.dev, img);
+}
+
+static void video_thread_image_free(struct image_t *img)
+{
+  v4l2_image_free(video_thread.dev, img);
+}
+
 void video_thread_periodic(void) { }
 
 // Initialize the video_thread structure with the defaults
@@ -164,7 +176,7 @@ static void *video_thread_function(void *data __attribute__((unused)))
     // Run processing if required
     cv_run(&img);
 
-    // Free the image
+    // Free the image (the buffer is given back when the last consumer is done)
     v4l2_image_free(video_thread.dev, &img);
   }
 
@@ -176,6 +188,10 @@ static void *video_thread_function(void *data __attribute__((unused)))
  */
 void video_thread_init(void)
 {
+  // Initialize the computer vision framework
+  cv_init();
+  cv_set_frame_ref(video_thread_image_ref, video_thread_image_free);
+
 #ifdef VIDEO_THREAD_SUBDEV
   PRINT_CONFIG_MSG("[video_thread] Configuring a subdevice!")
   PRINT_CONFIG_VAR(VIDEO_THREAD_SUBDEV)
@@ -37,7 +37,10 @@ struct video_thread_t video_thread = {
 };
 
 // All dummy functions
-void video_thread_init(void) {}
+void video_thread_init(void)
+{
+  cv_init();
+}
 void video_thread_periodic(void)
 {
   struct image_t img;
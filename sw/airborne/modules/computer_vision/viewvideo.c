@@ -191,7 +191,8 @@ void viewvideo_init(void)
 //  struct UdpSocket video_sock;
   udp_socket_create(&video_sock, STRINGIFY(VIEWVIDEO_HOST), VIEWVIDEO_PORT_OUT, -1, VIEWVIDEO_BROADCAST);
 
-  cv_add(viewvideo_function);
+  // Encoding and sending is slow, do it in its own thread directly on the video buffer
+  cv_add_threaded(viewvideo_function, 0, CV_FRAME_SHARED);
 
   viewvideo.is_streaming = TRUE;
 
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/** @file modules/core/state_conversion_stats.c
+ *
+ * Report the conversions per second of the state interface.
+ */
+
+#include "core/state_conversion_stats.h"
+#include "state.h"
+
+#if !STATE_CONVERSION_STATS
+#error "state_conversion_stats needs the state interface built with STATE_CONVERSION_STATS"
+#endif
+
+#if PERIODIC_TELEMETRY
+#include "subsystems/datalink/telemetry.h"
+
+static void send_state_conversions(struct transport_tx *trans, struct link_device *dev)
+{
+  pprz_msg_send_STATE_CONVERSIONS(trans, dev, AC_ID,
+                                  POS_UTM_F + 1, state_conversion_rate.pos,
+                                  SPEED_HDIR_F + 1, state_conversion_rate.speed);
+}
+#endif
+
+void state_conversion_stats_init(void)
+{
+#if PERIODIC_TELEMETRY
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_STATE_CONVERSIONS_ID, send_state_conversions);
+#endif
+}
+
+void state_conversion_stats_periodic(void)
+{
+  stateConversionStatsPeriodic(1.f);
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/** @file modules/core/state_conversion_stats.h
+ *
+ * Report the conversions per second of the state interface.
+ */
+
+#ifndef STATE_CONVERSION_STATS_MODULE_H
+#define STATE_CONVERSION_STATS_MODULE_H
+
+extern void state_conversion_stats_init(void);
+
+/** Update the conversion rates, has to be called at 1Hz */
+extern void state_conversion_stats_periodic(void);
+
+#endif /* STATE_CONVERSION_STATS_MODULE_H */
@@ -129,7 +129,7 @@ void digital_cam_uart_init(void)
     }
   }
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "PAYLOAD", send_thumbnails);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_PAYLOAD_ID, send_thumbnails);
 #endif
 
 #ifdef SITL
@@ -92,7 +92,7 @@ static void send_survey(struct transport_tx *trans, struct link_device *dev)
 void nav_survey_rectangle_rotorcraft_init(void)
 {
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "SURVEY", send_survey);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_SURVEY_ID, send_survey);
 #endif
 }
 
@@ -160,7 +160,7 @@ void ms45xx_i2c_init(void)
                               MS45XX_I2C_PERIODIC_PERIOD, 0);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "AIRSPEED_MS45XX", ms45xx_downlink);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AIRSPEED_MS45XX_ID, ms45xx_downlink);
 #endif
 }
 
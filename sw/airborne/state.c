@@ -35,6 +35,14 @@
 
 struct State state;
 
+#if STATE_CONVERSION_STATS
+struct StateConversionStats state_conversion_count;
+struct StateConversionStats state_conversion_rate;
+#define STATE_CONVERSION_COUNT(_kind, _rep) { state_conversion_count._kind[_rep]++; }
+#else
+#define STATE_CONVERSION_COUNT(_kind, _rep) {}
+#endif
+
 /**
  * @addtogroup state_interface
  * @{
@@ -53,6 +61,19 @@ void stateInit(void)
   state.utm_initialized_f = FALSE;
 }
 
+#if STATE_CONVERSION_STATS
+void stateConversionStatsPeriodic(float dt)
+{
+  /* both structs only hold uint32_t counters */
+  uint32_t *count = (uint32_t *)&state_conversion_count;
+  uint32_t *rate = (uint32_t *)&state_conversion_rate;
+  for (uint32_t i = 0; i < sizeof(struct StateConversionStats) / sizeof(uint32_t); i++) {
+    rate[i] = (dt > 0.f) ? (uint32_t)(count[i] / dt + 0.5f) : 0;
+    count[i] = 0;
+  }
+}
+#endif
+
 
 /*******************************************************************************
  *                                                                             *
@@ -62,11 +83,58 @@ void stateInit(void)
 /** @addtogroup state_position
  *  @{ */
 
+/**
+ * Cache the direct conversions from ECEF to local NED positions.
+ * Rows of ltp_of_ecef (ENU) are reordered to NED and the cm to m (BFP)
+ * scaling is folded in, so that the ECEF to NED getters only need one
+ * matrix product with the difference to the origin.
+ */
+void stateCalcNedOfEcef(void)
+{
+  static const int ned_of_enu_row[3] = {1, 0, 2};
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      int64_t m = (int64_t)state.ned_origin_i.ltp_of_ecef.m[ned_of_enu_row[i] * 3 + j] << INT32_POS_FRAC;
+      if (i == 2) {
+        m = -m;
+      }
+      /* divide by 100 (cm to m) with rounding */
+      state.ned_of_ecef_pos_i.m[i * 3 + j] = (int32_t)((m >= 0 ? m + 50 : m - 50) / 100);
+      state.ned_of_ecef_pos_f.m[i * 3 + j] = (i == 2 ? -0.01f : 0.01f) *
+                                              state.ned_origin_f.ltp_of_ecef.m[ned_of_enu_row[i] * 3 + j];
+    }
+  }
+}
+
+/// ECEF position (cm) to local NED position (BFP) with the cached direct conversion
+static inline void ned_of_ecef_pos_direct_i(struct NedCoor_i *ned, struct EcefCoor_i *ecef)
+{
+  struct EcefCoor_i delta;
+  VECT3_DIFF(delta, *ecef, state.ned_origin_i.ecef);
+  const int32_t *m = state.ned_of_ecef_pos_i.m;
+  ned->x = (int32_t)(((int64_t)m[0] * delta.x + (int64_t)m[1] * delta.y + (int64_t)m[2] * delta.z) >> HIGH_RES_TRIG_FRAC);
+  ned->y = (int32_t)(((int64_t)m[3] * delta.x + (int64_t)m[4] * delta.y + (int64_t)m[5] * delta.z) >> HIGH_RES_TRIG_FRAC);
+  ned->z = (int32_t)(((int64_t)m[6] * delta.x + (int64_t)m[7] * delta.y + (int64_t)m[8] * delta.z) >> HIGH_RES_TRIG_FRAC);
+}
+
+/// ECEF position (cm) to local NED position (m) with the cached direct conversion
+static inline void ned_of_ecef_pos_direct_f(struct NedCoor_f *ned, struct EcefCoor_i *ecef)
+{
+  /* difference in int to keep the resolution, ECEF coordinates are too large for floats */
+  struct FloatVect3 delta;
+  VECT3_DIFF(delta, *ecef, state.ned_origin_i.ecef);
+  const float *m = state.ned_of_ecef_pos_f.m;
+  ned->x = m[0] * delta.x + m[1] * delta.y + m[2] * delta.z;
+  ned->y = m[3] * delta.x + m[4] * delta.y + m[5] * delta.z;
+  ned->z = m[6] * delta.x + m[7] * delta.y + m[8] * delta.z;
+}
+
 void stateCalcPositionEcef_i(void)
 {
   if (bit_is_set(state.pos_status, POS_ECEF_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
 
   if (bit_is_set(state.pos_status, POS_ECEF_F)) {
     ECEF_BFP_OF_REAL(state.ecef_pos_i, state.ecef_pos_f);
@@ -75,6 +143,7 @@ void stateCalcPositionEcef_i(void)
   } else if (bit_is_set(state.pos_status, POS_NED_F) && state.ned_initialized_f) {
     /* transform ned_f to ecef_f, set status bit, then convert to int */
     ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_origin_f, &state.ned_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
     SetBit(state.pos_status, POS_ECEF_F);
     ECEF_BFP_OF_REAL(state.ecef_pos_i, state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
@@ -82,6 +151,7 @@ void stateCalcPositionEcef_i(void)
   } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
     /* transform lla_f to ecef_f, set status bit, then convert to int */
     ecef_of_lla_f(&state.ecef_pos_f, &state.lla_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
     SetBit(state.pos_status, POS_ECEF_F);
     ECEF_BFP_OF_REAL(state.ecef_pos_i, state.ecef_pos_f);
   } else {
@@ -98,6 +168,7 @@ void stateCalcPositionNed_i(void)
   if (bit_is_set(state.pos_status, POS_NED_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_NED_I);
 
   int errno = 0;
   if (state.ned_initialized_i) {
@@ -107,24 +178,32 @@ void stateCalcPositionNed_i(void)
       INT32_VECT3_NED_OF_ENU(state.ned_pos_i, state.enu_pos_i);
     } else if (bit_is_set(state.pos_status, POS_ENU_F)) {
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_I);
       SetBit(state.pos_status, POS_ENU_I);
       INT32_VECT3_NED_OF_ENU(state.ned_pos_i, state.enu_pos_i);
     } else if (bit_is_set(state.pos_status, POS_ECEF_I)) {
-      ned_of_ecef_pos_i(&state.ned_pos_i, &state.ned_origin_i, &state.ecef_pos_i);
+      ned_of_ecef_pos_direct_i(&state.ned_pos_i, &state.ecef_pos_i);
     } else if (bit_is_set(state.pos_status, POS_ECEF_F)) {
       /* transform ecef_f -> ned_f, set status bit, then convert to int */
       ned_of_ecef_point_f(&state.ned_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> ecef_f -> ned_f, set status bits, then convert to int */
       ecef_of_lla_f(&state.ecef_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
       SetBit(state.pos_status, POS_ECEF_F);
       ned_of_ecef_point_f(&state.ned_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
-      ned_of_lla_point_i(&state.ned_pos_i, &state.ned_origin_i, &state.lla_pos_i);
+      /* transform lla_i -> ecef_i -> ned_i, set status bits */
+      ecef_of_lla_i(&state.ecef_pos_i, &state.lla_pos_i); /* converts to doubles internally */
+      STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
+      SetBit(state.pos_status, POS_ECEF_I);
+      ned_of_ecef_pos_direct_i(&state.ned_pos_i, &state.ecef_pos_i);
     } else { /* could not get this representation,  set errno */
       errno = 1;
     }
@@ -135,27 +214,34 @@ void stateCalcPositionNed_i(void)
       INT32_VECT3_NED_OF_ENU(state.ned_pos_i, state.enu_pos_i);
     } else if (bit_is_set(state.pos_status, POS_ENU_F)) {
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_I);
       SetBit(state.pos_status, POS_ENU_I);
       INT32_VECT3_NED_OF_ENU(state.ned_pos_i, state.enu_pos_i);
     } else if (bit_is_set(state.pos_status, POS_UTM_F)) {
       /* transform utm_f -> ned_f -> ned_i, set status bits */
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> ned_f -> ned_i, set status bits */
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> lla_f -> utm_f -> ned_f -> ned_i, set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_LLA_F);
       SetBit(state.pos_status, POS_LLA_F);
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
     } else { /* could not get this representation,  set errno */
@@ -177,6 +263,7 @@ void stateCalcPositionEnu_i(void)
   if (bit_is_set(state.pos_status, POS_ENU_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_ENU_I);
 
   int errno = 0;
   if (state.ned_initialized_i) {
@@ -186,24 +273,39 @@ void stateCalcPositionEnu_i(void)
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
     } else if (bit_is_set(state.pos_status, POS_NED_F)) {
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_NED_I);
       SetBit(state.pos_status, POS_NED_I);
       INT32_VECT3_ENU_OF_NED(state.enu_pos_i, state.ned_pos_i);
     } else if (bit_is_set(state.pos_status, POS_ECEF_I)) {
-      enu_of_ecef_pos_i(&state.enu_pos_i, &state.ned_origin_i, &state.ecef_pos_i);
+      /* transform ecef_i -> ned_i -> enu_i, set status bits */
+      ned_of_ecef_pos_direct_i(&state.ned_pos_i, &state.ecef_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_NED_I);
+      SetBit(state.pos_status, POS_NED_I);
+      INT32_VECT3_ENU_OF_NED(state.enu_pos_i, state.ned_pos_i);
     } else if (bit_is_set(state.pos_status, POS_ECEF_F)) {
       /* transform ecef_f -> enu_f, set status bit, then convert to int */
       enu_of_ecef_point_f(&state.enu_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_F);
       SetBit(state.pos_status, POS_ENU_F);
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> ecef_f -> enu_f, set status bits, then convert to int */
       ecef_of_lla_f(&state.ecef_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
       SetBit(state.pos_status, POS_ECEF_F);
       enu_of_ecef_point_f(&state.enu_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_F);
       SetBit(state.pos_status, POS_ENU_F);
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
-      enu_of_lla_point_i(&state.enu_pos_i, &state.ned_origin_i, &state.lla_pos_i);
+      /* transform lla_i -> ecef_i -> ned_i -> enu_i, set status bits */
+      ecef_of_lla_i(&state.ecef_pos_i, &state.lla_pos_i); /* converts to doubles internally */
+      STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
+      SetBit(state.pos_status, POS_ECEF_I);
+      ned_of_ecef_pos_direct_i(&state.ned_pos_i, &state.ecef_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_NED_I);
+      SetBit(state.pos_status, POS_NED_I);
+      INT32_VECT3_ENU_OF_NED(state.enu_pos_i, state.ned_pos_i);
     } else { /* could not get this representation,  set errno */
       errno = 1;
     }
@@ -214,27 +316,34 @@ void stateCalcPositionEnu_i(void)
       INT32_VECT3_ENU_OF_NED(state.enu_pos_i, state.ned_pos_i);
     } else if (bit_is_set(state.pos_status, POS_NED_F)) {
       NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_NED_I);
       SetBit(state.pos_status, POS_NED_I);
       INT32_VECT3_ENU_OF_NED(state.enu_pos_i, state.ned_pos_i);
     } else if (bit_is_set(state.pos_status, POS_UTM_F)) {
       /* transform utm_f -> enu_f -> enu_i , set status bits */
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_F);
       SetBit(state.pos_status, POS_ENU_F);
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> enu_f -> enu_i , set status bits */
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_F);
       SetBit(state.pos_status, POS_ENU_F);
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> lla_f -> utm_f -> enu_f -> enu_i , set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_LLA_F);
       SetBit(state.pos_status, POS_LLA_F);
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_F);
       SetBit(state.pos_status, POS_ENU_F);
       ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
     } else { /* could not get this representation,  set errno */
@@ -262,36 +371,44 @@ void stateCalcPositionLla_i(void)
   if (bit_is_set(state.pos_status, POS_LLA_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_LLA_I);
 
   if (bit_is_set(state.pos_status, POS_ECEF_I)) {
     lla_of_ecef_i(&state.lla_pos_i, &state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_ECEF_F)) {
     /* transform ecef_f -> ecef_i -> lla_i, set status bits */
     ECEF_BFP_OF_REAL(state.ecef_pos_i, state.ecef_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
     SetBit(state.pos_status, POS_ECEF_I);
     lla_of_ecef_i(&state.lla_pos_i, &state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_NED_I) && state.ned_initialized_i) {
     /* transform ned_i -> ecef_i -> lla_i, set status bits */
     ecef_of_ned_pos_i(&state.ecef_pos_i, &state.ned_origin_i, &state.ned_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
     SetBit(state.pos_status, POS_ECEF_I);
     lla_of_ecef_i(&state.lla_pos_i, &state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_ENU_I) && state.ned_initialized_i) {
     /* transform enu_i -> ecef_i -> lla_i, set status bits */
     ecef_of_enu_pos_i(&state.ecef_pos_i, &state.ned_origin_i, &state.enu_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
     SetBit(state.pos_status, POS_ECEF_I);
     lla_of_ecef_i(&state.lla_pos_i, &state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_NED_F) && state.ned_initialized_i) {
     /* transform ned_f -> ned_i -> ecef_i -> lla_i, set status bits */
     NED_BFP_OF_REAL(state.ned_pos_i, state.ned_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_NED_I);
     SetBit(state.pos_status, POS_NED_I);
     ecef_of_ned_pos_i(&state.ecef_pos_i, &state.ned_origin_i, &state.ned_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
     SetBit(state.pos_status, POS_ECEF_I);
     lla_of_ecef_i(&state.lla_pos_i, &state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_ENU_F) && state.ned_initialized_i) {
     /* transform enu_f -> enu_i -> ecef_i -> lla_i, set status bits */
     ENU_BFP_OF_REAL(state.enu_pos_i, state.enu_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_ENU_I);
     SetBit(state.pos_status, POS_ENU_I);
     ecef_of_enu_pos_i(&state.ecef_pos_i, &state.ned_origin_i, &state.enu_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
     SetBit(state.pos_status, POS_ECEF_I);
     lla_of_ecef_i(&state.lla_pos_i, &state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
@@ -299,6 +416,7 @@ void stateCalcPositionLla_i(void)
   } else if (bit_is_set(state.pos_status, POS_UTM_F)) {
     /* transform utm_f -> lla_f -> lla_i, set status bits */
     lla_of_utm_f(&state.lla_pos_f, &state.utm_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_LLA_F);
     SetBit(state.pos_status, POS_LLA_F);
     LLA_BFP_OF_REAL(state.lla_pos_i, state.lla_pos_f);
   } else {
@@ -315,12 +433,14 @@ void stateCalcPositionUtm_f(void)
   if (bit_is_set(state.pos_status, POS_UTM_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_UTM_F);
 
   if (bit_is_set(state.pos_status, POS_LLA_F)) {
     utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
   } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
     /* transform lla_i -> lla_f -> utm_f, set status bits */
     LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_LLA_F);
     SetBit(state.pos_status, POS_LLA_F);
     utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
   } else if (state.utm_initialized_f) {
@@ -328,12 +448,14 @@ void stateCalcPositionUtm_f(void)
       UTM_OF_ENU_ADD(state.utm_pos_f, state.enu_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_ENU_I)) {
       ENU_FLOAT_OF_BFP(state.enu_pos_f, state.enu_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_F);
       SetBit(state.pos_status, POS_ENU_F);
       UTM_OF_ENU_ADD(state.utm_pos_f, state.enu_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_NED_F)) {
       UTM_OF_NED_ADD(state.utm_pos_f, state.ned_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_NED_I)) {
       NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       UTM_OF_NED_ADD(state.utm_pos_f, state.ned_pos_f, state.utm_origin_f);
     }
@@ -351,6 +473,7 @@ void stateCalcPositionEcef_f(void)
   if (bit_is_set(state.pos_status, POS_ECEF_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
 
   if (bit_is_set(state.pos_status, POS_ECEF_I)) {
     ECEF_FLOAT_OF_BFP(state.ecef_pos_f, state.ecef_pos_i);
@@ -359,12 +482,14 @@ void stateCalcPositionEcef_f(void)
   } else if (bit_is_set(state.pos_status, POS_NED_I) && &state.ned_initialized_i) {
     /* transform ned_i -> ecef_i -> ecef_f, set status bits */
     ecef_of_ned_pos_i(&state.ecef_pos_i, &state.ned_origin_i, &state.ned_pos_i);
-    SetBit(state.pos_status, POS_ECEF_F);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
+    SetBit(state.pos_status, POS_ECEF_I);
     ECEF_FLOAT_OF_BFP(state.ecef_pos_f, state.ecef_pos_i);
   } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
     ecef_of_lla_f(&state.ecef_pos_f, &state.lla_pos_f);
   } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
     LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_LLA_F);
     SetBit(state.pos_status, POS_LLA_F);
     ecef_of_lla_f(&state.ecef_pos_f, &state.lla_pos_f);
   } else {
@@ -381,6 +506,7 @@ void stateCalcPositionNed_f(void)
   if (bit_is_set(state.pos_status, POS_NED_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_NED_F);
 
   int errno = 0;
   if (state.ned_initialized_f) {
@@ -389,19 +515,15 @@ void stateCalcPositionNed_f(void)
     } else if (bit_is_set(state.pos_status, POS_ECEF_F)) {
       ned_of_ecef_point_f(&state.ned_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
     } else if (bit_is_set(state.pos_status, POS_ECEF_I)) {
-      /* transform ecef_i -> ned_i -> ned_f, set status bits */
-      ned_of_ecef_pos_i(&state.ned_pos_i, &state.ned_origin_i, &state.ecef_pos_i);
-      SetBit(state.pos_status, POS_NED_I);
-      NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
+      ned_of_ecef_pos_direct_f(&state.ned_pos_f, &state.ecef_pos_i);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       ned_of_lla_point_f(&state.ned_pos_f, &state.ned_origin_f, &state.lla_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
-      /* transform lla_i -> ecef_i -> ned_i -> ned_f, set status bits */
+      /* transform lla_i -> ecef_i -> ned_f, set status bits */
       ecef_of_lla_i(&state.ecef_pos_i, &state.lla_pos_i); /* converts to doubles internally */
+      STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
       SetBit(state.pos_status, POS_ECEF_I);
-      ned_of_ecef_pos_i(&state.ned_pos_i, &state.ned_origin_i, &state.ecef_pos_i);
-      SetBit(state.pos_status, POS_NED_I);
-      NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
+      ned_of_ecef_pos_direct_f(&state.ned_pos_f, &state.ecef_pos_i);
     } else { /* could not get this representation,  set errno */
       errno = 1;
     }
@@ -410,6 +532,7 @@ void stateCalcPositionNed_f(void)
       NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
     } else if (bit_is_set(state.pos_status, POS_ENU_I)) {
       ENU_FLOAT_OF_BFP(state.enu_pos_f, state.enu_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_ENU_F);
       SetBit(state.pos_status, POS_ENU_F);
       VECT3_NED_OF_ENU(state.ned_pos_f, state.enu_pos_f);
     } else if (bit_is_set(state.pos_status, POS_ENU_F)) {
@@ -419,13 +542,16 @@ void stateCalcPositionNed_f(void)
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> ned, set status bits */
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> lla_f -> utm_f -> ned, set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_LLA_F);
       SetBit(state.pos_status, POS_LLA_F);
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       NED_OF_UTM_DIFF(state.ned_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else { /* could not get this representation,  set errno */
@@ -447,6 +573,7 @@ void stateCalcPositionEnu_f(void)
   if (bit_is_set(state.pos_status, POS_ENU_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_ENU_F);
 
   int errno = 0;
   if (state.ned_initialized_f) {
@@ -456,24 +583,28 @@ void stateCalcPositionEnu_f(void)
       ENU_FLOAT_OF_BFP(state.enu_pos_f, state.enu_pos_i);
     } else if (bit_is_set(state.pos_status, POS_NED_I)) {
       NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       VECT3_ENU_OF_NED(state.enu_pos_f, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_ECEF_F)) {
       enu_of_ecef_point_f(&state.enu_pos_f, &state.ned_origin_f, &state.ecef_pos_f);
     } else if (bit_is_set(state.pos_status, POS_ECEF_I)) {
-      /* transform ecef_i -> enu_i -> enu_f, set status bits */
-      enu_of_ecef_pos_i(&state.enu_pos_i, &state.ned_origin_i, &state.ecef_pos_i);
-      SetBit(state.pos_status, POS_ENU_I);
-      ENU_FLOAT_OF_BFP(state.enu_pos_f, state.enu_pos_i);
+      /* transform ecef_i -> ned_f -> enu_f, set status bits */
+      ned_of_ecef_pos_direct_f(&state.ned_pos_f, &state.ecef_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
+      SetBit(state.pos_status, POS_NED_F);
+      VECT3_ENU_OF_NED(state.enu_pos_f, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       enu_of_lla_point_f(&state.enu_pos_f, &state.ned_origin_f, &state.lla_pos_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
-      /* transform lla_i -> ecef_i -> enu_i -> enu_f, set status bits */
+      /* transform lla_i -> ecef_i -> ned_f -> enu_f, set status bits */
       ecef_of_lla_i(&state.ecef_pos_i, &state.lla_pos_i); /* converts to doubles internally */
+      STATE_CONVERSION_COUNT(pos, POS_ECEF_I);
       SetBit(state.pos_status, POS_ECEF_I);
-      enu_of_ecef_pos_i(&state.enu_pos_i, &state.ned_origin_i, &state.ecef_pos_i);
-      SetBit(state.pos_status, POS_ENU_I);
-      ENU_FLOAT_OF_BFP(state.enu_pos_f, state.enu_pos_i);
+      ned_of_ecef_pos_direct_f(&state.ned_pos_f, &state.ecef_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
+      SetBit(state.pos_status, POS_NED_F);
+      VECT3_ENU_OF_NED(state.enu_pos_f, state.ned_pos_f);
     } else { /* could not get this representation,  set errno */
       errno = 1;
     }
@@ -484,6 +615,7 @@ void stateCalcPositionEnu_f(void)
       VECT3_ENU_OF_NED(state.enu_pos_f, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_NED_I)) {
       NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_NED_F);
       SetBit(state.pos_status, POS_NED_F);
       VECT3_ENU_OF_NED(state.enu_pos_f, state.ned_pos_f);
     } else if (bit_is_set(state.pos_status, POS_UTM_F)) {
@@ -491,13 +623,16 @@ void stateCalcPositionEnu_f(void)
     } else if (bit_is_set(state.pos_status, POS_LLA_F)) {
       /* transform lla_f -> utm_f -> enu, set status bits */
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else if (bit_is_set(state.pos_status, POS_LLA_I)) {
       /* transform lla_i -> lla_f -> utm_f -> enu, set status bits */
       LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_i);
+      STATE_CONVERSION_COUNT(pos, POS_LLA_F);
       SetBit(state.pos_status, POS_LLA_F);
       utm_of_lla_f(&state.utm_pos_f, &state.lla_pos_f);
+      STATE_CONVERSION_COUNT(pos, POS_UTM_F);
       SetBit(state.pos_status, POS_UTM_F);
       ENU_OF_UTM_DIFF(state.enu_pos_f, state.utm_pos_f, state.utm_origin_f);
     } else { /* could not get this representation,  set errno */
@@ -519,6 +654,7 @@ void stateCalcPositionLla_f(void)
   if (bit_is_set(state.pos_status, POS_LLA_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(pos, POS_LLA_F);
 
   if (bit_is_set(state.pos_status, POS_LLA_I)) {
     LLA_FLOAT_OF_BFP(state.lla_pos_f, state.lla_pos_f);
@@ -527,18 +663,22 @@ void stateCalcPositionLla_f(void)
   } else if (bit_is_set(state.pos_status, POS_ECEF_I)) {
     /* transform ecef_i -> ecef_f -> lla_f, set status bits */
     ECEF_FLOAT_OF_BFP(state.ecef_pos_f, state.ecef_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
     SetBit(state.pos_status, POS_ECEF_F);
     lla_of_ecef_f(&state.lla_pos_f, &state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_NED_F) && state.ned_initialized_f) {
     /* transform ned_f -> ecef_f -> lla_f, set status bits */
     ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_origin_f, &state.ned_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
     SetBit(state.pos_status, POS_ECEF_F);
     lla_of_ecef_f(&state.lla_pos_f, &state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_NED_I) && state.ned_initialized_f) {
     /* transform ned_i -> ned_f -> ecef_f -> lla_f, set status bits */
     NED_FLOAT_OF_BFP(state.ned_pos_f, state.ned_pos_i);
+    STATE_CONVERSION_COUNT(pos, POS_NED_F);
     SetBit(state.pos_status, POS_NED_F);
     ecef_of_ned_point_f(&state.ecef_pos_f, &state.ned_origin_f, &state.ned_pos_f);
+    STATE_CONVERSION_COUNT(pos, POS_ECEF_F);
     SetBit(state.pos_status, POS_ECEF_F);
     lla_of_ecef_f(&state.lla_pos_f, &state.ecef_pos_f);
   } else if (bit_is_set(state.pos_status, POS_UTM_F)) {
@@ -571,6 +711,7 @@ void stateCalcSpeedNed_i(void)
   if (bit_is_set(state.speed_status, SPEED_NED_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_NED_I);
 
   int errno = 0;
   if (state.ned_initialized_i) {
@@ -580,6 +721,7 @@ void stateCalcSpeedNed_i(void)
       INT32_VECT3_NED_OF_ENU(state.ned_speed_i, state.enu_speed_i);
     } else if (bit_is_set(state.speed_status, SPEED_ENU_F)) {
       SPEEDS_BFP_OF_REAL(state.enu_speed_i, state.enu_speed_f);
+      STATE_CONVERSION_COUNT(speed, SPEED_ENU_I);
       SetBit(state.speed_status, SPEED_ENU_I);
       INT32_VECT3_NED_OF_ENU(state.ned_speed_i, state.enu_speed_i);
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
@@ -587,6 +729,7 @@ void stateCalcSpeedNed_i(void)
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_F)) {
       /* transform ecef_f -> ecef_i -> ned_i , set status bits */
       SPEEDS_BFP_OF_REAL(state.ecef_speed_i, state.ecef_speed_f);
+      STATE_CONVERSION_COUNT(speed, SPEED_ECEF_I);
       SetBit(state.speed_status, SPEED_ECEF_I);
       ned_of_ecef_vect_i(&state.ned_speed_i, &state.ned_origin_i, &state.ecef_speed_i);
     } else { /* could not get this representation,  set errno */
@@ -599,6 +742,7 @@ void stateCalcSpeedNed_i(void)
       INT32_VECT3_NED_OF_ENU(state.ned_speed_i, state.enu_speed_i);
     } else if (bit_is_set(state.speed_status, SPEED_ENU_F)) {
       SPEEDS_BFP_OF_REAL(state.enu_speed_i, state.enu_speed_f);
+      STATE_CONVERSION_COUNT(speed, SPEED_ENU_I);
       SetBit(state.speed_status, SPEED_ENU_I);
       INT32_VECT3_NED_OF_ENU(state.ned_speed_i, state.enu_speed_i);
     } else { /* could not get this representation,  set errno */
@@ -620,6 +764,7 @@ void stateCalcSpeedEnu_i(void)
   if (bit_is_set(state.speed_status, SPEED_ENU_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_ENU_I);
 
   int errno = 0;
   if (state.ned_initialized_i) {
@@ -630,13 +775,15 @@ void stateCalcSpeedEnu_i(void)
       ENU_BFP_OF_REAL(state.enu_speed_i, state.enu_speed_f);
     } else if (bit_is_set(state.speed_status, SPEED_NED_F)) {
       SPEEDS_BFP_OF_REAL(state.ned_speed_i, state.ned_speed_f);
-      SetBit(state.pos_status, SPEED_NED_I);
+      STATE_CONVERSION_COUNT(speed, SPEED_NED_I);
+      SetBit(state.speed_status, SPEED_NED_I);
       INT32_VECT3_ENU_OF_NED(state.enu_speed_i, state.ned_speed_i);
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
       enu_of_ecef_vect_i(&state.enu_speed_i, &state.ned_origin_i, &state.ecef_speed_i);
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_F)) {
       /* transform ecef_f -> ecef_i -> enu_i , set status bits */
       SPEEDS_BFP_OF_REAL(state.ecef_speed_i, state.ecef_speed_f);
+      STATE_CONVERSION_COUNT(speed, SPEED_ECEF_I);
       SetBit(state.speed_status, SPEED_ECEF_I);
       enu_of_ecef_vect_i(&state.enu_speed_i, &state.ned_origin_i, &state.ecef_speed_i);
     } else { /* could not get this representation,  set errno */
@@ -650,7 +797,8 @@ void stateCalcSpeedEnu_i(void)
       ENU_BFP_OF_REAL(state.enu_speed_i, state.enu_speed_f);
     } else if (bit_is_set(state.speed_status, SPEED_NED_F)) {
       SPEEDS_BFP_OF_REAL(state.ned_speed_i, state.ned_speed_f);
-      SetBit(state.pos_status, SPEED_NED_I);
+      STATE_CONVERSION_COUNT(speed, SPEED_NED_I);
+      SetBit(state.speed_status, SPEED_NED_I);
       INT32_VECT3_ENU_OF_NED(state.enu_speed_i, state.ned_speed_i);
     } else { /* could not get this representation,  set errno */
       errno = 2;
@@ -671,6 +819,7 @@ void stateCalcSpeedEcef_i(void)
   if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_ECEF_I);
 
   if (bit_is_set(state.speed_status, SPEED_ECEF_F)) {
     SPEEDS_BFP_OF_REAL(state.ecef_speed_i, state.ecef_speed_f);
@@ -679,6 +828,7 @@ void stateCalcSpeedEcef_i(void)
   } else if (bit_is_set(state.speed_status, SPEED_NED_F)) {
     /* transform ned_f -> ned_i -> ecef_i , set status bits */
     SPEEDS_BFP_OF_REAL(state.ned_speed_i, state.ned_speed_f);
+    STATE_CONVERSION_COUNT(speed, SPEED_NED_I);
     SetBit(state.speed_status, SPEED_NED_I);
     ecef_of_ned_vect_i(&state.ecef_speed_i, &state.ned_origin_i, &state.ned_speed_i);
   } else {
@@ -695,6 +845,7 @@ void stateCalcHorizontalSpeedNorm_i(void)
   if (bit_is_set(state.speed_status, SPEED_HNORM_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_HNORM_I);
 
   if (bit_is_set(state.speed_status, SPEED_HNORM_F)) {
     state.h_speed_norm_i = SPEED_BFP_OF_REAL(state.h_speed_norm_f);
@@ -704,6 +855,7 @@ void stateCalcHorizontalSpeedNorm_i(void)
     INT32_SQRT(state.h_speed_norm_i, n2);
   } else if (bit_is_set(state.speed_status, SPEED_NED_F)) {
     state.h_speed_norm_f = FLOAT_VECT2_NORM(state.ned_speed_f);
+    STATE_CONVERSION_COUNT(speed, SPEED_HNORM_F);
     SetBit(state.speed_status, SPEED_HNORM_F);
     state.h_speed_norm_i = SPEED_BFP_OF_REAL(state.h_speed_norm_f);
   } else if (bit_is_set(state.speed_status, SPEED_ENU_I)) {
@@ -712,19 +864,23 @@ void stateCalcHorizontalSpeedNorm_i(void)
     INT32_SQRT(state.h_speed_norm_i, n2);
   } else if (bit_is_set(state.speed_status, SPEED_ENU_F)) {
     state.h_speed_norm_f = FLOAT_VECT2_NORM(state.enu_speed_f);
+    STATE_CONVERSION_COUNT(speed, SPEED_HNORM_F);
     SetBit(state.speed_status, SPEED_HNORM_F);
     state.h_speed_norm_i = SPEED_BFP_OF_REAL(state.h_speed_norm_f);
   } else if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
     /* transform ecef speed to ned, set status bit, then compute norm */
     ned_of_ecef_vect_i(&state.ned_speed_i, &state.ned_origin_i, &state.ecef_speed_i);
+    STATE_CONVERSION_COUNT(speed, SPEED_NED_I);
     SetBit(state.speed_status, SPEED_NED_I);
     uint32_t n2 = (state.ned_speed_i.x * state.ned_speed_i.x +
                    state.ned_speed_i.y * state.ned_speed_i.y) >> INT32_SPEED_FRAC;
     INT32_SQRT(state.h_speed_norm_i, n2);
   } else if (bit_is_set(state.speed_status, SPEED_ECEF_F)) {
     ned_of_ecef_vect_f(&state.ned_speed_f, &state.ned_origin_f, &state.ecef_speed_f);
+    STATE_CONVERSION_COUNT(speed, SPEED_NED_F);
     SetBit(state.speed_status, SPEED_NED_F);
     state.h_speed_norm_f = FLOAT_VECT2_NORM(state.ned_speed_f);
+    STATE_CONVERSION_COUNT(speed, SPEED_HNORM_F);
     SetBit(state.speed_status, SPEED_HNORM_F);
     state.h_speed_norm_i = SPEED_BFP_OF_REAL(state.h_speed_norm_f);
   } else {
@@ -740,6 +896,7 @@ void stateCalcHorizontalSpeedDir_i(void)
   if (bit_is_set(state.speed_status, SPEED_HDIR_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_HDIR_I);
 
   if (bit_is_set(state.speed_status, SPEED_HDIR_F)) {
     state.h_speed_dir_i = SPEED_BFP_OF_REAL(state.h_speed_dir_f);
@@ -751,11 +908,13 @@ void stateCalcHorizontalSpeedDir_i(void)
     INT32_COURSE_NORMALIZE(state.h_speed_dir_i);
   } else if (bit_is_set(state.speed_status, SPEED_NED_F)) {
     SPEEDS_BFP_OF_REAL(state.ned_speed_i, state.ned_speed_f);
+    STATE_CONVERSION_COUNT(speed, SPEED_NED_I);
     SetBit(state.speed_status, SPEED_NED_I);
     state.h_speed_dir_i = int32_atan2(state.ned_speed_i.y, state.ned_speed_i.x);
     INT32_COURSE_NORMALIZE(state.h_speed_dir_i);
   } else if (bit_is_set(state.speed_status, SPEED_ENU_F)) {
     SPEEDS_BFP_OF_REAL(state.enu_speed_i, state.enu_speed_f);
+    STATE_CONVERSION_COUNT(speed, SPEED_ENU_I);
     SetBit(state.speed_status, SPEED_ENU_I);
     state.h_speed_dir_i = int32_atan2(state.enu_speed_i.x, state.enu_speed_i.y);
     INT32_COURSE_NORMALIZE(state.h_speed_dir_i);
@@ -769,6 +928,7 @@ void stateCalcSpeedNed_f(void)
   if (bit_is_set(state.speed_status, SPEED_NED_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_NED_F);
 
   int errno = 0;
   if (state.ned_initialized_f) {
@@ -778,6 +938,7 @@ void stateCalcSpeedNed_f(void)
       VECT3_NED_OF_ENU(state.ned_speed_f, state.enu_speed_f);
     } else if (bit_is_set(state.speed_status, SPEED_ENU_I)) {
       SPEEDS_FLOAT_OF_BFP(state.enu_speed_f, state.enu_speed_i);
+      STATE_CONVERSION_COUNT(speed, SPEED_ENU_F);
       SetBit(state.speed_status, SPEED_ENU_F);
       VECT3_NED_OF_ENU(state.ned_speed_f, state.enu_speed_f);
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_F)) {
@@ -785,6 +946,7 @@ void stateCalcSpeedNed_f(void)
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
       /* transform ecef_i -> ecef_f -> ned_f , set status bits */
       SPEEDS_FLOAT_OF_BFP(state.ecef_speed_f, state.ecef_speed_i);
+      STATE_CONVERSION_COUNT(speed, SPEED_ECEF_F);
       SetBit(state.speed_status, SPEED_ECEF_F);
       ned_of_ecef_vect_f(&state.ned_speed_f, &state.ned_origin_f, &state.ecef_speed_f);
     } else { /* could not get this representation,  set errno */
@@ -797,6 +959,7 @@ void stateCalcSpeedNed_f(void)
       VECT3_NED_OF_ENU(state.ned_speed_f, state.enu_speed_f);
     } else if (bit_is_set(state.speed_status, SPEED_ENU_I)) {
       SPEEDS_FLOAT_OF_BFP(state.enu_speed_f, state.enu_speed_i);
+      STATE_CONVERSION_COUNT(speed, SPEED_ENU_F);
       SetBit(state.speed_status, SPEED_ENU_F);
       VECT3_NED_OF_ENU(state.ned_speed_f, state.enu_speed_f);
     } else { /* could not get this representation,  set errno */
@@ -818,6 +981,7 @@ void stateCalcSpeedEnu_f(void)
   if (bit_is_set(state.speed_status, SPEED_ENU_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_ENU_F);
 
   int errno = 0;
   if (state.ned_initialized_f) {
@@ -827,13 +991,15 @@ void stateCalcSpeedEnu_f(void)
       ENU_FLOAT_OF_BFP(state.enu_speed_f, state.enu_speed_i);
     } else if (bit_is_set(state.speed_status, SPEED_NED_I)) {
       SPEEDS_FLOAT_OF_BFP(state.ned_speed_f, state.ned_speed_i);
-      SetBit(state.pos_status, SPEED_NED_F);
+      STATE_CONVERSION_COUNT(speed, SPEED_NED_F);
+      SetBit(state.speed_status, SPEED_NED_F);
       VECT3_ENU_OF_NED(state.enu_speed_f, state.ned_speed_f);
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_F)) {
       enu_of_ecef_vect_f(&state.enu_speed_f, &state.ned_origin_f, &state.ecef_speed_f);
     } else if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
       /* transform ecef_I -> ecef_f -> enu_f , set status bits */
       SPEEDS_FLOAT_OF_BFP(state.ecef_speed_f, state.ecef_speed_i);
+      STATE_CONVERSION_COUNT(speed, SPEED_ECEF_F);
       SetBit(state.speed_status, SPEED_ECEF_F);
       enu_of_ecef_vect_f(&state.enu_speed_f, &state.ned_origin_f, &state.ecef_speed_f);
     } else { /* could not get this representation,  set errno */
@@ -846,7 +1012,8 @@ void stateCalcSpeedEnu_f(void)
       ENU_FLOAT_OF_BFP(state.enu_speed_f, state.enu_speed_i);
     } else if (bit_is_set(state.speed_status, SPEED_NED_I)) {
       SPEEDS_FLOAT_OF_BFP(state.ned_speed_f, state.ned_speed_i);
-      SetBit(state.pos_status, SPEED_NED_F);
+      STATE_CONVERSION_COUNT(speed, SPEED_NED_F);
+      SetBit(state.speed_status, SPEED_NED_F);
       VECT3_ENU_OF_NED(state.enu_speed_f, state.ned_speed_f);
     } else { /* could not get this representation,  set errno */
       errno = 2;
@@ -867,6 +1034,7 @@ void stateCalcSpeedEcef_f(void)
   if (bit_is_set(state.speed_status, SPEED_ECEF_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_ECEF_F);
 
   if (bit_is_set(state.speed_status, SPEED_ECEF_I)) {
     SPEEDS_FLOAT_OF_BFP(state.ecef_speed_f, state.ned_speed_i);
@@ -875,6 +1043,7 @@ void stateCalcSpeedEcef_f(void)
   } else if (bit_is_set(state.speed_status, SPEED_NED_I)) {
     /* transform ned_f -> ned_i -> ecef_i , set status bits */
     SPEEDS_FLOAT_OF_BFP(state.ned_speed_f, state.ned_speed_i);
+    STATE_CONVERSION_COUNT(speed, SPEED_NED_F);
     SetBit(state.speed_status, SPEED_NED_F);
     ecef_of_ned_vect_f(&state.ecef_speed_f, &state.ned_origin_f, &state.ned_speed_f);
   } else {
@@ -891,6 +1060,7 @@ void stateCalcHorizontalSpeedNorm_f(void)
   if (bit_is_set(state.speed_status, SPEED_HNORM_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_HNORM_F);
 
   if (bit_is_set(state.speed_status, SPEED_HNORM_I)) {
     state.h_speed_norm_f = SPEED_FLOAT_OF_BFP(state.h_speed_norm_i);
@@ -900,10 +1070,12 @@ void stateCalcHorizontalSpeedNorm_f(void)
     state.h_speed_norm_f = FLOAT_VECT2_NORM(state.enu_speed_f);
   } else if (bit_is_set(state.speed_status, SPEED_NED_I)) {
     SPEEDS_FLOAT_OF_BFP(state.ned_speed_f, state.ned_speed_i);
+    STATE_CONVERSION_COUNT(speed, SPEED_NED_F);
     SetBit(state.speed_status, SPEED_NED_F);
     state.h_speed_norm_f = FLOAT_VECT2_NORM(state.ned_speed_f);
   } else if (bit_is_set(state.speed_status, SPEED_ENU_I)) {
     SPEEDS_FLOAT_OF_BFP(state.enu_speed_f, state.enu_speed_i);
+    STATE_CONVERSION_COUNT(speed, SPEED_ENU_F);
     SetBit(state.speed_status, SPEED_ENU_F);
     state.h_speed_norm_f = FLOAT_VECT2_NORM(state.enu_speed_f);
   }
@@ -916,6 +1088,7 @@ void stateCalcHorizontalSpeedDir_f(void)
   if (bit_is_set(state.speed_status, SPEED_HDIR_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(speed, SPEED_HDIR_F);
 
   if (bit_is_set(state.speed_status, SPEED_HDIR_I)) {
     state.h_speed_dir_f = SPEED_FLOAT_OF_BFP(state.h_speed_dir_i);
@@ -925,10 +1098,12 @@ void stateCalcHorizontalSpeedDir_f(void)
     state.h_speed_dir_f = atan2f(state.enu_speed_f.x, state.enu_speed_f.y);
   } else if (bit_is_set(state.speed_status, SPEED_NED_I)) {
     SPEEDS_FLOAT_OF_BFP(state.ned_speed_f, state.ned_speed_i);
+    STATE_CONVERSION_COUNT(speed, SPEED_NED_F);
     SetBit(state.speed_status, SPEED_NED_F);
     state.h_speed_dir_f = atan2f(state.ned_speed_f.y, state.ned_speed_f.x);
   } else if (bit_is_set(state.speed_status, SPEED_ENU_I)) {
     SPEEDS_FLOAT_OF_BFP(state.enu_speed_f, state.enu_speed_i);
+    STATE_CONVERSION_COUNT(speed, SPEED_ENU_F);
     SetBit(state.speed_status, SPEED_ENU_F);
     state.h_speed_dir_f = atan2f(state.enu_speed_f.x, state.enu_speed_f.y);
   }
@@ -952,6 +1127,7 @@ void stateCalcAccelNed_i(void)
   if (bit_is_set(state.accel_status, ACCEL_NED_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(accel, ACCEL_NED_I);
 
   int errno = 0;
   if (state.ned_initialized_i) {
@@ -962,6 +1138,7 @@ void stateCalcAccelNed_i(void)
     } else if (bit_is_set(state.accel_status, ACCEL_ECEF_F)) {
       /* transform ecef_f -> ecef_i -> ned_i , set status bits */
       ACCELS_BFP_OF_REAL(state.ecef_accel_i, state.ecef_accel_f);
+      STATE_CONVERSION_COUNT(accel, ACCEL_ECEF_I);
       SetBit(state.accel_status, ACCEL_ECEF_I);
       ned_of_ecef_vect_i(&state.ned_accel_i, &state.ned_origin_i, &state.ecef_accel_i);
     } else { /* could not get this representation,  set errno */
@@ -983,6 +1160,7 @@ void stateCalcAccelEcef_i(void)
   if (bit_is_set(state.accel_status, ACCEL_ECEF_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(accel, ACCEL_ECEF_I);
 
   if (bit_is_set(state.accel_status, ACCEL_ECEF_F)) {
     ACCELS_BFP_OF_REAL(state.ecef_accel_i, state.ecef_accel_f);
@@ -991,6 +1169,7 @@ void stateCalcAccelEcef_i(void)
   } else if (bit_is_set(state.accel_status, ACCEL_NED_F)) {
     /* transform ned_f -> ned_i -> ecef_i , set status bits */
     ACCELS_BFP_OF_REAL(state.ned_accel_i, state.ned_accel_f);
+    STATE_CONVERSION_COUNT(accel, ACCEL_NED_I);
     SetBit(state.accel_status, ACCEL_NED_I);
     ecef_of_ned_vect_i(&state.ecef_accel_i, &state.ned_origin_i, &state.ned_accel_i);
   } else {
@@ -1007,6 +1186,7 @@ void stateCalcAccelNed_f(void)
   if (bit_is_set(state.accel_status, ACCEL_NED_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(accel, ACCEL_NED_F);
 
   int errno = 0;
   if (state.ned_initialized_f) {
@@ -1017,6 +1197,7 @@ void stateCalcAccelNed_f(void)
     } else if (bit_is_set(state.accel_status, ACCEL_ECEF_I)) {
       /* transform ecef_i -> ecef_f -> ned_f , set status bits */
       ACCELS_FLOAT_OF_BFP(state.ecef_accel_f, state.ecef_accel_i);
+      STATE_CONVERSION_COUNT(accel, ACCEL_ECEF_F);
       SetBit(state.accel_status, ACCEL_ECEF_F);
       ned_of_ecef_vect_f(&state.ned_accel_f, &state.ned_origin_f, &state.ecef_accel_f);
     } else { /* could not get this representation,  set errno */
@@ -1038,6 +1219,7 @@ void stateCalcAccelEcef_f(void)
   if (bit_is_set(state.accel_status, ACCEL_ECEF_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(accel, ACCEL_ECEF_F);
 
   if (bit_is_set(state.accel_status, ACCEL_ECEF_I)) {
     ACCELS_FLOAT_OF_BFP(state.ecef_accel_f, state.ned_accel_i);
@@ -1046,6 +1228,7 @@ void stateCalcAccelEcef_f(void)
   } else if (bit_is_set(state.accel_status, ACCEL_NED_I)) {
     /* transform ned_f -> ned_i -> ecef_i , set status bits */
     ACCELS_FLOAT_OF_BFP(state.ned_accel_f, state.ned_accel_i);
+    STATE_CONVERSION_COUNT(accel, ACCEL_NED_F);
     SetBit(state.accel_status, ACCEL_NED_F);
     ecef_of_ned_vect_f(&state.ecef_accel_f, &state.ned_origin_f, &state.ned_accel_f);
   } else {
@@ -1071,6 +1254,7 @@ void stateCalcBodyRates_i(void)
   if (bit_is_set(state.rate_status, RATE_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(rate, RATE_I);
 
   if (bit_is_set(state.rate_status, RATE_F)) {
     RATES_BFP_OF_REAL(state.body_rates_i, state.body_rates_f);
@@ -1084,6 +1268,7 @@ void stateCalcBodyRates_f(void)
   if (bit_is_set(state.rate_status, RATE_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(rate, RATE_F);
 
   if (bit_is_set(state.rate_status, RATE_I)) {
     RATES_FLOAT_OF_BFP(state.body_rates_f, state.body_rates_i);
@@ -1108,6 +1293,7 @@ void stateCalcHorizontalWindspeed_i(void)
   if (bit_is_set(state.wind_air_status, WINDSPEED_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(wind_air, WINDSPEED_I);
 
   if (bit_is_set(state.wind_air_status, WINDSPEED_F)) {
     state.h_windspeed_i.x = SPEED_BFP_OF_REAL(state.h_windspeed_f.x);
@@ -1122,6 +1308,7 @@ void stateCalcAirspeed_i(void)
   if (bit_is_set(state.wind_air_status, AIRSPEED_I)) {
     return;
   }
+  STATE_CONVERSION_COUNT(wind_air, AIRSPEED_I);
 
   if (bit_is_set(state.wind_air_status, AIRSPEED_F)) {
     state.airspeed_i = SPEED_BFP_OF_REAL(state.airspeed_f);
@@ -1135,6 +1322,7 @@ void stateCalcHorizontalWindspeed_f(void)
   if (bit_is_set(state.wind_air_status, WINDSPEED_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(wind_air, WINDSPEED_F);
 
   if (bit_is_set(state.wind_air_status, WINDSPEED_I)) {
     state.h_windspeed_f.x = SPEED_FLOAT_OF_BFP(state.h_windspeed_i.x);
@@ -1149,6 +1337,7 @@ void stateCalcAirspeed_f(void)
   if (bit_is_set(state.wind_air_status, AIRSPEED_F)) {
     return;
   }
+  STATE_CONVERSION_COUNT(wind_air, AIRSPEED_F);
 
   if (bit_is_set(state.wind_air_status, AIRSPEED_I)) {
     state.airspeed_f = SPEED_FLOAT_OF_BFP(state.airspeed_i);
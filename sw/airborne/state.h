@@ -218,6 +218,19 @@ struct State {
   /// True if local float coordinate frame is initialsed
   bool_t ned_initialized_f;
 
+  /**
+   * Direct conversion from ECEF position to local NED position.
+   * Rotation from ECEF to NED scaled from cm to m in BFP with #INT32_POS_FRAC,
+   * in BFP with #HIGH_RES_TRIG_FRAC, cached when the local origin is set.
+   */
+  struct Int32Mat33 ned_of_ecef_pos_i;
+
+  /**
+   * Direct conversion from ECEF position to local NED position.
+   * Rotation from ECEF to NED scaled from cm to m, cached when the local origin is set.
+   */
+  struct FloatMat33 ned_of_ecef_pos_f;
+
   /**
    * Definition of the origin of Utm coordinate system.
    * Defines the origin of the local NorthEastDown coordinate system
@@ -433,9 +446,53 @@ extern struct State state;
 
 extern void stateInit(void);
 
+/**
+ * @defgroup state_conversion_stats Conversion statistics
+ *
+ * When STATE_CONVERSION_STATS is TRUE, each representation computed on the fly
+ * by the stateCalc functions is counted, including the intermediate ones set on
+ * the way (e.g. ECEF_I when NED_I is computed from LLA_I), so that the expensive
+ * conversions triggered by the getters can be tracked down.
+ * stateConversionStatsPeriodic() has to be called periodically to get the number
+ * of conversions per second, the state_conversion_stats module does it and
+ * sends them in the STATE_CONVERSIONS message.
+ * @{
+ */
+#ifndef STATE_CONVERSION_STATS
+#define STATE_CONVERSION_STATS FALSE
+#endif
+
+#if STATE_CONVERSION_STATS
+/**
+ * Number of conversions for each representation,
+ * indexed by the representation bits (e.g. pos[POS_LLA_I]).
+ */
+struct StateConversionStats {
+  uint32_t pos[POS_UTM_F + 1];
+  uint32_t speed[SPEED_HDIR_F + 1];
+  uint32_t accel[ACCEL_NED_F + 1];
+  uint32_t rate[RATE_F + 1];
+  uint32_t wind_air[SIDESLIP_F + 1];
+};
+
+/// Conversions since the last call to stateConversionStatsPeriodic()
+extern struct StateConversionStats state_conversion_count;
+/// Conversions per second over the last period
+extern struct StateConversionStats state_conversion_rate;
+
+/**
+ * Update the conversions per second and restart counting.
+ * @param[in] dt time since the last call in seconds
+ */
+extern void stateConversionStatsPeriodic(float dt);
+#endif
+/** @}*/
+
 /** @addtogroup state_position
  *  @{ */
 
+extern void stateCalcNedOfEcef(void);
+
 /// Set the local (flat earth) coordinate frame origin (int).
 static inline void stateSetLocalOrigin_i(struct LtpDef_i *ltp_def)
 {
@@ -445,6 +502,7 @@ static inline void stateSetLocalOrigin_i(struct LtpDef_i *ltp_def)
   LLA_FLOAT_OF_BFP(state.ned_origin_f.lla, state.ned_origin_i.lla);
   HIGH_RES_RMAT_FLOAT_OF_BFP(state.ned_origin_f.ltp_of_ecef, state.ned_origin_i.ltp_of_ecef);
   state.ned_origin_f.hmsl = M_OF_MM(state.ned_origin_i.hmsl);
+  stateCalcNedOfEcef();
 
   /* clear bits for all local frame representations */
   state.pos_status &= ~(POS_LOCAL_COORD);
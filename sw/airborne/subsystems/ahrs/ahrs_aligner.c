@@ -91,7 +91,7 @@ void ahrs_aligner_init(void)
   AbiBindMsgIMU_GYRO_INT32(AHRS_ALIGNER_IMU_ID, &gyro_ev, gyro_cb);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "FILTER_ALIGNER", send_aligner);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_FILTER_ALIGNER_ID, send_aligner);
 #endif
 }
 
@@ -254,8 +254,8 @@ void ahrs_fc_register(void)
   AbiBindMsgGPS(ABI_BROADCAST, &gps_ev, gps_cb);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "AHRS_EULER_INT", send_att);
-  register_periodic_telemetry(DefaultPeriodic, "GEO_MAG", send_geo_mag);
-  register_periodic_telemetry(DefaultPeriodic, "STATE_FILTER_STATUS", send_filter_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AHRS_EULER_INT_ID, send_att);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_GEO_MAG_ID, send_geo_mag);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_STATE_FILTER_STATUS_ID, send_filter_status);
 #endif
 }
@@ -207,8 +207,8 @@ void ahrs_mlkf_register(void)
   AbiBindMsgGEO_MAG(ABI_BROADCAST, &geo_mag_ev, geo_mag_cb);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "GEO_MAG", send_geo_mag);
-  register_periodic_telemetry(DefaultPeriodic, "STATE_FILTER_STATUS", send_filter_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_GEO_MAG_ID, send_geo_mag);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_STATE_FILTER_STATUS_ID, send_filter_status);
 #endif
 }
 
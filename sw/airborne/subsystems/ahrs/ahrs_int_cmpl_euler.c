@@ -43,6 +43,14 @@
 #define AHRS_MAG_OFFSET 0.
 #endif
 
+/** atan2 function for the attitude measurement from the accelerometer.
+ * Use int32_atan2_table for an error below 1 LSB instead of ~0.08 rad,
+ * see pprz_trig_int.h.
+ */
+#ifndef AHRS_ICE_ATAN2
+#define AHRS_ICE_ATAN2 int32_atan2
+#endif
+
 struct AhrsIntCmplEuler ahrs_ice;
 
 static inline void get_phi_theta_measurement_fom_accel(int32_t *phi_meas, int32_t *theta_meas,
@@ -234,11 +242,11 @@ __attribute__((always_inline)) static inline void get_phi_theta_measurement_fom_
     int32_t *theta_meas, struct Int32Vect3 *accel)
 {
 
-  *phi_meas = int32_atan2(-accel->y, -accel->z);
+  *phi_meas = AHRS_ICE_ATAN2(-accel->y, -accel->z);
   int32_t cphi;
   PPRZ_ITRIG_COS(cphi, *phi_meas);
   int32_t cphi_ax = -INT_MULT_RSHIFT(cphi, accel->x, INT32_TRIG_FRAC);
-  *theta_meas = int32_atan2(-cphi_ax, -accel->z);
+  *theta_meas = AHRS_ICE_ATAN2(-cphi_ax, -accel->z);
   *phi_meas   *= F_UPDATE;
   *theta_meas *= F_UPDATE;
 
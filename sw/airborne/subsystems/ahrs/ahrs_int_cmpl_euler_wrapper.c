@@ -210,9 +210,9 @@ void ahrs_ice_register(void)
   AbiBindMsgBODY_TO_IMU_QUAT(ABI_BROADCAST, &body_to_imu_ev, body_to_imu_cb);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "FILTER", send_filter);
-  register_periodic_telemetry(DefaultPeriodic, "AHRS_EULER_INT", send_euler);
-  register_periodic_telemetry(DefaultPeriodic, "AHRS_GYRO_BIAS_INT", send_bias);
-  register_periodic_telemetry(DefaultPeriodic, "STATE_FILTER_STATUS", send_filter_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_FILTER_ID, send_filter);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AHRS_EULER_INT_ID, send_euler);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AHRS_GYRO_BIAS_INT_ID, send_bias);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_STATE_FILTER_STATUS_ID, send_filter_status);
 #endif
 }
@@ -280,10 +280,10 @@ void ahrs_icq_register(void)
   AbiBindMsgGPS(ABI_BROADCAST, &gps_ev, gps_cb);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "AHRS_QUAT_INT", send_quat);
-  register_periodic_telemetry(DefaultPeriodic, "AHRS_EULER_INT", send_euler);
-  register_periodic_telemetry(DefaultPeriodic, "AHRS_GYRO_BIAS_INT", send_bias);
-  register_periodic_telemetry(DefaultPeriodic, "GEO_MAG", send_geo_mag);
-  register_periodic_telemetry(DefaultPeriodic, "STATE_FILTER_STATUS", send_filter_status);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AHRS_QUAT_INT_ID, send_quat);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AHRS_EULER_INT_ID, send_euler);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_AHRS_GYRO_BIAS_INT_ID, send_bias);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_GEO_MAG_ID, send_geo_mag);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_STATE_FILTER_STATUS_ID, send_filter_status);
 #endif
 }
@@ -41,22 +41,15 @@ static inline void ahrs_int_get_euler_from_accel_mag(struct Int32Eulers *e, stru
     struct Int32Vect3 *mag)
 {
   //  DISPLAY_INT32_VECT3("# accel", (*accel));
-  const float fphi = atan2f(-accel->y, -accel->z);
-  //  printf("# atan float %f\n", DegOfRad(fphi));
-  e->phi = ANGLE_BFP_OF_REAL(fphi);
+  e->phi = int32_atan2_table(-accel->y, -accel->z);
 
-  int32_t cphi;
-  PPRZ_ITRIG_COS(cphi, e->phi);
+  int32_t sphi, cphi;
+  PPRZ_ITRIG_SINCOS(sphi, cphi, e->phi);
   int32_t cphi_ax = -INT_MULT_RSHIFT(cphi, accel->x, INT32_TRIG_FRAC);
-  const float ftheta = atan2f(-cphi_ax, -accel->z);
-  e->theta = ANGLE_BFP_OF_REAL(ftheta);
+  e->theta = int32_atan2_table(-cphi_ax, -accel->z);
 
-  int32_t sphi;
-  PPRZ_ITRIG_SIN(sphi, e->phi);
-  int32_t stheta;
-  PPRZ_ITRIG_SIN(stheta, e->theta);
-  int32_t ctheta;
-  PPRZ_ITRIG_COS(ctheta, e->theta);
+  int32_t stheta, ctheta;
+  PPRZ_ITRIG_SINCOS(stheta, ctheta, e->theta);
 
   int32_t sphi_stheta = (sphi * stheta) >> INT32_TRIG_FRAC;
   int32_t cphi_stheta = (cphi * stheta) >> INT32_TRIG_FRAC;
@@ -71,8 +64,7 @@ static inline void ahrs_int_get_euler_from_accel_mag(struct Int32Eulers *e, stru
   //  cphi_ctheta * imu.mag.z;
   //  float m_psi = -atan2(me, mn);
   const float mag_dec = atan2(-AHRS_H_Y, AHRS_H_X);
-  const float fpsi = atan2f(-me, mn) - mag_dec;
-  e->psi = ANGLE_BFP_OF_REAL(fpsi);
+  e->psi = int32_atan2_table(-me, mn) - ANGLE_BFP_OF_REAL(mag_dec);
   INT32_ANGLE_NORMALIZE(e->psi);
 
 }
@@ -95,7 +95,7 @@ void downlink_init(void)
 #endif
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "DATALINK_REPORT", send_downlink);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_DATALINK_REPORT_ID, send_downlink);
 #endif
 }
 
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file subsystems/datalink/ivy_print.h
+ *
+ * Number printers for the Ivy text messages.
+ *
+ * They write straight into the message buffer and return the new end of it,
+ * without terminating the string. The output is the same as the
+ * "%u", "%d" and "%f" formats of printf.
+ */
+
+#ifndef IVY_PRINT_H
+#define IVY_PRINT_H
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+
+/** Max number of characters written by ivy_print_double */
+#define IVY_PRINT_MAX_LEN 32
+
+/** Print an unsigned integer, same as "%u" */
+static inline char *ivy_print_uint(char *p, uint64_t v)
+{
+  char tmp[20];
+  int n = 0;
+  do {
+    tmp[n++] = '0' + (char)(v % 10);
+    v /= 10;
+  } while (v != 0);
+  while (n > 0) {
+    *p++ = tmp[--n];
+  }
+  return p;
+}
+
+/** Print a signed integer, same as "%d" */
+static inline char *ivy_print_int(char *p, int64_t v)
+{
+  if (v < 0) {
+    *p++ = '-';
+    return ivy_print_uint(p, (uint64_t)0 - (uint64_t)v);
+  }
+  return ivy_print_uint(p, (uint64_t)v);
+}
+
+/**
+ * Print a floating point number with 6 decimals, same as "%f".
+ * The value is rounded to an integer number of millionths; the exact product
+ * is only needed to break the ties, which are rare.
+ * Values that don't fit (above 2^53 millionths, inf, nan) use snprintf,
+ * truncated to IVY_PRINT_MAX_LEN characters.
+ */
+static inline char *ivy_print_double(char *p, double v)
+{
+  const double scaled = v * 1e6;
+  if (!(fabs(scaled) < 9007199254740992.)) {
+    int n = snprintf(p, IVY_PRINT_MAX_LEN + 1, "%f", v);
+    return p + (n < IVY_PRINT_MAX_LEN ? n : IVY_PRINT_MAX_LEN);
+  }
+  double r = nearbyint(scaled);
+  const double frac = scaled - r;
+  if (frac == 0.5 || frac == -0.5) {
+    /* the rounded product is halfway, the rounding error decides */
+    const double err = fma(v, 1e6, -scaled);
+    if (err > 0) {
+      r = floor(scaled) + 1;
+    } else if (err < 0) {
+      r = ceil(scaled) - 1;
+    }
+  }
+  if (signbit(v)) {
+    *p++ = '-';
+  }
+  const uint64_t u = (uint64_t)fabs(r);
+  p = ivy_print_uint(p, u / 1000000);
+  *p++ = '.';
+  uint32_t f = u % 1000000;
+  for (int i = 5; i >= 0; i--) {
+    p[i] = '0' + (char)(f % 10);
+    f /= 10;
+  }
+  return p + 6;
+}
+
+#endif /* IVY_PRINT_H */
@@ -32,20 +32,72 @@
 #include "subsystems/datalink/downlink.h"
 #include "subsystems/datalink/transport.h"
 
+#include "subsystems/datalink/ivy_print.h"
+
 #include <stdio.h>
+#include <string.h>
 #include <Ivy/ivy.h>
 
 struct ivy_transport ivy_tp;
 
+#if IVY_TRANSPORT_BINARY
+
+#include "subsystems/datalink/pprz_transport.h" // STX
+#include "arch/linux/udp_socket.h"
+
+#ifndef IVY_TRANSPORT_BINARY_HOST
+#define IVY_TRANSPORT_BINARY_HOST "127.0.0.1"
+#endif
+
+#ifndef IVY_TRANSPORT_BINARY_PORT
+#define IVY_TRANSPORT_BINARY_PORT 4246
+#endif
+
+static struct UdpSocket ivy_binary_sock;
+static bool_t ivy_binary_sock_ok = FALSE;
+
+/* frame is |STX|length|payload|ck_a|ck_b| as in pprz_transport */
+void ivy_transport_send_binary(const uint8_t *payload, uint8_t len)
+{
+  uint8_t frame[IVY_TRANSPORT_BINARY_BUF_SIZE + 4];
+  if (!ivy_binary_sock_ok || len > IVY_TRANSPORT_BINARY_BUF_SIZE) {
+    return;
+  }
+  uint8_t ck_a, ck_b;
+  frame[0] = STX;
+  frame[1] = ck_a = ck_b = len + 4;
+  for (uint8_t i = 0; i < len; i++) {
+    frame[2 + i] = payload[i];
+    ck_a += payload[i];
+    ck_b += ck_a;
+  }
+  frame[len + 2] = ck_a;
+  frame[len + 3] = ck_b;
+  udp_socket_send_dontwait(&ivy_binary_sock, frame, len + 4);
+}
+
+#endif /* IVY_TRANSPORT_BINARY */
+
 static void put_bytes(struct ivy_transport *trans, struct link_device *dev __attribute__((unused)),
                       enum TransportDataType type __attribute__((unused)), enum TransportDataFormat format __attribute__((unused)),
                       uint8_t len, const void *bytes)
 {
   const uint8_t *b = (const uint8_t *) bytes;
+  char *p = trans->ivy_p;
+
+#if IVY_TRANSPORT_BINARY
+  if (trans->bin_idx + len <= IVY_TRANSPORT_BINARY_BUF_SIZE) {
+    memcpy(&trans->bin_buf[trans->bin_idx], bytes, len);
+    trans->bin_idx += len;
+  } else {
+    // too long, don't send it
+    trans->bin_idx = IVY_TRANSPORT_BINARY_BUF_SIZE + 1;
+  }
+#endif
 
   // Start delimiter "quote" for char arrays (strings)
   if (format == DL_FORMAT_ARRAY && type == DL_TYPE_CHAR) {
-    trans->ivy_p += sprintf(trans->ivy_p, "\"");
+    *p++ = '"';
   }
 
   int i = 0;
@@ -53,56 +105,48 @@ static void put_bytes(struct ivy_transport *trans, struct link_device *dev __att
     // print data with correct type
     switch (type) {
       case DL_TYPE_CHAR:
-        trans->ivy_p += sprintf(trans->ivy_p, "%c", (char)(*((char *)(b + i))));
+        *p++ = (char)(*((char *)(b + i)));
         i++;
         break;
       case DL_TYPE_UINT8:
-        trans->ivy_p += sprintf(trans->ivy_p, "%u", b[i]);
+        p = ivy_print_uint(p, b[i]);
         i++;
         break;
       case DL_TYPE_UINT16:
-        trans->ivy_p += sprintf(trans->ivy_p, "%u", (uint16_t)(*((uint16_t *)(b + i))));
+        p = ivy_print_uint(p, (uint16_t)(*((uint16_t *)(b + i))));
         i += 2;
         break;
       case DL_TYPE_UINT32:
       case DL_TYPE_TIMESTAMP:
-        trans->ivy_p += sprintf(trans->ivy_p, "%u", (uint32_t)(*((uint32_t *)(b + i))));
+        p = ivy_print_uint(p, (uint32_t)(*((uint32_t *)(b + i))));
         i += 4;
         break;
       case DL_TYPE_UINT64:
-#if __WORDSIZE == 64
-        trans->ivy_p += sprintf(trans->ivy_p, "%lu", (uint64_t)(*((uint64_t *)(b + i))));
-#else
-        trans->ivy_p += sprintf(trans->ivy_p, "%llu", (uint64_t)(*((uint64_t *)(b + i))));
-#endif
+        p = ivy_print_uint(p, (uint64_t)(*((uint64_t *)(b + i))));
         i += 8;
         break;
       case DL_TYPE_INT8:
-        trans->ivy_p += sprintf(trans->ivy_p, "%d", (int8_t)(*((int8_t *)(b + i))));
+        p = ivy_print_int(p, (int8_t)(*((int8_t *)(b + i))));
         i++;
         break;
       case DL_TYPE_INT16:
-        trans->ivy_p += sprintf(trans->ivy_p, "%d", (int16_t)(*((int16_t *)(b + i))));
+        p = ivy_print_int(p, (int16_t)(*((int16_t *)(b + i))));
         i += 2;
         break;
       case DL_TYPE_INT32:
-        trans->ivy_p += sprintf(trans->ivy_p, "%d", (int32_t)(*((int32_t *)(b + i))));
+        p = ivy_print_int(p, (int32_t)(*((int32_t *)(b + i))));
         i += 4;
         break;
       case DL_TYPE_INT64:
-#if __WORDSIZE == 64
-        trans->ivy_p += sprintf(trans->ivy_p, "%ld", (uint64_t)(*((uint64_t *)(b + i))));
-#else
-        trans->ivy_p += sprintf(trans->ivy_p, "%lld", (uint64_t)(*((uint64_t *)(b + i))));
-#endif
+        p = ivy_print_int(p, (int64_t)(*((int64_t *)(b + i))));
         i += 8;
         break;
       case DL_TYPE_FLOAT:
-        trans->ivy_p += sprintf(trans->ivy_p, "%f", (float)(*((float *)(b + i))));
+        p = ivy_print_double(p, (float)(*((float *)(b + i))));
         i += 4;
         break;
       case DL_TYPE_DOUBLE:
-        trans->ivy_p += sprintf(trans->ivy_p, "%f", (double)(*((double *)(b + i))));
+        p = ivy_print_double(p, (double)(*((double *)(b + i))));
         i += 8;
         break;
       case DL_TYPE_ARRAY_LENGTH:
@@ -114,28 +158,38 @@ static void put_bytes(struct ivy_transport *trans, struct link_device *dev __att
     // Coma delimiter for array, no delimiter for char array (string), space otherwise
     if (format == DL_FORMAT_ARRAY) {
       if (type != DL_TYPE_CHAR) {
-        trans->ivy_p += sprintf(trans->ivy_p, ",");
+        *p++ = ',';
       }
     } else {
-      trans->ivy_p += sprintf(trans->ivy_p, " ");
+      *p++ = ' ';
     }
   }
 
   // space end delimiter for arrays, additionally un-quote char arrays (strings)
   if (format == DL_FORMAT_ARRAY) {
     if (type == DL_TYPE_CHAR) {
-      trans->ivy_p += sprintf(trans->ivy_p, "\" ");
-    } else {
-      trans->ivy_p += sprintf(trans->ivy_p, " ");
+      *p++ = '"';
     }
+    *p++ = ' ';
   }
+  trans->ivy_p = p;
 }
 
 static void put_named_byte(struct ivy_transport *trans, struct link_device *dev __attribute__((unused)),
                            enum TransportDataType type __attribute__((unused)), enum TransportDataFormat format __attribute__((unused)),
-                           uint8_t byte __attribute__((unused)), const char *name __attribute__((unused)))
+                           uint8_t byte, const char *name)
 {
-  trans->ivy_p += sprintf(trans->ivy_p, "%s ", name);
+#if IVY_TRANSPORT_BINARY
+  if (trans->bin_idx < IVY_TRANSPORT_BINARY_BUF_SIZE) {
+    trans->bin_buf[trans->bin_idx++] = byte;
+  } else {
+    trans->bin_idx = IVY_TRANSPORT_BINARY_BUF_SIZE + 1;
+  }
+#endif
+  size_t n = strlen(name);
+  memcpy(trans->ivy_p, name, n);
+  trans->ivy_p += n;
+  *trans->ivy_p++ = ' ';
 }
 
 static uint8_t size_of(struct ivy_transport *trans __attribute__((unused)), uint8_t len)
@@ -147,6 +201,9 @@ static void start_message(struct ivy_transport *trans, struct link_device *dev _
                           uint8_t payload_len __attribute__((unused)))
 {
   trans->ivy_p = trans->ivy_buf;
+#if IVY_TRANSPORT_BINARY
+  trans->bin_idx = 0;
+#endif
 }
 
 static void end_message(struct ivy_transport *trans, struct link_device *dev __attribute__((unused)))
@@ -154,6 +211,9 @@ static void end_message(struct ivy_transport *trans, struct link_device *dev __a
   *(--trans->ivy_p) = '\0';
   if (trans->ivy_dl_enabled) {
     IvySendMsg("%s", trans->ivy_buf);
+#if IVY_TRANSPORT_BINARY
+    ivy_transport_send_binary(trans->bin_buf, trans->bin_idx);
+#endif
     downlink.nb_msgs++;
   }
 }
@@ -185,6 +245,11 @@ void ivy_transport_init(void)
 {
   ivy_tp.ivy_p = ivy_tp.ivy_buf;
   ivy_tp.ivy_dl_enabled = TRUE;
+#if IVY_TRANSPORT_BINARY
+  ivy_tp.bin_idx = 0;
+  ivy_binary_sock_ok = (udp_socket_create(&ivy_binary_sock, IVY_TRANSPORT_BINARY_HOST,
+                                          IVY_TRANSPORT_BINARY_PORT, -1, FALSE) == 0);
+#endif
 
   ivy_tp.trans_tx.size_of = (size_of_t) size_of;
   ivy_tp.trans_tx.check_available_space = (check_available_space_t) check_available_space;
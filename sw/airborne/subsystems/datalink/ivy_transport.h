@@ -33,11 +33,25 @@
 #include "subsystems/datalink/transport.h"
 #include "mcu_periph/link_device.h"
 
+/** Also send the messages as pprz frames over UDP,
+ *  to IVY_TRANSPORT_BINARY_HOST:IVY_TRANSPORT_BINARY_PORT
+ *  (default 127.0.0.1:4246), for tools that don't want to parse the text.
+ */
+#ifndef IVY_TRANSPORT_BINARY
+#define IVY_TRANSPORT_BINARY FALSE
+#endif
+
+#define IVY_TRANSPORT_BINARY_BUF_SIZE 251 ///< max payload of a pprz frame
+
 // IVY transport
 struct ivy_transport {
   char ivy_buf[256];
   char *ivy_p;
   int ivy_dl_enabled;
+#if IVY_TRANSPORT_BINARY
+  uint8_t bin_buf[IVY_TRANSPORT_BINARY_BUF_SIZE];
+  uint16_t bin_idx;
+#endif
   // generic transmission interface
   struct transport_tx trans_tx;
   // generic (dummy) device
@@ -49,5 +63,10 @@ extern struct ivy_transport ivy_tp;
 // Init function
 extern void ivy_transport_init(void);
 
+#if IVY_TRANSPORT_BINARY
+/** Send a message payload (ac_id, msg_id, fields) as a pprz frame on the binary channel */
+extern void ivy_transport_send_binary(const uint8_t *payload, uint8_t len);
+#endif
+
 #endif // IVY_TRANSPORT_H
 
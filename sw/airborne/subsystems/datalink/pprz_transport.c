@@ -36,9 +36,13 @@
  *     ck_A += b;
  *     ck_b += ck_A;
  * @endcode
+ *
+ * With PPRZ_TRANSPORT_TX_BUFFERED, the frame is built in a buffer and
+ * written to the device at once in end_message.
  */
 
 #include <inttypes.h>
+#include <string.h>
 #include "subsystems/datalink/downlink.h"
 #ifndef PPRZ_DATALINK_EXPORT
 #include "subsystems/datalink/pprz_transport.h"
@@ -48,6 +52,27 @@
 
 struct pprz_transport pprz_tp;
 
+#if PPRZ_TRANSPORT_TX_BUFFERED
+
+static void put_1byte(struct pprz_transport *trans, struct link_device *dev __attribute__((unused)), const uint8_t byte)
+{
+  if (trans->tx_idx < PPRZ_TRANSPORT_TX_BUF_SIZE) {
+    trans->tx_buf[trans->tx_idx++] = byte;
+  }
+}
+
+static void put_bytes(struct pprz_transport *trans, struct link_device *dev __attribute__((unused)),
+                      enum TransportDataType type __attribute__((unused)), enum TransportDataFormat format __attribute__((unused)),
+                      uint8_t len, const void *bytes)
+{
+  if (trans->tx_idx + len <= PPRZ_TRANSPORT_TX_BUF_SIZE) {
+    memcpy(&trans->tx_buf[trans->tx_idx], bytes, len);
+    trans->tx_idx += len;
+  }
+}
+
+#else
+
 static void put_1byte(struct pprz_transport *trans, struct link_device *dev, const uint8_t byte)
 {
   trans->ck_a_tx += byte;
@@ -66,6 +91,8 @@ static void put_bytes(struct pprz_transport *trans, struct link_device *dev,
   }
 }
 
+#endif
+
 static void put_named_byte(struct pprz_transport *trans, struct link_device *dev,
                            enum TransportDataType type __attribute__((unused)), enum TransportDataFormat format __attribute__((unused)),
                            uint8_t byte, const char *name __attribute__((unused)))
@@ -79,6 +106,44 @@ static uint8_t size_of(struct pprz_transport *trans __attribute__((unused)), uin
   return len + 4;
 }
 
+#if PPRZ_TRANSPORT_TX_BUFFERED
+
+static void start_message(struct pprz_transport *trans, struct link_device *dev __attribute__((unused)),
+                          uint8_t payload_len)
+{
+  downlink.nb_msgs++;
+  trans->tx_buf[0] = STX;
+  trans->tx_buf[1] = size_of(trans, payload_len);
+  trans->tx_idx = 2;
+}
+
+static void end_message(struct pprz_transport *trans, struct link_device *dev)
+{
+  // checksum over length and payload
+  uint8_t ck_a = 0, ck_b = 0;
+  uint16_t i;
+  for (i = 1; i < trans->tx_idx; i++) {
+    ck_a += trans->tx_buf[i];
+    ck_b += ck_a;
+  }
+  trans->ck_a_tx = ck_a;
+  trans->ck_b_tx = ck_b;
+  put_1byte(trans, dev, ck_a);
+  put_1byte(trans, dev, ck_b);
+
+  // write the complete frame at once
+  if (dev->put_buffer != NULL) {
+    dev->put_buffer(dev->periph, trans->tx_buf, trans->tx_idx);
+  } else {
+    for (i = 0; i < trans->tx_idx; i++) {
+      dev->put_byte(dev->periph, trans->tx_buf[i]);
+    }
+  }
+  dev->send_message(dev->periph);
+}
+
+#else
+
 static void start_message(struct pprz_transport *trans, struct link_device *dev, uint8_t payload_len)
 {
   downlink.nb_msgs++;
@@ -96,6 +161,8 @@ static void end_message(struct pprz_transport *trans, struct link_device *dev)
   dev->send_message(dev->periph);
 }
 
+#endif
+
 static void overrun(struct pprz_transport *trans __attribute__((unused)),
                     struct link_device *dev __attribute__((unused)))
 {
@@ -56,6 +56,15 @@
 
 #define STX  0x99
 
+/** Build the complete frame in a buffer (checksum computed in one pass)
+ * and give it to the device in a single write.
+ */
+#ifndef PPRZ_TRANSPORT_TX_BUFFERED
+#define PPRZ_TRANSPORT_TX_BUFFERED FALSE
+#endif
+
+#define PPRZ_TRANSPORT_TX_BUF_SIZE 255
+
 // PPRZ parsing state machine
 #define UNINIT      0
 #define GOT_STX     1
@@ -74,6 +83,10 @@ struct pprz_transport {
   struct transport_tx trans_tx;
   // specific pprz transport_tx variables
   uint8_t ck_a_tx, ck_b_tx;
+#if PPRZ_TRANSPORT_TX_BUFFERED
+  uint8_t tx_buf[PPRZ_TRANSPORT_TX_BUF_SIZE];
+  uint16_t tx_idx;
+#endif
 };
 
 extern struct pprz_transport pprz_tp;
@@ -29,6 +29,7 @@
 
 #include "subsystems/datalink/telemetry_common.h"
 #include "generated/periodic_telemetry.h"
+#include <string.h>
 
 /* Implement global structures from generated header
  */
@@ -37,7 +38,27 @@ telemetry_cb telemetry_cbs[TELEMETRY_NB_MSG] = TELEMETRY_CBS_NULL;
 struct periodic_telemetry pprz_telemetry = { TELEMETRY_NB_MSG, telemetry_msgs, telemetry_cbs };
 
 
+/** Register a telemetry callback function by message ID.
+ * @param _pt periodic telemetry structure to register
+ * @param _id message ID as generated in periodic_telemetry.h (TELEMETRY_MSG_<NAME>_ID)
+ * @param _cb callback function, called according to telemetry mode and specified period
+ * @return TRUE if message registered with success, FALSE otherwise
+ */
+bool_t register_periodic_telemetry_id(struct periodic_telemetry *_pt, uint8_t _id, telemetry_cb _cb)
+{
+  // return FALSE if NULL is passed as periodic_telemetry
+  // or if the message is not in the telemetry file
+  if (_pt == NULL || _id >= _pt->nb) { return FALSE; }
+  // register callback if not already done
+  if (_pt->cbs[_id] == NULL) {
+    _pt->cbs[_id] = _cb;
+    return TRUE;
+  }
+  return FALSE;
+}
+
 /** Register a telemetry callback function.
+ * The generated message names are sorted, a binary search is used to find the ID.
  * @param _pt periodic telemetry structure to register
  * @param _msg message name (string) as defined in telemetry xml file
  * @param _cb callback function, called according to telemetry mode and specified period
@@ -48,14 +69,17 @@ bool_t register_periodic_telemetry(struct periodic_telemetry *_pt, const char *_
   // return FALSE if NULL is passed as periodic_telemetry
   if (_pt == NULL) { return FALSE; }
   // look for message name
-  uint8_t i;
-  for (i = 0; i < _pt->nb; i++) {
-    if (str_equal(_pt->msgs[i], _msg)) {
-      // register callback if not already done
-      if (_pt->cbs[i] == NULL) {
-        _pt->cbs[i] = _cb;
-        return TRUE;
-      } else { return FALSE; }
+  int16_t low = 0;
+  int16_t high = (int16_t)_pt->nb - 1;
+  while (low <= high) {
+    int16_t mid = (low + high) / 2;
+    int cmp = strcmp(_pt->msgs[mid], _msg);
+    if (cmp == 0) {
+      return register_periodic_telemetry_id(_pt, (uint8_t)mid, _cb);
+    } else if (cmp < 0) {
+      low = mid + 1;
+    } else {
+      high = mid - 1;
     }
   }
   // message name is not in telemetry file
@@ -44,6 +44,11 @@
  *    @code
  *    register_periodic_telemetry(&your_telemetry_struct, "YOUR_MESSAGE_NAME", your_callback);
  *    @endcode
+ *   or, when the name is a message of the telemetry class, by its generated ID
+ *   (faster, and a wrong name fails at compile time)
+ *    @code
+ *    register_periodic_telemetry_id(&your_telemetry_struct, TELEMETRY_MSG_YOUR_MESSAGE_NAME_ID, your_callback);
+ *    @endcode
  * In most cases, the default telemetry structure should be used
  * (replace &your_telemetry_struct by DefaultPeriodic in the register function).
  */
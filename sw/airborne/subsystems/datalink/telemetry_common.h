@@ -67,6 +67,25 @@ static inline bool_t register_periodic_telemetry(struct periodic_telemetry *_pt
     const char *_msg __attribute__((unused)), telemetry_cb _cb __attribute__((unused))) { return FALSE; }
 #endif
 
+/** Register a telemetry callback function by message ID (no search).
+ * The IDs are generated in periodic_telemetry.h for all the telemetry messages,
+ * so an unknown message name fails at compile time. Messages which are not
+ * in the telemetry file can't be registered.
+ * @code
+ * register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_YOUR_MESSAGE_NAME_ID, your_callback);
+ * @endcode
+ * @param _pt periodic telemetry structure to register
+ * @param _id message ID (TELEMETRY_MSG_<NAME>_ID)
+ * @param _cb callback function, called according to telemetry mode and specified period
+ * @return TRUE if message registered with success, FALSE otherwise
+ */
+#if PERIODIC_TELEMETRY
+extern bool_t register_periodic_telemetry_id(struct periodic_telemetry *_pt, uint8_t _id, telemetry_cb _cb);
+#else
+static inline bool_t register_periodic_telemetry_id(struct periodic_telemetry *_pt __attribute__((unused)),
+    uint8_t _id __attribute__((unused)), telemetry_cb _cb __attribute__((unused))) { return FALSE; }
+#endif
+
 #if USE_PERIODIC_TELEMETRY_REPORT
 /** Send an error report when trying to send message that as not been register
  * @param _process telemetry process id
@@ -156,14 +156,14 @@ void ins_vectornav_init(void)
   orientationSetEulers_f(&ins_vn.body_to_imu, &body_to_imu_eulers);
 
 #if PERIODIC_TELEMETRY
-  register_periodic_telemetry(DefaultPeriodic, "INS", send_ins);
-  register_periodic_telemetry(DefaultPeriodic, "INS_Z", send_ins_z);
-  register_periodic_telemetry(DefaultPeriodic, "INS_REF", send_ins_ref);
-  register_periodic_telemetry(DefaultPeriodic, "VECTORNAV_INFO", send_vn_info);
-  register_periodic_telemetry(DefaultPeriodic, "IMU_ACCEL", send_accel);
-  register_periodic_telemetry(DefaultPeriodic, "IMU_GYRO", send_gyro);
-  register_periodic_telemetry(DefaultPeriodic, "IMU_ACCEL_SCALED", send_accel_scaled);
-  register_periodic_telemetry(DefaultPeriodic, "IMU_GYRO_SCALED", send_gyro_scaled);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_INS_ID, send_ins);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_INS_Z_ID, send_ins_z);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_INS_REF_ID, send_ins_ref);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_VECTORNAV_INFO_ID, send_vn_info);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_IMU_ACCEL_ID, send_accel);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_IMU_GYRO_ID, send_gyro);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_IMU_ACCEL_SCALED_ID, send_accel_scaled);
+  register_periodic_telemetry_id(DefaultPeriodic, TELEMETRY_MSG_IMU_GYRO_SCALED_ID, send_gyro_scaled);
 #endif
 }
 
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file test/vision/bench_image.c
+ * Throughput benchmark of the image.c kernels on a synthetic 640x480 YUV422 frame.
+ *
+ * Reports pixels per second for each kernel and a checksum of its output,
+ * so the SIMD build can be compared against bench_image_scalar.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lib/vision/image.h"
+
+#define W 640
+#define H 480
+#define ITERATIONS 200
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static uint32_t checksum(struct image_t *img)
+{
+  uint32_t sum = 0;
+  uint8_t *buf = (uint8_t *)img->buf;
+  for (uint32_t i = 0; i < img->buf_size; i++) {
+    sum = sum * 31 + buf[i];
+  }
+  return sum;
+}
+
+static void report(const char *name, double t, uint32_t pixels, uint32_t check)
+{
+  printf("%-20s %10.1f Mpx/s  (checksum %08x)\n", name, pixels * (double)ITERATIONS / t / 1e6, check);
+}
+
+int main(void)
+{
+  struct image_t yuv, filt, small, gray, gray2, yuv_gray, dx, dy, diff;
+  image_create(&yuv, W, H, IMAGE_YUV422);
+  image_create(&filt, W, H, IMAGE_YUV422);
+  image_create(&small, W / 2, H / 2, IMAGE_YUV422);
+  image_create(&gray, W, H, IMAGE_GRAYSCALE);
+  image_create(&gray2, W - 2, H - 2, IMAGE_GRAYSCALE);
+  image_create(&yuv_gray, W, H, IMAGE_YUV422);
+  image_create(&dx, W - 2, H - 2, IMAGE_GRADIENT);
+  image_create(&dy, W - 2, H - 2, IMAGE_GRADIENT);
+  image_create(&diff, W - 2, H - 2, IMAGE_GRADIENT);
+
+  // Pseudo random but reproducible frame
+  srand(42);
+  uint8_t *buf = (uint8_t *)yuv.buf;
+  for (uint32_t i = 0; i < yuv.buf_size; i++) {
+    buf[i] = (uint8_t)((i * 7 + (i / (2 * W)) * 3) + (rand() & 0x1F));
+  }
+  uint8_t *g2 = (uint8_t *)gray2.buf;
+  for (uint32_t i = 0; i < gray2.buf_size; i++) {
+    g2[i] = (uint8_t)(rand() & 0xFF);
+  }
+
+  printf("image kernels (%s), %dx%d, %d iterations\n", image_simd_name(), W, H, ITERATIONS);
+
+  double t0 = now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    image_to_grayscale(&yuv, &gray);
+  }
+  report("to_grayscale", now() - t0, W * H, checksum(&gray));
+
+  t0 = now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    image_to_grayscale(&yuv, &yuv_gray);
+  }
+  report("to_grayscale_yuv", now() - t0, W * H, checksum(&yuv_gray));
+
+  uint16_t cnt = 0;
+  t0 = now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    cnt = image_yuv422_colorfilt(&yuv, &filt, 60, 200, 0, 120, 130, 255);
+  }
+  report("yuv422_colorfilt", now() - t0, W * H, checksum(&filt) + cnt);
+
+  t0 = now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    image_yuv422_downsample(&yuv, &small, 2);
+  }
+  report("yuv422_downsample", now() - t0, W * H, checksum(&small));
+
+  t0 = now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    image_gradients(&gray, &dx, &dy);
+  }
+  report("gradients", now() - t0, W * H, checksum(&dx) ^ checksum(&dy));
+
+  uint32_t err = 0;
+  t0 = now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    err = image_difference(&gray, &gray2, &diff);
+  }
+  report("difference", now() - t0, (W - 2) * (H - 2), checksum(&diff) + err);
+
+  image_free(&yuv);
+  image_free(&filt);
+  image_free(&small);
+  image_free(&gray);
+  image_free(&gray2);
+  image_free(&yuv_gray);
+  image_free(&dx);
+  image_free(&dy);
+  image_free(&diff);
+  return 0;
+}
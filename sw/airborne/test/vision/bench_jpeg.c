@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file test/vision/bench_jpeg.c
+ * Throughput benchmark of the JPEG encoder on YUV422 frames.
+ *
+ * Usage: bench_jpeg [file.uyvy width height]
+ *
+ * Without arguments a synthetic 640x480 frame is used, otherwise all the raw
+ * UYVY frames of the file are encoded in turn. Reports frames per second and
+ * the average compressed size for a few quality factors, so the fast DCT build
+ * can be compared against bench_jpeg_ref.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib/vision/image.h"
+#include "lib/encoding/jpeg.h"
+
+#define W 640
+#define H 480
+#ifndef ITERATIONS
+#define ITERATIONS 100
+#endif
+#define MAX_FRAMES 64
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Smooth pattern with some noise, closer to a camera image than pure noise */
+static void synthetic_frame(struct image_t *img)
+{
+  uint8_t *buf = (uint8_t *)img->buf;
+  srand(42);
+  for (uint16_t y = 0; y < img->h; y++) {
+    for (uint16_t x = 0; x < img->w; x += 2) {
+      uint8_t *p = &buf[(y * img->w + x) * 2];
+      p[0] = (uint8_t)(128 + (x / 8) % 32 - (y / 16) % 16);
+      p[1] = (uint8_t)((x + y) / 5 + (rand() & 0x0F));
+      p[2] = (uint8_t)(128 - (y / 8) % 32 + (x / 32) % 8);
+      p[3] = (uint8_t)((x + 1 + y) / 5 + ((x * y) % 97 < 8 ? 60 : 0) + (rand() & 0x0F));
+    }
+  }
+}
+
+static uint16_t load_frames(const char *file, struct image_t *frames, uint16_t w, uint16_t h)
+{
+  FILE *f = fopen(file, "rb");
+  if (f == NULL) {
+    perror(file);
+    return 0;
+  }
+  uint16_t nb = 0;
+  while (nb < MAX_FRAMES) {
+    image_create(&frames[nb], w, h, IMAGE_YUV422);
+    if (fread(frames[nb].buf, 1, frames[nb].buf_size, f) != frames[nb].buf_size) {
+      image_free(&frames[nb]);
+      break;
+    }
+    nb++;
+  }
+  fclose(f);
+  return nb;
+}
+
+int main(int argc, char **argv)
+{
+  static struct image_t frames[MAX_FRAMES];
+  uint16_t nb_frames = 1;
+  uint16_t w = W, h = H;
+
+  if (argc == 4) {
+    w = atoi(argv[2]);
+    h = atoi(argv[3]);
+    nb_frames = load_frames(argv[1], frames, w, h);
+    if (nb_frames == 0) {
+      fprintf(stderr, "no %dx%d UYVY frame in %s\n", w, h, argv[1]);
+      return 1;
+    }
+  } else if (argc == 1) {
+    image_create(&frames[0], w, h, IMAGE_YUV422);
+    synthetic_frame(&frames[0]);
+  } else {
+    fprintf(stderr, "usage: %s [file.uyvy width height]\n", argv[0]);
+    return 1;
+  }
+
+  struct image_t jpeg;
+  image_create(&jpeg, w, h, IMAGE_JPEG);
+
+  printf("jpeg encoder, %dx%d, %d frame(s), %d iterations\n", w, h, nb_frames, ITERATIONS);
+
+  static const uint32_t qualities[] = {50, 80, 95};
+  for (uint8_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++) {
+    uint64_t size = 0;
+    uint32_t sum = 0;
+    double t0 = now();
+    for (int i = 0; i < ITERATIONS; i++) {
+      jpeg_encode_image(&frames[i % nb_frames], &jpeg, qualities[q], TRUE);
+      size += jpeg.buf_size;
+    }
+    double t = now() - t0;
+    uint8_t *buf = (uint8_t *)jpeg.buf;
+    for (uint32_t i = 0; i < jpeg.buf_size; i++) {
+      sum = sum * 31 + buf[i];
+    }
+    printf("quality %3d  %8.1f fps  %8.1f Mpx/s  %8lu bytes/frame  (checksum %08x)\n",
+           qualities[q], ITERATIONS / t, (double)w * h * ITERATIONS / t / 1e6,
+           (unsigned long)(size / ITERATIONS), sum);
+  }
+
+  image_free(&jpeg);
+  for (uint16_t i = 0; i < nb_frames; i++) {
+    image_free(&frames[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of Paparazzi.
+ *
+ * Paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * Paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file test/vision/bench_vision.c
+ * Latency benchmark of the vision stages and of the full optic flow pipeline.
+ *
+ * Usage: bench_vision [file.uyvy width height]
+ *
+ * Without arguments a synthetic 320x240 sequence (a moving and slowly zooming
+ * texture with a colored blob) is used, otherwise the raw UYVY frames of the
+ * file are played in turn. A recording can for instance be converted with:
+ *   ffmpeg -i video.mp4 -s 320x240 -pix_fmt uyvy422 -f rawvideo video.uyvy
+ *
+ * Every stage is timed per frame and the median, 90th and 99th percentile and
+ * worst latencies are reported with the matching frame rate (from the mean),
+ * followed by a few results of the pipeline to check that it still tracks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lib/vision/image.h"
+#include "lib/vision/fast_rosten.h"
+#include "lib/vision/lucas_kanade.h"
+#include "lib/vision/integral_image.h"
+#include "lib/encoding/jpeg.h"
+#include "blob/blob_finder.h"
+#include "opticflow/opticflow_calculator.h"
+
+#define W 320
+#define H 240
+#ifndef ITERATIONS
+#define ITERATIONS 200
+#endif
+#define MAX_FRAMES 64
+#define SYNTHETIC_FRAMES 32
+
+/* Tracking settings, the defaults of the opticflow module except for the
+ * pyramid (two levels above full resolution) */
+#define FAST9_THRESHOLD 20
+#define FAST9_MIN_DISTANCE 10
+#define FAST9_MAX_CORNERS 100
+#define LK_HALF_WINDOW 5
+#define LK_SUBPIXEL_FACTOR 10
+#define LK_MAX_ITERATIONS 10
+#define LK_THRESHOLD_VEC 2
+#define LK_MAX_POINTS 25
+#define PYRAMID_LEVELS 3
+#define LABELS_SIZE 512
+
+enum bench_stage {
+  STAGE_GRAYSCALE,
+  STAGE_DOWNSAMPLE,
+  STAGE_PYRAMID,
+  STAGE_FAST9,
+  STAGE_LUCAS_KANADE,
+  STAGE_INTEGRAL_IMAGE,
+  STAGE_BLOB_LABELING,
+  STAGE_JPEG,
+  STAGE_OPTICFLOW,
+  NB_STAGES
+};
+
+static const char *stage_names[NB_STAGES] = {
+  "to_grayscale",
+  "yuv422_downsample",
+  "pyramid_build",
+  "fast9_detect",
+  "lucas_kanade",
+  "integral_image",
+  "blob_labeling",
+  "jpeg_encode",
+  "opticflow_pipeline",
+};
+
+static double timings[NB_STAGES][ITERATIONS];
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+  double da = *(const double *)a, db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+/* Latency percentiles in microseconds and frame rate of a stage */
+static void report(enum bench_stage stage)
+{
+  double *t = timings[stage];
+  double mean = 0;
+  for (int i = 0; i < ITERATIONS; i++) {
+    mean += t[i];
+  }
+  mean /= ITERATIONS;
+  qsort(t, ITERATIONS, sizeof(double), compare_double);
+  printf("%-20s %9.1f %9.1f %9.1f %9.1f %10.1f\n", stage_names[stage],
+         t[ITERATIONS / 2] * 1e6, t[ITERATIONS * 90 / 100] * 1e6, t[ITERATIONS * 99 / 100] * 1e6,
+         t[ITERATIONS - 1] * 1e6, 1. / mean);
+}
+
+/* Texture moving diagonally and zooming in, with an orange disk in the middle */
+static void synthetic_sequence(struct image_t *frames, uint16_t nb, uint16_t w, uint16_t h)
+{
+  static uint8_t texture[512][512];
+  srand(42);
+  for (int y = 0; y < 512; y++) {
+    for (int x = 0; x < 512; x++) {
+      texture[y][x] = (uint8_t)(((x / 9 + y / 7) % 3) * 50 + (rand() & 0x1F) + ((x * y) % 41 < 5 ? 70 : 0));
+    }
+  }
+  for (uint16_t f = 0; f < nb; f++) {
+    image_create(&frames[f], w, h, IMAGE_YUV422);
+    uint8_t *buf = (uint8_t *)frames[f].buf;
+    float scale = 1.f - 0.002f * f;
+    for (uint16_t y = 0; y < h; y++) {
+      for (uint16_t x = 0; x < w; x++) {
+        int tx = ((int)((x - w / 2) * scale) + w / 2 + 2 * f) & 511;
+        int ty = ((int)((y - h / 2) * scale) + h / 2 + f) & 511;
+        int dx = x - w / 2, dy = y - h / 2;
+        bool_t blob = (dx * dx + dy * dy < (h / 8) * (h / 8));
+        uint8_t *p = &buf[(y * w + x) * 2];
+        if (x % 2 == 0) {
+          p[0] = blob ? 60 : 128;     // U
+        } else {
+          p[0] = blob ? 200 : 128;    // V
+        }
+        p[1] = blob ? 150 : texture[ty][tx];
+      }
+    }
+  }
+}
+
+static uint16_t load_frames(const char *file, struct image_t *frames, uint16_t w, uint16_t h)
+{
+  FILE *f = fopen(file, "rb");
+  if (f == NULL) {
+    perror(file);
+    return 0;
+  }
+  uint16_t nb = 0;
+  while (nb < MAX_FRAMES) {
+    image_create(&frames[nb], w, h, IMAGE_YUV422);
+    if (fread(frames[nb].buf, 1, frames[nb].buf_size, f) != frames[nb].buf_size) {
+      image_free(&frames[nb]);
+      break;
+    }
+    nb++;
+  }
+  fclose(f);
+  return nb;
+}
+
+int main(int argc, char **argv)
+{
+  static struct image_t frames[MAX_FRAMES];
+  static struct image_label_t labels[LABELS_SIZE];
+  uint16_t nb_frames = SYNTHETIC_FRAMES;
+  uint16_t w = W, h = H;
+
+  if (argc == 4) {
+    w = atoi(argv[2]);
+    h = atoi(argv[3]);
+    nb_frames = load_frames(argv[1], frames, w, h);
+    if (nb_frames < 2) {
+      fprintf(stderr, "need at least 2 %dx%d UYVY frames in %s\n", w, h, argv[1]);
+      return 1;
+    }
+  } else if (argc == 1) {
+    synthetic_sequence(frames, nb_frames, w, h);
+  } else {
+    fprintf(stderr, "usage: %s [file.uyvy width height]\n", argv[0]);
+    return 1;
+  }
+
+  struct image_t gray, prev_gray, small, jpeg, blobs;
+  struct image_pyramid_t pyr, prev_pyr;
+  struct image_arena_t arena;
+  image_create(&gray, w, h, IMAGE_GRAYSCALE);
+  image_create(&prev_gray, w, h, IMAGE_GRAYSCALE);
+  image_create(&small, w / 2, h / 2, IMAGE_YUV422);
+  image_create(&jpeg, w, h, IMAGE_JPEG);
+  image_create(&blobs, w, h, IMAGE_GRADIENT);
+  image_pyramid_create(&pyr, w, h, PYRAMID_LEVELS);
+  image_pyramid_create(&prev_pyr, w, h, PYRAMID_LEVELS);
+  image_arena_create(&arena, sizeof(struct point_t) * FAST9_MAX_CORNERS + sizeof(struct flow_t) * LK_MAX_POINTS +
+                     2 * IMAGE_ARENA_ALIGN + Max(fast9_scratch_size(w, h, FAST9_MIN_DISTANCE),
+                         opticFlowLKScratchSize(LK_HALF_WINDOW)));
+  uint32_t *integral = malloc(sizeof(uint32_t) * w * h);
+
+  struct image_filter_t filter = {100, 200, 0, 100, 150, 255};
+
+  image_to_grayscale(&frames[0], &prev_gray);
+  image_pyramid_build(&prev_pyr, &prev_gray, PYRAMID_LEVELS);
+
+  printf("vision stages (%s/%s kernels), %dx%d, %d frame(s), %d iterations\n", image_simd_name(),
+         integral_image_simd_name(), w, h, nb_frames, ITERATIONS);
+
+  // Separate stages, every iteration uses the next frame
+  uint32_t corners_sum = 0, tracked_sum = 0, blobs_sum = 0;
+  for (int i = 0; i < ITERATIONS; i++) {
+    struct image_t *img = &frames[(i + 1) % nb_frames];
+    double t0, t1;
+
+    t0 = now();
+    image_to_grayscale(img, &gray);
+    t1 = now();
+    timings[STAGE_GRAYSCALE][i] = t1 - t0;
+
+    t0 = now();
+    image_yuv422_downsample(img, &small, 2);
+    t1 = now();
+    timings[STAGE_DOWNSAMPLE][i] = t1 - t0;
+
+    t0 = now();
+    image_pyramid_build(&pyr, &gray, PYRAMID_LEVELS);
+    t1 = now();
+    timings[STAGE_PYRAMID][i] = t1 - t0;
+
+    image_arena_reset(&arena);
+    struct point_t *corners = image_arena_alloc(&arena, sizeof(struct point_t) * FAST9_MAX_CORNERS);
+    struct flow_t *vectors = image_arena_alloc(&arena, sizeof(struct flow_t) * LK_MAX_POINTS);
+    uint16_t corner_cnt = 0;
+    t0 = now();
+    fast9_detect(&prev_gray, FAST9_THRESHOLD, FAST9_MIN_DISTANCE, 20, 20, corners, FAST9_MAX_CORNERS, &corner_cnt,
+                 &arena);
+    t1 = now();
+    timings[STAGE_FAST9][i] = t1 - t0;
+    corners_sum += corner_cnt;
+
+    uint16_t tracked_cnt = corner_cnt;
+    t0 = now();
+    opticFlowLKPyramid(&pyr, &prev_pyr, corners, &tracked_cnt, vectors, LK_HALF_WINDOW, LK_SUBPIXEL_FACTOR,
+                       LK_MAX_ITERATIONS, LK_THRESHOLD_VEC, LK_MAX_POINTS, &arena);
+    t1 = now();
+    timings[STAGE_LUCAS_KANADE][i] = t1 - t0;
+    tracked_sum += tracked_cnt;
+
+    t0 = now();
+    integral_image_compute((uint8_t *)gray.buf, w, h, integral);
+    t1 = now();
+    timings[STAGE_INTEGRAL_IMAGE][i] = t1 - t0;
+
+    uint16_t labels_cnt = LABELS_SIZE;
+    t0 = now();
+    image_labeling(img, &blobs, &filter, 1, labels, &labels_cnt);
+    t1 = now();
+    timings[STAGE_BLOB_LABELING][i] = t1 - t0;
+    blobs_sum += labels_cnt;
+
+    t0 = now();
+    jpeg_encode_image(img, &jpeg, 80, TRUE);
+    t1 = now();
+    timings[STAGE_JPEG][i] = t1 - t0;
+
+    image_switch(&gray, &prev_gray);
+    image_pyramid_switch(&pyr, &prev_pyr);
+  }
+
+  // Full pipeline on the sequence at 30 Hz
+  struct opticflow_t opticflow;
+  struct opticflow_state_t state = {0, 0, 1};
+  struct opticflow_result_t result;
+  float flow_x = 0, flow_y = 0;
+  memset(&result, 0, sizeof(result));
+  opticflow_calc_init(&opticflow, w, h);
+  for (int i = 0; i < ITERATIONS; i++) {
+    struct image_t *img = &frames[i % nb_frames];
+    img->ts.tv_sec = i / 30;
+    img->ts.tv_usec = (i % 30) * 1000000 / 30;
+    double t0 = now();
+    opticflow_calc_frame(&opticflow, &state, img, &result);
+    timings[STAGE_OPTICFLOW][i] = now() - t0;
+    flow_x += result.flow_x;
+    flow_y += result.flow_y;
+  }
+
+  printf("%-20s %9s %9s %9s %9s %10s\n", "stage", "p50 us", "p90 us", "p99 us", "max us", "fps");
+  for (int s = 0; s < NB_STAGES; s++) {
+    report(s);
+  }
+  printf("average per frame: %.1f corners, %.1f tracked, %.1f blobs, flow %.2f %.2f px\n",
+         (float)corners_sum / ITERATIONS, (float)tracked_sum / ITERATIONS, (float)blobs_sum / ITERATIONS,
+         flow_x / ITERATIONS / LK_SUBPIXEL_FACTOR, flow_y / ITERATIONS / LK_SUBPIXEL_FACTOR);
+
+  free(integral);
+  image_arena_free(&arena);
+  image_pyramid_free(&pyr);
+  image_pyramid_free(&prev_pyr);
+  image_free(&gray);
+  image_free(&prev_gray);
+  image_free(&small);
+  image_free(&jpeg);
+  image_free(&blobs);
+  for (uint16_t i = 0; i < nb_frames; i++) {
+    image_free(&frames[i]);
+  }
+  return 0;
+}
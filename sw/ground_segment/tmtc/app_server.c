@@ -67,7 +67,26 @@ char defaultIvyBus[] = "127.255.255.255:2010";
 #endif
 char* IvyBus;
 
-char ivybuffer[BUFLEN];
+// Max number of Ivy messages waiting to be sent to the clients
+#define MAXPENDING 256
+
+// Max rate (Hz) of each message per aircraft sent to the clients (0: no limit)
+int max_rate = 0;
+
+//Messages waiting to be sent, only the last one of each type per aircraft is kept if max_rate > 0
+typedef struct {
+  char msg[BUFLEN];
+  gsize len;
+} pending_msg;
+
+pending_msg PendingMsgs[MAXPENDING];
+int nb_pending = 0;
+GHashTable *PendingIndex;
+//Without rate limit, an idle callback sends the pending messages
+gboolean broadcast_pending = FALSE;
+
+//UDP socket used to send the messages to all clients
+GSocket *udpSocket = NULL;
 
 // verbose flag
 int verbose = 0;
@@ -114,6 +133,8 @@ typedef struct {
   char client_ip[MAXIPLEN];
   //Pointer for tcp connection;
   gpointer ClientTcpData;
+  //UDP destination (address of the client and udp_port)
+  GSocketAddress *UdpAddress;
 } client_data;
 
 client_data ConnectedClients[MAXCLIENT];  //Holds all status of devices
@@ -142,6 +163,10 @@ void remove_client(char* RemClientIpAd) {
         //record found clean it!!
         ConnectedClients[i].client_ip[0]='\0';
         ConnectedClients[i].used=0;
+        if (ConnectedClients[i].UdpAddress != NULL) {
+          g_object_unref(ConnectedClients[i].UdpAddress);
+          ConnectedClients[i].UdpAddress = NULL;
+        }
         if (verbose) {
           printf("App Server: Client removed from client list %s\n", RemClientIpAd);
           fflush(stdout);
@@ -176,6 +201,12 @@ void add_client(char* ClientIpAd, gpointer connection_in) {
     //record new client ip
     g_stpcpy(ConnectedClients[i].client_ip,ClientIpAd);
     ConnectedClients[i].ClientTcpData = connection_in;
+    //Resolve the udp destination once
+    GInetAddress *udpAddress = g_inet_address_new_from_string(ClientIpAd);
+    ConnectedClients[i].UdpAddress = udpAddress ? g_inet_socket_address_new(udpAddress, udp_port) : NULL;
+    if (udpAddress) {
+      g_object_unref(udpAddress);
+    }
     //
     ConnectedClients[i].used = 1;
     if (verbose) {
@@ -230,10 +261,11 @@ int get_wp_data(char* InStr, char* RetBuf) {
   if ( AcID > 0 ) {
     //create wp data string
     char WpStr[BUFLEN] = "";
+    gsize len = 0;
     int i = 1;
-    while ( strlen(DevNames[AcID].AcWp[i].Wp_Name)  > 0 ) {
+    while ( i < MAXWPNUMB && strlen(DevNames[AcID].AcWp[i].Wp_Name)  > 0 && len < BUFLEN ) {
       //Read & add wp data to return string
-      sprintf(WpStr, "%s%d,%s ", WpStr, i, DevNames[AcID].AcWp[i].Wp_Name);
+      len += snprintf(WpStr + len, BUFLEN - len, "%d,%s ", i, DevNames[AcID].AcWp[i].Wp_Name);
       i++;
     }
     sprintf(RetBuf, "AppServer WPs %d %s\n", AcID, WpStr);
@@ -258,9 +290,10 @@ int get_bl_data(char* InStr, char* RetBuf) {
   if ( AcID > 0 ) {
     //create wp data string
     char BlStr[BUFLEN] ="";
+    gsize len = 0;
     int i=1;
-    while ( strlen(DevNames[AcID].AcBl[i].Bl_Name)  > 0 ) {
-      sprintf(BlStr, "%s</n>%s", BlStr, DevNames[AcID].AcBl[i].Bl_Name);
+    while ( i < MAXWPNUMB && strlen(DevNames[AcID].AcBl[i].Bl_Name)  > 0 && len < BUFLEN ) {
+      len += snprintf(BlStr + len, BUFLEN - len, "</n>%s", DevNames[AcID].AcBl[i].Bl_Name);
       i++;
     }
     sprintf(RetBuf, "AppServer BLs %d %s\n", AcID, BlStr);
@@ -268,59 +301,125 @@ int get_bl_data(char* InStr, char* RetBuf) {
   return AcID;
 }
 
-//Bfoadcast ivy msgs to clients
+//Broadcast pending ivy msgs to clients
 void broadcast_to_clients () {
 
-  int i;
+  int i, j;
 
-  if (uTCP) {
-    //broadcast using tcp connection
-    GError *error = NULL;
+  if (nb_pending == 0) {
+    return;
+  }
 
+  if (uTCP) {
+    //broadcast using tcp connection, all pending messages in one write per client
+    static char tcpbuffer[MAXPENDING * (BUFLEN + 1)];
+    gsize len = 0;
+    for (j = 0; j < nb_pending; j++) {
+      memcpy(tcpbuffer + len, PendingMsgs[j].msg, PendingMsgs[j].len);
+      len += PendingMsgs[j].len;
+      tcpbuffer[len++] = '\n';
+    }
     for (i = 0; i < MAXCLIENT; i++) {
       if (ConnectedClients[i].used > 0) {
+        GError *error = NULL;
         GOutputStream * ostream = g_io_stream_get_output_stream (ConnectedClients[i].ClientTcpData);
-        g_output_stream_write(ostream, ivybuffer, strlen(ivybuffer), NULL, &error);
+        g_output_stream_write(ostream, tcpbuffer, len, NULL, &error);
+        if (error) {
+          g_error_free(error);
+        }
       }
-
     }
-    return;
   }
-
-  i=0;
-  for (i = 0; i < MAXCLIENT; i++) {
-    if (ConnectedClients[i].used > 0) {
-
-      //Send data
-      GInetAddress *udpAddress;
-      GSocketAddress *udpSocketAddress;
-      GSocket *udpSocket;
-
-      udpAddress = g_inet_address_new_from_string(ConnectedClients[i].client_ip);
-
-      udpSocketAddress = g_inet_socket_address_new(udpAddress, udp_port);
-
-      udpSocket = g_socket_new(G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM, 17, NULL);
-
-      if (g_socket_connect(udpSocket, udpSocketAddress, NULL, NULL) == FALSE) {
-        printf("App Server: stg wrong with socket connect\n");
-        fflush(stdout);
+  else if (udpSocket != NULL) {
+    //one datagram per message and client, sent with as few system calls as possible
+#if GLIB_CHECK_VERSION (2, 44, 0)
+    static GOutputVector vectors[MAXPENDING];
+    static GOutputMessage messages[MAXPENDING * MAXCLIENT];
+    guint nb_msgs = 0;
+    for (j = 0; j < nb_pending; j++) {
+      vectors[j].buffer = PendingMsgs[j].msg;
+      vectors[j].size = PendingMsgs[j].len;
+    }
+    for (i = 0; i < MAXCLIENT; i++) {
+      if (ConnectedClients[i].used > 0 && ConnectedClients[i].UdpAddress != NULL) {
+        for (j = 0; j < nb_pending; j++) {
+          GOutputMessage *m = &messages[nb_msgs++];
+          memset(m, 0, sizeof(GOutputMessage));
+          m->address = ConnectedClients[i].UdpAddress;
+          m->vectors = &vectors[j];
+          m->num_vectors = 1;
+        }
       }
-      if (g_socket_send(udpSocket, ivybuffer, strlen(ivybuffer) , NULL, NULL) < 0) {
+    }
+    guint sent = 0;
+    while (sent < nb_msgs) {
+      gint ret = g_socket_send_messages(udpSocket, messages + sent, nb_msgs - sent, 0, NULL, NULL);
+      if (ret <= 0) {
         printf("App Server: stg wrong with send func\n");
         fflush(stdout);
+        break;
       }
-      if (g_socket_close(udpSocket, NULL) == FALSE) {
-        printf("App Server: stg wrong with socket close\n");
-        fflush(stdout);
+      sent += ret;
+    }
+#else
+    for (i = 0; i < MAXCLIENT; i++) {
+      if (ConnectedClients[i].used > 0 && ConnectedClients[i].UdpAddress != NULL) {
+        for (j = 0; j < nb_pending; j++) {
+          if (g_socket_send_to(udpSocket, ConnectedClients[i].UdpAddress, PendingMsgs[j].msg,
+                               PendingMsgs[j].len, NULL, NULL) < 0) {
+            printf("App Server: stg wrong with send func\n");
+            fflush(stdout);
+          }
+        }
       }
-      //Unref objects
-      g_object_unref(udpAddress);
-      g_object_unref(udpSocketAddress);
-      g_object_unref(udpSocket);
     }
+#endif
   }
 
+  nb_pending = 0;
+  g_hash_table_remove_all(PendingIndex);
+}
+
+//Add an ivy msg to the pending ones, replacing the previous one of the same type if rate limited
+void queue_msg(const char *msg, const char *msg_name, const char *ac_id) {
+  int idx = -1;
+  gchar *key = NULL;
+
+  if (max_rate > 0) {
+    key = g_strconcat(msg_name, " ", ac_id, NULL);
+    gpointer value;
+    if (g_hash_table_lookup_extended(PendingIndex, key, NULL, &value)) {
+      idx = GPOINTER_TO_INT(value);
+    }
+  }
+  if (idx < 0) {
+    if (nb_pending == MAXPENDING) {
+      broadcast_to_clients();
+    }
+    idx = nb_pending++;
+    if (key) {
+      g_hash_table_insert(PendingIndex, key, GINT_TO_POINTER(idx));
+      key = NULL;
+    }
+  }
+  g_free(key);
+  PendingMsgs[idx].len = g_strlcpy(PendingMsgs[idx].msg, msg, BUFLEN);
+  if (PendingMsgs[idx].len >= BUFLEN) {
+    PendingMsgs[idx].len = BUFLEN - 1;
+  }
+}
+
+//Send the pending messages at max_rate
+gboolean broadcast_timeout(gpointer data) {
+  broadcast_to_clients();
+  return TRUE;
+}
+
+//Send the pending messages once the Ivy messages already received are queued
+gboolean broadcast_idle(gpointer data) {
+  broadcast_pending = FALSE;
+  broadcast_to_clients();
+  return FALSE;
 }
 
 //Read tcp requests of connected clients
@@ -483,12 +582,14 @@ void request_ac_config(int ac_id_req) {
 //Ivy msg function
 void Ivy_All_Msgs(IvyClientPtr app, void *user_data, int argc, char *argv[]){
 
-  //For compatibility.. This will be joined in upcoming releases..
-  if (uTCP) sprintf(ivybuffer, "%s\n", argv[0]);
-  else sprintf(ivybuffer, "%s", argv[0]);
+  //Ivy msg received, queue it for the clients
+  queue_msg(argv[0], argv[1], argv[2]);
 
-  //Ivy msg received broadcast to clients..
-  broadcast_to_clients();
+  //if not rate limited, send the messages of this burst together when the main loop is done reading them
+  if (max_rate <= 0 && !broadcast_pending) {
+    broadcast_pending = TRUE;
+    g_idle_add_full(G_PRIORITY_DEFAULT, broadcast_idle, NULL, NULL);
+  }
 
 }
 
@@ -815,6 +916,7 @@ void print_help() {
   printf("   -b <Ivy bus>\tdefault is %s\n", defaultIvyBus);
   printf("   -p <password>\tpassword for connection with control capabilities (default is %s)\n", defaultAppPass);
   printf("   -utcp \t\tUse TCP communication to send ivy messages (default: UDP )\n");
+  printf("   -r <rate>\tmax rate (Hz) of each message per aircraft, only the last one is sent (default: no limit, the messages received together are sent together)\n");
   printf("   -v\tverbose\n");
   printf("   -h --help show this help\n");
 }
@@ -862,6 +964,9 @@ int main(int argc, char **argv) {
     else if (strcmp(argv[i], "-utcp") == 0) {
       uTCP = 1;
     }
+    else if (strcmp(argv[i], "-r") == 0) {
+      max_rate = atoi(argv[++i]);
+    }
     else {
       printf("App Server: Unknown option\n");
       print_help();
@@ -877,6 +982,9 @@ int main(int argc, char **argv) {
     }else{
       printf("Server broadcast port (UDP) : %d\n", udp_port);
     }
+    if (max_rate > 0) {
+      printf("Max rate per message        : %d Hz\n", max_rate);
+    }
     printf("Control Pass                : %s\n", AppPass);
     printf("Ivy Bus                     : %s\n", IvyBus);
     fflush(stdout);
@@ -903,6 +1011,21 @@ int main(int argc, char **argv) {
   //Connect listening signal
   g_signal_connect(service, "incoming", G_CALLBACK(new_connection), NULL);
 
+  //Create the udp socket used for all clients
+  if (!uTCP) {
+    udpSocket = g_socket_new(G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, NULL);
+    if (udpSocket == NULL) {
+      printf("App Server: could not create udp socket\n");
+      fflush(stdout);
+    }
+  }
+
+  //Index of the pending messages by type and aircraft
+  PendingIndex = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  if (max_rate > 0) {
+    g_timeout_add(max_rate < 1000 ? 1000 / max_rate : 1, broadcast_timeout, NULL);
+  }
+
   //Here comes the ivy bindings
   IvyInit ("PPRZ_App_Server", "Papparazzi App Server Ready!", NULL, NULL, NULL, NULL);
 
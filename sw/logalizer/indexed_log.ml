@@ -0,0 +1,328 @@
+(*
+ * Indexed binary flight logs
+ *
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ *)
+
+open Printf
+
+let extension = ".bdata"
+let magic = "PPRZBLOG"
+let version = 1
+let header_length = 40
+let index_period = 1.
+
+(** Times are stored in 1e-4s, as in the airborne logs *)
+let ticks_of_time = fun t -> max 0 (truncate (t *. 1e4 +. 0.5))
+let time_of_ticks = fun x -> float x /. 1e4
+let index_ticks = ticks_of_time index_period
+
+type record = {
+    time : float;
+    source : int;
+    frame : string
+  }
+
+let payload_of_record = fun r -> Pprz.Transport.payload r.frame
+
+let compressed_extensions = [".gz"; ".Z"; ".bz2"; ".zip"; ".ZIP"]
+
+let name_of_data_file = fun data_file ->
+  let f =
+    List.fold_left
+      (fun f ext -> if Filename.check_suffix f ext then Filename.chop_suffix f ext else f)
+      data_file compressed_extensions in
+  let f = if Filename.check_suffix f ".data" then Filename.chop_suffix f ".data" else f in
+  f ^ extension
+
+let find = fun dir data_file ->
+  let f = Filename.concat dir (name_of_data_file data_file) in
+  if not (Sys.file_exists f) then
+    raise Not_found;
+  let data_mtime =
+    try (Unix.stat (Ocaml_tools.find_file [dir] data_file)).Unix.st_mtime with
+      Not_found -> neg_infinity in
+  if data_mtime > (Unix.stat f).Unix.st_mtime then
+    raise Not_found;
+  f
+
+
+let output_uint32 = fun o x ->
+  output_byte o (x land 0xff);
+  output_byte o ((x lsr 8) land 0xff);
+  output_byte o ((x lsr 16) land 0xff);
+  output_byte o ((x lsr 24) land 0xff)
+
+let buffer_add_uint32 = fun b x ->
+  Buffer.add_char b (Char.chr (x land 0xff));
+  Buffer.add_char b (Char.chr ((x lsr 8) land 0xff));
+  Buffer.add_char b (Char.chr ((x lsr 16) land 0xff));
+  Buffer.add_char b (Char.chr ((x lsr 24) land 0xff))
+
+let input_uint32 = fun i ->
+  let b0 = input_byte i in
+  let b1 = input_byte i in
+  let b2 = input_byte i in
+  let b3 = input_byte i in
+  b0 lor (b1 lsl 8) lor (b2 lsl 16) lor (b3 lsl 24)
+
+(** Offsets are stored on 32 bits *)
+let offset_of_pos = fun o ->
+  if o lsr 16 lsr 16 <> 0 then
+    failwith "Indexed_log: offset past 4GB";
+  o
+
+let output_header = fun o nb start end_ times_offset nb_times msgs_offset nb_msgs ->
+  output_string o magic;
+  List.iter (output_uint32 o)
+    [version; nb; start; end_; times_offset; nb_times; msgs_offset; nb_msgs]
+
+
+(** Writing *)
+
+type writer = {
+    out : out_channel;
+    mutable nb : int;
+    mutable start_time : int;
+    mutable end_time : int;
+    mutable next_index : int; (* time of the next entry of the time index *)
+    mutable nb_times : int;
+    times : Buffer.t;
+    msgs : (int * int * int, Buffer.t) Hashtbl.t (* offset lists *)
+  }
+
+let open_out = fun name ->
+  let o = open_out_bin name in
+  (* rewritten by close_out, a null time index offset marks an unfinished file *)
+  output_header o 0 0 0 0 0 0 0;
+  { out = o; nb = 0; start_time = 0; end_time = 0; next_index = 0; nb_times = 0;
+    times = Buffer.create 4096; msgs = Hashtbl.create 97 }
+
+let add = fun w time source payload ->
+  let frame = Pprz.Transport.packet payload in
+  let p = Serial.string_of_payload payload in
+  let ticks = ticks_of_time time in
+  let offset = offset_of_pos (pos_out w.out) in
+  if w.nb = 0 then
+    w.start_time <- ticks;
+  w.end_time <- max ticks w.end_time;
+
+  if w.nb = 0 || ticks >= w.next_index then begin
+    buffer_add_uint32 w.times ticks;
+    buffer_add_uint32 w.times w.nb;
+    buffer_add_uint32 w.times offset;
+    w.nb_times <- w.nb_times + 1;
+    w.next_index <- (ticks / index_ticks + 1) * index_ticks
+  end;
+
+  (* the payload starts with ac_id and msg_id *)
+  let key = (source, Char.code p.[0], Char.code p.[1]) in
+  let l =
+    try Hashtbl.find w.msgs key with
+      Not_found ->
+        let l = Buffer.create 256 in
+        Hashtbl.add w.msgs key l;
+        l in
+  buffer_add_uint32 l offset;
+
+  output_uint32 w.out ticks;
+  output_byte w.out source;
+  output_string w.out frame;
+  w.nb <- w.nb + 1
+
+let close_out = fun w ->
+  let times_offset = offset_of_pos (pos_out w.out) in
+  Buffer.output_buffer w.out w.times;
+
+  let msgs = Hashtbl.fold (fun key l r -> (key, l) :: r) w.msgs [] in
+  let msgs = List.sort (fun (a, _) (b, _) -> compare a b) msgs in
+  let msgs =
+    List.map
+      (fun (key, l) ->
+        let offset = offset_of_pos (pos_out w.out) in
+        Buffer.output_buffer w.out l;
+        (key, Buffer.length l / 4, offset))
+      msgs in
+
+  let msgs_offset = offset_of_pos (pos_out w.out) in
+  List.iter
+    (fun ((source, ac_id, msg_id), nb, offset) ->
+      output_byte w.out source;
+      output_byte w.out ac_id;
+      output_byte w.out msg_id;
+      output_byte w.out 0;
+      output_uint32 w.out nb;
+      output_uint32 w.out offset)
+    msgs;
+
+  seek_out w.out 0;
+  output_header w.out w.nb w.start_time w.end_time times_offset w.nb_times msgs_offset (List.length msgs);
+  Pervasives.close_out w.out
+
+
+(** Reading *)
+
+type t = {
+    chan : in_channel;
+    nb : int;
+    start_time : float;
+    end_time : float;
+    index : (int * int * int) array; (* time, record number, offset *)
+    messages : (int * int * int, int * int) Hashtbl.t; (* nb, offset of the list *)
+    mutable next : int (* number of the next record *)
+  }
+
+let open_in = fun name ->
+  let i = open_in_bin name in
+  try
+    let m = String.create (String.length magic) in
+    really_input i m 0 (String.length magic);
+    if m <> magic then
+      failwith (sprintf "Indexed_log: %s is not an indexed log" name);
+    let v = input_uint32 i in
+    if v <> version then
+      failwith (sprintf "Indexed_log: unsupported version %d in %s" v name);
+    let nb = input_uint32 i in
+    let start_time = input_uint32 i in
+    let end_time = input_uint32 i in
+    let times_offset = input_uint32 i in
+    let nb_times = input_uint32 i in
+    let msgs_offset = input_uint32 i in
+    let nb_msgs = input_uint32 i in
+    if times_offset = 0 then
+      failwith (sprintf "Indexed_log: %s was not closed" name);
+
+    seek_in i times_offset;
+    let index =
+      Array.init nb_times
+        (fun _ ->
+          let t = input_uint32 i in
+          let r = input_uint32 i in
+          let o = input_uint32 i in
+          (t, r, o)) in
+
+    seek_in i msgs_offset;
+    let messages = Hashtbl.create 97 in
+    for k = 1 to nb_msgs do
+      let source = input_byte i in
+      let ac_id = input_byte i in
+      let msg_id = input_byte i in
+      let _padding = input_byte i in
+      let n = input_uint32 i in
+      let o = input_uint32 i in
+      Hashtbl.add messages (source, ac_id, msg_id) (n, o)
+    done;
+
+    seek_in i header_length;
+    { chan = i; nb = nb; start_time = time_of_ticks start_time; end_time = time_of_ticks end_time;
+      index = index; messages = messages; next = 0 }
+  with
+    End_of_file ->
+      Pervasives.close_in i;
+      failwith (sprintf "Indexed_log: %s is truncated" name)
+  | exc ->
+      Pervasives.close_in i;
+      raise exc
+
+let close_in = fun log -> Pervasives.close_in log.chan
+
+let find_open = fun dir data_file ->
+  match (try Some (find dir data_file) with Not_found -> None) with
+    None -> None
+  | Some f ->
+      try Some (open_in f) with
+        Failure msg ->
+          prerr_endline msg;
+          None
+
+let nb_records = fun log -> log.nb
+
+let bounds = fun log -> (log.start_time, log.end_time)
+
+let read_record = fun i ->
+  let ticks = input_uint32 i in
+  let source = input_byte i in
+  let stx = input_char i in
+  let length = input_byte i in
+  if length < 4 then
+    failwith "Indexed_log: corrupted record";
+  let frame = String.create length in
+  frame.[0] <- stx;
+  frame.[1] <- Char.chr length;
+  really_input i frame 2 (length - 2);
+  { time = time_of_ticks ticks; source = source; frame = frame }
+
+let read = fun log ->
+  if log.next >= log.nb then
+    raise End_of_file;
+  let r = read_record log.chan in
+  log.next <- log.next + 1;
+  r
+
+let seek_time = fun log t ->
+  let ticks = ticks_of_time t in
+  let n = Array.length log.index in
+  let time_of_entry = fun k -> let (t, _, _) = log.index.(k) in t in
+  (* Last entry at or before t, or the first one *)
+  let rec loop = fun a b ->
+    if b - a <= 1 then a else
+    let c = (a + b) / 2 in
+    if time_of_entry c <= ticks then loop c b else loop a c in
+  if n = 0 then
+    log.next <- log.nb
+  else begin
+    let (_, r, o) = log.index.(loop 0 n) in
+    seek_in log.chan o;
+    log.next <- r;
+    (* Skip the records of the period before t *)
+    let rec skip = fun () ->
+      if log.next < log.nb then begin
+        let pos = pos_in log.chan in
+        if input_uint32 log.chan < ticks then begin
+          (* time, source, stx then the length of the frame *)
+          seek_in log.chan (pos + 6);
+          let length = input_byte log.chan in
+          seek_in log.chan (pos + 5 + length);
+          log.next <- log.next + 1;
+          skip ()
+        end else
+          seek_in log.chan pos
+      end in
+    skip ()
+  end
+
+let messages = fun log ->
+  let l = Hashtbl.fold (fun (source, ac_id, msg_id) (n, _) r -> (source, ac_id, msg_id, n) :: r) log.messages [] in
+  List.sort compare l
+
+let iter_message = fun log source ac_id msg_id f ->
+  match (try Some (Hashtbl.find log.messages (source, ac_id, msg_id)) with Not_found -> None) with
+    None -> ()
+  | Some (n, o) ->
+      let pos = pos_in log.chan in
+      seek_in log.chan o;
+      let offsets = Array.init n (fun _ -> input_uint32 log.chan) in
+      Array.iter
+        (fun o ->
+          seek_in log.chan o;
+          f (read_record log.chan))
+        offsets;
+      seek_in log.chan pos
@@ -0,0 +1,108 @@
+(*
+ * Indexed binary flight logs
+ *
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ *)
+
+(** Binary version of the .data files, with a time and a message index.
+
+    Integers are little endian, offsets are in bytes from the start of the
+    file (so a log is limited to 4GB):
+    - header (40 bytes): "PPRZBLOG", version, number of records, start and
+    end times, offset and number of entries of the time index, offset and
+    number of entries of the message index (uint32)
+    - records: time (uint32, 1e-4s), source (uint8, 0 for telemetry,
+    1 for datalink as in {!Logpprz}) and pprz frame (see {!Pprz.Transport})
+    - time index: time, record number and offset (uint32) of the first
+    record of every [index_period]
+    - offset lists: offsets (uint32) of the records of each message
+    - message index: source, ac_id, msg_id, padding (uint8), number of
+    records and offset of the list (uint32) of each message
+*)
+
+val extension : string
+(** ".bdata" *)
+
+val index_period : float
+(** Time between two entries of the time index, in seconds *)
+
+type record = {
+    time : float; (** seconds *)
+    source : int; (** 0 for telemetry, 1 for datalink *)
+    frame : string (** pprz frame *)
+  }
+
+val payload_of_record : record -> Serial.payload
+(** [payload_of_record r] Returns the payload of the frame (ac_id, msg_id
+    and fields) *)
+
+val name_of_data_file : string -> string
+(** [name_of_data_file f] Returns the name of the indexed log of the
+    (possibly compressed) .data file [f] *)
+
+val find : string -> string -> string
+(** [find dir data_file] Returns the indexed log of [data_file] in [dir].
+    Raises [Not_found] if there is none or if it is older than the .data *)
+
+type writer
+
+val open_out : string -> writer
+
+val add : writer -> float -> int -> Serial.payload -> unit
+(** [add w time source payload] Appends a message. Messages are expected
+    in time order. May raise [Invalid_argument] if the payload is too long
+    for a pprz frame, raises [Failure] once the file is larger than 4GB *)
+
+val close_out : writer -> unit
+(** Writes the indexes and closes the file. Raises [Failure] if the indexes
+    would start past 4GB *)
+
+type t
+
+val open_in : string -> t
+(** Reads the header and the indexes, the records are read on demand.
+    Raises [Failure] if the file is not a complete indexed log *)
+
+val close_in : t -> unit
+
+val find_open : string -> string -> t option
+(** [find_open dir data_file] Opens the indexed log of [data_file] in [dir].
+    Returns [None] if there is none, if it is older than the .data or if it
+    can't be read (e.g. an interrupted conversion), the .data is then used *)
+
+val nb_records : t -> int
+
+val bounds : t -> float * float
+(** Times of the first and of the last record *)
+
+val seek_time : t -> float -> unit
+(** [seek_time log t] Moves to the first record at or after [t] *)
+
+val read : t -> record
+(** Reads the next record. Raises [End_of_file] after the last one *)
+
+val messages : t -> (int * int * int * int) list
+(** Returns the (source, ac_id, msg_id, number of records) of the messages
+    of the log *)
+
+val iter_message : t -> int -> int -> int -> (record -> unit) -> unit
+(** [iter_message log source ac_id msg_id f] Applies [f] to the records of
+    a message, in time order. The current position is kept *)
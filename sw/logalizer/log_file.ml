@@ -32,7 +32,7 @@ let log_suffix = fun s ->
   let n = String.length s in
   n > 4 && String.sub s (n-4) 4 = ".log"
 
-let length_data = fun data_file ->
+let length_text_data = fun data_file ->
   let f = Ocaml_tools.open_compress data_file in
   let line = ref "" in
   try
@@ -42,6 +42,16 @@ let length_data = fun data_file ->
       let i = String.index !line '.' in
       int_of_string (String.sub !line 0 i)
 
+(** The end time is in the header of the indexed log if there is one *)
+let length_data = fun data_file ->
+  let dir = Filename.dirname data_file in
+  match Indexed_log.find_open dir (Filename.basename data_file) with
+    Some l ->
+      let (_, end_) = Indexed_log.bounds l in
+      Indexed_log.close_in l;
+      truncate end_
+  | None -> length_text_data data_file
+
 let chooser = fun ~callback () ->
   let dialog = GWindow.file_chooser_dialog ~action:`OPEN ~title:"Open Log" () in
   ignore (dialog#set_current_folder logs_dir);
@@ -0,0 +1,241 @@
+(*
+ * Conversion between .data files and indexed binary logs
+ *
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ *)
+
+open Printf
+
+let (//) = Filename.concat
+
+(* In the old days, telemetry class was named telemetry_ap ... *)
+let telemetry_class = fun protocol ->
+  let select = fun x -> Xml.attrib x "name" = "telemetry_ap" in
+  try
+    ignore (try ExtXml.child protocol ~select "msg_class" with Not_found -> ExtXml.child protocol ~select "class");
+    "telemetry_ap"
+  with
+    Not_found -> "telemetry"
+
+(** Returns the number of converted messages and of errors *)
+let bdata_of_data = fun protocol data_file bdata_file ->
+  let module Tm_Pprz = Pprz.MessagesOfXml(struct let xml = protocol let name = telemetry_class protocol end) in
+  let module Dl_Pprz = Pprz.MessagesOfXml(struct let xml = protocol let name = "datalink" end) in
+  let f = Ocaml_tools.open_compress data_file in
+  (* written aside and renamed once complete, so readers never find an
+     unfinished indexed log *)
+  let tmp_file = bdata_file ^ ".tmp" in
+  let w = Indexed_log.open_out tmp_file in
+  let nb = ref 0 and nb_errors = ref 0 in
+  begin
+    try
+      begin
+        try
+          while true do
+            let l = input_line f in
+            let message =
+              try
+                Scanf.sscanf l "%f %d %[^\n]"
+                  (fun t ac_id m ->
+                    try
+                      let msg_id, vs = Tm_Pprz.values_of_string m in
+                      Some (t, 0, Tm_Pprz.payload_of_values msg_id ac_id vs)
+                    with
+                      Pprz.Unknown_msg_name _ ->
+                        let msg_id, vs = Dl_Pprz.values_of_string m in
+                        Some (t, 1, Dl_Pprz.payload_of_values msg_id ac_id vs))
+              with
+                _ -> None in
+            (* a log too large for the offsets is an error, not a skipped line *)
+            match message with
+              Some (t, source, payload) ->
+                begin
+                  try
+                    Indexed_log.add w t source payload;
+                    incr nb
+                  with
+                    Invalid_argument _ -> incr nb_errors
+                end
+            | None -> incr nb_errors
+          done
+        with
+          End_of_file -> ()
+      end;
+      Indexed_log.close_out w
+    with
+      exc ->
+        (* the unfinished file is removed, its channel is left to the exit *)
+        close_in f;
+        Sys.remove tmp_file;
+        raise exc
+  end;
+  close_in f;
+  Sys.rename tmp_file bdata_file;
+  (!nb, !nb_errors)
+
+let data_of_bdata = fun protocol bdata_file data_file ->
+  let module Tm_Pprz = Pprz.MessagesOfXml(struct let xml = protocol let name = telemetry_class protocol end) in
+  let module Dl_Pprz = Pprz.MessagesOfXml(struct let xml = protocol let name = "datalink" end) in
+  let log = Indexed_log.open_in bdata_file in
+  let f = open_out data_file in
+  let nb = ref 0 and nb_errors = ref 0 in
+  begin
+    try
+      while true do
+        let r = Indexed_log.read log in
+        try
+          let payload = Indexed_log.payload_of_record r in
+          let ac_id, s =
+            if r.Indexed_log.source = 0 then
+              let msg_id, ac_id, vs = Tm_Pprz.values_of_payload payload in
+              ac_id, Tm_Pprz.string_of_message (Tm_Pprz.message_of_id msg_id) vs
+            else
+              let msg_id, ac_id, vs = Dl_Pprz.values_of_payload payload in
+              ac_id, Dl_Pprz.string_of_message (Dl_Pprz.message_of_id msg_id) vs in
+          fprintf f "%.4f %d %s\n" r.Indexed_log.time ac_id s;
+          incr nb
+        with
+          _ -> incr nb_errors
+      done
+    with
+      End_of_file -> ()
+  end;
+  Indexed_log.close_in log;
+  close_out f;
+  (!nb, !nb_errors)
+
+(** Checks the round trip of the messages of the .data through the indexed
+    log: the stored frames must have the payloads of the .data lines, and
+    the lines written back by [data_of_bdata] must give the same payloads.
+    Returns the number of checked messages and of differences *)
+let check = fun protocol data_file bdata_file ->
+  let module Tm_Pprz = Pprz.MessagesOfXml(struct let xml = protocol let name = telemetry_class protocol end) in
+  let module Dl_Pprz = Pprz.MessagesOfXml(struct let xml = protocol let name = "datalink" end) in
+  (* same decoding as bdata_of_data, lines it skips give None *)
+  let payload_of_line = fun l ->
+    try
+      Scanf.sscanf l "%f %d %[^\n]"
+        (fun t ac_id m ->
+          let (source, payload) =
+            try
+              let msg_id, vs = Tm_Pprz.values_of_string m in
+              0, Tm_Pprz.payload_of_values msg_id ac_id vs
+            with
+              Pprz.Unknown_msg_name _ ->
+                let msg_id, vs = Dl_Pprz.values_of_string m in
+                1, Dl_Pprz.payload_of_values msg_id ac_id vs in
+          ignore (Pprz.Transport.packet payload);
+          Some (t, source, Serial.string_of_payload payload))
+    with
+      _ -> None in
+  let line_of_record = fun r ->
+    let payload = Indexed_log.payload_of_record r in
+    let ac_id, s =
+      if r.Indexed_log.source = 0 then
+        let msg_id, ac_id, vs = Tm_Pprz.values_of_payload payload in
+        ac_id, Tm_Pprz.string_of_message (Tm_Pprz.message_of_id msg_id) vs
+      else
+        let msg_id, ac_id, vs = Dl_Pprz.values_of_payload payload in
+        ac_id, Dl_Pprz.string_of_message (Dl_Pprz.message_of_id msg_id) vs in
+    sprintf "%.4f %d %s" r.Indexed_log.time ac_id s in
+  let f = Ocaml_tools.open_compress data_file in
+  let log = Indexed_log.open_in bdata_file in
+  let nb = ref 0 and nb_diffs = ref 0 in
+  let diff = fun l reason ->
+    incr nb_diffs;
+    fprintf stderr "%s: %s\n" reason l in
+  begin
+    try
+      while true do
+        let l = input_line f in
+        match payload_of_line l with
+          None -> ()
+        | Some (t, source, payload) ->
+            incr nb;
+            match (try Some (Indexed_log.read log) with End_of_file -> None) with
+              None -> diff l "missing in the indexed log"
+            | Some r ->
+                let stored = Serial.string_of_payload (Indexed_log.payload_of_record r) in
+                if abs_float (r.Indexed_log.time -. t) > 0.6e-4 then
+                  diff l "different time"
+                else if r.Indexed_log.source <> source || stored <> payload then
+                  diff l "different message"
+                else
+                  match (try payload_of_line (line_of_record r) with _ -> None) with
+                    Some (_, _, p) when p = payload -> ()
+                  | _ -> diff l "different message written back"
+      done
+    with
+      End_of_file -> ()
+  end;
+  if Indexed_log.nb_records log > !nb then
+    diff bdata_file "more records than messages in the .data";
+  close_in f;
+  Indexed_log.close_in log;
+  (!nb, !nb_diffs)
+
+
+let () =
+  let to_data = ref false
+  and check_only = ref false
+  and output = ref ""
+  and log_file = ref "" in
+  let options =
+    [ "-data", Arg.Set to_data, "Convert the indexed log back to a .data file (<log>.converted.data by default)";
+      "-o", Arg.Set_string output, "<file> Output file";
+      "-check", Arg.Set check_only, "Check the indexed log (or the -o file) against the .data, both ways" ] in
+  let usage = sprintf "Usage: %s [-data | -check] [-o <file>] <log file>\nConverts the .data of a .log to an indexed binary log (%s)" Sys.argv.(0) Indexed_log.extension in
+  Arg.parse options (fun x -> log_file := x) usage;
+  if !log_file = "" then begin
+    Arg.usage options usage;
+    exit 1
+  end;
+
+  let xml = Xml.parse_file !log_file in
+  let dir = Filename.dirname !log_file in
+  let data_file = ExtXml.attrib xml "data_file" in
+  let protocol = ExtXml.child xml "protocol" in
+  let bdata_file = dir // Indexed_log.name_of_data_file data_file in
+
+  if !check_only then begin
+    let bdata_file = if !output = "" then bdata_file else !output in
+    let (nb, nb_diffs) = check protocol (Ocaml_tools.find_file [dir] data_file) bdata_file in
+    fprintf stderr "%s: %d messages checked, %d differences\n%!" bdata_file nb nb_diffs;
+    exit (if nb_diffs = 0 then 0 else 1)
+  end;
+
+  let (input, default_output, convert) =
+    if !to_data then
+      (bdata_file, Filename.chop_suffix bdata_file Indexed_log.extension ^ ".converted.data", data_of_bdata)
+    else
+      (Ocaml_tools.find_file [dir] data_file, bdata_file, bdata_of_data) in
+  let output = if !output = "" then default_output else !output in
+  (* The indexed log is rebuilt from the .data, other files are never
+     overwritten (the .data may be compressed, indexed times are rounded) *)
+  if Sys.file_exists output && (!to_data || output <> bdata_file) then begin
+    fprintf stderr "%s already exists, not overwritten\n" output;
+    exit 1
+  end;
+  let (nb, nb_errors) = convert protocol input output in
+  fprintf stderr "%s: %d messages" output nb;
+  if nb_errors > 0 then
+    fprintf stderr ", %d skipped" nb_errors;
+  fprintf stderr "\n%!"
@@ -692,86 +692,112 @@ let load_log = fun ?export ?factor (plot:plot) (menubar:GMenu.menu_shell GMenu.f
         with Not_found ->
           fprintf stderr "File '%s' not found\n%!" data_file;
 	  failwith "Data file not found" in
-  let f = Ocaml_tools.open_compress f in
   let acs = Hashtbl.create 3 in (* indexed by A/C *)
-  try
-    while true do
-      let l = input_line f in
-      try
-	Scanf.sscanf l "%f %s %[^\n]"
-	  (fun t ac m ->
-	    if not (Hashtbl.mem acs ac) then
-	      Hashtbl.add acs ac (Hashtbl.create 97, ref []);
-	    let msgs, raw_msgs = Hashtbl.find acs ac in
-
-	    (*Elements of [acs] are assoc lists of [fields] indexed by msg id*)
-	    let msg_id, vs = P.values_of_string m in
-	    if not (Hashtbl.mem msgs msg_id) then
-	      Hashtbl.add msgs msg_id (Hashtbl.create 97);
-	    let fields = Hashtbl.find msgs msg_id in
-
-	    (* Elements of [fields] are values indexed by field name *)
-	    List.iter
-	      (fun (f, value) ->
-		match value with
-		  Pprz.Array array ->
-		    Array.iteri
-		      (fun i scalar ->
-			let f = sprintf "%s[%d]" f i in
-			Hashtbl.add fields f (t, scalar))
-		      array
-		| scalar ->
-		    Hashtbl.add fields f (t, scalar))
-	      vs;
-
-	    let msg_name = (P.message_of_id msg_id).Pprz.name in
-	    raw_msgs := (t, msg_name, vs) :: !raw_msgs
-	  )
-      with
-	exc ->
-	  if !verbose then
-	    prerr_endline (Printexc.to_string exc)
-    done
-  with
-    End_of_file ->
-      close_in f;
-      (* Compile the data to ease the menu building *)
-      Hashtbl.iter (* For all A/Cs *)
-	(fun ac (msgs, raw_msgs) ->
-	  let raw_msgs = List.rev !raw_msgs in
-	  let menu_name = sprintf "%s:%s" (Filename.chop_extension (Filename.basename xml_file)) ac in
-
-	  (* First sort by message id *)
-	  let l = ref [] in
-	  Hashtbl.iter (fun msg fields -> l := (P.message_of_id msg, fields):: !l) msgs;
-	  let msgs = List.sort (fun (a,_) (b,_) -> compare a b) !l in
-
-	  let msgs =
-	    List.map (fun (msg, fields) ->
-	      let l = ref [] in
-	      Hashtbl.iter
-		(fun f v -> if not (List.mem f !l) then l := f :: !l)
-		fields;
-	      let sorted_fields = List.sort compare !l in
-
-	      let field_values_assoc =
-		List.map
-		  (fun f ->
-		    let values = Hashtbl.find_all fields f in
-		    let values = List.map (fun (t, v) -> (t, pprz_float v)) values in
-		    let values = Array.of_list values in
-		    Array.sort compare values;
-		    (f, values))
-		  sorted_fields in
-	      (msg, field_values_assoc))
-	      msgs in
-
-	  (* Store data for other windows *)
-	  logs_menus :=  !logs_menus @ [(ac, menu_name, (msgs, raw_msgs), protocol)];
-
-	  add_ac_submenu ?export protocol ?factor plot menubar curves_fact ac menu_name msgs raw_msgs;
-	)
-	acs
+  let add_msg = fun t ac msg_id vs ->
+    if not (Hashtbl.mem acs ac) then
+      Hashtbl.add acs ac (Hashtbl.create 97, ref []);
+    let msgs, raw_msgs = Hashtbl.find acs ac in
+
+    (*Elements of [acs] are assoc lists of [fields] indexed by msg id*)
+    if not (Hashtbl.mem msgs msg_id) then
+      Hashtbl.add msgs msg_id (Hashtbl.create 97);
+    let fields = Hashtbl.find msgs msg_id in
+
+    (* Elements of [fields] are values indexed by field name *)
+    List.iter
+      (fun (f, value) ->
+	match value with
+	  Pprz.Array array ->
+	    Array.iteri
+	      (fun i scalar ->
+		let f = sprintf "%s[%d]" f i in
+		Hashtbl.add fields f (t, scalar))
+	      array
+	| scalar ->
+	    Hashtbl.add fields f (t, scalar))
+      vs;
+
+    let msg_name = (P.message_of_id msg_id).Pprz.name in
+    raw_msgs := (t, msg_name, vs) :: !raw_msgs in
+
+  (* Decode the binary messages of the indexed log if there is one *)
+  begin
+    match Indexed_log.find_open (Filename.dirname f) (Filename.basename f) with
+      Some l ->
+	begin
+	  try
+	    while true do
+	      let r = Indexed_log.read l in
+	      if r.Indexed_log.source = 0 then
+		try
+		  let msg_id, ac_id, vs = P.values_of_payload (Indexed_log.payload_of_record r) in
+		  add_msg r.Indexed_log.time (string_of_int ac_id) msg_id vs
+		with
+		  exc ->
+		    if !verbose then
+		      prerr_endline (Printexc.to_string exc)
+	    done
+	  with
+	    End_of_file -> Indexed_log.close_in l
+	end
+    | None ->
+	let f = Ocaml_tools.open_compress f in
+	begin
+	  try
+	    while true do
+	      let l = input_line f in
+	      try
+		Scanf.sscanf l "%f %s %[^\n]"
+		  (fun t ac m ->
+		    let msg_id, vs = P.values_of_string m in
+		    add_msg t ac msg_id vs)
+	      with
+		exc ->
+		  if !verbose then
+		    prerr_endline (Printexc.to_string exc)
+	    done
+	  with
+	    End_of_file -> close_in f
+	end
+  end;
+
+  (* Compile the data to ease the menu building *)
+  Hashtbl.iter (* For all A/Cs *)
+    (fun ac (msgs, raw_msgs) ->
+      let raw_msgs = List.rev !raw_msgs in
+      let menu_name = sprintf "%s:%s" (Filename.chop_extension (Filename.basename xml_file)) ac in
+
+      (* First sort by message id *)
+      let l = ref [] in
+      Hashtbl.iter (fun msg fields -> l := (P.message_of_id msg, fields):: !l) msgs;
+      let msgs = List.sort (fun (a,_) (b,_) -> compare a b) !l in
+
+      let msgs =
+        List.map (fun (msg, fields) ->
+          let l = ref [] in
+          Hashtbl.iter
+            (fun f v -> if not (List.mem f !l) then l := f :: !l)
+            fields;
+          let sorted_fields = List.sort compare !l in
+
+          let field_values_assoc =
+            List.map
+              (fun f ->
+                let values = Hashtbl.find_all fields f in
+                let values = List.map (fun (t, v) -> (t, pprz_float v)) values in
+                let values = Array.of_list values in
+                Array.sort compare values;
+                (f, values))
+              sorted_fields in
+          (msg, field_values_assoc))
+          msgs in
+
+      (* Store data for other windows *)
+      logs_menus :=  !logs_menus @ [(ac, menu_name, (msgs, raw_msgs), protocol)];
+
+      add_ac_submenu ?export protocol ?factor plot menubar curves_fact ac menu_name msgs raw_msgs;
+    )
+    acs
 
 
 
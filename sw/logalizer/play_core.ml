@@ -32,6 +32,9 @@ let replay_dir = Env.paparazzi_home // "var" // "replay"
 let dump_fp = Env.paparazzi_src // "sw" // "tools" // "generators" // "gen_flight_plan.out -dump"
 
 let log = ref [||]
+let indexed_log = ref None
+(* (ac_id, message) of a telemetry payload, with the protocol of the log *)
+let string_of_payload = ref (fun _ -> failwith "string_of_payload")
 
 let write_xml = fun f xml ->
   let d = Filename.dirname f in
@@ -88,18 +91,35 @@ let store_messages = fun protocol ->
 let time_of = fun (t, _, _) -> t
 
 let get_log_bounds = fun () ->
-  let start = time_of !log.(0) in
-  let end_ = time_of !log.(Array.length !log - 1) in
-  (start, end_)
-
-
-
-let load_log = fun xml_file ->
-  let xml = Xml.parse_file xml_file in
-  let data_file =  ExtXml.attrib xml "data_file" in
-
-  let f = Ocaml_tools.find_file [Filename.dirname xml_file] data_file in
-  let f = Ocaml_tools.open_compress f in
+  match !indexed_log with
+    Some l -> Indexed_log.bounds l
+  | None ->
+      let start = time_of !log.(0) in
+      let end_ = time_of !log.(Array.length !log - 1) in
+      (start, end_)
+
+
+let load_indexed_log = fun xml l ->
+  let protocol = ExtXml.child xml "protocol" in
+  let module P = Pprz.MessagesOfXml(struct let xml = protocol let name = "telemetry" end) in
+  string_of_payload :=
+    (fun payload ->
+      let msg_id, ac_id, vs = P.values_of_payload payload in
+      ac_id, P.string_of_message (P.message_of_id msg_id) vs);
+  let acs =
+    List.fold_left
+      (fun r (source, ac_id, _, _) ->
+        let ac = string_of_int ac_id in
+        if source = 0 && not (List.mem ac r) then ac :: r else r)
+      [] (Indexed_log.messages l) in
+  indexed_log := Some l;
+  log := [||];
+  store_conf (ExtXml.child xml "conf") acs;
+  store_messages protocol
+
+
+let load_data_log = fun xml data_file ->
+  let f = Ocaml_tools.open_compress data_file in
   let lines = ref [] in
   let acs = ref [] in
   try
@@ -122,6 +142,22 @@ let load_log = fun xml_file ->
       store_messages (ExtXml.child xml "protocol")
 
 
+let load_log = fun xml_file ->
+  let xml = Xml.parse_file xml_file in
+  let data_file =  ExtXml.attrib xml "data_file" in
+
+  begin match !indexed_log with
+    Some l -> Indexed_log.close_in l; indexed_log := None
+  | None -> ()
+  end;
+
+  (* Records are read on demand from the indexed log if there is one *)
+  let dir = Filename.dirname xml_file in
+  match Indexed_log.find_open dir data_file with
+    Some l -> load_indexed_log xml l
+  | None -> load_data_log xml (Ocaml_tools.find_file [dir] data_file)
+
+
 let timer = ref None
 let was_running = ref false
 
@@ -180,10 +216,50 @@ let run = fun serial_port log adj i0 speed no_gui ->
   loop i0
 
 
+let read_next = fun l ->
+  try Some (Indexed_log.read l) with End_of_file -> None
+
+let run_indexed = fun serial_port l adj speed no_gui ->
+  let rec loop = fun r ->
+    let t = r.Indexed_log.time in
+    (* only the telemetry messages, as in the .data *)
+    if r.Indexed_log.source = 0 then begin
+      try
+        let (ac_id, m) = !string_of_payload (Indexed_log.payload_of_record r) in
+        Ivy.send (Printf.sprintf "replay%d %s" ac_id m);
+        Ivy.send (Printf.sprintf "time%d %f" ac_id t);
+        begin
+          match serial_port with
+            None -> ()
+          | Some channel ->
+              (* the frame is sent as it was stored *)
+              Debug.call 'o' (fun f -> fprintf f "%s\n" (Debug.xprint r.Indexed_log.frame));
+              fprintf channel "%s%!" r.Indexed_log.frame
+        end
+      with _ -> ()
+    end;
+    adj#set_value t;
+    match read_next l with
+      Some next ->
+        let dt = next.Indexed_log.time -. t in
+        timer := Some (GMain.Timeout.add (truncate (1000. *. dt /. speed#value)) (fun () -> loop next;false))
+    | None ->
+        if no_gui then exit 0
+  in
+  match read_next l with
+    Some r -> loop r
+  | None -> if no_gui then exit 0
+
+
 let play = fun ?(no_gui=false) serial_port adj speed ->
   stop ();
-  if Array.length !log > 1 then
-    run serial_port !log adj (index_of_time !log adj#value) speed no_gui
+  match !indexed_log with
+    Some l ->
+      Indexed_log.seek_time l adj#value;
+      run_indexed serial_port l adj speed no_gui
+  | None ->
+      if Array.length !log > 1 then
+        run serial_port !log adj (index_of_time !log adj#value) speed no_gui
 
 
 let init = fun () ->
@@ -4,6 +4,7 @@
 #include "generated/airframe.h"
 
 #include "nps_radio_control.h"
+#include "math/pprz_geodetic_double.h"
 
 /**
  * Number of commands sent to the FDM of NPS.
@@ -32,6 +33,19 @@ struct NpsAutopilot {
 
 extern struct NpsAutopilot autopilot;
 
+/**
+ * Setpoints of the guidance and navigation, in the frame of the fdm.
+ * Only the flagged parts are tracked in the current modes.
+ */
+struct NpsSetpoint {
+  struct NedCoor_d pos;   ///< position setpoint in the ltpprz frame, in m
+  double heading;         ///< heading setpoint in rad, course over ground if course is set
+  bool_t h_valid;         ///< horizontal position setpoint is tracked
+  bool_t v_valid;         ///< vertical position setpoint is tracked
+  bool_t heading_valid;   ///< heading setpoint is tracked
+  bool_t course;          ///< heading is a course over ground (fixedwing)
+};
+
 extern bool_t nps_bypass_ahrs;
 extern bool_t nps_bypass_ins;
 extern void sim_overwrite_ahrs(void);
@@ -40,6 +54,7 @@ extern void sim_overwrite_ins(void);
 extern void nps_autopilot_init(enum NpsRadioControlType type, int num_script, char *js_dev);
 extern void nps_autopilot_run_step(double time);
 extern void nps_autopilot_run_systime_step(void);
+extern void nps_autopilot_get_setpoint(struct NpsSetpoint *sp);
 
 
 #endif /* NPS_AUTOPILOT_H */
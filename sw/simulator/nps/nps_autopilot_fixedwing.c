@@ -51,6 +51,8 @@
 
 // for launch
 #include "firmwares/fixedwing/autopilot.h"
+#include "firmwares/fixedwing/stabilization/stabilization_attitude.h"
+#include CTRL_TYPE_H
 
 // for datalink_time hack
 #include "subsystems/datalink/datalink.h"
@@ -186,6 +188,23 @@ void nps_autopilot_run_step(double time)
   }
 }
 
+/**
+ * Altitude and course setpoints of the fixedwing control loops.
+ * The navigation gives no position setpoint to track, only the altitude,
+ * expressed here in the fdm frame from the true altitude above MSL.
+ */
+void nps_autopilot_get_setpoint(struct NpsSetpoint *sp)
+{
+  sp->h_valid = FALSE;
+  sp->v_valid = (v_ctl_mode == V_CTL_MODE_AUTO_ALT);
+  sp->heading_valid = (lateral_mode >= LATERAL_MODE_COURSE);
+  sp->course = TRUE;
+  sp->pos.x = fdm.ltpprz_pos.x;
+  sp->pos.y = fdm.ltpprz_pos.y;
+  sp->pos.z = fdm.ltpprz_pos.z + (fdm.hmsl - v_ctl_altitude_setpoint);
+  sp->heading = h_ctl_course_setpoint;
+}
+
 void sim_overwrite_ahrs(void)
 {
 
@@ -37,6 +37,10 @@
 
 #include "subsystems/actuators/motor_mixing.h"
 
+#include "firmwares/rotorcraft/guidance/guidance_h.h"
+#include "firmwares/rotorcraft/guidance/guidance_v.h"
+#include "firmwares/rotorcraft/navigation.h"
+
 #include "subsystems/abi.h"
 
 #include "messages.h"
@@ -151,6 +155,25 @@ void nps_autopilot_run_step(double time)
 }
 
 
+/**
+ * Position and heading setpoints of the rotorcraft guidance, tracked in
+ * HOVER and NAV modes (position setpoints only, not the attitude ones).
+ */
+void nps_autopilot_get_setpoint(struct NpsSetpoint *sp)
+{
+  bool_t nav_pos = (guidance_h.mode == GUIDANCE_H_MODE_NAV && horizontal_mode != HORIZONTAL_MODE_ATTITUDE);
+
+  sp->h_valid = (guidance_h.mode == GUIDANCE_H_MODE_HOVER || nav_pos);
+  sp->v_valid = (guidance_v_mode == GUIDANCE_V_MODE_HOVER ||
+                 (guidance_v_mode == GUIDANCE_V_MODE_NAV && vertical_mode == VERTICAL_MODE_ALT));
+  sp->heading_valid = nav_pos;
+  sp->course = FALSE;
+  sp->pos.x = POS_FLOAT_OF_BFP(guidance_h.sp.pos.x);
+  sp->pos.y = POS_FLOAT_OF_BFP(guidance_h.sp.pos.y);
+  sp->pos.z = POS_FLOAT_OF_BFP(guidance_v_z_sp);
+  sp->heading = ANGLE_FLOAT_OF_BFP(guidance_h.sp.heading);
+}
+
 void sim_overwrite_ahrs(void)
 {
 
@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <Ivy/ivy.h>
 #include <Ivy/ivyglibloop.h>
 
@@ -125,6 +126,8 @@ static void on_WORLD_ENV(IvyClientPtr app __attribute__((unused)),
 #include "generated/settings.h"
 #include "dl_protocol.h"
 #include "subsystems/datalink/downlink.h"
+#include "subsystems/datalink/ivy_transport.h"
+#include "subsystems/datalink/ivy_print.h"
 static void on_DL_SETTING(IvyClientPtr app __attribute__((unused)),
                           void *user_data __attribute__((unused)),
                           int argc __attribute__((unused)), char *argv[])
@@ -229,60 +232,100 @@ static void on_DL_RC_4CH(IvyClientPtr app __attribute__((unused)),
 #endif
 
 
+/*
+ * Send a NPS message with double fields.
+ * The text is the same as IvySendMsg with "%d NAME %f %f ..." but is
+ * formatted without printf. With IVY_TRANSPORT_BINARY, the fields are also
+ * sent as floats in a pprz frame on the binary channel.
+ */
+#define NPS_IVY_MAX_FIELDS 12
+
+static void nps_ivy_send(const char *name, uint8_t msg_id __attribute__((unused)), const double *values, int n)
+{
+  char buf[512];
+  char *p = ivy_print_uint(buf, AC_ID);
+  *p++ = ' ';
+  size_t len = strlen(name);
+  memcpy(p, name, len);
+  p += len;
+  for (int i = 0; i < n; i++) {
+    *p++ = ' ';
+    p = ivy_print_double(p, values[i]);
+  }
+  *p = '\0';
+  IvySendMsg("%s", buf);
+
+#if IVY_TRANSPORT_BINARY
+  uint8_t payload[2 + 4 * NPS_IVY_MAX_FIELDS];
+  payload[0] = AC_ID;
+  payload[1] = msg_id;
+  for (int i = 0; i < n && i < NPS_IVY_MAX_FIELDS; i++) {
+    float f = values[i];
+    memcpy(&payload[2 + 4 * i], &f, 4);
+  }
+  ivy_transport_send_binary(payload, 2 + 4 * Min(n, NPS_IVY_MAX_FIELDS));
+#endif
+}
+
 void nps_ivy_display(void)
 {
-  IvySendMsg("%d NPS_RATE_ATTITUDE %f %f %f %f %f %f",
-             AC_ID,
-             DegOfRad(fdm.body_ecef_rotvel.p),
-             DegOfRad(fdm.body_ecef_rotvel.q),
-             DegOfRad(fdm.body_ecef_rotvel.r),
-             DegOfRad(fdm.ltp_to_body_eulers.phi),
-             DegOfRad(fdm.ltp_to_body_eulers.theta),
-             DegOfRad(fdm.ltp_to_body_eulers.psi));
-  IvySendMsg("%d NPS_POS_LLH %f %f %f %f %f %f %f %f %f",
-             AC_ID,
-             (fdm.lla_pos_pprz.lat),
-             (fdm.lla_pos_geod.lat),
-             (fdm.lla_pos_geoc.lat),
-             (fdm.lla_pos_pprz.lon),
-             (fdm.lla_pos_geod.lon),
-             (fdm.lla_pos_pprz.alt),
-             (fdm.lla_pos_geod.alt),
-             (fdm.agl),
-             (fdm.hmsl));
-  IvySendMsg("%d NPS_SPEED_POS %f %f %f %f %f %f %f %f %f",
-             AC_ID,
-             (fdm.ltpprz_ecef_accel.x),
-             (fdm.ltpprz_ecef_accel.y),
-             (fdm.ltpprz_ecef_accel.z),
-             (fdm.ltpprz_ecef_vel.x),
-             (fdm.ltpprz_ecef_vel.y),
-             (fdm.ltpprz_ecef_vel.z),
-             (fdm.ltpprz_pos.x),
-             (fdm.ltpprz_pos.y),
-             (fdm.ltpprz_pos.z));
-  IvySendMsg("%d NPS_GYRO_BIAS %f %f %f",
-             AC_ID,
-             DegOfRad(RATE_FLOAT_OF_BFP(sensors.gyro.bias_random_walk_value.x) + sensors.gyro.bias_initial.x),
-             DegOfRad(RATE_FLOAT_OF_BFP(sensors.gyro.bias_random_walk_value.y) + sensors.gyro.bias_initial.y),
-             DegOfRad(RATE_FLOAT_OF_BFP(sensors.gyro.bias_random_walk_value.z) + sensors.gyro.bias_initial.z));
+  double rate_attitude[] = {
+    DegOfRad(fdm.body_ecef_rotvel.p),
+    DegOfRad(fdm.body_ecef_rotvel.q),
+    DegOfRad(fdm.body_ecef_rotvel.r),
+    DegOfRad(fdm.ltp_to_body_eulers.phi),
+    DegOfRad(fdm.ltp_to_body_eulers.theta),
+    DegOfRad(fdm.ltp_to_body_eulers.psi)
+  };
+  nps_ivy_send("NPS_RATE_ATTITUDE", DL_NPS_RATE_ATTITUDE, rate_attitude, 6);
+
+  double pos_llh[] = {
+    (fdm.lla_pos_pprz.lat),
+    (fdm.lla_pos_geod.lat),
+    (fdm.lla_pos_geoc.lat),
+    (fdm.lla_pos_pprz.lon),
+    (fdm.lla_pos_geod.lon),
+    (fdm.lla_pos_pprz.alt),
+    (fdm.lla_pos_geod.alt),
+    (fdm.agl),
+    (fdm.hmsl)
+  };
+  nps_ivy_send("NPS_POS_LLH", DL_NPS_POS_LLH, pos_llh, 9);
+
+  double speed_pos[] = {
+    (fdm.ltpprz_ecef_accel.x),
+    (fdm.ltpprz_ecef_accel.y),
+    (fdm.ltpprz_ecef_accel.z),
+    (fdm.ltpprz_ecef_vel.x),
+    (fdm.ltpprz_ecef_vel.y),
+    (fdm.ltpprz_ecef_vel.z),
+    (fdm.ltpprz_pos.x),
+    (fdm.ltpprz_pos.y),
+    (fdm.ltpprz_pos.z)
+  };
+  nps_ivy_send("NPS_SPEED_POS", DL_NPS_SPEED_POS, speed_pos, 9);
+
+  double gyro_bias[] = {
+    DegOfRad(RATE_FLOAT_OF_BFP(sensors.gyro.bias_random_walk_value.x) + sensors.gyro.bias_initial.x),
+    DegOfRad(RATE_FLOAT_OF_BFP(sensors.gyro.bias_random_walk_value.y) + sensors.gyro.bias_initial.y),
+    DegOfRad(RATE_FLOAT_OF_BFP(sensors.gyro.bias_random_walk_value.z) + sensors.gyro.bias_initial.z)
+  };
+  nps_ivy_send("NPS_GYRO_BIAS", DL_NPS_GYRO_BIAS, gyro_bias, 3);
 
   /* transform magnetic field to body frame */
   struct DoubleVect3 h_body;
   double_quat_vmult(&h_body, &fdm.ltp_to_body_quat, &fdm.ltp_h);
 
-  IvySendMsg("%d NPS_SENSORS_SCALED %f %f %f %f %f %f",
-             AC_ID,
-             ((sensors.accel.value.x - sensors.accel.neutral.x) / NPS_ACCEL_SENSITIVITY_XX),
-             ((sensors.accel.value.y - sensors.accel.neutral.y) / NPS_ACCEL_SENSITIVITY_YY),
-             ((sensors.accel.value.z - sensors.accel.neutral.z) / NPS_ACCEL_SENSITIVITY_ZZ),
-             h_body.x,
-             h_body.y,
-             h_body.z);
-
-  IvySendMsg("%d NPS_WIND %f %f %f",
-             AC_ID,
-             fdm.wind.x,
-             fdm.wind.y,
-             fdm.wind.z);
+  double sensors_scaled[] = {
+    ((sensors.accel.value.x - sensors.accel.neutral.x) / NPS_ACCEL_SENSITIVITY_XX),
+    ((sensors.accel.value.y - sensors.accel.neutral.y) / NPS_ACCEL_SENSITIVITY_YY),
+    ((sensors.accel.value.z - sensors.accel.neutral.z) / NPS_ACCEL_SENSITIVITY_ZZ),
+    h_body.x,
+    h_body.y,
+    h_body.z
+  };
+  nps_ivy_send("NPS_SENSORS_SCALED", DL_NPS_SENSORS_SCALED, sensors_scaled, 6);
+
+  double wind[] = { fdm.wind.x, fdm.wind.y, fdm.wind.z };
+  nps_ivy_send("NPS_WIND", DL_NPS_WIND, wind, 3);
 }
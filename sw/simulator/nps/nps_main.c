@@ -35,12 +35,22 @@
 #include "nps_autopilot.h"
 #include "nps_ivy.h"
 #include "nps_flightgear.h"
+#include "nps_random.h"
+#include "nps_metrics.h"
 
 #include "mcu_periph/sys_time.h"
 #define SIM_DT     (1./SYS_TIME_FREQUENCY)
 #define DISPLAY_DT (1./30.)
 #define HOST_TIMEOUT_MS 40
 
+/** Number of simulation steps run per idle callback in fast mode.
+ * Keeps the glib main loop (and thus Ivy) responsive while not being
+ * locked to wall-clock.
+ */
+#ifndef NPS_FAST_STEPS_PER_CALL
+#define NPS_FAST_STEPS_PER_CALL 512
+#endif
+
 static struct {
   double real_initial_time;
   double scaled_initial_time;
@@ -55,6 +65,23 @@ static struct {
   char *spektrum_dev;
   int rc_script;
   char *ivy_bus;
+  bool_t fast_mode;         ///< run as fast as possible, not locked to wall-clock
+  unsigned int display_decimation; ///< only display every n-th display period, 0 to disable
+  unsigned int display_cnt;
+  double duration;          ///< stop after this simulated time in seconds, <= 0 to run forever
+  bool_t has_seed;
+  unsigned long int seed;   ///< seed of the sensor noise random generator
+  double wind_speed;        ///< initial wind speed in m/s, negative to keep airframe default
+  double wind_dir;          ///< initial wind direction in degrees
+  int turbulence;           ///< turbulence severity, negative to keep airframe default
+  char *metrics_file;       ///< write run metrics to this file on exit
+  /* sensor noise standard deviations on all axes, negative to keep the sensors params */
+  double gyro_noise;        ///< in rad/s
+  double accel_noise;       ///< in m/s2
+  double mag_noise;         ///< in unit of the normalized field
+  double baro_noise;        ///< in Pa
+  double gps_noise;         ///< position noise in m
+  GMainLoop *ml;
 } nps_main;
 
 static bool_t nps_main_parse_options(int argc, char **argv);
@@ -62,6 +89,7 @@ static void nps_main_init(void);
 static void nps_main_display(void);
 static void nps_main_run_sim_step(void);
 static gboolean nps_main_periodic(gpointer data __attribute__((unused)));
+static gboolean nps_main_fast_periodic(gpointer data __attribute__((unused)));
 
 int pauseSignal = 0;
 
@@ -102,13 +130,24 @@ int main(int argc, char **argv)
 
   nps_main_init();
 
-  signal(SIGCONT, cont_hdl);
-  signal(SIGTSTP, tstp_hdl);
-  printf("Time factor is %f. (Press Ctrl-Z to change)\n", nps_main.host_time_factor);
+  nps_main.ml = g_main_loop_new(NULL, FALSE);
 
-  GMainLoop *ml =  g_main_loop_new(NULL, FALSE);
-  g_timeout_add(HOST_TIMEOUT_MS, nps_main_periodic, NULL);
-  g_main_loop_run(ml);
+  if (nps_main.fast_mode) {
+    printf("Running in fast mode (display decimation %u, duration %f s)\n",
+           nps_main.display_decimation, nps_main.duration);
+    g_idle_add(nps_main_fast_periodic, NULL);
+  } else {
+    signal(SIGCONT, cont_hdl);
+    signal(SIGTSTP, tstp_hdl);
+    printf("Time factor is %f. (Press Ctrl-Z to change)\n", nps_main.host_time_factor);
+    g_timeout_add(HOST_TIMEOUT_MS, nps_main_periodic, NULL);
+  }
+
+  g_main_loop_run(nps_main.ml);
+
+  if (nps_main.metrics_file) {
+    nps_metrics_write(nps_main.metrics_file, nps_main.seed);
+  }
 
   return 0;
 }
@@ -119,6 +158,7 @@ static void nps_main_init(void)
 
   nps_main.sim_time = 0.;
   nps_main.display_time = 0.;
+  nps_main.display_cnt = 0;
   struct timeval t;
   gettimeofday(&t, NULL);
   nps_main.real_initial_time = time_to_double(&t);
@@ -127,7 +167,33 @@ static void nps_main_init(void)
   nps_ivy_init(nps_main.ivy_bus);
   nps_fdm_init(SIM_DT);
   nps_atmosphere_init();
+  if (nps_main.wind_speed >= 0.) {
+    nps_atmosphere_set_wind_speed(nps_main.wind_speed);
+    nps_atmosphere_set_wind_dir(RadOfDeg(nps_main.wind_dir));
+  }
+  if (nps_main.turbulence >= 0) {
+    nps_atmosphere.turbulence_severity = nps_main.turbulence;
+  }
+  if (nps_main.has_seed) {
+    nps_random_init(nps_main.seed);
+    printf("Random seed %lu\n", nps_main.seed);
+  }
   nps_sensors_init(nps_main.sim_time);
+  if (nps_main.gyro_noise >= 0.) {
+    VECT3_ASSIGN(sensors.gyro.noise_std_dev, nps_main.gyro_noise, nps_main.gyro_noise, nps_main.gyro_noise);
+  }
+  if (nps_main.accel_noise >= 0.) {
+    VECT3_ASSIGN(sensors.accel.noise_std_dev, nps_main.accel_noise, nps_main.accel_noise, nps_main.accel_noise);
+  }
+  if (nps_main.mag_noise >= 0.) {
+    VECT3_ASSIGN(sensors.mag.noise_std_dev, nps_main.mag_noise, nps_main.mag_noise, nps_main.mag_noise);
+  }
+  if (nps_main.baro_noise >= 0.) {
+    sensors.baro.noise_std_dev = nps_main.baro_noise;
+  }
+  if (nps_main.gps_noise >= 0.) {
+    VECT3_ASSIGN(sensors.gps.pos_noise_std_dev, nps_main.gps_noise, nps_main.gps_noise, nps_main.gps_noise);
+  }
   printf("Simulating with dt of %f\n", SIM_DT);
 
   enum NpsRadioControlType rc_type;
@@ -147,6 +213,8 @@ static void nps_main_init(void)
     nps_flightgear_init(nps_main.fg_host, nps_main.fg_port, nps_main.fg_time_offset);
   }
 
+  nps_metrics_init();
+
 #if DEBUG_NPS_TIME
   printf("host_time_factor,host_time_elapsed,host_time_now,scaled_initial_time,sim_time_before,display_time_before,sim_time_after,display_time_after\n");
 #endif
@@ -169,6 +237,8 @@ static void nps_main_run_sim_step(void)
 
   nps_autopilot_run_step(nps_main.sim_time);
 
+  nps_metrics_run_step(nps_main.sim_time, SIM_DT, autopilot.commands, NPS_COMMANDS_NB);
+
 }
 
 
@@ -188,6 +258,10 @@ static void nps_main_display(void)
 
 void nps_set_time_factor(float time_factor)
 {
+  /* time factor is meaningless when not locked to wall-clock */
+  if (nps_main.fast_mode) {
+    return;
+  }
   if (time_factor < 0.0 || time_factor > 100.0) {
     return;
   }
@@ -282,6 +356,11 @@ static gboolean nps_main_periodic(gpointer data __attribute__((unused)))
     printf("Warning: The time factor is too large for efficient operation! Please reduce the time factor.\n");
   }
 
+  if (nps_main.duration > 0. && nps_main.sim_time >= nps_main.duration) {
+    g_main_loop_quit(nps_main.ml);
+    return FALSE;
+  }
+
 #if DEBUG_NPS_TIME
   printf("%f,%f\n", nps_main.sim_time, nps_main.display_time);
 #endif
@@ -291,6 +370,40 @@ static gboolean nps_main_periodic(gpointer data __attribute__((unused)))
 }
 
 
+/**
+ * Fast mode periodic.
+ * Runs a batch of simulation steps without waiting for wall-clock,
+ * display is done on simulated time and decimated.
+ * Quits the main loop once the requested duration has been simulated.
+ */
+static gboolean nps_main_fast_periodic(gpointer data __attribute__((unused)))
+{
+  int i;
+  for (i = 0; i < NPS_FAST_STEPS_PER_CALL; i++) {
+    nps_main_run_sim_step();
+    nps_main.sim_time += SIM_DT;
+    if (nps_main.display_time < nps_main.sim_time) {
+      if (nps_main.display_decimation > 0 &&
+          ++nps_main.display_cnt >= nps_main.display_decimation) {
+        nps_main_display();
+        nps_main.display_cnt = 0;
+      }
+      nps_main.display_time += DISPLAY_DT;
+    }
+    if (nps_main.duration > 0. && nps_main.sim_time >= nps_main.duration) {
+      struct timeval tv_now;
+      gettimeofday(&tv_now, NULL);
+      double elapsed = time_to_double(&tv_now) - nps_main.real_initial_time;
+      printf("Simulated %f s in %f s (x%.1f)\n", nps_main.sim_time, elapsed,
+             elapsed > 0. ? nps_main.sim_time / elapsed : 0.);
+      g_main_loop_quit(nps_main.ml);
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+
 static bool_t nps_main_parse_options(int argc, char **argv)
 {
 
@@ -303,6 +416,20 @@ static bool_t nps_main_parse_options(int argc, char **argv)
   nps_main.ivy_bus = NULL;
   nps_main.host_time_factor = 1.0;
   nps_main.fg_fdm = 0;
+  nps_main.fast_mode = FALSE;
+  nps_main.display_decimation = 1;
+  nps_main.duration = 0.;
+  nps_main.has_seed = FALSE;
+  nps_main.seed = 0;
+  nps_main.wind_speed = -1.;
+  nps_main.wind_dir = 0.;
+  nps_main.turbulence = -1;
+  nps_main.metrics_file = NULL;
+  nps_main.gyro_noise = -1.;
+  nps_main.accel_noise = -1.;
+  nps_main.mag_noise = -1.;
+  nps_main.baro_noise = -1.;
+  nps_main.gps_noise = -1.;
 
   static const char *usage =
     "Usage: %s [options]\n"
@@ -316,7 +443,21 @@ static bool_t nps_main_parse_options(int argc, char **argv)
     "   --rc_script <number>                   e.g. 0\n"
     "   --ivy_bus <ivy bus>                    e.g. 127.255.255.255\n"
     "   --time_factor <factor>                 e.g. 2.5\n"
-    "   --fg_fdm";
+    "   --fg_fdm\n"
+    "   --fast                                 run as fast as possible (not locked to wall-clock)\n"
+    "   --display_decimation <n>               in fast mode, only display every n-th frame, 0 to disable\n"
+    "   --duration <seconds>                   stop after simulated duration, e.g. 600\n"
+    "   --seed <number>                        seed for the sensor noise generator, e.g. 42\n"
+    "   --noise_scale <factor>                 scale all sensor noise, e.g. 2.0\n"
+    "   --gyro_noise <rad/s>                   gyro noise std dev on all axes, e.g. 0.01\n"
+    "   --accel_noise <m/s2>                   accel noise std dev on all axes, e.g. 0.05\n"
+    "   --mag_noise <std dev>                  mag noise std dev on all axes (normalized field), e.g. 0.002\n"
+    "   --baro_noise <Pa>                      baro noise std dev, e.g. 2\n"
+    "   --gps_noise <m>                        gps position noise std dev on all axes, e.g. 0.5\n"
+    "   --wind_speed <m/s>                     initial wind speed, e.g. 5.0\n"
+    "   --wind_dir <degrees>                   initial wind direction (north=0, CCW), e.g. 90\n"
+    "   --turbulence <severity>                turbulence severity from 0 to 7\n"
+    "   --metrics_file <file>                  write run metrics to file on exit\n";
 
 
   while (1) {
@@ -331,6 +472,20 @@ static bool_t nps_main_parse_options(int argc, char **argv)
       {"ivy_bus", 1, NULL, 0},
       {"time_factor", 1, NULL, 0},
       {"fg_fdm", 0, NULL, 0},
+      {"fast", 0, NULL, 0},
+      {"display_decimation", 1, NULL, 0},
+      {"duration", 1, NULL, 0},
+      {"seed", 1, NULL, 0},
+      {"noise_scale", 1, NULL, 0},
+      {"wind_speed", 1, NULL, 0},
+      {"wind_dir", 1, NULL, 0},
+      {"turbulence", 1, NULL, 0},
+      {"metrics_file", 1, NULL, 0},
+      {"gyro_noise", 1, NULL, 0},
+      {"accel_noise", 1, NULL, 0},
+      {"mag_noise", 1, NULL, 0},
+      {"baro_noise", 1, NULL, 0},
+      {"gps_noise", 1, NULL, 0},
       {0, 0, 0, 0}
     };
     int option_index = 0;
@@ -364,6 +519,36 @@ static bool_t nps_main_parse_options(int argc, char **argv)
           case 8:
             nps_main.fg_fdm = 1;
             break;
+          case 9:
+            nps_main.fast_mode = TRUE; break;
+          case 10:
+            nps_main.display_decimation = atoi(optarg); break;
+          case 11:
+            nps_main.duration = atof(optarg); break;
+          case 12:
+            nps_main.has_seed = TRUE;
+            nps_main.seed = strtoul(optarg, NULL, 0);
+            break;
+          case 13:
+            nps_random_noise_scale = atof(optarg); break;
+          case 14:
+            nps_main.wind_speed = atof(optarg); break;
+          case 15:
+            nps_main.wind_dir = atof(optarg); break;
+          case 16:
+            nps_main.turbulence = atoi(optarg); break;
+          case 17:
+            nps_main.metrics_file = strdup(optarg); break;
+          case 18:
+            nps_main.gyro_noise = atof(optarg); break;
+          case 19:
+            nps_main.accel_noise = atof(optarg); break;
+          case 20:
+            nps_main.mag_noise = atof(optarg); break;
+          case 21:
+            nps_main.baro_noise = atof(optarg); break;
+          case 22:
+            nps_main.gps_noise = atof(optarg); break;
         }
         break;
 
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file nps_metrics.c
+ * Per-run performance metrics for NPS batch / Monte-Carlo runs.
+ *
+ * Compares the autopilot state estimate with the FDM truth (estimation
+ * error), the FDM truth with the guidance setpoints (tracking error), and
+ * accumulates a few flight figures, written to a file at the end of a run
+ * so that they can be collected by sw/simulator/pprzsim-montecarlo.
+ */
+
+#include "nps_metrics.h"
+
+#include <stdio.h>
+#include <math.h>
+
+#include "nps_fdm.h"
+#include "nps_autopilot.h"
+#include "nps_atmosphere.h"
+#include "nps_random.h"
+#include "nps_sensors.h"
+#include "state.h"
+
+struct NpsMetrics nps_metrics;
+
+static struct NedCoor_d last_pos;
+
+void nps_metrics_init(void)
+{
+  nps_metrics.sim_time = 0.;
+  nps_metrics.airborne_time = 0.;
+  nps_metrics.land_time = -1.;
+  nps_metrics.max_alt = 0.;
+  nps_metrics.distance = 0.;
+  nps_metrics.pos_err_sum2 = 0.;
+  nps_metrics.pos_err_max = 0.;
+  nps_metrics.pos_err_nb = 0;
+  nps_metrics.track_err_sum2 = 0.;
+  nps_metrics.track_err_max = 0.;
+  nps_metrics.track_err_nb = 0;
+  nps_metrics.heading_err_sum2 = 0.;
+  nps_metrics.heading_err_nb = 0;
+  nps_metrics.cmd_effort = 0.;
+  nps_metrics.has_taken_off = FALSE;
+  last_pos = fdm.ltpprz_pos;
+}
+
+void nps_metrics_run_step(double time, double dt, double *commands, int commands_nb)
+{
+  int i;
+
+  nps_metrics.sim_time = time;
+
+  for (i = 0; i < commands_nb; i++) {
+    nps_metrics.cmd_effort += fabs(commands[i]) * dt;
+  }
+
+  if (!fdm.on_ground) {
+    nps_metrics.has_taken_off = TRUE;
+    nps_metrics.airborne_time += dt;
+  } else if (nps_metrics.has_taken_off && nps_metrics.land_time < 0.) {
+    nps_metrics.land_time = time;
+  }
+
+  if (-fdm.ltpprz_pos.z > nps_metrics.max_alt) {
+    nps_metrics.max_alt = -fdm.ltpprz_pos.z;
+  }
+  double dx = fdm.ltpprz_pos.x - last_pos.x;
+  double dy = fdm.ltpprz_pos.y - last_pos.y;
+  nps_metrics.distance += sqrt(dx * dx + dy * dy);
+  last_pos = fdm.ltpprz_pos;
+
+  if (stateIsLocalCoordinateValid()) {
+    struct NedCoor_f *pos = stateGetPositionNed_f();
+    double ex = pos->x - fdm.ltpprz_pos.x;
+    double ey = pos->y - fdm.ltpprz_pos.y;
+    double ez = pos->z - fdm.ltpprz_pos.z;
+    double e2 = ex * ex + ey * ey + ez * ez;
+    nps_metrics.pos_err_sum2 += e2;
+    nps_metrics.pos_err_nb++;
+    if (sqrt(e2) > nps_metrics.pos_err_max) {
+      nps_metrics.pos_err_max = sqrt(e2);
+    }
+  }
+
+  // tracking error, only in flight where the setpoints are flown
+  struct NpsSetpoint sp;
+  nps_autopilot_get_setpoint(&sp);
+  if (!fdm.on_ground && (sp.h_valid || sp.v_valid)) {
+    double e2 = 0.;
+    if (sp.h_valid) {
+      double ex = fdm.ltpprz_pos.x - sp.pos.x;
+      double ey = fdm.ltpprz_pos.y - sp.pos.y;
+      e2 += ex * ex + ey * ey;
+    }
+    if (sp.v_valid) {
+      double ez = fdm.ltpprz_pos.z - sp.pos.z;
+      e2 += ez * ez;
+    }
+    nps_metrics.track_err_sum2 += e2;
+    nps_metrics.track_err_nb++;
+    if (sqrt(e2) > nps_metrics.track_err_max) {
+      nps_metrics.track_err_max = sqrt(e2);
+    }
+  }
+  if (!fdm.on_ground && sp.heading_valid) {
+    double heading = fdm.ltpprz_to_body_eulers.psi;
+    if (sp.course) {
+      heading = atan2(fdm.ltpprz_ecef_vel.y, fdm.ltpprz_ecef_vel.x);
+    }
+    double eh = heading - sp.heading;
+    FLOAT_ANGLE_NORMALIZE(eh);
+    nps_metrics.heading_err_sum2 += eh * eh;
+    nps_metrics.heading_err_nb++;
+  }
+}
+
+int nps_metrics_write(const char *filename, unsigned long int seed)
+{
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) {
+    printf("Could not open metrics file %s\n", filename);
+    return -1;
+  }
+  double pos_err_rms = 0.;
+  if (nps_metrics.pos_err_nb > 0) {
+    pos_err_rms = sqrt(nps_metrics.pos_err_sum2 / nps_metrics.pos_err_nb);
+  }
+  double track_err_rms = 0.;
+  if (nps_metrics.track_err_nb > 0) {
+    track_err_rms = sqrt(nps_metrics.track_err_sum2 / nps_metrics.track_err_nb);
+  }
+  double heading_err_rms = 0.;
+  if (nps_metrics.heading_err_nb > 0) {
+    heading_err_rms = sqrt(nps_metrics.heading_err_sum2 / nps_metrics.heading_err_nb);
+  }
+  fprintf(f, "seed %lu\n", seed);
+  fprintf(f, "wind_speed %f\n", nps_atmosphere.wind_speed);
+  fprintf(f, "wind_dir %f\n", DegOfRad(nps_atmosphere.wind_dir));
+  fprintf(f, "noise_scale %f\n", nps_random_noise_scale);
+  fprintf(f, "gyro_noise %f\n", sensors.gyro.noise_std_dev.x);
+  fprintf(f, "accel_noise %f\n", sensors.accel.noise_std_dev.x);
+  fprintf(f, "mag_noise %f\n", sensors.mag.noise_std_dev.x);
+  fprintf(f, "baro_noise %f\n", sensors.baro.noise_std_dev);
+  fprintf(f, "gps_noise %f\n", sensors.gps.pos_noise_std_dev.x);
+  fprintf(f, "sim_time %f\n", nps_metrics.sim_time);
+  fprintf(f, "airborne_time %f\n", nps_metrics.airborne_time);
+  fprintf(f, "land_time %f\n", nps_metrics.land_time);
+  fprintf(f, "max_alt %f\n", nps_metrics.max_alt);
+  fprintf(f, "distance %f\n", nps_metrics.distance);
+  fprintf(f, "pos_err_rms %f\n", pos_err_rms);
+  fprintf(f, "pos_err_max %f\n", nps_metrics.pos_err_max);
+  fprintf(f, "track_err_rms %f\n", track_err_rms);
+  fprintf(f, "track_err_max %f\n", nps_metrics.track_err_max);
+  fprintf(f, "heading_err_rms %f\n", DegOfRad(heading_err_rms));
+  fprintf(f, "cmd_effort %f\n", nps_metrics.cmd_effort);
+  fclose(f);
+  return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @file nps_metrics.h
+ * Per-run performance metrics for NPS batch / Monte-Carlo runs.
+ */
+
+#ifndef NPS_METRICS_H
+#define NPS_METRICS_H
+
+#include "std.h"
+
+struct NpsMetrics {
+  double sim_time;          ///< total simulated time in s
+  double airborne_time;     ///< simulated time spent off ground in s
+  double land_time;         ///< sim time of first touchdown after takeoff, negative if not landed
+  double max_alt;           ///< maximum altitude above initial LTP in m
+  double distance;          ///< horizontal distance flown in m
+  double pos_err_sum2;      ///< accumulated squared estimation error (for RMS)
+  double pos_err_max;       ///< max position estimation error (state vs fdm) in m
+  unsigned long pos_err_nb; ///< number of valid estimation error samples
+  double track_err_sum2;    ///< accumulated squared tracking error (for RMS)
+  double track_err_max;     ///< max position tracking error (fdm vs guidance setpoint) in m
+  unsigned long track_err_nb;     ///< number of tracking error samples
+  double heading_err_sum2;  ///< accumulated squared heading (or course) tracking error
+  unsigned long heading_err_nb;   ///< number of heading tracking error samples
+  double cmd_effort;        ///< integral of sum of absolute commands over time (energy proxy)
+  bool_t has_taken_off;
+};
+
+extern struct NpsMetrics nps_metrics;
+
+extern void nps_metrics_init(void);
+extern void nps_metrics_run_step(double time, double dt, double *commands, int commands_nb);
+/** Write metrics as "name value" lines, seed is written as well for reference */
+extern int nps_metrics_write(const char *filename, unsigned long int seed);
+
+#endif /* NPS_METRICS_H */
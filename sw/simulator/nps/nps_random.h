@@ -3,6 +3,15 @@
 
 #include "math/pprz_algebra_double.h"
 
+/**
+ * Scale factor applied to all generated noise (default 1.0).
+ * The standard deviation of each sensor is set by its own parameters (or the
+ * per sensor options of nps_main), this scale multiplies all of them at once.
+ */
+extern double nps_random_noise_scale;
+
+/** (Re)seed the random number generator to get reproducible runs */
+extern void nps_random_init(unsigned long int seed);
 extern double get_gaussian_noise(void);
 extern void double_vect3_add_gaussian_noise(struct DoubleVect3 *vect, struct DoubleVect3 *std_dev);
 extern void double_vect3_get_gaussian_noise(struct DoubleVect3 *vect, struct DoubleVect3 *std_dev);
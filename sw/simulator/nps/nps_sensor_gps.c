@@ -7,6 +7,14 @@
 #include "nps_sensors_utils.h"
 #include NPS_SENSORS_PARAMS
 
+/** Interpolate the delayed GPS readings at time - latency instead of
+ *  using the first reading after it.
+ *  The longitude is not unwrapped, so don't use it across the antimeridian.
+ */
+#ifndef NPS_GPS_LATENCY_INTERPOLATE
+#define NPS_GPS_LATENCY_INTERPOLATE FALSE
+#endif
+
 void nps_sensor_gps_init(struct NpsSensorGps *gps, double time)
 {
   FLOAT_VECT3_ZERO(gps->ecef_pos);
@@ -14,6 +22,10 @@ void nps_sensor_gps_init(struct NpsSensorGps *gps, double time)
   gps->hmsl = 0.0;
   gps->pos_latency = NPS_GPS_POS_LATENCY;
   gps->speed_latency = NPS_GPS_SPEED_LATENCY;
+  nps_sensor_delay_init(&gps->speed_history, 3, gps->speed_latency, NPS_GPS_DT, NPS_GPS_LATENCY_INTERPOLATE);
+  nps_sensor_delay_init(&gps->pos_history, 3, gps->pos_latency, NPS_GPS_DT, NPS_GPS_LATENCY_INTERPOLATE);
+  nps_sensor_delay_init(&gps->lla_history, 3, gps->pos_latency, NPS_GPS_DT, NPS_GPS_LATENCY_INTERPOLATE);
+  nps_sensor_delay_init(&gps->hmsl_history, 1, gps->pos_latency, NPS_GPS_DT, NPS_GPS_LATENCY_INTERPOLATE);
   VECT3_ASSIGN(gps->pos_noise_std_dev,
                NPS_GPS_POS_NOISE_STD_DEV, NPS_GPS_POS_NOISE_STD_DEV, NPS_GPS_POS_NOISE_STD_DEV);
   VECT3_ASSIGN(gps->speed_noise_std_dev,
@@ -53,7 +65,7 @@ void nps_sensor_gps_run_step(struct NpsSensorGps *gps, double time)
   double_vect3_add_gaussian_noise(&cur_speed_reading, &gps->speed_noise_std_dev);
 
   /* store that for later and retrieve a previously stored data */
-  UpdateSensorLatency(time, &cur_speed_reading, &gps->speed_history, gps->speed_latency, &gps->ecef_vel);
+  nps_sensor_delay_update(&gps->speed_history, time, (double *)&cur_speed_reading, (double *)&gps->ecef_vel);
 
 
   /*
@@ -74,7 +86,7 @@ void nps_sensor_gps_run_step(struct NpsSensorGps *gps, double time)
   VECT3_ADD(cur_pos_reading, pos_error);
 
   /* store that for later and retrieve a previously stored data */
-  UpdateSensorLatency(time, &cur_pos_reading, &gps->pos_history, gps->pos_latency, &gps->ecef_pos);
+  nps_sensor_delay_update(&gps->pos_history, time, (double *)&cur_pos_reading, (double *)&gps->ecef_pos);
 
 
   /*
@@ -85,10 +97,10 @@ void nps_sensor_gps_run_step(struct NpsSensorGps *gps, double time)
   lla_of_ecef_d(&cur_lla_reading, (struct EcefCoor_d *) &cur_pos_reading);
 
   /* store that for later and retrieve a previously stored data */
-  UpdateSensorLatency(time, &cur_lla_reading, &gps->lla_history, gps->pos_latency, &gps->lla_pos);
+  nps_sensor_delay_update(&gps->lla_history, time, (double *)&cur_lla_reading, (double *)&gps->lla_pos);
 
   double cur_hmsl_reading = fdm.hmsl;
-  UpdateSensorLatency_Single(time, &cur_hmsl_reading, &gps->hmsl_history, gps->pos_latency, &gps->hmsl);
+  nps_sensor_delay_update(&gps->hmsl_history, time, &cur_hmsl_reading, &gps->hmsl);
 
   gps->next_update += NPS_GPS_DT;
   gps->data_available = TRUE;
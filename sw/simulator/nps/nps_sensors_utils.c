@@ -1,49 +1,80 @@
 #include "nps_sensors_utils.h"
 
-//#include <string.h>
-#include "math/pprz_algebra.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
-void UpdateSensorLatency(double time, gpointer cur_reading, GSList **history, double latency, gpointer sensor_reading)
+/* index of the i-th oldest reading in the ring buffer */
+#define DelayIdx(_d, _i) (((_d)->head + (_i)) % (_d)->capacity)
+
+void nps_sensor_delay_init(struct NpsSensorDelay *delay, uint32_t dim, double latency, double dt,
+                           bool_t interpolate)
 {
-  /* add new reading */
-  struct BoozDatedSensor *cur_read = g_new(struct BoozDatedSensor, 1);
-  cur_read->time = time;
-  cur_read->value = (struct DoubleVect3 *) g_memdup(cur_reading, sizeof(struct DoubleVect3));
-  *history = g_slist_prepend(*history, cur_read);
-  /* remove old readings */
-  GSList *last =  g_slist_last(*history);
-  while (last && ((struct BoozDatedSensor *)last->data)->time < time - latency) {
-    *history = g_slist_remove_link(*history, last);
-    g_free(((struct BoozDatedSensor *)last->data)->value);
-    g_free((struct BoozDatedSensor *)last->data);
-    g_slist_free_1(last);
-    last = g_slist_last(*history);
-  }
-  /* update sensor        */
-  //g_memmove((gpointer)sensor_reading, (gpointer)((struct BoozDatedSensor*)last->data)->value, sizeof(struct DoubleVect3));
-  VECT3_COPY(*((struct DoubleVect3 *)sensor_reading), *((struct BoozDatedSensor *)last->data)->value);
+  delay->dim = dim;
+  delay->latency = latency;
+  delay->interpolate = interpolate;
+  /* readings in the latency window, plus the newest and the one before the window */
+  delay->capacity = (dt > 0. ? (uint32_t)ceil(latency / dt) : 0) + 3;
+  delay->time = calloc(delay->capacity, sizeof(double));
+  delay->value = calloc(delay->capacity * dim, sizeof(double));
+  delay->head = 0;
+  delay->count = 0;
+  delay->dropped = 0;
+}
+
+void nps_sensor_delay_free(struct NpsSensorDelay *delay)
+{
+  free(delay->time);
+  free(delay->value);
+  delay->time = NULL;
+  delay->value = NULL;
+  delay->capacity = 0;
+  delay->count = 0;
 }
 
-void UpdateSensorLatency_Single(double time, gpointer cur_reading, GSList **history, double latency,
-                                gpointer sensor_reading)
+void nps_sensor_delay_update(struct NpsSensorDelay *delay, double time, const double *cur_reading,
+                             double *sensor_reading)
 {
-  /* add new reading */
-  struct BoozDatedSensor_Single *cur_read = g_new(struct BoozDatedSensor_Single, 1);
-  cur_read->time = time;
-  cur_read->value = (double *) g_memdup(cur_reading, sizeof(double));
-  *history = g_slist_prepend(*history, cur_read);
-  /* remove old readings */
-  GSList *last =  g_slist_last(*history);
-  while (last && ((struct BoozDatedSensor_Single *)last->data)->time < time - latency) {
-    *history = g_slist_remove_link(*history, last);
-    g_free(((struct BoozDatedSensor_Single *)last->data)->value);
-    g_free((struct BoozDatedSensor_Single *)last->data);
-    g_slist_free_1(last);
-    last = g_slist_last(*history);
+  const uint32_t dim = delay->dim;
+  const double t_out = time - delay->latency;
+
+  /* add new reading, dropping the oldest one if the updates come faster
+   * than the dt given at init */
+  if (delay->count == delay->capacity) {
+    delay->head = DelayIdx(delay, 1);
+    delay->count--;
+    delay->dropped++;
   }
+  uint32_t idx = DelayIdx(delay, delay->count);
+  delay->time[idx] = time;
+  memcpy(&delay->value[idx * dim], cur_reading, dim * sizeof(double));
+  delay->count++;
 
-  /* update sensor        */
-  //g_memmove((gpointer)sensor_reading, (gpointer)((struct BoozDatedSensor*)last->data)->value, sizeof(struct DoubleVect3));
-  *((double *)sensor_reading) = *(((struct BoozDatedSensor_Single *)last->data)->value);
+  /* remove old readings, the newest one is always kept */
+  if (delay->interpolate) {
+    /* keep the last reading older than t_out to interpolate from */
+    while (delay->count > 1 && delay->time[DelayIdx(delay, 1)] <= t_out) {
+      delay->head = DelayIdx(delay, 1);
+      delay->count--;
+    }
+  } else {
+    while (delay->count > 1 && delay->time[delay->head] < t_out) {
+      delay->head = DelayIdx(delay, 1);
+      delay->count--;
+    }
+  }
 
+  /* update sensor */
+  const double *v0 = &delay->value[delay->head * dim];
+  const double t0 = delay->time[delay->head];
+  if (delay->interpolate && delay->count > 1 && t0 < t_out) {
+    uint32_t next = DelayIdx(delay, 1);
+    const double *v1 = &delay->value[next * dim];
+    const double alpha = (t_out - t0) / (delay->time[next] - t0);
+    for (uint32_t i = 0; i < dim; i++) {
+      sensor_reading[i] = v0[i] + alpha * (v1[i] - v0[i]);
+    }
+  } else {
+    memcpy(sensor_reading, v0, dim * sizeof(double));
+  }
 }
@@ -1,25 +1,51 @@
 #ifndef NPS_SENSORS_UTILS_H
 #define NPS_SENSORS_UTILS_H
 
-#include <glib.h>
 #include "math/pprz_algebra_double.h"
+#include "std.h"
 
-struct BoozDatedSensor {
-  struct DoubleVect3 *value;
-  double time;
+/**
+ * Delay line of dated sensor readings, used to simulate sensor latency.
+ * Readings of dim doubles are stored in a ring buffer allocated at init
+ * for latency / dt readings, so an update is O(1) and does not allocate.
+ * If the updates come faster than the dt given at init, the buffer is not
+ * grown: the oldest reading is dropped and counted.
+ */
+struct NpsSensorDelay {
+  double *time;         ///< reading times, capacity elements
+  double *value;        ///< readings, capacity * dim elements
+  uint32_t dim;         ///< number of doubles per reading
+  uint32_t capacity;    ///< max number of stored readings
+  uint32_t head;        ///< index of the oldest reading
+  uint32_t count;       ///< number of stored readings
+  uint32_t dropped;     ///< readings dropped because the buffer was full
+  double latency;       ///< delay in seconds
+  bool_t interpolate;   ///< linear interpolation between readings
 };
 
-struct BoozDatedSensor_Single {
-  double *value;
-  double time;
-};
+/**
+ * Initialize a delay line.
+ * @param delay the delay line
+ * @param dim number of doubles per reading (e.g. 3 for a DoubleVect3)
+ * @param latency delay in seconds
+ * @param dt expected period of the updates in seconds, used to size the buffer
+ * @param interpolate if TRUE, the output is interpolated at time - latency,
+ *        otherwise it is the oldest reading not older than time - latency
+ */
+extern void nps_sensor_delay_init(struct NpsSensorDelay *delay, uint32_t dim, double latency, double dt,
+                                  bool_t interpolate);
 
-/* cur_reading and sensor_reading must be of a type that can be cast to DoubleVect3* */
-extern void UpdateSensorLatency(double time, gpointer cur_reading, GSList **history,
-                                double latency, gpointer sensor_reading);
+/**
+ * Store a new reading and get the delayed one.
+ * @param delay the delay line
+ * @param time current time in seconds
+ * @param cur_reading current reading, dim doubles
+ * @param sensor_reading delayed reading, dim doubles
+ */
+extern void nps_sensor_delay_update(struct NpsSensorDelay *delay, double time, const double *cur_reading,
+                                    double *sensor_reading);
 
-/* ...and the same for single double values */
-extern void UpdateSensorLatency_Single(double time, gpointer cur_reading, GSList **history,
-                                       double latency, gpointer sensor_reading);
+/** Free the buffers of a delay line */
+extern void nps_sensor_delay_free(struct NpsSensorDelay *delay);
 
 #endif /* NPS_SENSORS_UTILS_H */
@@ -129,7 +129,7 @@ let write_settings = fun xml_file out_set telemetry_xml ->
   end;
   fprintf out_set "</settings>\n"
 
-let print_message_table = fun out_h xml ->
+let print_message_table = fun out_h xml messages_xml ->
   let messages = Hashtbl.create 15 in
   fprintf out_h "/* Periodic telemetry messages */\n";
   (* For each process *)
@@ -144,18 +144,33 @@ let print_message_table = fun out_h xml ->
       ) (Xml.children mode)
     ) (Xml.children process)
   ) (Xml.children xml);
+  (* Sort the names so that register_periodic_telemetry can use a binary search *)
+  let names = List.sort compare (Hashtbl.fold (fun n _ l -> n :: l) messages []) in
   (* Print ID *)
-  let nb = Hashtbl.fold (fun n _ i ->
+  let nb = List.fold_left (fun i n ->
     Xml2h.define (sprintf "TELEMETRY_MSG_%s_ID" n) (sprintf "%d" i);
     i+1
-  ) messages 0 in
+  ) 0 names in
   Xml2h.define "TELEMETRY_NB_MSG" (sprintf "%d" nb);
+  (* Telemetry messages not in the telemetry file get an invalid ID,
+   * so that registering an unknown name by ID fails at compile time *)
+  fprintf out_h "\n/* Telemetry messages not used in this telemetry file */\n";
+  begin try
+    let telemetry_class = ExtXml.child ~select:(fun x -> Xml.attrib x "name" = "telemetry") messages_xml "msg_class" in
+    List.iter (fun msg ->
+      let n = ExtXml.attrib msg "name" in
+      if not (Hashtbl.mem messages n) then
+        Xml2h.define (sprintf "TELEMETRY_MSG_%s_ID" n) "TELEMETRY_NB_MSG"
+    ) (Xml.children telemetry_class)
+  with Not_found -> failwith "No msg_class 'telemetry' found"
+  end;
+  fprintf out_h "\n";
   (* Structure initialization *)
   fprintf out_h "#define TELEMETRY_MSG_NAMES { \\\n";
-  Hashtbl.iter (fun n _ -> fprintf out_h "  \"%s\", \\\n" n) messages;
+  List.iter (fun n -> fprintf out_h "  \"%s\", \\\n" n) names;
   fprintf out_h "};\n\n";
   fprintf out_h "#define TELEMETRY_CBS_NULL { \\\n";
-  for i = 1 to (Hashtbl.length messages) do fprintf out_h "  NULL, \\\n" done;
+  for i = 1 to nb do fprintf out_h "  NULL, \\\n" done;
   fprintf out_h "};\n\n"
 
 let print_process_send = fun out_h xml freq modules ->
@@ -216,6 +231,7 @@ let _ =
     with Dtd.Check_error e -> failwith (Dtd.check_error e)
 
   in
+  let messages_xml = Xml.parse_file Sys.argv.(2) in
   let modules_name = GC.get_modules_name (ExtXml.parse_file Sys.argv.(1)) in
 
   let out_h = stdout in
@@ -231,7 +247,7 @@ let _ =
   fprintf out_h "#define TELEMETRY_FREQUENCY %d\n\n" freq;
 
   (** Print the telemetry table with ID *)
-  print_message_table out_h telemetry_xml;
+  print_message_table out_h telemetry_xml messages_xml;
 
   (** Print process sending functions *)
   print_process_send out_h telemetry_xml freq modules_name;
@@ -1,89 +1,441 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file mergelogs.c
+ *
+ * Merge any number of .data logs (ground logs, logs extracted from the
+ * onboard SD cards by sd2log...) by time.
+ *
+ * The logs are read line by line and merged with a heap holding the current
+ * line of each of them, so the memory use does not depend on their size.
+ * Each log is expected to be in time order.
+ *
+ * The clocks of the logs are aligned on the clock of the first one with GPS
+ * time, from the time of week of their GPS messages: a first pass over each
+ * log fits a line to its GPS time against its local time, giving its clock
+ * offset and drift. They can also be given for each log, which skips this pass.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+/** Message giving the GPS time of week, with its field indexes (1 is the first field) */
+#define GPS_MSG "GPS"
+#define GPS_MODE_FIELD 1
+#define GPS_ITOW_FIELD 9
+#define GPS_MODE_3D 3
+
+#define WEEK_S 604800.
+/** Estimated drifts larger than this are considered as wrong fits */
+#define MAX_DRIFT 1e-3
 
+struct LogSource {
+  const char *name;
+  FILE *file;
+  int is_pipe;
+  char *line;       ///< current line
+  size_t size;      ///< size of the line buffer
+  char *msg;        ///< current line after the time stamp
+  double time;      ///< time of the current line, output clock
+  /* local to output clock: t_out = scale * t + offset */
+  double scale;
+  double offset;
+  int manual;       ///< clock offset and drift given on the command line
+  /* local time of the first and last lines */
+  double first;
+  double last;
+  /* least squares fit of the GPS time against the local time,
+   * on values relative to the first fix for precision */
+  long nb_fix;
+  double t0, tow0, last_tow;
+  double sx, sy, sxx, sxy;
+  /* GPS time = gps_scale * (t - t0) + gps_offset */
+  double gps_scale;
+  double gps_offset;
+};
 
-char buf[200];
+static struct LogSource *sources;
+static int nb_sources;
 
-float get_time(char* str)
+/* min-heap of the sources with a current line, ordered by time */
+static int *heap;
+static int heap_size;
+
+
+static int open_source(struct LogSource *s)
 {
-	float time = 0.0f;
-	sscanf(str,"%f", &time);
-	return time;
+  size_t len = strlen(s->name);
+  const char *unzip = NULL;
+  s->is_pipe = 0;
+  if (strcmp(s->name, "-") == 0) {
+    s->file = stdin;
+    return 0;
+  }
+  if (len > 3 && strcmp(s->name + len - 3, ".gz") == 0) {
+    unzip = "gzip -dc";
+  } else if (len > 4 && strcmp(s->name + len - 4, ".bz2") == 0) {
+    unzip = "bzip2 -dc";
+  }
+  if (unzip != NULL) {
+    if (strchr(s->name, '\'') != NULL) {
+      fprintf(stderr, "Unsupported file name %s\n", s->name);
+      return -1;
+    }
+    char *cmd = malloc(len + strlen(unzip) + 4);
+    sprintf(cmd, "%s '%s'", unzip, s->name);
+    s->file = popen(cmd, "r");
+    free(cmd);
+    s->is_pipe = 1;
+  } else {
+    s->file = fopen(s->name, "r");
+  }
+  if (s->file == NULL) {
+    perror(s->name);
+    return -1;
+  }
+  return 0;
 }
 
-void add_time(char* str, float offset, FILE* fp)
+static void close_source(struct LogSource *s)
 {
-	float time = 0.0f;
-	char* c = strchr(str, ' ');
-	if (c == 0)
-		return;
+  if (s->is_pipe) {
+    pclose(s->file);
+  } else if (s->file != stdin) {
+    fclose(s->file);
+  }
+  s->file = NULL;
+}
 
-	sscanf(str,"%f", &time);
-	fprintf(fp, "%.3f%s", time+offset, c);
+/** Read the next line with a time stamp, its local time in t, returns -1 at the end */
+static int read_line(struct LogSource *s, double *t)
+{
+  while (getline(&s->line, &s->size, s->file) != -1) {
+    char *end;
+    *t = strtod(s->line, &end);
+    if (end != s->line && *end == ' ') {
+      s->msg = end;
+      return 0;
+    }
+  }
+  return -1;
 }
 
-int merge(char* fn1, char* fn2)
+/** Returns the n-th field after the message name, or NULL */
+static const char *get_field(const char *p, int n)
 {
-	FILE* f1 = fopen(fn1,"r+w");
-	FILE* f2 = fopen(fn2,"r");
-	int res = 0;
-	char str[200];
-	float offset = 0.0f;
-	int firstline = 1;
-
-	if ((f1 > 0) && (f2 > 0))
-	{
-		//
-		printf("Searching End Time in File '%s'\n",fn1);
-
-		while(fgets(str,sizeof(str),f1) != NULL)
-		{
-		}
-
-		printf("Last Line:\n%s\n",str);
-		offset = get_time(str);
-		printf("Last Time Stamp: %f\n", offset);
-
-		while(fgets(str,sizeof(str),f2) != NULL)
-		{
-			// Find initial time
-			//if (firstline)
-			//{
-			//	firstline = 0;
-			//	offset -= get_time(str);
-			//}
-
-			// Change Time and add to first file:
-			add_time(str, offset, f1);
-		}
-
-	}
-	else
-	{
-		fprintf(stderr,"Failed to open file\n");
-		res = -1;
-	}
-
-	if (f1 > 0)
-		fclose(f1);
-	if (f2 > 0)
-		fclose(f2);
-
-	return -1;
+  for (int i = 0; i < n; i++) {
+    p = strchr(p, ' ');
+    if (p == NULL) {
+      return NULL;
+    }
+    while (*p == ' ') {
+      p++;
+    }
+  }
+  return p;
 }
 
+static void add_fix(struct LogSource *s, double t, const char *msg)
+{
+  const char *mode = get_field(msg, GPS_MODE_FIELD);
+  const char *itow = get_field(msg, GPS_ITOW_FIELD);
+  if (mode == NULL || itow == NULL || atoi(mode) != GPS_MODE_3D) {
+    return;
+  }
+  double tow = strtod(itow, NULL) / 1000.;
+  if (s->nb_fix == 0) {
+    s->t0 = t;
+    s->tow0 = tow;
+  } else {
+    /* new week */
+    while (tow < s->last_tow - WEEK_S / 2) {
+      tow += WEEK_S;
+    }
+  }
+  s->last_tow = tow;
+  double x = t - s->t0;
+  double y = tow - s->tow0;
+  s->nb_fix++;
+  s->sx += x;
+  s->sy += y;
+  s->sxx += x * x;
+  s->sxy += x * y;
+}
 
+/** First pass over a log: time span and GPS clock fit */
+static int scan_source(struct LogSource *s, int use_gps)
+{
+  double t;
+  if (open_source(s) != 0) {
+    return -1;
+  }
+  s->nb_fix = 0;
+  s->sx = s->sy = s->sxx = s->sxy = 0.;
+  s->first = s->last = 0.;
+  if (read_line(s, &t) == 0) {
+    s->first = t;
+    do {
+      s->last = t;
+      if (use_gps) {
+        /* skip the A/C id */
+        const char *msg = s->msg;
+        while (*msg == ' ') {
+          msg++;
+        }
+        msg = get_field(msg, 1);
+        if (msg != NULL && strncmp(msg, GPS_MSG " ", strlen(GPS_MSG) + 1) == 0) {
+          add_fix(s, t, msg);
+        }
+      }
+    } while (read_line(s, &t) == 0);
+  }
+  close_source(s);
 
+  if (s->nb_fix > 0) {
+    const double n = s->nb_fix;
+    const double den = n * s->sxx - s->sx * s->sx;
+    s->gps_scale = 1.;
+    if (s->nb_fix > 1 && den > 0.) {
+      s->gps_scale = (n * s->sxy - s->sx * s->sy) / den;
+      if (s->gps_scale - 1. > MAX_DRIFT || 1. - s->gps_scale > MAX_DRIFT) {
+        fprintf(stderr, "%s: clock drift of %.0f ppm ignored\n", s->name, (s->gps_scale - 1.) * 1e6);
+        s->gps_scale = 1.;
+      }
+    }
+    s->gps_offset = s->tow0 + (s->sy - s->gps_scale * s->sx) / n;
+  }
+  return 0;
+}
 
-int main(int argc, char** argv)
+/** Set the clock conversions, relative to the first log with GPS time */
+static void align_sources(int append)
 {
-	if (argc < 3)
-	{
-		fprintf(stderr, "Program needs 2 logfile names to merge\n");
-		return -1;
-	}
+  struct LogSource *ref = NULL;
+  for (int i = 0; i < nb_sources; i++) {
+    if (!sources[i].manual && sources[i].nb_fix > 0) {
+      ref = &sources[i];
+      break;
+    }
+  }
+
+  double prev_end = 0.;
+  for (int i = 0; i < nb_sources; i++) {
+    struct LogSource *s = &sources[i];
+    if (!s->manual) {
+      if (s->nb_fix > 0) {
+        /* t_out = local time of ref at the GPS time of t */
+        double dt = s->gps_offset - ref->gps_offset;
+        while (dt > WEEK_S / 2) {
+          dt -= WEEK_S;
+        }
+        while (dt < -WEEK_S / 2) {
+          dt += WEEK_S;
+        }
+        s->scale = s->gps_scale / ref->gps_scale;
+        s->offset = (dt - s->gps_scale * s->t0) / ref->gps_scale + ref->t0;
+      } else if (append && i > 0) {
+        /* starts at the end of the previous one */
+        s->scale = 1.;
+        s->offset = prev_end - s->first;
+      } else {
+        s->scale = 1.;
+        s->offset = 0.;
+      }
+      fprintf(stderr, "%s: %ld GPS fixes, offset %.4f s, drift %.1f ppm\n", s->name, s->nb_fix, s->offset,
+              (s->scale - 1.) * 1e6);
+    }
+    prev_end = s->scale * s->last + s->offset;
+  }
+}
+
+
+static int heap_less(int a, int b)
+{
+  if (sources[a].time != sources[b].time) {
+    return sources[a].time < sources[b].time;
+  }
+  return a < b;
+}
+
+static void heap_down(int i)
+{
+  for (;;) {
+    int min = i;
+    int l = 2 * i + 1, r = 2 * i + 2;
+    if (l < heap_size && heap_less(heap[l], heap[min])) {
+      min = l;
+    }
+    if (r < heap_size && heap_less(heap[r], heap[min])) {
+      min = r;
+    }
+    if (min == i) {
+      return;
+    }
+    int tmp = heap[i];
+    heap[i] = heap[min];
+    heap[min] = tmp;
+    i = min;
+  }
+}
+
+/** Read the next line of a source, returns -1 at the end */
+static int next_line(struct LogSource *s)
+{
+  double t;
+  if (read_line(s, &t) != 0) {
+    return -1;
+  }
+  s->time = s->scale * t + s->offset;
+  return 0;
+}
+
+static void merge(FILE *out)
+{
+  heap = malloc(nb_sources * sizeof(int));
+  heap_size = 0;
+  for (int i = 0; i < nb_sources; i++) {
+    if (next_line(&sources[i]) == 0) {
+      heap[heap_size++] = i;
+    }
+  }
+  for (int i = heap_size / 2 - 1; i >= 0; i--) {
+    heap_down(i);
+  }
+
+  while (heap_size > 0) {
+    struct LogSource *s = &sources[heap[0]];
+    size_t len = strlen(s->msg);
+    fprintf(out, "%.4f", s->time);
+    fwrite(s->msg, 1, len, out);
+    if (len > 0 && s->msg[len - 1] != '\n') {
+      fputc('\n', out);
+    }
+    if (next_line(s) != 0) {
+      heap[0] = heap[--heap_size];
+    }
+    heap_down(0);
+  }
+  free(heap);
+}
+
+
+static void usage(const char *prog)
+{
+  fprintf(stderr,
+          "Usage: %s [-o output] [-n] [-a] log[,offset[,drift]] ...\n"
+          "Merges .data logs by time, in the clock of the first one with GPS time.\n"
+          "Logs can be compressed (.gz, .bz2), - is the standard input (after --).\n"
+          "  log,offset,drift  output time = (1 + drift * 1e-6) * time + offset,\n"
+          "                    instead of the alignment on the GPS time\n"
+          "  -o output  output file, default is the standard output\n"
+          "  -n         do not use the GPS time\n"
+          "  -a         logs without GPS time start at the end of the previous one\n",
+          prog);
+}
+
+int main(int argc, char **argv)
+{
+  const char *output = NULL;
+  int use_gps = 1;
+  int append = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "o:nah")) != -1) {
+    switch (opt) {
+      case 'o':
+        output = optarg;
+        break;
+      case 'n':
+        use_gps = 0;
+        break;
+      case 'a':
+        append = 1;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+  nb_sources = argc - optind;
+  if (nb_sources < 1) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  sources = calloc(nb_sources, sizeof(struct LogSource));
+  for (int i = 0; i < nb_sources; i++) {
+    struct LogSource *s = &sources[i];
+    char *name = strdup(argv[optind + i]);
+    char *sep = strchr(name, ',');
+    s->name = name;
+    s->scale = 1.;
+    if (sep != NULL) {
+      *sep = '\0';
+      s->manual = 1;
+      s->offset = strtod(sep + 1, &sep);
+      if (*sep == ',') {
+        s->scale = 1. + strtod(sep + 1, NULL) * 1e-6;
+      }
+    }
+  }
 
-	printf("Merging '%s' and '%s'\n",argv[1], argv[2]);
+  /* first pass, unless everything is given */
+  for (int i = 0; i < nb_sources; i++) {
+    struct LogSource *s = &sources[i];
+    if (s->manual) {
+      continue;
+    }
+    if (strcmp(s->name, "-") == 0) {
+      fprintf(stderr, "The clock of the standard input must be given (-- -,offset[,drift])\n");
+      return 1;
+    }
+    if (scan_source(s, use_gps) != 0) {
+      return 1;
+    }
+  }
+  align_sources(append);
 
-	return merge(argv[1],argv[2]);
+  FILE *out = stdout;
+  if (output != NULL) {
+    out = fopen(output, "w");
+    if (out == NULL) {
+      perror(output);
+      return 1;
+    }
+  }
+  for (int i = 0; i < nb_sources; i++) {
+    if (open_source(&sources[i]) != 0) {
+      return 1;
+    }
+  }
+  merge(out);
+  for (int i = 0; i < nb_sources; i++) {
+    close_source(&sources[i]);
+  }
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
 }
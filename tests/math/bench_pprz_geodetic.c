@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_pprz_geodetic.c
+ * @brief Micro-benchmark of the scalar and batch geodetic conversions.
+ *
+ * Converts a track of GPS fixes around a reference point one by one
+ * and with the array functions, and reports the time per point.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "math/pprz_geodetic_float.h"
+#include "math/pprz_geodetic_double.h"
+
+#define NB_POINTS 100000
+#ifndef ITERATIONS
+#define ITERATIONS 10
+#endif
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void report(const char *name, double t_scalar, double t_array)
+{
+  printf("%-20s %10.1f %10.1f %8.2fx\n", name, t_scalar * 1e9 / ((double)ITERATIONS * NB_POINTS),
+         t_array * 1e9 / ((double)ITERATIONS * NB_POINTS), t_scalar / t_array);
+}
+
+static double lat_d[NB_POINTS], lon_d[NB_POINTS], alt_d[NB_POINTS];
+static double x_d[NB_POINTS], y_d[NB_POINTS], z_d[NB_POINTS];
+static double u_d[NB_POINTS], v_d[NB_POINTS], w_d[NB_POINTS];
+static float lat_f[NB_POINTS], lon_f[NB_POINTS], alt_f[NB_POINTS];
+static float x_f[NB_POINTS], y_f[NB_POINTS], z_f[NB_POINTS];
+static float u_f[NB_POINTS], v_f[NB_POINTS], w_f[NB_POINTS];
+
+int main(void)
+{
+  struct LlaCoorArray_d lla_d = { lat_d, lon_d, alt_d };
+  struct EcefCoorArray_d ecef_d = { x_d, y_d, z_d };
+  struct LlaCoorArray_d lla_out_d = { u_d, v_d, w_d };
+  struct NedCoorArray_d ned_d = { u_d, v_d, w_d };
+  struct LlaCoorArray_f lla_f = { lat_f, lon_f, alt_f };
+  struct EcefCoorArray_f ecef_f = { x_f, y_f, z_f };
+  struct NedCoorArray_f ned_f = { u_f, v_f, w_f };
+  struct UtmCoorArray_f utm_f = { u_f, v_f, w_f, 31 };
+  double t0, t_scalar;
+  int i, it;
+
+  /* a track around Toulouse */
+  for (i = 0; i < NB_POINTS; i++) {
+    lat_d[i] = RadOfDeg(43.46 + 0.01 * sin(i * 1e-3));
+    lon_d[i] = RadOfDeg(1.27 + 0.01 * cos(i * 1.3e-3));
+    alt_d[i] = 180. + 50. * sin(i * 1e-2);
+    lat_f[i] = lat_d[i];
+    lon_f[i] = lon_d[i];
+    alt_f[i] = alt_d[i];
+  }
+  ecef_of_lla_array_d(&ecef_d, &lla_d, NB_POINTS);
+  struct LtpDef_d ltp_d;
+  struct EcefCoor_d origin_d = { x_d[0], y_d[0], z_d[0] };
+  ltp_def_from_ecef_d(&ltp_d, &origin_d);
+  struct LtpDef_f ltp_f;
+  struct LlaCoor_f origin_f = { lat_f[0], lon_f[0], alt_f[0] };
+  ltp_def_from_lla_f(&ltp_f, &origin_f);
+
+  printf("geodetic conversions, %d points, time per point in ns\n", NB_POINTS);
+  printf("%-20s %10s %10s %9s\n", "", "scalar", "array", "speedup");
+
+  /* double */
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_POINTS; i++) {
+      struct LlaCoor_d lla = { lat_d[i], lon_d[i], alt_d[i] };
+      struct EcefCoor_d ecef;
+      ecef_of_lla_d(&ecef, &lla);
+      x_d[i] = ecef.x; y_d[i] = ecef.y; z_d[i] = ecef.z;
+    }
+  }
+  t_scalar = now() - t0;
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    ecef_of_lla_array_d(&ecef_d, &lla_d, NB_POINTS);
+  }
+  report("ecef_of_lla_d", t_scalar, now() - t0);
+
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_POINTS; i++) {
+      struct EcefCoor_d ecef = { x_d[i], y_d[i], z_d[i] };
+      struct LlaCoor_d lla;
+      lla_of_ecef_d(&lla, &ecef);
+      u_d[i] = lla.lat; v_d[i] = lla.lon; w_d[i] = lla.alt;
+    }
+  }
+  t_scalar = now() - t0;
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    lla_of_ecef_array_d(&lla_out_d, &ecef_d, NB_POINTS);
+  }
+  report("lla_of_ecef_d", t_scalar, now() - t0);
+
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_POINTS; i++) {
+      struct EcefCoor_d ecef = { x_d[i], y_d[i], z_d[i] };
+      struct NedCoor_d ned;
+      ned_of_ecef_point_d(&ned, &ltp_d, &ecef);
+      u_d[i] = ned.x; v_d[i] = ned.y; w_d[i] = ned.z;
+    }
+  }
+  t_scalar = now() - t0;
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    ned_of_ecef_point_array_d(&ned_d, &ltp_d, &ecef_d, NB_POINTS);
+  }
+  report("ned_of_ecef_point_d", t_scalar, now() - t0);
+
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_POINTS; i++) {
+      struct LlaCoor_d lla = { lat_d[i], lon_d[i], alt_d[i] };
+      struct NedCoor_d ned;
+      ned_of_lla_point_d(&ned, &ltp_d, &lla);
+      u_d[i] = ned.x; v_d[i] = ned.y; w_d[i] = ned.z;
+    }
+  }
+  t_scalar = now() - t0;
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    ned_of_lla_point_array_d(&ned_d, &ltp_d, &lla_d, NB_POINTS);
+  }
+  report("ned_of_lla_point_d", t_scalar, now() - t0);
+
+  /* float */
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_POINTS; i++) {
+      struct LlaCoor_f lla = { lat_f[i], lon_f[i], alt_f[i] };
+      struct EcefCoor_f ecef;
+      ecef_of_lla_f(&ecef, &lla);
+      x_f[i] = ecef.x; y_f[i] = ecef.y; z_f[i] = ecef.z;
+    }
+  }
+  t_scalar = now() - t0;
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    ecef_of_lla_array_f(&ecef_f, &lla_f, NB_POINTS);
+  }
+  report("ecef_of_lla_f", t_scalar, now() - t0);
+
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_POINTS; i++) {
+      struct EcefCoor_f ecef = { x_f[i], y_f[i], z_f[i] };
+      struct NedCoor_f ned;
+      ned_of_ecef_point_f(&ned, &ltp_f, &ecef);
+      u_f[i] = ned.x; v_f[i] = ned.y; w_f[i] = ned.z;
+    }
+  }
+  t_scalar = now() - t0;
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    ned_of_ecef_point_array_f(&ned_f, &ltp_f, &ecef_f, NB_POINTS);
+  }
+  report("ned_of_ecef_point_f", t_scalar, now() - t0);
+
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_POINTS; i++) {
+      struct LlaCoor_f lla = { lat_f[i], lon_f[i], alt_f[i] };
+      struct UtmCoor_f utm = { .zone = 31 };
+      utm_of_lla_f(&utm, &lla);
+      u_f[i] = utm.north; v_f[i] = utm.east; w_f[i] = utm.alt;
+    }
+  }
+  t_scalar = now() - t0;
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    utm_of_lla_array_f(&utm_f, &lla_f, NB_POINTS);
+  }
+  report("utm_of_lla_f", t_scalar, now() - t0);
+
+  return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_pprz_matrix_decomp.c
+ * @brief Micro-benchmark of the generic and fixed size matrix decompositions.
+ *
+ * Reports the time per call of the Cholesky, QR and SVD (with solve)
+ * decompositions for a few sizes, through the row pointer API (including
+ * building the pointer tables, as the callers have to) and the fixed size API.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "math/pprz_algebra_float.h"
+#include "math/pprz_matrix_decomp_float.h"
+
+#ifndef ITERATIONS
+#define ITERATIONS 20000
+#endif
+#define NB_MATRICES 16
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static float rand_float(void)
+{
+  return (float)rand() / RAND_MAX * 2.f - 1.f;
+}
+
+/* Random inputs: symmetric positive definite ones for Cholesky, general ones otherwise */
+static void random_matrices(float *spd, float *gen, int n)
+{
+  for (int s = 0; s < NB_MATRICES; s++) {
+    float *a = &spd[s * n * n], *g = &gen[s * n * n];
+    for (int i = 0; i < n * n; i++) {
+      g[i] = rand_float();
+    }
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        a[i * n + j] = (i == j) ? n : 0;
+        for (int k = 0; k < n; k++) {
+          a[i * n + j] += g[i * n + k] * g[j * n + k];
+        }
+      }
+    }
+  }
+}
+
+static volatile float sink;
+
+static void report(const char *name, int n, double t_generic, double t_fixed)
+{
+  printf("%-10s %2dx%-2d %10.3f %10.3f %8.2fx\n", name, n, n, t_generic * 1e6 / ITERATIONS,
+         t_fixed * 1e6 / ITERATIONS, t_generic / t_fixed);
+}
+
+#define BENCH_SIZE(_n) \
+  { \
+    static float spd[NB_MATRICES][_n][_n], gen[NB_MATRICES][_n][_n]; \
+    float a[_n][_n], b[_n][_n], c[_n][_n], w[_n], x[_n], rhs[_n]; \
+    float _rhs[_n][1], _x[_n][1]; \
+    random_matrices(&spd[0][0][0], &gen[0][0][0], _n); \
+    for (int i = 0; i < _n; i++) { rhs[i] = _rhs[i][0] = rand_float(); } \
+    double t0, t_generic, t_fixed; \
+    \
+    t0 = now(); \
+    for (int it = 0; it < ITERATIONS; it++) { \
+      MAKE_MATRIX_PTR(in_ptr, spd[it % NB_MATRICES], _n); \
+      MAKE_MATRIX_PTR(a_ptr, a, _n); \
+      pprz_cholesky_float(a_ptr, in_ptr, _n); \
+      sink = a[_n - 1][_n - 1]; \
+    } \
+    t_generic = now() - t0; \
+    t0 = now(); \
+    for (int it = 0; it < ITERATIONS; it++) { \
+      pprz_cholesky_float_##_n(a, spd[it % NB_MATRICES]); \
+      sink = a[_n - 1][_n - 1]; \
+    } \
+    t_fixed = now() - t0; \
+    report("cholesky", _n, t_generic, t_fixed); \
+    \
+    t0 = now(); \
+    for (int it = 0; it < ITERATIONS; it++) { \
+      MAKE_MATRIX_PTR(in_ptr, gen[it % NB_MATRICES], _n); \
+      MAKE_MATRIX_PTR(q_ptr, a, _n); \
+      MAKE_MATRIX_PTR(r_ptr, b, _n); \
+      pprz_qr_float(q_ptr, r_ptr, in_ptr, _n, _n); \
+      sink = b[_n - 1][_n - 1]; \
+    } \
+    t_generic = now() - t0; \
+    t0 = now(); \
+    for (int it = 0; it < ITERATIONS; it++) { \
+      pprz_qr_float_##_n(a, b, gen[it % NB_MATRICES]); \
+      sink = b[_n - 1][_n - 1]; \
+    } \
+    t_fixed = now() - t0; \
+    report("qr", _n, t_generic, t_fixed); \
+    \
+    t0 = now(); \
+    for (int it = 0; it < ITERATIONS; it++) { \
+      memcpy(a, gen[it % NB_MATRICES], sizeof(a)); \
+      MAKE_MATRIX_PTR(a_ptr, a, _n); \
+      MAKE_MATRIX_PTR(v_ptr, c, _n); \
+      MAKE_MATRIX_PTR(rhs_ptr, _rhs, _n); \
+      MAKE_MATRIX_PTR(x_ptr, _x, _n); \
+      pprz_svd_float(a_ptr, w, v_ptr, _n, _n); \
+      pprz_svd_solve_float(x_ptr, a_ptr, w, v_ptr, rhs_ptr, _n, _n, 1); \
+      sink = _x[0][0]; \
+    } \
+    t_generic = now() - t0; \
+    t0 = now(); \
+    for (int it = 0; it < ITERATIONS; it++) { \
+      memcpy(a, gen[it % NB_MATRICES], sizeof(a)); \
+      pprz_svd_float_##_n(a, w, c, _n); \
+      pprz_svd_solve_float_##_n(x, a, w, c, rhs, _n); \
+      sink = x[0]; \
+    } \
+    t_fixed = now() - t0; \
+    report("svd+solve", _n, t_generic, t_fixed); \
+  }
+
+int main(void)
+{
+  srand(42);
+  printf("matrix decompositions, %d iterations, time per call in us\n", ITERATIONS);
+  printf("%-10s %5s %10s %10s %9s\n", "", "size", "generic", "fixed", "speedup");
+  BENCH_SIZE(3)
+  BENCH_SIZE(4)
+  BENCH_SIZE(6)
+  BENCH_SIZE(9)
+  BENCH_SIZE(12)
+  return 0;
+}
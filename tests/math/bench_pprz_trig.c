@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_pprz_trig.c
+ * @brief Accuracy and throughput of the trig functions.
+ *
+ * Prints the max error and the time per call of the integer and float
+ * sine/cosine and atan2 functions, for the table configuration it is built with,
+ * e.g. make bench USER_CFLAGS="-DPPRZ_TRIG_INT_FULL_TABLE=FALSE -DPPRZ_TRIG_INTERP_BITS=6"
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "math/pprz_algebra_int.h"
+#include "math/pprz_trig_int.h"
+
+#define NB_ANGLES 4096
+#ifndef ITERATIONS
+#define ITERATIONS 500
+#endif
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static volatile int32_t sink_i;
+static volatile float sink_f;
+
+static void report(const char *name, double err, const char *unit, double t)
+{
+  printf("%-22s %10.3g %-4s %8.2f\n", name, err, unit, t * 1e9 / ((double)ITERATIONS * NB_ANGLES));
+}
+
+int main(void)
+{
+  static int32_t angle_i[NB_ANGLES], s_i[NB_ANGLES], c_i[NB_ANGLES], x_i[NB_ANGLES], y_i[NB_ANGLES];
+  static float angle_f[NB_ANGLES], s_f[NB_ANGLES], c_f[NB_ANGLES], x_f[NB_ANGLES], y_f[NB_ANGLES];
+  double t0, err;
+  int i, it;
+
+  for (i = 0; i < NB_ANGLES; i++) {
+    angle_i[i] = -INT32_ANGLE_PI + (int32_t)((2 * (int64_t)INT32_ANGLE_PI * i) / NB_ANGLES);
+    angle_f[i] = ANGLE_FLOAT_OF_BFP(angle_i[i]);
+    x_f[i] = 1000.f * cosf(angle_f[i] * 3.f) + 10.f;
+    y_f[i] = 1000.f * sinf(angle_f[i] * 7.f) - 10.f;
+    x_i[i] = (int32_t)x_f[i];
+    y_i[i] = (int32_t)y_f[i];
+    x_f[i] = x_i[i];
+    y_f[i] = y_i[i];
+  }
+
+  printf("PPRZ_TRIG_INT_FULL_TABLE %d, PPRZ_TRIG_INTERP_BITS %d\n", PPRZ_TRIG_INT_FULL_TABLE, PPRZ_TRIG_INTERP_BITS);
+  printf("%-22s %15s %8s\n", "", "max error", "ns/call");
+
+  /* integer sine/cosine, error of the table on [0, pi/2] in LSB */
+  err = 0;
+  for (i = 0; i <= INT32_ANGLE_PI_2; i++) {
+    err = fmax(err, fabs(pprz_itrig_sin(i) - TRIG_BFP_OF_REAL(sin(ANGLE_FLOAT_OF_BFP(i)))));
+  }
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_ANGLES; i++) {
+      sink_i = pprz_itrig_sin(angle_i[i]) + pprz_itrig_cos(angle_i[i]);
+    }
+  }
+  report("pprz_itrig_sin+cos", err, "LSB", now() - t0);
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    pprz_itrig_sincos_array(s_i, c_i, angle_i, NB_ANGLES);
+    sink_i = s_i[it % NB_ANGLES];
+  }
+  report("pprz_itrig_sincos", err, "LSB", now() - t0);
+
+  /* float sine/cosine */
+  err = 0;
+  for (i = 0; i < NB_ANGLES; i++) {
+    float s, c;
+    pprz_trig_sincos_f(&s, &c, angle_f[i] * 1.37f);
+    err = fmax(err, fmax(fabs(s - sin(angle_f[i] * 1.37f)), fabs(c - cos(angle_f[i] * 1.37f))));
+  }
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_ANGLES; i++) {
+      sink_f = sinf(angle_f[i]) + cosf(angle_f[i]);
+    }
+  }
+  report("sinf+cosf", 0, "", now() - t0);
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    pprz_trig_sincos_f_array(s_f, c_f, angle_f, NB_ANGLES);
+    sink_f = s_f[it % NB_ANGLES];
+  }
+  report("pprz_trig_sincos_f", err, "", now() - t0);
+
+  /* atan2, error in rad */
+#define BENCH_ATAN2(_f) { \
+    err = 0; \
+    for (i = 0; i < NB_ANGLES; i++) { \
+      double e = fabs(ANGLE_FLOAT_OF_BFP(_f(y_i[i], x_i[i])) - atan2(y_i[i], x_i[i])); \
+      err = fmax(err, fmin(e, 2 * M_PI - e)); \
+    } \
+    t0 = now(); \
+    for (it = 0; it < ITERATIONS; it++) { \
+      for (i = 0; i < NB_ANGLES; i++) { \
+        sink_i = _f(y_i[i], x_i[i]); \
+      } \
+    } \
+    report(#_f, err, "rad", now() - t0); \
+  }
+  BENCH_ATAN2(int32_atan2)
+  BENCH_ATAN2(int32_atan2_2)
+  BENCH_ATAN2(int32_atan2_table)
+  t0 = now();
+  for (it = 0; it < ITERATIONS; it++) {
+    for (i = 0; i < NB_ANGLES; i++) {
+      sink_f = atan2f(y_f[i], x_f[i]);
+    }
+  }
+  report("atan2f", 0, "", now() - t0);
+
+  return 0;
+}
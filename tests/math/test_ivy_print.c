@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_ivy_print.c
+ * @brief Tests for the Ivy number printers.
+ *
+ * The output of ivy_print_uint, ivy_print_int and ivy_print_double is
+ * compared with the "%u", "%d" and "%f" formats of snprintf.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+#include "subsystems/datalink/ivy_print.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NB_RANDOM 1000000
+
+/* max number of mismatches printed per test */
+#define MAX_NOTES 5
+
+static uint64_t rand64(void)
+{
+  uint64_t r = 0;
+  for (int i = 0; i < 4; i++) {
+    r = (r << 16) | (uint64_t)(rand() & 0xffff);
+  }
+  return r;
+}
+
+/* count the differences with snprintf, the first ones are noted */
+static void check_double(double v, int *errors)
+{
+  char got[IVY_PRINT_MAX_LEN + 1], expected[IVY_PRINT_MAX_LEN + 1];
+  *ivy_print_double(got, v) = '\0';
+  snprintf(expected, sizeof(expected), "%f", v);
+  if (strcmp(got, expected) != 0) {
+    if ((*errors)++ < MAX_NOTES) {
+      note("%a: got %s, expected %s", v, got, expected);
+    }
+  }
+}
+
+static void check_uint(uint64_t v, int *errors)
+{
+  char got[24], expected[24];
+  *ivy_print_uint(got, v) = '\0';
+  snprintf(expected, sizeof(expected), "%" PRIu64, v);
+  if (strcmp(got, expected) != 0) {
+    if ((*errors)++ < MAX_NOTES) {
+      note("got %s, expected %s", got, expected);
+    }
+  }
+}
+
+static void check_int(int64_t v, int *errors)
+{
+  char got[24], expected[24];
+  *ivy_print_int(got, v) = '\0';
+  snprintf(expected, sizeof(expected), "%" PRId64, v);
+  if (strcmp(got, expected) != 0) {
+    if ((*errors)++ < MAX_NOTES) {
+      note("got %s, expected %s", got, expected);
+    }
+  }
+}
+
+static void test_uint(void)
+{
+  int errors = 0;
+  const uint64_t values[] = { 0, 1, 9, 10, 99, 100, UINT8_MAX, UINT16_MAX, UINT32_MAX,
+                              (uint64_t)UINT32_MAX + 1, 10000000000000000000ULL, UINT64_MAX
+                            };
+  for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    check_uint(values[i], &errors);
+  }
+  for (int i = 0; i < NB_RANDOM; i++) {
+    /* random number of digits */
+    check_uint(rand64() >> (rand() % 64), &errors);
+  }
+  ok(errors == 0, "ivy_print_uint is the same as %%u (%d differences)", errors);
+}
+
+static void test_int(void)
+{
+  int errors = 0;
+  const int64_t values[] = { 0, 1, -1, 9, -10, INT8_MIN, INT8_MAX, INT16_MIN, INT16_MAX,
+                             INT32_MIN, INT32_MAX, INT64_MIN, INT64_MAX
+                           };
+  for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    check_int(values[i], &errors);
+  }
+  for (int i = 0; i < NB_RANDOM; i++) {
+    check_int((int64_t)rand64() >> (rand() % 64), &errors);
+  }
+  ok(errors == 0, "ivy_print_int is the same as %%d (%d differences)", errors);
+}
+
+static void test_double_random(void)
+{
+  int errors = 0;
+  for (int i = 0; i < NB_RANDOM; i++) {
+    /* uniform mantissa, exponent in the range the values are printed exactly */
+    double v = ldexp((double)(rand64() >> 11) / 9007199254740992., rand() % 80 - 40);
+    check_double(rand() % 2 ? v : -v, &errors);
+  }
+  for (int i = 0; i < NB_RANDOM; i++) {
+    /* as sent by the transport for the float fields */
+    float f = (float)ldexp((double)(rand() & 0xffffff) / 16777216., rand() % 80 - 40);
+    check_double(rand() % 2 ? f : -f, &errors);
+  }
+  ok(errors == 0, "ivy_print_double is the same as %%f on random values (%d differences)", errors);
+}
+
+/* v * 1e6 is exactly halfway between two integers for the odd multiples of 1/128 */
+static void test_double_halfway(void)
+{
+  int errors = 0;
+  for (int j = 1; j < 200000; j += 2) {
+    const double v = j / 128.;
+    check_double(v, &errors);
+    check_double(-v, &errors);
+    check_double(nextafter(v, 0.), &errors);
+    check_double(nextafter(v, INFINITY), &errors);
+    check_double(nextafter(-v, 0.), &errors);
+    check_double(nextafter(-v, -INFINITY), &errors);
+  }
+  /* and the decimal halfway values that are not exact in binary */
+  for (int j = 1; j < 200000; j += 2) {
+    check_double(j * 5e-7, &errors);
+    check_double(-j * 5e-7, &errors);
+  }
+  ok(errors == 0, "ivy_print_double is the same as %%f on halfway cases (%d differences)", errors);
+}
+
+static void test_double_zero(void)
+{
+  int errors = 0;
+  check_double(0., &errors);
+  check_double(-0., &errors);
+  check_double(1e-300, &errors);
+  check_double(-1e-300, &errors);
+  check_double(-4e-7, &errors);
+  check_double(-5e-7, &errors);
+  check_double(-6e-7, &errors);
+  ok(errors == 0, "ivy_print_double is the same as %%f around zero and -0.0 (%d differences)", errors);
+}
+
+/* values around 2^53 millionths, where the printer switches to snprintf */
+static void test_double_limit(void)
+{
+  int errors = 0;
+  const double limit = 9007199254740992. / 1e6;
+  double v = limit;
+  for (int i = 0; i < 100; i++) {
+    v = nextafter(v, 0.);
+  }
+  for (int i = 0; i < 200; i++) {
+    check_double(v, &errors);
+    check_double(-v, &errors);
+    v = nextafter(v, INFINITY);
+  }
+  check_double(1e300, &errors);
+  check_double(-DBL_MAX, &errors);
+  ok(errors == 0, "ivy_print_double is the same as %%f around 2^53/1e6 and above (%d differences)", errors);
+}
+
+static void test_double_special(void)
+{
+  char buf[IVY_PRINT_MAX_LEN + 1];
+  int errors = 0;
+  check_double(INFINITY, &errors);
+  check_double(-INFINITY, &errors);
+  check_double(NAN, &errors);
+  check_double(-NAN, &errors);
+  ok(errors == 0, "ivy_print_double is the same as %%f for inf and nan (%d differences)", errors);
+
+  /* the snprintf fallback never writes more than IVY_PRINT_MAX_LEN characters */
+  memset(buf, 'x', sizeof(buf));
+  char *end = ivy_print_double(buf, DBL_MAX);
+  ok(end - buf == IVY_PRINT_MAX_LEN, "ivy_print_double output is truncated to %d characters",
+     IVY_PRINT_MAX_LEN);
+}
+
+int main()
+{
+  note("running ivy print tests");
+  plan(8);
+
+  srand(42);
+  test_uint();
+  test_int();
+  test_double_random();
+  test_double_halfway();
+  test_double_zero();
+  test_double_limit();
+  test_double_special();
+
+  done_testing();
+}
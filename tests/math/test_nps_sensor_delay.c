@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_nps_sensor_delay.c
+ * @brief Tests for the NPS sensor delay line.
+ *
+ * The readings are functions of their time, so the delayed output can be
+ * checked against the reading expected at time - latency.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+#include "nps_sensors_utils.h"
+#include <math.h>
+
+/* periods and latencies are exact in binary, the times are exact multiples */
+#define DT 0.125
+
+static void reading_of_time(double t, double *r)
+{
+  r[0] = t;
+  r[1] = 2. * t + 1.;
+  r[2] = -t;
+}
+
+/* stepped output: the oldest reading not older than time - latency */
+static void test_stepped(double latency)
+{
+  struct NpsSensorDelay delay;
+  nps_sensor_delay_init(&delay, 3, latency, DT, FALSE);
+
+  int errors = 0;
+  for (int k = 0; k < 200; k++) {
+    double t = k * DT;
+    double cur[3], out[3], expected[3];
+    reading_of_time(t, cur);
+    nps_sensor_delay_update(&delay, t, cur, out);
+    /* readings start at 0 */
+    double t_exp = fmax(0., ceil((t - latency) / DT) * DT);
+    reading_of_time(t_exp, expected);
+    if (out[0] != expected[0] || out[1] != expected[1] || out[2] != expected[2]) {
+      if (errors++ < 5) {
+        note("t=%f: got reading of t=%f, expected t=%f", t, out[0], t_exp);
+      }
+    }
+  }
+  ok(errors == 0, "stepped output with %.3fs latency is the reading at t - latency, rounded up", latency);
+  ok(delay.dropped == 0, "no reading dropped at the init rate");
+  nps_sensor_delay_free(&delay);
+}
+
+/* interpolated output: the linear readings are rebuilt at time - latency */
+static void test_interpolated(double latency)
+{
+  struct NpsSensorDelay delay;
+  nps_sensor_delay_init(&delay, 3, latency, DT, TRUE);
+
+  int errors = 0;
+  for (int k = 0; k < 200; k++) {
+    double t = k * DT;
+    double cur[3], out[3], expected[3];
+    reading_of_time(t, cur);
+    nps_sensor_delay_update(&delay, t, cur, out);
+    /* before the first reading, the first one is held */
+    reading_of_time(fmax(0., t - latency), expected);
+    if (fabs(out[0] - expected[0]) > 1e-12 || fabs(out[1] - expected[1]) > 1e-12 ||
+        fabs(out[2] - expected[2]) > 1e-12) {
+      if (errors++ < 5) {
+        note("t=%f: got %f %f %f, expected %f %f %f", t, out[0], out[1], out[2],
+             expected[0], expected[1], expected[2]);
+      }
+    }
+  }
+  ok(errors == 0, "interpolated output with %.3fs latency is the reading at t - latency", latency);
+  nps_sensor_delay_free(&delay);
+}
+
+/* updates faster than the init rate: fixed buffer, the oldest readings are dropped */
+static void test_overflow(void)
+{
+  const double latency = 0.5;
+  const double dt = DT / 8.;
+  struct NpsSensorDelay delay;
+  nps_sensor_delay_init(&delay, 1, latency, DT, FALSE);
+  const uint32_t capacity = delay.capacity;
+  const double *time_buf = delay.time;
+  const double *value_buf = delay.value;
+
+  int errors = 0;
+  for (int k = 0; k < 200; k++) {
+    double t = k * dt;
+    double out;
+    nps_sensor_delay_update(&delay, t, &t, &out);
+    /* too few readings are kept to reach t - latency, the output is the oldest kept */
+    if (delay.count > capacity || out < t - latency ||
+        out != t - (delay.count - 1) * dt) {
+      if (errors++ < 5) {
+        note("t=%f: got reading of t=%f with %u readings", t, out, delay.count);
+      }
+    }
+  }
+  ok(errors == 0, "output is the oldest kept reading when the buffer is full");
+  ok(delay.capacity == capacity && delay.time == time_buf && delay.value == value_buf,
+     "buffer is not reallocated (capacity %u)", delay.capacity);
+  ok(delay.dropped == 200 - capacity, "dropped readings are counted (%u)", delay.dropped);
+  nps_sensor_delay_free(&delay);
+}
+
+int main()
+{
+  note("running NPS sensor delay tests");
+  plan(8);
+
+  test_stepped(0.5);
+  test_stepped(0.3);
+  test_interpolated(0.3);
+  test_overflow();
+
+  done_testing();
+}
@@ -355,10 +355,88 @@ static void test_lla_of_ecef(void)
   cmp_ok(lla_i.alt, "==", lla_ref_i.alt, "altitude (int) matches reference");
 }
 
+#define NB_ARRAY_POINTS 200
+
+static void test_array_conversions(void)
+{
+  note("--- compare array conversions with the scalar ones on %d points", NB_ARRAY_POINTS);
+
+  static double lat[NB_ARRAY_POINTS], lon[NB_ARRAY_POINTS], alt[NB_ARRAY_POINTS];
+  static double x[NB_ARRAY_POINTS], y[NB_ARRAY_POINTS], z[NB_ARRAY_POINTS];
+  static double u[NB_ARRAY_POINTS], v[NB_ARRAY_POINTS], w[NB_ARRAY_POINTS];
+  static float lat_f[NB_ARRAY_POINTS], lon_f[NB_ARRAY_POINTS], alt_f[NB_ARRAY_POINTS];
+  static float u_f[NB_ARRAY_POINTS], v_f[NB_ARRAY_POINTS], w_f[NB_ARRAY_POINTS];
+  struct LlaCoorArray_d lla_a = { lat, lon, alt };
+  struct EcefCoorArray_d ecef_a = { x, y, z };
+  struct LlaCoorArray_d lla_out_a = { u, v, w };
+  struct NedCoorArray_d ned_a = { u, v, w };
+  struct LlaCoorArray_f lla_f_a = { lat_f, lon_f, alt_f };
+  struct UtmCoorArray_f utm_f_a = { u_f, v_f, w_f, 31 };
+  int i;
+
+  for (i = 0; i < NB_ARRAY_POINTS; i++) {
+    lat[i] = RadOfDeg(43.6 + 0.05 * sin(i * 0.1));
+    lon[i] = RadOfDeg(1.44 + 0.05 * cos(i * 0.13));
+    alt[i] = 180. + 1000. * sin(i * 0.07);
+    lat_f[i] = lat[i];
+    lon_f[i] = lon[i];
+    alt_f[i] = alt[i];
+  }
+
+  struct EcefCoor_d ecef_ref = { 4624497.0, 116475.0, 4376563.0 };
+  struct LtpDef_d ltp_def;
+  ltp_def_from_ecef_d(&ltp_def, &ecef_ref);
+
+  double ecef_err = 0, lla_err = 0, alt_err = 0, ned_err = 0;
+  ecef_of_lla_array_d(&ecef_a, &lla_a, NB_ARRAY_POINTS);
+  lla_of_ecef_array_d(&lla_out_a, &ecef_a, NB_ARRAY_POINTS);
+  for (i = 0; i < NB_ARRAY_POINTS; i++) {
+    struct LlaCoor_d lla = { lat[i], lon[i], alt[i] };
+    struct EcefCoor_d ecef;
+    ecef_of_lla_d(&ecef, &lla);
+    ecef_err = Max(ecef_err, fabs(ecef.x - x[i]) + fabs(ecef.y - y[i]) + fabs(ecef.z - z[i]));
+    struct LlaCoor_d lla_check;
+    lla_of_ecef_d(&lla_check, &ecef);
+    lla_err = Max(lla_err, fabs(lla_check.lat - u[i]) + fabs(lla_check.lon - v[i]));
+    alt_err = Max(alt_err, fabs(lla_check.alt - w[i]));
+  }
+  note("ecef_of_lla_array_d max error %g m, lla_of_ecef_array_d max error %g rad, %g m", ecef_err, lla_err, alt_err);
+  ok(ecef_err < 1e-6 && lla_err < 1e-12 && alt_err < 1e-6, "ECEF <-> LLA arrays match the scalar conversions");
+
+  ned_of_lla_point_array_d(&ned_a, &ltp_def, &lla_a, NB_ARRAY_POINTS);
+  for (i = 0; i < NB_ARRAY_POINTS; i++) {
+    struct LlaCoor_d lla = { lat[i], lon[i], alt[i] };
+    struct NedCoor_d ned;
+    ned_of_lla_point_d(&ned, &ltp_def, &lla);
+    ned_err = Max(ned_err, fabs(ned.x - u[i]) + fabs(ned.y - v[i]) + fabs(ned.z - w[i]));
+  }
+  ned_of_ecef_point_array_d(&ned_a, &ltp_def, &ecef_a, NB_ARRAY_POINTS);
+  for (i = 0; i < NB_ARRAY_POINTS; i++) {
+    struct EcefCoor_d ecef = { x[i], y[i], z[i] };
+    struct NedCoor_d ned;
+    ned_of_ecef_point_d(&ned, &ltp_def, &ecef);
+    ned_err = Max(ned_err, fabs(ned.x - u[i]) + fabs(ned.y - v[i]) + fabs(ned.z - w[i]));
+  }
+  note("ned_of_lla/ecef_point_array_d max error %g m", ned_err);
+  ok(ned_err < 1e-6, "NED arrays match the scalar conversions");
+
+  double utm_err = 0;
+  utm_of_lla_array_f(&utm_f_a, &lla_f_a, NB_ARRAY_POINTS);
+  for (i = 0; i < NB_ARRAY_POINTS; i++) {
+    struct LlaCoor_f lla = { lat_f[i], lon_f[i], alt_f[i] };
+    struct UtmCoor_f utm = { .zone = 31 };
+    utm_of_lla_f(&utm, &lla);
+    utm_err = Max(utm_err, Max(fabs(utm.north - u_f[i]), fabs(utm.east - v_f[i])));
+  }
+  /* a float northing has a resolution of 0.5m */
+  note("utm_of_lla_array_f max difference %g m", utm_err);
+  ok(utm_err <= 1., "UTM array matches the scalar conversion within two float steps");
+}
+
 int main()
 {
   note("runing geodetic math tests");
-  plan(12);
+  plan(15);
 
   test_ecef_of_ned_int();
   test_enu_of_ecef_int();
@@ -366,6 +444,7 @@ int main()
   test_ecef_to_enu_to_ecef_float();
   test_lla_of_utm();
   test_lla_of_ecef();
+  test_array_conversions();
 
   done_testing();
 }
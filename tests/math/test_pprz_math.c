@@ -28,12 +28,47 @@
  */
 
 #include "tap.h"
+#include <math.h>
 #include "math/pprz_algebra_int.h"
 
+static void test_trig(void)
+{
+  int32_t a, mismatch = 0;
+  for (a = -2 * INT32_ANGLE_2_PI; a <= 2 * INT32_ANGLE_2_PI; a++) {
+    int32_t s, c;
+    pprz_itrig_sincos(&s, &c, a);
+    if (s != pprz_itrig_sin(a) || c != pprz_itrig_cos(a)) {
+      mismatch++;
+    }
+  }
+  ok(mismatch == 0, "pprz_itrig_sincos gives the same result as pprz_itrig_sin and pprz_itrig_cos");
+
+  double err_f = 0;
+  for (a = -2 * INT32_ANGLE_2_PI; a <= 2 * INT32_ANGLE_2_PI; a++) {
+    float s, c, angle = ANGLE_FLOAT_OF_BFP(a) * 1.1f;
+    pprz_trig_sincos_f(&s, &c, angle);
+    err_f = fmax(err_f, fmax(fabs(s - sin(angle)), fabs(c - cos(angle))));
+  }
+  ok(err_f < 1e-4, "pprz_trig_sincos_f max error %g", err_f);
+
+  double err_2 = 0, err_table = 0;
+  for (a = 0; a < 3600; a++) {
+    const double angle = a * M_PI / 1800.;
+    const int32_t x = (int32_t)(10000 * cos(angle) * (1 + a % 7));
+    const int32_t y = (int32_t)(10000 * sin(angle) * (1 + a % 7));
+    double e = fabs(ANGLE_FLOAT_OF_BFP(int32_atan2_2(y, x)) - atan2(y, x));
+    err_2 = fmax(err_2, fmin(e, 2 * M_PI - e));
+    e = fabs(ANGLE_FLOAT_OF_BFP(int32_atan2_table(y, x)) - atan2(y, x));
+    err_table = fmax(err_table, fmin(e, 2 * M_PI - e));
+  }
+  ok(err_2 < 0.015, "int32_atan2_2 max error %g rad", err_2);
+  ok(err_table < ANGLE_FLOAT_OF_BFP(1), "int32_atan2_table max error %g rad, less than 1 LSB", err_table);
+}
+
 int main()
 {
   note("running algebra math tests");
-  plan(1);
+  plan(5);
 
   /* test int32_vect2_normalize */
   struct Int32Vect2 v = {2300, -4200};
@@ -42,6 +77,8 @@ int main()
   ok((v.x == 491 && v.y == -898),
      "int32_vect2_normalize([2300, -4200], 10) returned [%d, %d]", v.x, v.y);
 
+  test_trig();
+
 
   done_testing();
 }
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2016 The Paparazzi Team
+ *
+ * This file is part of paparazzi.
+ *
+ * paparazzi is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * paparazzi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with paparazzi; see the file COPYING.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test_pprz_matrix_decomp.c
+ * @brief Tests for the fixed size matrix decompositions.
+ *
+ * The fixed size decompositions are compared with the generic ones
+ * on random matrices and their factors are multiplied back.
+ *
+ * Using libtap to create a TAP (TestAnythingProtocol) producer:
+ * https://github.com/zorgnax/libtap
+ *
+ */
+
+#include "tap.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include "math/pprz_algebra_float.h"
+#include "math/pprz_matrix_decomp_float.h"
+
+#define N 6
+#define M 9
+#define NB_SAMPLES 100
+
+static float rand_float(void)
+{
+  return (float)rand() / RAND_MAX * 2.f - 1.f;
+}
+
+/* random symmetric positive definite matrix */
+static void random_spd(float a[N][N])
+{
+  float b[N][N];
+  int i, j, k;
+  for (i = 0; i < N; i++) {
+    for (j = 0; j < N; j++) {
+      b[i][j] = rand_float();
+    }
+  }
+  for (i = 0; i < N; i++) {
+    for (j = 0; j < N; j++) {
+      a[i][j] = (i == j) ? N : 0;
+      for (k = 0; k < N; k++) {
+        a[i][j] += b[i][k] * b[j][k];
+      }
+    }
+  }
+}
+
+static void test_cholesky(void)
+{
+  float max_diff = 0, max_err = 0;
+  for (int s = 0; s < NB_SAMPLES; s++) {
+    float a[N][N], l[N][N], l_ref[N][N];
+    random_spd(a);
+    MAKE_MATRIX_PTR(a_ptr, a, N);
+    MAKE_MATRIX_PTR(l_ref_ptr, l_ref, N);
+    pprz_cholesky_float(l_ref_ptr, a_ptr, N);
+    pprz_cholesky_float_6(l, a);
+    for (int i = 0; i < N; i++) {
+      for (int j = 0; j < N; j++) {
+        float llt = 0;
+        for (int k = 0; k < N; k++) {
+          llt += l[i][k] * l[j][k];
+        }
+        max_err = Max(max_err, fabsf(llt - a[i][j]));
+        max_diff = Max(max_diff, fabsf(l[i][j] - l_ref[i][j]));
+      }
+    }
+    // in place
+    pprz_cholesky_float_6(a, a);
+    for (int i = 0; i < N; i++) {
+      for (int j = 0; j < N; j++) {
+        max_diff = Max(max_diff, fabsf(a[i][j] - l_ref[i][j]));
+      }
+    }
+  }
+  note("cholesky: max difference with generic %g, max error of L.Lt %g", max_diff, max_err);
+  ok(max_diff < 1e-5, "pprz_cholesky_float_6 gives the same result as pprz_cholesky_float");
+  ok(max_err < 1e-4, "pprz_cholesky_float_6 L.Lt equals the input");
+}
+
+static void test_qr(void)
+{
+  float max_diff = 0, max_err = 0, max_orth = 0, max_low = 0;
+  for (int s = 0; s < NB_SAMPLES; s++) {
+    float a[N][N], q[N][N], r[N][N], q_ref[N][N], r_ref[N][N];
+    for (int i = 0; i < N; i++) {
+      for (int j = 0; j < N; j++) {
+        a[i][j] = rand_float();
+      }
+    }
+    MAKE_MATRIX_PTR(a_ptr, a, N);
+    MAKE_MATRIX_PTR(q_ref_ptr, q_ref, N);
+    MAKE_MATRIX_PTR(r_ref_ptr, r_ref, N);
+    pprz_qr_float(q_ref_ptr, r_ref_ptr, a_ptr, N, N);
+    pprz_qr_float_6(q, r, a);
+    for (int i = 0; i < N; i++) {
+      for (int j = 0; j < N; j++) {
+        float qr = 0, qtq = 0;
+        for (int k = 0; k < N; k++) {
+          qr += q[i][k] * r[k][j];
+          qtq += q[k][i] * q[k][j];
+        }
+        max_err = Max(max_err, fabsf(qr - a[i][j]));
+        max_orth = Max(max_orth, fabsf(qtq - (i == j ? 1.f : 0.f)));
+        max_diff = Max(max_diff, fabsf(q[i][j] - q_ref[i][j]));
+        max_diff = Max(max_diff, fabsf(r[i][j] - r_ref[i][j]));
+        if (i > j) {
+          max_low = Max(max_low, fabsf(r[i][j]));
+        }
+      }
+    }
+  }
+  note("qr: max difference with generic %g, max error of Q.R %g, of Qt.Q %g", max_diff, max_err, max_orth);
+  ok(max_diff < 1e-4, "pprz_qr_float_6 gives the same result as pprz_qr_float");
+  ok(max_err < 1e-5 && max_orth < 1e-5, "pprz_qr_float_6 Q.R equals the input and Q is orthogonal");
+  ok(max_low == 0, "pprz_qr_float_6 R is upper triangular");
+}
+
+static void test_svd(void)
+{
+  float max_diff = 0, max_err = 0;
+  int converged = 1;
+  for (int s = 0; s < NB_SAMPLES; s++) {
+    float a[M][N], u[M][N], u_ref[M][N], w[N], w_ref[N], v[N][N], v_ref[N][N];
+    float b[M], x[N];
+    float _b_ref[M][1], _x_ref[N][1];
+    for (int i = 0; i < M; i++) {
+      for (int j = 0; j < N; j++) {
+        a[i][j] = u[i][j] = u_ref[i][j] = rand_float();
+      }
+      b[i] = _b_ref[i][0] = rand_float();
+    }
+    MAKE_MATRIX_PTR(u_ref_ptr, u_ref, M);
+    MAKE_MATRIX_PTR(v_ref_ptr, v_ref, N);
+    MAKE_MATRIX_PTR(b_ref_ptr, _b_ref, M);
+    MAKE_MATRIX_PTR(x_ref_ptr, _x_ref, N);
+    converged &= pprz_svd_float(u_ref_ptr, w_ref, v_ref_ptr, M, N);
+    pprz_svd_solve_float(x_ref_ptr, u_ref_ptr, w_ref, v_ref_ptr, b_ref_ptr, M, N, 1);
+    converged &= pprz_svd_float_6(u, w, v, M);
+    pprz_svd_solve_float_6(x, u, w, v, b, M);
+
+    for (int j = 0; j < N; j++) {
+      max_diff = Max(max_diff, fabsf(w[j] - w_ref[j]));
+      max_diff = Max(max_diff, fabsf(x[j] - _x_ref[j][0]));
+    }
+    for (int i = 0; i < M; i++) {
+      for (int j = 0; j < N; j++) {
+        float usvt = 0;
+        for (int k = 0; k < N; k++) {
+          usvt += u[i][k] * w[k] * v[j][k];
+        }
+        max_err = Max(max_err, fabsf(usvt - a[i][j]));
+        max_diff = Max(max_diff, fabsf(u[i][j] - u_ref[i][j]));
+      }
+    }
+  }
+  note("svd: max difference with generic %g, max error of U.W.Vt %g", max_diff, max_err);
+  ok(converged, "pprz_svd_float_6 converged");
+  ok(max_diff < 1e-5, "pprz_svd_float_6 and pprz_svd_solve_float_6 give the same result as the generic ones");
+  ok(max_err < 1e-5, "pprz_svd_float_6 U.W.Vt equals the input");
+}
+
+int main()
+{
+  note("running matrix decomposition tests");
+  plan(8);
+
+  srand(42);
+  test_cholesky();
+  test_qr();
+  test_svd();
+
+  done_testing();
+}
@@ -32,6 +32,7 @@
 #include "tap.h"
 #include "state.h"
 #include "math/pprz_geodetic_double.h"
+#include <math.h>
 
 static void test_pos_lla_i(void)
 {
@@ -75,14 +76,103 @@ static void test_pos_lla_i(void)
   }
 }
 
+/* local origin and positions around it (up to ~30km) */
+static void test_pos_ned_of_ecef(void)
+{
+  struct LlaCoor_d lla_ref = {.lat=0.749999999392454875,
+                              .lon=0.019999999054505127,
+                              .alt=180.0};
+  struct EcefCoor_d ecef_ref;
+  ecef_of_lla_d(&ecef_ref, &lla_ref);
+  struct EcefCoor_i origin_i;
+  ECEF_BFP_OF_REAL(origin_i, ecef_ref);
+  struct LtpDef_i ltp_i;
+  ltp_def_from_ecef_i(&ltp_i, &origin_i);
+  stateSetLocalOrigin_i(&ltp_i);
+
+  /* double reference with exactly the same origin */
+  struct EcefCoor_d origin_d;
+  ECEF_DOUBLE_OF_BFP(origin_d, origin_i);
+  struct LtpDef_d ltp_d;
+  ltp_def_from_ecef_d(&ltp_d, &origin_d);
+
+  double max_err_i = 0, max_err_f = 0, max_err_lla = 0, max_err_old = 0;
+  for (int k = 0; k < 50; k++) {
+    struct LlaCoor_d lla = {.lat = lla_ref.lat + (k % 7 - 3) * 1e-3,
+                            .lon = lla_ref.lon + (k % 5 - 2) * 2e-3,
+                            .alt = lla_ref.alt + k * 20.0};
+    struct EcefCoor_d ecef_d;
+    ecef_of_lla_d(&ecef_d, &lla);
+    struct EcefCoor_i ecef_i;
+    ECEF_BFP_OF_REAL(ecef_i, ecef_d);
+    ECEF_DOUBLE_OF_BFP(ecef_d, ecef_i);
+    struct NedCoor_d ned_ref;
+    ned_of_ecef_point_d(&ned_ref, &ltp_d, &ecef_d);
+
+    stateSetPositionEcef_i(&ecef_i);
+    struct NedCoor_i *ned_i = stateGetPositionNed_i();
+    struct NedCoor_f *ned_f = stateGetPositionNed_f();
+    struct NedCoor_i ned_old;
+    ned_of_ecef_pos_i(&ned_old, &ltp_i, &ecef_i);
+    for (int j = 0; j < 3; j++) {
+      double ref = (&ned_ref.x)[j];
+      max_err_i = Max(max_err_i, fabs(POS_FLOAT_OF_BFP((&ned_i->x)[j]) - ref));
+      max_err_f = Max(max_err_f, fabs((&ned_f->x)[j] - ref));
+      max_err_old = Max(max_err_old, fabs(POS_FLOAT_OF_BFP((&ned_old.x)[j]) - ref));
+    }
+
+    struct LlaCoor_i lla_i;
+    LLA_BFP_OF_REAL(lla_i, lla);
+    stateSetPositionLla_i(&lla_i);
+    ned_i = stateGetPositionNed_i();
+    ecef_of_lla_d(&ecef_d, &lla);
+    ned_of_ecef_point_d(&ned_ref, &ltp_d, &ecef_d);
+    for (int j = 0; j < 3; j++) {
+      max_err_lla = Max(max_err_lla, fabs(POS_FLOAT_OF_BFP((&ned_i->x)[j]) - (&ned_ref.x)[j]));
+    }
+  }
+  note("ned from ecef_i: max error int %.4f m (ned_of_ecef_pos_i %.4f m), float %.4f m", max_err_i,
+       max_err_old, max_err_f);
+  /* error is mostly due to the resolution of ltp_of_ecef (HIGH_RES_TRIG_FRAC) */
+  ok(max_err_i < 0.05 && max_err_i <= max_err_old, "stateGetPositionNed_i() from ecef_i has max error of 5cm");
+  ok(max_err_f < 0.05, "stateGetPositionNed_f() from ecef_i has max error of 5cm");
+  note("ned from lla_i: max error %.4f m", max_err_lla);
+  ok(max_err_lla < 0.05, "stateGetPositionNed_i() from lla_i has max error of 5cm");
+}
+
+static void test_conversion_stats(void)
+{
+  struct EcefCoor_i ecef = state.ned_origin_i.ecef;
+  stateConversionStatsPeriodic(1.f);
+  for (int k = 0; k < 10; k++) {
+    stateSetPositionEcef_i(&ecef);
+    stateGetPositionNed_i();
+    stateGetPositionNed_i();
+  }
+  ok(state_conversion_count.pos[POS_NED_I] == 10 && state_conversion_count.pos[POS_ECEF_I] == 0,
+     "conversions are counted once per new position");
+  stateConversionStatsPeriodic(0.5f);
+  ok(state_conversion_rate.pos[POS_NED_I] == 20 && state_conversion_count.pos[POS_NED_I] == 0,
+     "conversions per second are updated and counting restarts");
+
+  struct LlaCoor_i lla = state.ned_origin_i.lla;
+  stateSetPositionLla_i(&lla);
+  stateGetPositionNed_i();
+  stateGetPositionEcef_i();
+  ok(state_conversion_count.pos[POS_NED_I] == 1 && state_conversion_count.pos[POS_ECEF_I] == 1,
+     "intermediate conversions are counted once");
+}
+
 int main()
 {
   note("\n *** running state interface tests ***");
-  plan(1);
+  plan(7);
 
   stateInit();
 
   test_pos_lla_i();
+  test_pos_ned_of_ecef();
+  test_conversion_stats();
 
   done_testing();
 }